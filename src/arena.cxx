@@ -0,0 +1,192 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "arena.hxx"
+#include <cstdint>
+
+namespace sil {
+
+  namespace {
+
+    /// \brief Hands out small indices to the threads that allocate from
+    /// an Arena, reusing those of threads that have ended.
+    class ThreadIndex {
+    private:
+      static std::mutex& mutex() {
+        static std::mutex indexMutex;
+        return indexMutex;
+      }
+
+      static std::vector<std::size_t>& unused() {
+        static std::vector<std::size_t> unusedIndices;
+        return unusedIndices;
+      }
+
+      static std::size_t next; //!< The lowest index never handed out.
+
+    public:
+      std::size_t value; //!< The index of the calling thread.
+
+      ThreadIndex(void) {
+        std::lock_guard<std::mutex> lock(mutex());
+        if (unused().empty())
+          this->value = next++;
+        else {
+          this->value = unused().back();
+          unused().pop_back();
+        }
+      }
+
+      ~ThreadIndex(void) {
+        std::lock_guard<std::mutex> lock(mutex());
+        unused().push_back(this->value);
+      }
+    };
+
+    std::size_t ThreadIndex::next = 0;
+
+    thread_local ThreadIndex threadIndex;
+
+  } // namespace
+
+  Arena::Arena(std::size_t usrBlockSize, std::pmr::memory_resource* usrUpstream) :
+    upstream(usrUpstream), blockSize(usrBlockSize > 0 ? usrBlockSize : 1),
+    threadBlocks(NULL), bytesAllocated(0), bytesDeallocated(0), bytesReserved(0) {
+    this->sharedBlock.current = NULL;
+    this->sharedBlock.end = NULL;
+  }
+
+  Arena::~Arena() {
+    this->release();
+    delete[] this->threadBlocks.load();
+  }
+
+  char* Arena::newBlock(std::size_t bytes, std::size_t alignment) {
+    if (alignment < alignof(std::max_align_t))
+      alignment = alignof(std::max_align_t);
+    Block block;
+    block.data = static_cast<char*>(this->upstream->allocate(bytes, alignment));
+    block.size = bytes;
+    block.alignment = alignment;
+    this->blocks.push_back(block);
+    this->bytesReserved += bytes;
+    return block.data;
+  }
+
+  Arena::BumpBlock* Arena::getThreadBlocks() {
+    BumpBlock* result = this->threadBlocks.load(std::memory_order_acquire);
+    if (result != NULL)
+      return result;
+    BumpBlock* made = new BumpBlock[THREAD_BLOCKS]();
+    if (this->threadBlocks.compare_exchange_strong(result, made, std::memory_order_acq_rel))
+      return made;
+    delete[] made; // another thread was first
+    return result;
+  }
+
+  // Returns how many bytes from @current on @bytes with @alignment take
+  // up, or 0 if they do not fit before @end.
+  static std::size_t roomFor(const char* current, const char* end,
+                             std::size_t bytes, std::size_t alignment) {
+    if (current == NULL)
+      return 0;
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(current);
+    std::size_t padding = (alignment - address % alignment) % alignment;
+    if (static_cast<std::size_t>(end - current) < padding + bytes)
+      return 0;
+    return padding + bytes;
+  }
+
+  void* Arena::bump(BumpBlock& block, std::size_t bytes, std::size_t alignment) {
+    std::size_t needed = roomFor(block.current, block.end, bytes, alignment);
+    if (needed == 0) {
+      // the rest of the old block is left unused
+      block.current = this->newBlock(this->blockSize, alignment);
+      block.end = block.current + this->blockSize;
+      needed = bytes;
+    }
+    char* result = block.current + (needed - bytes);
+    block.current += needed;
+    return result;
+  }
+
+  void* Arena::do_allocate(std::size_t bytes, std::size_t alignment) {
+    this->bytesAllocated.fetch_add(bytes, std::memory_order_relaxed);
+    if (bytes > this->blockSize / 2) {
+      // a dedicated block, the rest of the bumped ones is still used
+      std::lock_guard<std::mutex> lock(this->mutex);
+      return this->newBlock(bytes, alignment);
+    }
+    std::size_t index = threadIndex.value;
+    if (index >= THREAD_BLOCKS) {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      return this->bump(this->sharedBlock, bytes, alignment);
+    }
+    BumpBlock& block = this->getThreadBlocks()[index];
+    if (roomFor(block.current, block.end, bytes, alignment) == 0) {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      return this->bump(block, bytes, alignment);
+    }
+    return this->bump(block, bytes, alignment);
+  }
+
+  void Arena::do_deallocate(void*, std::size_t bytes, std::size_t) {
+    this->bytesDeallocated.fetch_add(bytes, std::memory_order_relaxed);
+  }
+
+  bool Arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+  }
+
+  void Arena::release() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (std::size_t i = 0; i < this->blocks.size(); i++)
+      this->upstream->deallocate(this->blocks[i].data, this->blocks[i].size,
+                                 this->blocks[i].alignment);
+    this->blocks.clear();
+    // the blocks that were being bumped are gone
+    this->sharedBlock.current = NULL;
+    this->sharedBlock.end = NULL;
+    BumpBlock* bumped = this->threadBlocks.load();
+    for (std::size_t i = 0; bumped != NULL && i < THREAD_BLOCKS; i++) {
+      bumped[i].current = NULL;
+      bumped[i].end = NULL;
+    }
+    this->bytesAllocated = 0;
+    this->bytesDeallocated = 0;
+    this->bytesReserved = 0;
+  }
+
+  std::size_t Arena::getBytesInUse() const {
+    return this->bytesAllocated.load() - this->bytesDeallocated.load();
+  }
+
+  std::size_t Arena::getBytesAllocated() const {
+    return this->bytesAllocated.load();
+  }
+
+  std::size_t Arena::getBytesReserved() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->bytesReserved;
+  }
+
+  std::size_t Arena::getBlockCount() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->blocks.size();
+  }
+
+} // namespace sil
@@ -0,0 +1,137 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef ARENA_HXX
+#define ARENA_HXX
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+namespace sil {
+
+  /// \brief A memory resource that hands out memory from large blocks
+  /// and frees it all at once.
+  ///
+  /// Giving an Arena to a Layout (or a Cell) makes the shape lists and
+  /// the vertices of every Polygon and Path come from a few large
+  /// blocks instead of one heap allocation per shape. Allocating is a
+  /// pointer bump, freeing an individual allocation does nothing, and
+  /// the memory is returned to the upstream resource by release() or
+  /// when the Arena is destroyed. The Arena must therefore outlive
+  /// everything allocated from it.
+  ///
+  /// One Arena may be shared by threads that fill different cells or the
+  /// CellShard objects of one Cell. The Arena keeps a block for each of
+  /// the first THREAD_BLOCKS threads (counting threads that are alive at
+  /// the same time), so allocating only takes a mutex when a thread
+  /// needs a new block or an allocation gets a dedicated one; further
+  /// threads share one block under the mutex. A thread may use any
+  /// number of Arenas without them taking blocks from each other.
+  /// release() and the destructor must not run while other threads
+  /// allocate.
+  class Arena : public std::pmr::memory_resource {
+  private:
+    struct Block {
+      char* data;
+      std::size_t size;
+      std::size_t alignment;
+    };
+
+    std::pmr::memory_resource* upstream; //!< Where the blocks come from.
+    std::size_t blockSize; //!< The size of a regular block.
+    /// \brief The rest of a block that is handed out by bumping
+    /// @current, on a cache line of its own.
+    struct alignas(64) BumpBlock {
+      char* current; //!< The next free byte, NULL if there is no block.
+      char* end; //!< One past the last byte.
+    };
+
+    std::vector<Block> blocks; //!< Every block taken from @upstream.
+    /// \brief THREAD_BLOCKS blocks, one per thread index, made on the
+    /// first allocation.
+    std::atomic<BumpBlock*> threadBlocks;
+    BumpBlock sharedBlock; //!< The block of the other threads, guarded by @mutex.
+    std::atomic<std::size_t> bytesAllocated; //!< The sum of all allocation sizes.
+    std::atomic<std::size_t> bytesDeallocated; //!< The sum of all deallocation sizes.
+    std::size_t bytesReserved; //!< The sum of all block sizes.
+    mutable std::mutex mutex; //!< Guards @blocks, @bytesReserved and @sharedBlock.
+
+    /// \brief Takes a new block from @upstream for at least @bytes
+    /// bytes, to be called with @mutex held.
+    char* newBlock(std::size_t bytes, std::size_t alignment);
+
+    /// \brief Returns the blocks of the threads, making them if needed.
+    BumpBlock* getThreadBlocks(void);
+
+    /// \brief Hands out @bytes from @block, which gets a new block first
+    /// if it has no room. @mutex must be held unless @block has room.
+    void* bump(BumpBlock& block, std::size_t bytes, std::size_t alignment);
+
+  protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+  public:
+    /// \brief The number of threads that get a block of their own.
+    static const std::size_t THREAD_BLOCKS = 64;
+
+    /// \brief Creates an Arena.
+    ///
+    /// @usrBlockSize The size of the blocks taken from @usrUpstream.
+    /// Allocations larger than half of it get a block of their own.
+    /// @usrUpstream The resource the blocks come from.
+    explicit Arena(std::size_t usrBlockSize = 1 << 20,
+                   std::pmr::memory_resource* usrUpstream = std::pmr::get_default_resource());
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /// \brief Releases all of the blocks.
+    ~Arena(void);
+
+    /// \brief Returns every block to the upstream resource.
+    ///
+    /// Everything allocated from this Arena becomes invalid.
+    void release(void);
+
+    /// \brief Returns the bytes allocated and not deallocated since.
+    ///
+    /// Deallocated memory is only reused after release(), so this is
+    /// how much of getBytesReserved() is still in use.
+    std::size_t getBytesInUse(void) const;
+
+    /// \brief Returns the bytes allocated since the last release().
+    std::size_t getBytesAllocated(void) const;
+
+    /// \brief Returns the bytes taken from the upstream resource.
+    std::size_t getBytesReserved(void) const;
+
+    /// \brief Returns the number of blocks taken from the upstream
+    /// resource.
+    std::size_t getBlockCount(void) const;
+  };
+
+} // namespace sil
+
+#endif // ARENA_HXX
@@ -0,0 +1,366 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "arrayDetection.hxx"
+#include "validation.hxx"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <unordered_map>
+
+namespace sil {
+
+  // A placement of a repeated shape or reference. @index identifies
+  // the polygon or reference it came from.
+  struct ArraySite {
+    double x;
+    double y;
+    uint index;
+  };
+
+  // A row of @count sites starting at (x, y) with a constant pitch.
+  struct ArrayRun {
+    double x;
+    double y;
+    int count;
+    double pitch;
+  };
+
+  // A lattice of sites that will become a CellArray.
+  struct ArrayLattice {
+    double x;
+    double y;
+    int numCol;
+    int numRow;
+    double xSpacing;
+    double ySpacing;
+  };
+
+  ArrayDetectionOptions::ArrayDetectionOptions() {
+    this->minInstances = 4;
+    this->grid = 1e-3;
+    this->tolerance = 1e-4;
+  }
+
+  static bool siteBefore(const ArraySite& site1, const ArraySite& site2) {
+    return site1.y < site2.y || (site1.y == site2.y && site1.x < site2.x);
+  }
+
+  static bool siteLeftOf(const ArraySite& site1, const ArraySite& site2) {
+    return site1.x < site2.x;
+  }
+
+  // Splits one row of sites (sorted by x) into maximal runs with a
+  // constant pitch. Sites that are not part of a run go to @singles.
+  static void findRuns(const std::vector<ArraySite>& row, double tolerance,
+                       std::vector<ArrayRun>& runs,
+                       std::vector<ArraySite>& singles) {
+    uint i = 0;
+    while (i < row.size()) {
+      uint j = i;
+      double pitch = 0;
+      if (i + 1 < row.size()) {
+        pitch = row[i + 1].x - row[i].x;
+        if (pitch > tolerance) {
+          j = i + 1;
+          while (j + 1 < row.size() && (int) (j + 2 - i) <= GDS_MAX_ARRAY_DIMENSION &&
+                 std::abs(row[j + 1].x - (row[i].x + (j + 1 - i)*pitch)) <= tolerance)
+            j++;
+        }
+      }
+      if (j > i) {
+        ArrayRun run = {row[i].x, row[i].y, (int) (j - i + 1), pitch};
+        runs.push_back(run);
+      } else {
+        singles.push_back(row[i]);
+      }
+      i = j + 1;
+    }
+  }
+
+  // Groups sites into rows (sites whose y coordinates agree to within
+  // @tolerance) and finds the runs in each of them.
+  static void findRowRuns(std::vector<ArraySite>& sites, double tolerance,
+                          std::vector<ArrayRun>& runs,
+                          std::vector<ArraySite>& singles) {
+    std::sort(sites.begin(), sites.end(), siteBefore);
+    std::vector<ArraySite> row;
+    uint i = 0;
+    while (i < sites.size()) {
+      uint j = i;
+      while (j + 1 < sites.size() && sites[j + 1].y - sites[i].y <= tolerance)
+        j++;
+      row.assign(sites.begin() + i, sites.begin() + j + 1);
+      std::sort(row.begin(), row.end(), siteLeftOf);
+      findRuns(row, tolerance, runs, singles);
+      i = j + 1;
+    }
+  }
+
+  // Finds the lattices formed by @sites. Rows are found first, rows with
+  // the same start, pitch and length that are evenly spaced in y are then
+  // stacked into two dimensional lattices, and finally the sites left
+  // over are searched for columns. Whatever remains ends up in @singles.
+  static void findLattices(std::vector<ArraySite>& sites,
+                           const ArrayDetectionOptions& options,
+                           std::vector<ArrayLattice>& lattices,
+                           std::vector<ArraySite>& singles) {
+    double tolerance = options.tolerance;
+    std::vector<ArrayRun> runs;
+    std::vector<ArraySite> leftOver;
+    findRowRuns(sites, tolerance, runs, leftOver);
+
+    // Bucket the runs that may belong to the same lattice. Runs come out
+    // of findRowRuns sorted by y, and stay that way in each bucket.
+    typedef std::pair<std::pair<long long, long long>, int> RunKey;
+    std::map<RunKey, std::vector<uint> > buckets;
+    for (uint i = 0; i < runs.size(); i++) {
+      RunKey key(std::make_pair(std::llround(runs[i].x/options.grid),
+                                std::llround(runs[i].pitch/options.grid)),
+                 runs[i].count);
+      buckets[key].push_back(i);
+    }
+    for (std::map<RunKey, std::vector<uint> >::iterator bucket = buckets.begin();
+         bucket != buckets.end(); ++bucket) {
+      const std::vector<uint>& rows = bucket->second;
+      uint i = 0;
+      while (i < rows.size()) {
+        const ArrayRun& first = runs[rows[i]];
+        uint j = i;
+        double ySpacing = 0;
+        if (i + 1 < rows.size()) {
+          ySpacing = runs[rows[i + 1]].y - first.y;
+          while (ySpacing > tolerance && j + 1 < rows.size() &&
+                 (int) (j + 2 - i) <= GDS_MAX_ARRAY_DIMENSION) {
+            const ArrayRun& next = runs[rows[j + 1]];
+            if (std::abs(next.y - (first.y + (j + 1 - i)*ySpacing)) > tolerance ||
+                std::abs(next.x - first.x) > tolerance ||
+                std::abs(next.pitch - first.pitch)*first.count > tolerance)
+              break;
+            j++;
+          }
+        }
+        ArrayLattice lattice = {first.x, first.y, first.count, (int) (j - i + 1),
+                                first.pitch, j > i ? ySpacing : 0.};
+        lattices.push_back(lattice);
+        i = j + 1;
+      }
+    }
+
+    // Look for columns among the sites that were not part of any row by
+    // swapping x and y.
+    for (uint i = 0; i < leftOver.size(); i++)
+      std::swap(leftOver[i].x, leftOver[i].y);
+    std::vector<ArrayRun> columns;
+    findRowRuns(leftOver, tolerance, columns, singles);
+    for (uint i = 0; i < columns.size(); i++) {
+      ArrayLattice lattice = {columns[i].y, columns[i].x, 1, columns[i].count,
+                              0., columns[i].pitch};
+      lattices.push_back(lattice);
+    }
+    for (uint i = 0; i < singles.size(); i++)
+      std::swap(singles[i].x, singles[i].y);
+  }
+
+  // Creates a name for a generated child of @cell that is not yet used
+  // in @layout and fits in the 32 characters GDSII allows.
+  static std::string uniqueCellname(const Layout& layout, const Cell& cell,
+                                    unsigned int& counter) {
+    std::string base = cell.getCellname().substr(0, 24) + "_A";
+    std::string name;
+    do {
+      name = base + std::to_string(counter++);
+    } while (layout.findCell(name) != NULL);
+    return name;
+  }
+
+  // Appends the raw bytes of @value to @key.
+  template <typename T>
+  static void appendToKey(std::string& key, T value) {
+    key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  ArrayDetectionStats detectArrays(Layout& layout, Cell& cell,
+                                   ArrayDetectionOptions options) {
+    ArrayDetectionStats stats = {0, 0, 0, 0, 0};
+    unsigned int nameCounter = 0;
+    std::vector<ArrayLattice> lattices;
+    std::vector<ArraySite> sites;
+    std::vector<ArraySite> singles;
+
+    //----------------------------------------------------------------//
+    // Repeated polygons
+    PolygonList& polygons = cell.getPolygonList();
+    std::unordered_map<std::string, uint> groupIndex;
+    std::vector<std::vector<uint> > groups;
+    std::string key;
+    for (uint i = 0; i < polygons.size(); i++) {
+      Span<const CoordPnt> vertices = polygons[i].getVertexSpan();
+      key.clear();
+      appendToKey(key, polygons[i].getLayer());
+      appendToKey(key, polygons[i].getDataType());
+      for (uint j = 1; j < vertices.size(); j++) {
+        appendToKey(key, std::llround((vertices[j].getX() - vertices[0].getX())/options.grid));
+        appendToKey(key, std::llround((vertices[j].getY() - vertices[0].getY())/options.grid));
+      }
+      std::unordered_map<std::string, uint>::iterator found = groupIndex.find(key);
+      if (found == groupIndex.end()) {
+        found = groupIndex.insert(std::make_pair(key, (uint) groups.size())).first;
+        groups.push_back(std::vector<uint>());
+      }
+      groups[found->second].push_back(i);
+    }
+
+    std::vector<bool> replaced(polygons.size(), false);
+    for (uint g = 0; g < groups.size(); g++) {
+      const std::vector<uint>& members = groups[g];
+      if (members.size() < options.minInstances)
+        continue;
+      sites.clear();
+      for (uint i = 0; i < members.size(); i++) {
+        const CoordPnt& anchor = polygons[members[i]].getVertexSpan()[0];
+        ArraySite site = {anchor.getX(), anchor.getY(), members[i]};
+        sites.push_back(site);
+      }
+      lattices.clear();
+      singles.clear();
+      findLattices(sites, options, lattices, singles);
+
+      // Rough sizes (in 8 byte units) of the elements involved: a
+      // boundary costs its vertices plus its records, a new cell costs
+      // one boundary plus its header, references and arrays are small.
+      uint numVertices = polygons[members[0]].getVertexSpan().size();
+      uint flatCost = members.size()*(numVertices + 5);
+      uint hierarchyCost = (numVertices + 10) + 7*lattices.size() + 4*singles.size();
+      if (hierarchyCost >= flatCost)
+        continue;
+
+      Cell& child = layout.createCell(uniqueCellname(layout, cell, nameCounter));
+      stats.cellsCreated++;
+      Polygon shape = polygons[members[0]];
+      CoordPnt origin = shape.getVertexSpan()[0];
+      shape.translate(CoordPnt(-origin.getX(), -origin.getY()));
+      child.addPolygon(shape);
+
+      for (uint i = 0; i < lattices.size(); i++) {
+        const ArrayLattice& lattice = lattices[i];
+        if (lattice.numCol*lattice.numRow == 1) {
+          cell.addCellReference(CellReference(child, CoordPnt(lattice.x, lattice.y)));
+          stats.referencesCreated++;
+        } else {
+          cell.addCellArray(CellArray(child, CoordPnt(lattice.x, lattice.y),
+                                      lattice.numCol, lattice.numRow,
+                                      lattice.xSpacing, lattice.ySpacing));
+          stats.arraysCreated++;
+        }
+      }
+      for (uint i = 0; i < singles.size(); i++) {
+        cell.addCellReference(CellReference(child, CoordPnt(singles[i].x, singles[i].y)));
+        stats.referencesCreated++;
+      }
+      for (uint i = 0; i < members.size(); i++)
+        replaced[members[i]] = true;
+      stats.polygonsReplaced += members.size();
+    }
+
+    if (stats.polygonsReplaced > 0) {
+      PolygonList remaining(polygons.get_allocator());
+      remaining.reserve(polygons.size() - stats.polygonsReplaced);
+      for (uint i = 0; i < polygons.size(); i++)
+        if (!replaced[i])
+          remaining.push_back(polygons[i]);
+      polygons.swap(remaining);
+    }
+
+    //----------------------------------------------------------------//
+    // Regularly placed references. The references added above are not
+    // revisited since they are what is left over from the lattices.
+    CellReferenceList& refs = cell.getCellReferenceList();
+    uint numOriginalRefs = refs.size() - stats.referencesCreated;
+    groupIndex.clear();
+    groups.clear();
+    for (uint i = 0; i < numOriginalRefs; i++) {
+      key.clear();
+      appendToKey(key, &refs[i].getReferencedCell());
+      appendToKey(key, refs[i].getMagnification());
+      appendToKey(key, refs[i].getRotation());
+      std::unordered_map<std::string, uint>::iterator found = groupIndex.find(key);
+      if (found == groupIndex.end()) {
+        found = groupIndex.insert(std::make_pair(key, (uint) groups.size())).first;
+        groups.push_back(std::vector<uint>());
+      }
+      groups[found->second].push_back(i);
+    }
+
+    std::vector<bool> removed(refs.size(), false);
+    std::vector<CellArray> newArrays;
+    for (uint g = 0; g < groups.size(); g++) {
+      const std::vector<uint>& members = groups[g];
+      if (members.size() < options.minInstances)
+        continue;
+      sites.clear();
+      for (uint i = 0; i < members.size(); i++) {
+        ArraySite site = {refs[members[i]].getCenter().getX(),
+                          refs[members[i]].getCenter().getY(), members[i]};
+        sites.push_back(site);
+      }
+      lattices.clear();
+      singles.clear();
+      findLattices(sites, options, lattices, singles);
+
+      // Rough sizes as above: a reference or an array costs its records
+      // plus the name of the Cell it places.
+      const CellReference& ref = refs[members[0]];
+      uint nameCost = (ref.getReferencedCell().getCellname().size() + 7)/8;
+      uint flatCost = (members.size() - singles.size())*(4 + nameCost);
+      uint hierarchyCost = lattices.size()*(7 + nameCost);
+      if (hierarchyCost >= flatCost)
+        continue;
+
+      // every member that is not a single is covered by a lattice
+      for (uint i = 0; i < members.size(); i++)
+        removed[members[i]] = true;
+      for (uint i = 0; i < singles.size(); i++)
+        removed[singles[i].index] = false;
+      for (uint i = 0; i < lattices.size(); i++) {
+        const ArrayLattice& lattice = lattices[i];
+        CellArray array(ref.getReferencedCell(), CoordPnt(lattice.x, lattice.y),
+                        lattice.numCol, lattice.numRow,
+                        lattice.xSpacing, lattice.ySpacing);
+        array.setMagnification(ref.getMagnification());
+        array.setRotation(ref.getRotation());
+        newArrays.push_back(array);
+      }
+      stats.referencesReplaced += members.size() - singles.size();
+    }
+
+    if (stats.referencesReplaced > 0) {
+      CellReferenceList remaining(refs.get_allocator());
+      remaining.reserve(refs.size() - stats.referencesReplaced);
+      for (uint i = 0; i < refs.size(); i++)
+        if (!removed[i])
+          remaining.push_back(refs[i]);
+      refs.swap(remaining);
+      for (uint i = 0; i < newArrays.size(); i++)
+        cell.addCellArray(newArrays[i]);
+      stats.arraysCreated += newArrays.size();
+    }
+
+    return stats;
+  }
+
+}
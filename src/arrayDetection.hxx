@@ -0,0 +1,76 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ARRAY_DETECTION_HXX
+#define ARRAY_DETECTION_HXX
+
+#include "cell.hxx"
+#include "layout.hxx"
+
+namespace sil {
+
+  /// \brief The settings used by detectArrays().
+  struct ArrayDetectionOptions {
+    /// \brief Shapes, and references with the same Cell and
+    /// transformation, that occur fewer times than this are left alone.
+    unsigned int minInstances;
+
+    /// \brief The grid (in user units) on which two shapes are compared.
+    ///
+    /// Defaults to the database unit of the GDSII and OASIS writers.
+    double grid;
+
+    /// \brief How far (in user units) an instance may be from its ideal
+    /// lattice site and still be made part of an array.
+    double tolerance;
+
+    /// \brief Sets the defaults: 4 instances, a 1 nm grid and a 0.1 nm
+    /// tolerance.
+    ArrayDetectionOptions(void);
+  };
+
+  /// \brief A summary of the changes made by detectArrays().
+  struct ArrayDetectionStats {
+    unsigned int polygonsReplaced; //!< Polygons moved into generated cells.
+    unsigned int referencesReplaced; //!< CellReferences folded into CellArrays.
+    unsigned int cellsCreated; //!< Child cells generated to hold repeated shapes.
+    unsigned int arraysCreated; //!< CellArrays added to the Cell.
+    unsigned int referencesCreated; //!< CellReferences added to the Cell.
+  };
+
+  /// \brief Replaces repeated shapes and regularly placed references in
+  /// @cell by hierarchy.
+  ///
+  /// @layout The Layout that will own the generated child cells.
+  /// @cell The Cell to optimize (it does not have to belong to @layout).
+  /// @options The settings that control the detection.
+  ///
+  /// Polygons are hashed by their layer, datatype and vertices relative
+  /// to their first vertex, so every group holds translated copies of a
+  /// single shape. Each large enough group is moved into a new child
+  /// Cell and its placements are split into rows and columns with a
+  /// constant pitch; rows that line up are merged into two dimensional
+  /// lattices. Lattices become CellArrays and the remaining placements
+  /// become CellReferences. Existing CellReferences to the same Cell with
+  /// the same transformation are collapsed into CellArrays the same way.
+  /// Groups are only replaced when that makes the Cell smaller. The pass
+  /// runs in O(n log n) time for n shapes.
+  ArrayDetectionStats detectArrays(Layout& layout, Cell& cell,
+                                   ArrayDetectionOptions options = ArrayDetectionOptions());
+
+}
+
+#endif // ARRAY_DETECTION_HXX
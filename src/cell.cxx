@@ -16,12 +16,29 @@
 
 #include "cell.hxx"
 #include "gdsfile.hxx" // must keep
+#include "layout.hxx"
 
 namespace sil {
 
+  // Throws if @usrCellname is not a valid GDSII structure name.
+  static void checkCellname(const std::string& usrCellname) {
+    if (usrCellname.size() > 32)
+      throw std::invalid_argument("Cell name must be under 32 characters.");
+    if (usrCellname.find_first_not_of("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_?$") !=
+	std::string::npos)
+      throw std::invalid_argument("Cell name contains invalid characters.");
+  }
+
   // The full blooded Cell object constructor.
-  Cell::Cell(std::string usrCellname) {
-    this->setCellname(usrCellname);
+  Cell::Cell(std::string usrCellname) :
+    Cell::Cell(usrCellname, std::pmr::get_default_resource()) {}
+
+  Cell::Cell(std::string usrCellname, std::pmr::memory_resource* resource) :
+    polyList(resource), pathList(resource), cellReferenceList(resource),
+    cellArrayList(resource) {
+    // not a rename, a new Cell can not be in a Layout yet
+    checkCellname(usrCellname);
+    this->cellname = usrCellname;
     time_t now = time(0);
     tm *ltm = localtime(&now);
     this->timeCreated.year = 1900 + ltm->tm_year;
@@ -32,23 +49,78 @@ namespace sil {
     this->timeCreated.second = 1 + ltm->tm_sec;
   }
 
+  Cell::Cell(const Cell& other) :
+    cellname(other.cellname), polyList(other.polyList), pathList(other.pathList),
+    cellReferenceList(other.cellReferenceList), cellArrayList(other.cellArrayList),
+    timeCreated(other.timeCreated) {}
+
+  Cell::Cell(Cell&& other) :
+    cellname(other.cellname), polyList(std::move(other.polyList)),
+    pathList(std::move(other.pathList)), cellReferenceList(std::move(other.cellReferenceList)),
+    cellArrayList(std::move(other.cellArrayList)), timeCreated(other.timeCreated) {}
+
+  Cell& Cell::operator=(const Cell& other) {
+    if (this == &other)
+      return *this;
+    this->polyList = other.polyList;
+    this->pathList = other.pathList;
+    this->cellReferenceList = other.cellReferenceList;
+    this->cellArrayList = other.cellArrayList;
+    this->timeCreated = other.timeCreated;
+    this->rename(other.cellname);
+    return *this;
+  }
+
+  Cell& Cell::operator=(Cell&& other) {
+    if (this == &other)
+      return *this;
+    this->polyList = std::move(other.polyList);
+    this->pathList = std::move(other.pathList);
+    this->cellReferenceList = std::move(other.cellReferenceList);
+    this->cellArrayList = std::move(other.cellArrayList);
+    this->timeCreated = other.timeCreated;
+    this->rename(other.cellname);
+    return *this;
+  }
+
+  Cell::~Cell() {
+    std::vector<Layout*> remaining;
+    {
+      std::lock_guard<std::mutex> lock(this->layoutsMutex);
+      remaining.swap(this->layouts);
+    }
+    // a Cell destroyed while in a Layout leaves it rather than dangle
+    for (std::size_t i = 0; i < remaining.size(); i++)
+      remaining[i]->dropCell(*this);
+  }
+
   // Allows the user to reset this cell's name
   void Cell::setCellname(std::string usrCellname) {
-    if (usrCellname.size() > 32)
-      throw std::invalid_argument("Cell name must be under 32 characters.");
-    if (usrCellname.find_first_not_of("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_?$") !=
-	std::string::npos)
-      throw std::invalid_argument("Cell name contains invalid characters.");
+    checkCellname(usrCellname);
+    this->rename(usrCellname);
+  }
+
+  void Cell::rename(const std::string& usrCellname) {
+    std::lock_guard<std::mutex> lock(this->layoutsMutex);
+    if (usrCellname == this->cellname)
+      return;
+    std::string oldName = this->cellname;
     this->cellname = usrCellname;
+    for (std::size_t i = 0; i < this->layouts.size(); i++)
+      this->layouts[i]->renameCell(*this, oldName);
+  }
+
+  std::pmr::memory_resource* Cell::getMemoryResource() const {
+    return this->polyList.get_allocator().resource();
   }
 
   // Simple member function that returns the specified cell's name
-  std::string Cell::getCellname() const {
+  const std::string& Cell::getCellname() const {
     return this->cellname;
   }
 
-  std::vector<Polygon>& Cell::getPolygonList() const {
-    return const_cast<std::vector<sil::Polygon> &> (this->polyList);
+  PolygonList& Cell::getPolygonList() const {
+    return const_cast<PolygonList &> (this->polyList);
   }
   
   // Returns the data about when this cell was created 
@@ -57,27 +129,31 @@ namespace sil {
   }
 
   void Cell::addPolygon(sil::Polygon usrPolygon) {
-    this->polyList.push_back(usrPolygon);
+    this->polyList.push_back(std::move(usrPolygon));
   }
 
   void Cell::addPath(Path usrPath) {
-    this->pathList.push_back(usrPath);
+    this->pathList.push_back(std::move(usrPath));
   }
 
   void Cell::addCellReference(CellReference usrCellReference) {
-    this->cellReferenceList.push_back(usrCellReference);
+    this->cellReferenceList.push_back(std::move(usrCellReference));
+  }
+
+  void Cell::addCellArray(CellArray usrCellArray) {
+    this->cellArrayList.push_back(std::move(usrCellArray));
   }
 
-  std::vector<Path>& Cell::getPathList() const {
-    return const_cast<std::vector<sil::Path> &> (this->pathList);
+  PathList& Cell::getPathList() const {
+    return const_cast<PathList &> (this->pathList);
   }
 
-  std::vector<CellReference>& Cell::getCellReferenceList() const {
-    return const_cast<std::vector<sil::CellReference> &> (this->cellReferenceList);
+  CellReferenceList& Cell::getCellReferenceList() const {
+    return const_cast<CellReferenceList &> (this->cellReferenceList);
   }
 
-  std::vector<CellArray>& Cell::getCellArrayList(void) const {
-    return const_cast<std::vector<sil::CellArray> &> (this->cellArrayList);
+  CellArrayList& Cell::getCellArrayList(void) const {
+    return const_cast<CellArrayList &> (this->cellArrayList);
   }
 
 }
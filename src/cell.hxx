@@ -20,6 +20,11 @@
 #include <string>
 #include <vector>
 #include <ctime>
+#include <mutex>
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <utility>
 #include "polygon.hxx"
 #include "path.hxx"
 #include "cellReference.hxx"
@@ -37,6 +42,13 @@ struct timeData {
 
 namespace sil {
 
+  class Layout;
+
+  typedef std::pmr::vector<Polygon> PolygonList; //!< The polygons of a Cell.
+  typedef std::pmr::vector<Path> PathList; //!< The paths of a Cell.
+  typedef std::pmr::vector<CellReference> CellReferenceList; //!< The CellReferences of a Cell.
+  typedef std::pmr::vector<CellArray> CellArrayList; //!< The CellArrays of a Cell.
+
   /// Cells that are added to a Layout can be considered to be a
   /// component of a larger fabrication flow. An example would be
   /// the design for a transistor that is to be repeatedly used.
@@ -47,29 +59,85 @@ namespace sil {
   class Cell {
   private:
 
+    /// \brief Makes room in @list for the elements in [@first, @last)
+    /// if they can be counted without consuming them.
+    ///
+    /// The capacity at least doubles, so that many small bulk additions
+    /// still take amortized constant time per element.
+    template <typename List, typename InputIt>
+    static void reserveFor(List& list, InputIt first, InputIt last) {
+      typedef typename std::iterator_traits<InputIt>::iterator_category Category;
+      if constexpr (std::is_base_of<std::forward_iterator_tag, Category>::value) {
+        std::size_t needed = list.size() + std::distance(first, last);
+        if (needed > list.capacity())
+          list.reserve(std::max(needed, 2*list.capacity()));
+      }
+    }
+
+    std::vector<Layout*> layouts; //!< The layouts that index this Cell by name.
+    std::mutex layoutsMutex; //!< Guards @layouts, as several threads may add the Cell to layouts at once.
+
+    friend class Layout;
+
+    /// \brief Sets the name to @usrCellname, which must be valid, and
+    /// moves the Cell to it in the index of each of its layouts.
+    void rename(const std::string& usrCellname);
+
   protected:
     std::string cellname; //!< The name this object.
-    std::vector<Polygon> polyList; //<! The vector of objects the cell contains.
-    std::vector<Path> pathList; //!< The vector of path objects in the cell.
-    std::vector<CellReference> cellReferenceList; //!< The vector of CellReference objects that this cell contains.
-    std::vector<CellArray> cellArrayList; //!< The vector of CellArray objects that this cell contains.
+    PolygonList polyList; //<! The vector of objects the cell contains.
+    PathList pathList; //!< The vector of path objects in the cell.
+    CellReferenceList cellReferenceList; //!< The vector of CellReference objects that this cell contains.
+    CellArrayList cellArrayList; //!< The vector of CellArray objects that this cell contains.
     timeData timeCreated; //!< The struct containing a year, month, ... second.
 
   public:
 
     /// \brief Creates a Cell object with the specified cellname.
     Cell(std::string usrCellname);
+
+    /// \brief Creates a Cell whose shapes take their memory from
+    /// @resource.
+    ///
+    /// @usrCellname The name of the Cell.
+    /// @resource The memory resource of the shape lists and of the
+    /// vertices of every Polygon and Path added to them, for example an
+    /// Arena. It must outlive the Cell.
+    Cell(std::string usrCellname, std::pmr::memory_resource* resource);
+
+    /// \brief Copies @other, which does not add the copy to the layouts
+    /// of @other.
+    Cell(const Cell& other);
+
+    /// \brief Moves the shapes of @other, which keeps its name and its
+    /// place in its layouts.
+    Cell(Cell&& other);
+
+    /// \brief Copies the name and shapes of @other, see setCellname().
+    Cell& operator=(const Cell& other);
+
+    /// \brief Moves the shapes and copies the name of @other.
+    Cell& operator=(Cell&& other);
+
+    /// \brief Removes the Cell from the layouts it was added to.
+    ~Cell(void);
+
+    /// \brief Returns the memory resource of the shapes of this Cell.
+    std::pmr::memory_resource* getMemoryResource(void) const;
     
     /// \brief Sets the cell name to be that of what the user specifies.
     ///
     /// @usrCellname The name of this cell.
+    ///
+    /// Every Layout the Cell was added to moves it to the new name in
+    /// its index, see Layout::findCell().
     void setCellname(std::string usrCellname);
 
     /// \brief Returns the cell name for this object.
-    std::string getCellname(void) const;
+    const std::string& getCellname(void) const;
 
     /// \brief Returns a const reference to the Entity List
-    std::vector<Polygon>& getPolygonList(void) const;
+    PolygonList& getPolygonList(void) const;
 
     /// \brief Returns a vector full of the info about when the cell was 
     /// created
@@ -89,13 +157,55 @@ namespace sil {
     /// @usrPolygon The polygon to add to the Cell.
     void addPolygon(Polygon usrPolygon);
 
+    /// \brief Constructs a Polygon at the end of the polygon list.
+    ///
+    /// @args The vertices, layer and datatype, as accepted by
+    /// Polygon(std::allocator_arg_t, ...), or a Polygon to copy or move.
+    ///
+    /// The vertices are copied once, straight into memory from the
+    /// memory resource of this Cell. Returns the new Polygon, which is
+    /// valid until the polygon list next grows.
+    template <typename... Args>
+    Polygon& emplacePolygon(Args&&... args) {
+      this->polyList.emplace_back(std::forward<Args>(args)...);
+      return this->polyList.back();
+    }
+
+    /// \brief Adds every Polygon in [@first, @last) to the Cell.
+    ///
+    /// Room for all of them is made at once when the range can be
+    /// counted. Pass std::make_move_iterator()s to move the polygons.
+    template <typename InputIt>
+    void addPolygons(InputIt first, InputIt last) {
+      reserveFor(this->polyList, first, last);
+      for (; first != last; ++first)
+        this->polyList.emplace_back(*first);
+    }
+
     /// \brief Adds a path to the Cell.
     ///
     /// @usrPath The path to add to the Cell.    
     void addPath(Path usrPath);
 
+    /// \brief Constructs a Path at the end of the path list, see
+    /// emplacePolygon().
+    template <typename... Args>
+    Path& emplacePath(Args&&... args) {
+      this->pathList.emplace_back(std::forward<Args>(args)...);
+      return this->pathList.back();
+    }
+
+    /// \brief Adds every Path in [@first, @last) to the Cell, see
+    /// addPolygons().
+    template <typename InputIt>
+    void addPaths(InputIt first, InputIt last) {
+      reserveFor(this->pathList, first, last);
+      for (; first != last; ++first)
+        this->pathList.emplace_back(*first);
+    }
+
     /// \brief Returns the vector of Path objects in this Cell;
-    std::vector<Path>& getPathList(void) const;
+    PathList& getPathList(void) const;
 
     /// \brief Adds a cell reference to the vector of cellReferences;
     ///
@@ -108,10 +218,10 @@ namespace sil {
     void addCellArray(CellArray usrCellArray);
 
     /// \brief Returns the vector of CellReferences contained in this Cell.
-    std::vector<CellReference>& getCellReferenceList(void) const;
+    CellReferenceList& getCellReferenceList(void) const;
 
     /// \brief Returns the vector of CellArrays contained in this Cell.
-    std::vector<CellArray>& getCellArrayList(void) const;
+    CellArrayList& getCellArrayList(void) const;
   }; // class Cell
 } // namespace sil
 
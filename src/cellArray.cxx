@@ -16,17 +16,20 @@
 
 #include "cellArray.hxx"
 #include "cell.hxx"
+#include "validation.hxx"
 
 namespace sil {
 
-  CellArray::CellArray(Cell& cell, CoordPnt usrStartingPos, 
+  CellArray::CellArray(const Cell& cell, CoordPnt usrStartingPos, 
 		       int usrNumCol, int usrNumRow, double usrXSpacing, 
-		       double usrYSpacing) : refCell(cell) {
+		       double usrYSpacing) : refCell(&cell) {
     this->startingPos = usrStartingPos;
     this->setNumCol(usrNumCol);
     this->setNumRow(usrNumRow);
     this->xSpacing = usrXSpacing;
     this->ySpacing = usrYSpacing;
+    this->magnification = 1.0;
+    this->rotation = 0.0;
   }
 
   void CellArray::setStartingPos(CoordPnt newStartingPos) {
@@ -56,14 +59,15 @@ namespace sil {
   void CellArray::setNumCol(int newNumCol) {
     // the magic number 32,767 is from the GDSII standard. No reason
     // was given, but we will adhere to the rule.
-    if (newNumCol > 0 && newNumCol <= 32767)
+    if ((newNumCol > 0 && newNumCol <= GDS_MAX_ARRAY_DIMENSION) ||
+	DeferredValidation::isActive())
       this->numCol = newNumCol;
     else {
       std::stringstream errorMsg;
       errorMsg << "The number of columns may not exceed 32,767, and"
 	       << " must be nonzero. User entered " << newNumCol 
 	       << ".\n";
-      std::invalid_argument(errorMsg.str());
+      throw std::invalid_argument(errorMsg.str());
     }
   }
 
@@ -74,14 +78,15 @@ namespace sil {
   void CellArray::setNumRow(int newNumRow) {
     // the magic number 32,767 is from the GDSII standard. No reason
     // was given, but we will adhere to the rule.
-    if (newNumRow > 0 && newNumRow <= 32767)
+    if ((newNumRow > 0 && newNumRow <= GDS_MAX_ARRAY_DIMENSION) ||
+	DeferredValidation::isActive())
       this->numRow = newNumRow;
     else {
       std::stringstream errorMsg;
       errorMsg << "The number of rows may not exceed 32,767, and"
 	       << " must be nonzero. User entered " << newNumRow 
 	       << ".\n";
-      std::invalid_argument(errorMsg.str());
+      throw std::invalid_argument(errorMsg.str());
     }  
   }
 
@@ -102,19 +107,26 @@ namespace sil {
   }
 
   void CellArray::setMagnification(double newMagnification) {
-    if (newMagnification > 0)
-      this->numRow = newMagnification;
+    if (newMagnification > 0 || DeferredValidation::isActive())
+      this->magnification = newMagnification;
     else {
       std::stringstream errorMsg;
-      errorMsg << "The number of rows may not exceed 32,767, and"
-	       << " must be nonzero. User entered " << newMagnification 
-	       << ".\n";
-      std::invalid_argument(errorMsg.str());
+      errorMsg << "The magnification must be positive. User entered "
+	       << newMagnification << ".\n";
+      throw std::invalid_argument(errorMsg.str());
     }  
   }
 
-  std::string CellArray::getCellname() const {
-    return this->refCell.getCellname();
+  const std::string& CellArray::getCellname() const {
+    return this->refCell->getCellname();
+  }
+
+  const Cell& CellArray::getReferencedCell() const {
+    return *this->refCell;
+  }
+
+  void CellArray::setReferencedCell(const Cell& cell) {
+    this->refCell = &cell;
   }
 
 }
@@ -39,7 +39,7 @@ namespace sil {
   /// changed.
   class CellArray {
   private:
-    Cell& refCell; //!< The actual reference that makes it a cell reference.
+    const Cell* refCell; //!< The actual reference that makes it a cell reference.
     int numCol; //!< The number of times @refCell will be written in the x direction.
     int numRow; //!< The number of times @refCell will be written in the y direction.
     double xSpacing; //!< The spacing between each refCell in the x direction.
@@ -59,7 +59,7 @@ namespace sil {
     /// @usrNumRow The number of rows in the cell array.
     /// @xSpacing The spacing between each column.
     /// @ySpacing The spacing between each row.
-    CellArray(Cell& cell, CoordPnt usrStartingPos, int usrNumCol, 
+    CellArray(const Cell& cell, CoordPnt usrStartingPos, int usrNumCol, 
 	      int usrNumRow, double xSpacing, double ySpacing);
 
     /// \brief Sets the position of the lower left corner to @newStartingPos.
@@ -119,7 +119,15 @@ namespace sil {
     int getNumRow(void) const;
 
     /// \brief Returns the name of the referenced cell.
-    std::string getCellname(void) const;
+    const std::string& getCellname(void) const;
+
+    /// \brief Returns the referenced cell.
+    const Cell& getReferencedCell(void) const;
+
+    /// \brief Makes the array refer to @cell instead.
+    ///
+    /// @cell The cell each element of the array will now be.
+    void setReferencedCell(const Cell& cell);
 
     /// \brief Returns the value of rotation of the array members (in radians).
     double getRotation(void) const;
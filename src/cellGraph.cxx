@@ -0,0 +1,245 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cellGraph.hxx"
+#include "parallel.hxx"
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+namespace sil {
+
+  unsigned int CellGraph::addNode(const Cell* cell) {
+    std::unordered_map<const Cell*, unsigned int>::iterator it =
+      this->index.find(cell);
+    if (it != this->index.end())
+      return it->second;
+    unsigned int node = this->cells.size();
+    this->index[cell] = node;
+    this->cells.push_back(cell);
+    return node;
+  }
+
+  CellGraph::CellGraph(const Layout& layout) {
+    std::vector<Cell*> layoutCells = layout.getCells();
+    for (unsigned int i = 0; i < layoutCells.size(); i++)
+      this->addNode(layoutCells[i]);
+    this->numLayoutCells = this->cells.size();
+    this->build();
+  }
+
+  CellGraph::CellGraph(const Cell& root) {
+    this->addNode(&root);
+    this->numLayoutCells = 1;
+    this->build();
+  }
+
+  void CellGraph::build() {
+    // nodes are appended while their parents are visited, so this also
+    // reaches the cells that were never added to the layout
+    for (unsigned int node = 0; node < this->cells.size(); node++) {
+      std::vector<unsigned int> nodeChildren;
+      CellReferenceList& refs = this->cells[node]->getCellReferenceList();
+      for (unsigned int i = 0; i < refs.size(); i++)
+        nodeChildren.push_back(this->addNode(&refs[i].getReferencedCell()));
+      CellArrayList& arrays = this->cells[node]->getCellArrayList();
+      for (unsigned int i = 0; i < arrays.size(); i++)
+        nodeChildren.push_back(this->addNode(&arrays[i].getReferencedCell()));
+      std::sort(nodeChildren.begin(), nodeChildren.end());
+      nodeChildren.erase(std::unique(nodeChildren.begin(), nodeChildren.end()),
+                         nodeChildren.end());
+      this->children.push_back(nodeChildren);
+    }
+    this->parents.resize(this->cells.size());
+    for (unsigned int node = 0; node < this->cells.size(); node++)
+      for (unsigned int i = 0; i < this->children[node].size(); i++)
+        this->parents[this->children[node][i]].push_back(node);
+
+    // Kahn's algorithm from the leaves up: a node gets its level once
+    // every one of its children has one
+    std::vector<unsigned int> pending(this->cells.size());
+    std::vector<unsigned int> height(this->cells.size(), 0);
+    std::vector<unsigned int> ready;
+    for (unsigned int node = 0; node < this->cells.size(); node++) {
+      pending[node] = this->children[node].size();
+      if (pending[node] == 0)
+        ready.push_back(node);
+    }
+    std::size_t numPlaced = 0;
+    while (!ready.empty()) {
+      unsigned int node = ready.back();
+      ready.pop_back();
+      numPlaced++;
+      if (this->levels.size() <= height[node])
+        this->levels.resize(height[node] + 1);
+      this->levels[height[node]].push_back(node);
+      for (unsigned int i = 0; i < this->parents[node].size(); i++) {
+        unsigned int parent = this->parents[node][i];
+        height[parent] = std::max(height[parent], height[node] + 1);
+        if (--pending[parent] == 0)
+          ready.push_back(parent);
+      }
+    }
+    for (unsigned int level = 0; level < this->levels.size(); level++)
+      std::sort(this->levels[level].begin(), this->levels[level].end());
+
+    if (numPlaced == this->cells.size())
+      return;
+    // Every node that never got a level has a child without one, so
+    // following such children from any of them must run into a cycle.
+    unsigned int node = 0;
+    while (pending[node] == 0)
+      node++;
+    std::vector<int> position(this->cells.size(), -1);
+    std::vector<unsigned int> walk;
+    while (position[node] < 0) {
+      position[node] = walk.size();
+      walk.push_back(node);
+      for (unsigned int i = 0; i < this->children[node].size(); i++)
+        if (pending[this->children[node][i]] > 0) {
+          node = this->children[node][i];
+          break;
+        }
+    }
+    this->cycle.assign(walk.begin() + position[node], walk.end());
+  }
+
+  std::size_t CellGraph::size() const {
+    return this->cells.size();
+  }
+
+  std::size_t CellGraph::getLayoutCellCount() const {
+    return this->numLayoutCells;
+  }
+
+  const Cell& CellGraph::getCell(unsigned int node) const {
+    return *this->cells.at(node);
+  }
+
+  unsigned int CellGraph::getNode(const Cell& cell) const {
+    std::unordered_map<const Cell*, unsigned int>::const_iterator it =
+      this->index.find(&cell);
+    if (it == this->index.end()) {
+      std::stringstream errorMsg;
+      errorMsg << "The cell " << cell.getCellname()
+               << " is not part of the hierarchy.\n";
+      throw std::out_of_range(errorMsg.str());
+    }
+    return it->second;
+  }
+
+  const std::vector<unsigned int>& CellGraph::getChildren(unsigned int node) const {
+    return this->children.at(node);
+  }
+
+  const std::vector<unsigned int>& CellGraph::getParents(unsigned int node) const {
+    return this->parents.at(node);
+  }
+
+  bool CellGraph::hasCycle() const {
+    return !this->cycle.empty();
+  }
+
+  const std::vector<unsigned int>& CellGraph::getCycle() const {
+    return this->cycle;
+  }
+
+  void CellGraph::throwIfCyclic() const {
+    if (this->cycle.empty())
+      return;
+    std::stringstream errorMsg;
+    errorMsg << "The cell " << this->cells[this->cycle[0]]->getCellname()
+             << " places itself:";
+    for (unsigned int i = 0; i < this->cycle.size(); i++)
+      errorMsg << " " << this->cells[this->cycle[i]]->getCellname() << " ->";
+    errorMsg << " " << this->cells[this->cycle[0]]->getCellname() << ".\n";
+    throw std::logic_error(errorMsg.str());
+  }
+
+  std::vector<unsigned int> CellGraph::topologicalOrder() const {
+    this->throwIfCyclic();
+    std::vector<unsigned int> order;
+    order.reserve(this->cells.size());
+    for (unsigned int level = 0; level < this->levels.size(); level++)
+      order.insert(order.end(), this->levels[level].begin(), this->levels[level].end());
+    return order;
+  }
+
+  const std::vector<std::vector<unsigned int> >& CellGraph::getLevels() const {
+    this->throwIfCyclic();
+    return this->levels;
+  }
+
+  std::vector<unsigned int> CellGraph::topCells() const {
+    std::vector<unsigned int> tops;
+    for (unsigned int node = 0; node < this->cells.size(); node++)
+      if (this->parents[node].empty())
+        tops.push_back(node);
+    return tops;
+  }
+
+  std::vector<bool> CellGraph::reachableFrom(const std::vector<unsigned int>& tops) const {
+    std::vector<bool> reached(this->cells.size(), false);
+    std::vector<unsigned int> stack;
+    for (unsigned int i = 0; i < tops.size(); i++)
+      if (!reached.at(tops[i])) {
+        reached[tops[i]] = true;
+        stack.push_back(tops[i]);
+      }
+    while (!stack.empty()) {
+      unsigned int node = stack.back();
+      stack.pop_back();
+      for (unsigned int i = 0; i < this->children[node].size(); i++)
+        if (!reached[this->children[node][i]]) {
+          reached[this->children[node][i]] = true;
+          stack.push_back(this->children[node][i]);
+        }
+    }
+    return reached;
+  }
+
+  void CellGraph::parallelBottomUp(const std::function<void(unsigned int)>& body) const {
+    const std::vector<std::vector<unsigned int> >& nodeLevels = this->getLevels();
+    for (unsigned int level = 0; level < nodeLevels.size(); level++) {
+      const std::vector<unsigned int>& nodes = nodeLevels[level];
+      utils::parallelFor(nodes.size(), [&](std::size_t i) { body(nodes[i]); });
+    }
+  }
+
+  void CellGraph::parallelTopDown(const std::function<void(unsigned int)>& body) const {
+    const std::vector<std::vector<unsigned int> >& nodeLevels = this->getLevels();
+    for (std::size_t level = nodeLevels.size(); level-- > 0;) {
+      const std::vector<unsigned int>& nodes = nodeLevels[level];
+      utils::parallelFor(nodes.size(), [&](std::size_t i) { body(nodes[i]); });
+    }
+  }
+
+  unsigned int pruneUnreachableCells(Layout& layout,
+                                     const std::vector<const Cell*>& tops) {
+    CellGraph graph(layout);
+    std::vector<unsigned int> topNodes;
+    for (unsigned int i = 0; i < tops.size(); i++)
+      topNodes.push_back(graph.getNode(*tops[i]));
+    std::vector<bool> reached = graph.reachableFrom(topNodes);
+    std::vector<const Cell*> unreachable;
+    for (unsigned int node = 0; node < graph.getLayoutCellCount(); node++)
+      if (!reached[node])
+        unreachable.push_back(&graph.getCell(node));
+    layout.removeCells(unreachable);
+    return unreachable.size();
+  }
+
+}
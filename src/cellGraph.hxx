@@ -0,0 +1,140 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CELL_GRAPH_HXX
+#define CELL_GRAPH_HXX
+
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include "cell.hxx"
+#include "layout.hxx"
+
+namespace sil {
+
+  /// class CellGraph
+  ///
+  /// \brief The hierarchy of a Layout as a directed graph.
+  ///
+  /// Every Cell is a node, identified by an index, and every Cell it
+  /// places through a CellReference or CellArray is one of its children.
+  /// The cells of the Layout come first, in the order of
+  /// Layout::getCells() with a Cell that was added more than once only
+  /// at its first position, followed by any cells they reference that
+  /// were never added to the Layout. The graph is a snapshot: it does not see
+  /// changes made to the hierarchy after it was built.
+  class CellGraph {
+  private:
+    std::vector<const Cell*> cells; //!< The Cell of each node.
+    std::unordered_map<const Cell*, unsigned int> index; //!< The node of each Cell.
+    std::size_t numLayoutCells; //!< The number of nodes that belong to the Layout.
+    std::vector<std::vector<unsigned int> > children; //!< The distinct children of each node.
+    std::vector<std::vector<unsigned int> > parents; //!< The distinct parents of each node.
+    std::vector<std::vector<unsigned int> > levels; //!< The nodes grouped by height, leaves first.
+    std::vector<unsigned int> cycle; //!< A cycle of the hierarchy, empty if there is none.
+
+    /// \brief Returns the node of @cell, adding it if it is new.
+    unsigned int addNode(const Cell* cell);
+
+    /// \brief Adds the cells placed by the nodes added so far and links
+    /// and levels every node.
+    void build(void);
+
+    /// \brief Throws std::logic_error naming the cells of @cycle.
+    void throwIfCyclic(void) const;
+
+  public:
+    /// \brief Builds the graph of @layout.
+    CellGraph(const Layout& layout);
+
+    /// \brief Builds the graph of @root and the cells it places, as if
+    /// @root were the only Cell of a Layout. @root is node 0.
+    explicit CellGraph(const Cell& root);
+
+    /// \brief Returns the number of nodes.
+    std::size_t size(void) const;
+
+    /// \brief Returns the number of nodes that belong to the Layout.
+    ///
+    /// These are nodes 0 to getLayoutCellCount() - 1.
+    std::size_t getLayoutCellCount(void) const;
+
+    /// \brief Returns the Cell of node @node.
+    const Cell& getCell(unsigned int node) const;
+
+    /// \brief Returns the node of @cell, throwing std::out_of_range if
+    /// @cell is not in the graph.
+    unsigned int getNode(const Cell& cell) const;
+
+    /// \brief Returns the distinct cells placed by node @node.
+    const std::vector<unsigned int>& getChildren(unsigned int node) const;
+
+    /// \brief Returns the distinct cells that place node @node.
+    const std::vector<unsigned int>& getParents(unsigned int node) const;
+
+    /// \brief Returns true if some Cell (indirectly) places itself.
+    bool hasCycle(void) const;
+
+    /// \brief Returns the nodes of a cycle, each placing the next and
+    /// the last placing the first, or nothing if there is no cycle.
+    const std::vector<unsigned int>& getCycle(void) const;
+
+    /// \brief Returns the nodes ordered so that every Cell comes after
+    /// all of the cells it places.
+    ///
+    /// Throws std::logic_error if the hierarchy has a cycle.
+    std::vector<unsigned int> topologicalOrder(void) const;
+
+    /// \brief Returns the nodes grouped by their height in the
+    /// hierarchy. Level 0 holds the cells that place nothing, level n
+    /// the cells whose deepest child is on level n - 1.
+    ///
+    /// Throws std::logic_error if the hierarchy has a cycle.
+    const std::vector<std::vector<unsigned int> >& getLevels(void) const;
+
+    /// \brief Returns the nodes that no other Cell places.
+    std::vector<unsigned int> topCells(void) const;
+
+    /// \brief Returns, for every node, whether it is one of @tops or is
+    /// placed (indirectly) by one of them.
+    std::vector<bool> reachableFrom(const std::vector<unsigned int>& tops) const;
+
+    /// \brief Calls @body for every node, one level at a time from the
+    /// leaves up, with the nodes of a level processed in parallel.
+    ///
+    /// A node is only processed after all of its children, so @body
+    /// may read the results of the children of its node. It must be safe
+    /// to call concurrently for different nodes. Throws std::logic_error
+    /// if the hierarchy has a cycle.
+    void parallelBottomUp(const std::function<void(unsigned int)>& body) const;
+
+    /// \brief Like parallelBottomUp() but from the top level down, so
+    /// every node is processed after all of its parents.
+    void parallelTopDown(const std::function<void(unsigned int)>& body) const;
+  };
+
+  /// \brief Removes the cells of @layout that none of @tops place,
+  /// directly or indirectly, and returns how many were removed.
+  ///
+  /// @layout The Layout to prune.
+  /// @tops The cells to keep along with everything they place.
+  unsigned int pruneUnreachableCells(Layout& layout,
+                                     const std::vector<const Cell*>& tops);
+
+}
+
+#endif // CELL_GRAPH_HXX
@@ -20,21 +20,21 @@
 namespace sil {
 
   CellReference::CellReference(Cell& referenceCell, int centerX, 
-			       int centerY) : refCell(referenceCell) {
+			       int centerY) : refCell(&referenceCell) {
     this->center = CoordPnt(centerX, centerY);
     this->magnification = 1.0;
     this->rotation = 0.0;
   }
 
   CellReference::CellReference(Cell& referenceCell) :
-    refCell(referenceCell) {
+    refCell(&referenceCell) {
     this->center = CoordPnt(0, 0);
     this->magnification = 1.0;
     this->rotation = 0.0;
   }
 
   CellReference::CellReference(Cell& referenceCell, CoordPnt centerPnt) :
-    refCell(referenceCell) {
+    refCell(&referenceCell) {
     this->center = centerPnt;
     this->magnification = 1.0;
     this->rotation = 0.0;
@@ -43,7 +43,7 @@ namespace sil {
 
   std::vector<CoordPnt> CellReference::findVertices(void) {
     std::vector<CoordPnt> boundingVertex;
-    std::vector<Polygon> polygonVec = this->refCell.getPolygonList();
+    const PolygonList& polygonVec = this->refCell->getPolygonList();
     double totMax = std::numeric_limits<double>::max();
     double totMin = std::numeric_limits<double>::min();
     double minX = totMax;
@@ -51,10 +51,10 @@ namespace sil {
     double maxX = totMin;
     double maxY = totMin;
     // find the minimum and maximum values of x and y coordinates
-    for(std::vector<Polygon>::iterator polyIt = polygonVec.begin(); 
+    for(PolygonList::const_iterator polyIt = polygonVec.begin(); 
 	polyIt != polygonVec.end(); ++polyIt) {
-      std::vector<CoordPnt> vertexVec = polyIt->getVertices();
-      for (std::vector<CoordPnt>::iterator vertIt = vertexVec.begin();
+      BoxList vertexVec = polyIt->getBoundingBox();
+      for (BoxList::const_iterator vertIt = vertexVec.begin();
 	   vertIt != vertexVec.end(); ++vertIt) {
 	if (vertIt->getX() > maxX)
 	  maxX = vertIt->getX();
@@ -104,7 +104,15 @@ namespace sil {
     this->center = newCenter;
   }
 
-  std::string CellReference::getCellname() const {
-    return this->refCell.getCellname();
+  const std::string& CellReference::getCellname() const {
+    return this->refCell->getCellname();
+  }
+
+  const Cell& CellReference::getReferencedCell() const {
+    return *this->refCell;
+  }
+
+  void CellReference::setReferencedCell(const Cell& cell) {
+    this->refCell = &cell;
   }
 }
@@ -29,7 +29,7 @@ class Cell;
 
 class CellReference {
 private:
-  const Cell& refCell;
+  const Cell* refCell;
   std::vector<CoordPnt> findVertices(void);
   CoordPnt center;
 
@@ -55,7 +55,12 @@ public:
 
   void setCenter(CoordPnt newCenter);
 
-  std::string getCellname(void) const;
+  const std::string& getCellname(void) const;
+
+  const Cell& getReferencedCell(void) const;
+
+  /// \brief Makes this CellReference refer to @cell instead.
+  void setReferencedCell(const Cell& cell);
 
 };
 
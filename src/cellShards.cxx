@@ -0,0 +1,94 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "cellShards.hxx"
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+namespace sil {
+
+  CellShard::CellShard(std::pmr::memory_resource* resource) :
+    polyList(resource), pathList(resource), cellReferenceList(resource),
+    cellArrayList(resource) {}
+
+  void CellShard::addPolygon(Polygon usrPolygon) {
+    this->polyList.push_back(std::move(usrPolygon));
+  }
+
+  void CellShard::addPath(Path usrPath) {
+    this->pathList.push_back(std::move(usrPath));
+  }
+
+  void CellShard::addCellReference(CellReference usrCellReference) {
+    this->cellReferenceList.push_back(std::move(usrCellReference));
+  }
+
+  void CellShard::addCellArray(CellArray usrCellArray) {
+    this->cellArrayList.push_back(std::move(usrCellArray));
+  }
+
+  std::size_t CellShard::size() const {
+    return this->polyList.size() + this->pathList.size() +
+      this->cellReferenceList.size() + this->cellArrayList.size();
+  }
+
+  CellShards::CellShards(Cell& usrCell, std::size_t shardCount) : cell(usrCell) {
+    this->shards.reserve(shardCount);
+    for (std::size_t i = 0; i < shardCount; i++)
+      this->shards.push_back(CellShard(usrCell.getMemoryResource()));
+  }
+
+  std::size_t CellShards::getShardCount() const {
+    return this->shards.size();
+  }
+
+  CellShard& CellShards::getShard(std::size_t index) {
+    if (index >= this->shards.size()) {
+      std::stringstream errorMsg;
+      errorMsg << "Shard " << index << " requested but there are only "
+               << this->shards.size() << " shards.";
+      throw std::out_of_range(errorMsg.str());
+    }
+    return this->shards[index];
+  }
+
+  // Moves the elements of every shard's @member list to the end of
+  // @target, in shard order.
+  template <typename List>
+  static void moveShards(std::vector<CellShard>& shards, List CellShard::* member,
+                         List& target) {
+    std::size_t total = target.size();
+    for (std::size_t i = 0; i < shards.size(); i++)
+      total += (shards[i].*member).size();
+    target.reserve(total);
+    for (std::size_t i = 0; i < shards.size(); i++) {
+      List& source = shards[i].*member;
+      target.insert(target.end(), std::make_move_iterator(source.begin()),
+                    std::make_move_iterator(source.end()));
+      source.clear();
+    }
+  }
+
+  void CellShards::commit() {
+    moveShards(this->shards, &CellShard::polyList, this->cell.getPolygonList());
+    moveShards(this->shards, &CellShard::pathList, this->cell.getPathList());
+    moveShards(this->shards, &CellShard::cellReferenceList, this->cell.getCellReferenceList());
+    moveShards(this->shards, &CellShard::cellArrayList, this->cell.getCellArrayList());
+  }
+
+} // namespace sil
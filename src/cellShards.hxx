@@ -0,0 +1,127 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef CELL_SHARDS_HXX
+#define CELL_SHARDS_HXX
+
+#include <cstddef>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+#include "cell.hxx"
+
+namespace sil {
+
+  /// \brief A buffer of elements that one thread adds to a Cell, see
+  /// CellShards.
+  ///
+  /// The interface mirrors the adding half of Cell. A CellShard must only
+  /// be used by one thread at a time, but different shards may be filled
+  /// concurrently without any locking.
+  class alignas(64) CellShard {
+  private:
+    PolygonList polyList; //!< The polygons added to this shard.
+    PathList pathList; //!< The paths added to this shard.
+    CellReferenceList cellReferenceList; //!< The references added to this shard.
+    CellArrayList cellArrayList; //!< The arrays added to this shard.
+
+    friend class CellShards;
+
+  public:
+    /// \brief Creates an empty shard whose elements allocate from
+    /// @resource.
+    explicit CellShard(std::pmr::memory_resource* resource);
+
+    void addPolygon(Polygon usrPolygon);
+
+    /// \brief See Cell::emplacePolygon().
+    template <typename... Args>
+    Polygon& emplacePolygon(Args&&... args) {
+      this->polyList.emplace_back(std::forward<Args>(args)...);
+      return this->polyList.back();
+    }
+
+    void addPath(Path usrPath);
+
+    /// \brief See Cell::emplacePath().
+    template <typename... Args>
+    Path& emplacePath(Args&&... args) {
+      this->pathList.emplace_back(std::forward<Args>(args)...);
+      return this->pathList.back();
+    }
+
+    void addCellReference(CellReference usrCellReference);
+
+    void addCellArray(CellArray usrCellArray);
+
+    /// \brief Returns the number of elements waiting to be committed.
+    std::size_t size(void) const;
+  };
+
+  /// \brief Lets many threads add elements to one Cell at once.
+  ///
+  /// Every thread adds to its own CellShard, so generating the contents
+  /// of a single large Cell scales with the number of threads. commit()
+  /// then moves the buffered elements into the Cell in the order of the
+  /// shard indices, so the result does not depend on how the threads
+  /// were scheduled:
+  ///
+  ///   sil::CellShards shards(cell, numRows);
+  ///   sil::utils::parallelFor(numRows, [&](std::size_t row) {
+  ///       sil::CellShard& shard = shards.getShard(row);
+  ///       ... shard.emplacePolygon(...) ...
+  ///     });
+  ///   shards.commit();
+  ///
+  /// The Cell itself must not be changed while the shards are filled.
+  /// Elements that were not committed are dropped with the CellShards.
+  class CellShards {
+  private:
+    Cell& cell; //!< The Cell that commit() adds to.
+    std::vector<CellShard> shards; //!< The buffers, by index.
+
+  public:
+    /// \brief Creates @shardCount empty shards for @usrCell.
+    ///
+    /// The shards allocate from the memory resource of @usrCell, so
+    /// committing moves the elements without copying their vertices.
+    /// With an Arena each thread bumps a block of its own, so the
+    /// threads filling the shards do not contend for it.
+    CellShards(Cell& usrCell, std::size_t shardCount);
+
+    CellShards(const CellShards&) = delete;
+    CellShards& operator=(const CellShards&) = delete;
+
+    /// \brief Returns the number of shards.
+    std::size_t getShardCount(void) const;
+
+    /// \brief Returns the shard with @index, which throws
+    /// std::out_of_range if it is not below getShardCount().
+    CellShard& getShard(std::size_t index);
+
+    /// \brief Appends the elements of every shard to the Cell, shard 0
+    /// first, and empties the shards.
+    ///
+    /// Each list of the Cell grows at most once and the elements are
+    /// moved, so this costs little next to creating them. The shards
+    /// keep their memory and may be filled and committed again.
+    void commit(void);
+  };
+
+} // namespace sil
+
+#endif // CELL_SHARDS_HXX
@@ -0,0 +1,428 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "connectivity.hxx"
+#include "geometry.hxx"
+#include "parallel.hxx"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+namespace sil {
+
+  void LayerStack::addConductor(int layer) {
+    std::vector<int>::iterator it = std::lower_bound(this->layers.begin(), this->layers.end(), layer);
+    if (it != this->layers.end() && *it == layer)
+      return;
+    this->layers.insert(it, layer);
+    std::pair<int, int> self(layer, layer);
+    this->connections.insert(std::lower_bound(this->connections.begin(), this->connections.end(),
+                                              self), self);
+  }
+
+  void LayerStack::addVia(int viaLayer, int lowerLayer, int upperLayer) {
+    this->addConductor(viaLayer);
+    this->addConductor(lowerLayer);
+    this->addConductor(upperLayer);
+    int others[2] = {lowerLayer, upperLayer};
+    for (int i = 0; i < 2; i++) {
+      std::pair<int, int> pair(std::min(viaLayer, others[i]), std::max(viaLayer, others[i]));
+      std::vector<std::pair<int, int> >::iterator it =
+        std::lower_bound(this->connections.begin(), this->connections.end(), pair);
+      if (it == this->connections.end() || *it != pair)
+        this->connections.insert(it, pair);
+    }
+  }
+
+  const std::vector<int>& LayerStack::getLayers() const {
+    return this->layers;
+  }
+
+  const std::vector<std::pair<int, int> >& LayerStack::getConnections() const {
+    return this->connections;
+  }
+
+  bool LayerStack::connects(int layerA, int layerB) const {
+    return std::binary_search(this->connections.begin(), this->connections.end(),
+                              std::make_pair(std::min(layerA, layerB), std::max(layerA, layerB)));
+  }
+
+  namespace {
+
+    /// \brief The number of shapes one task looks up neighbours for.
+    const std::size_t SHAPES_PER_TASK = 4096;
+
+    /// \brief A union-find over shape indices that any number of threads
+    /// may merge into at once.
+    ///
+    /// Roots are only ever linked below smaller roots with a compare and
+    /// swap, so every set is represented by its smallest element and no
+    /// lock is needed; finds halve the paths they walk.
+    class ConcurrentUnionFind {
+    private:
+      std::unique_ptr<std::atomic<unsigned int>[]> parent;
+
+    public:
+      explicit ConcurrentUnionFind(std::size_t size) :
+        parent(new std::atomic<unsigned int>[size]) {
+        for (std::size_t i = 0; i < size; i++)
+          this->parent[i].store(i, std::memory_order_relaxed);
+      }
+
+      unsigned int find(unsigned int x) {
+        while (true) {
+          unsigned int up = this->parent[x].load(std::memory_order_relaxed);
+          if (up == x)
+            return x;
+          unsigned int next = this->parent[up].load(std::memory_order_relaxed);
+          if (next != up)
+            this->parent[x].compare_exchange_weak(up, next, std::memory_order_relaxed);
+          x = next;
+        }
+      }
+
+      void unite(unsigned int a, unsigned int b) {
+        while (true) {
+          a = this->find(a);
+          b = this->find(b);
+          if (a == b)
+            return;
+          if (a < b)
+            std::swap(a, b);
+          unsigned int expected = a;
+          if (this->parent[a].compare_exchange_strong(expected, b, std::memory_order_relaxed))
+            return;
+        }
+      }
+    };
+
+    /// \brief A cell placed in the flattened cell.
+    struct Instance {
+      unsigned int cell;
+      utils::Transform transform;
+    };
+
+    /// \brief Returns the number of non degenerate segments of @points.
+    std::size_t segmentCount(Span<const CoordPnt> points) {
+      std::size_t count = 0;
+      for (std::size_t i = 1; i < points.size(); i++)
+        if (points[i].getX() != points[i - 1].getX() || points[i].getY() != points[i - 1].getY())
+          count++;
+      return count;
+    }
+
+  } // namespace
+
+  Connectivity::Connectivity(const FrozenLayout& layout, unsigned int topCell,
+                             const LayerStack& stack) : layers(stack.getLayers()) {
+    layout.getCell(topCell); // throws if there is no such cell
+    std::size_t numSlots = this->layers.size();
+    std::size_t numCells = layout.getCellCount();
+
+    // the pieces and vertices every cell adds on each layer itself
+    std::vector<std::size_t> ownPieces(numCells*numSlots, 0);
+    std::vector<std::size_t> ownVertices(numCells*numSlots, 0);
+    std::vector<char> relevant(numCells, 0);
+    Span<const unsigned int> order = layout.getHierarchicalOrder();
+    for (std::size_t i = 0; i < order.size(); i++) {
+      unsigned int cell = order[i];
+      const FrozenCell& frozen = layout.getCell(cell);
+      for (std::size_t j = 0; j < frozen.polygons.size(); j++) {
+        std::size_t slot = this->layerSlot(frozen.polygons[j].layer);
+        if (slot < numSlots) {
+          ownPieces[cell*numSlots + slot]++;
+          ownVertices[cell*numSlots + slot] += frozen.polygons[j].vertices.size();
+        }
+      }
+      for (std::size_t j = 0; j < frozen.paths.size(); j++) {
+        std::size_t slot = this->layerSlot(frozen.paths[j].layer);
+        if (slot < numSlots) {
+          std::size_t segments = segmentCount(frozen.paths[j].points);
+          ownPieces[cell*numSlots + slot] += segments;
+          ownVertices[cell*numSlots + slot] += 4*segments;
+        }
+      }
+      for (std::size_t slot = 0; slot < numSlots; slot++)
+        relevant[cell] = relevant[cell] || ownPieces[cell*numSlots + slot] > 0;
+      for (std::size_t j = 0; j < frozen.children.size(); j++)
+        relevant[cell] = relevant[cell] || relevant[frozen.children[j]];
+    }
+
+    // every placement of a cell with conducting shapes
+    std::vector<Instance> instances;
+    std::vector<Instance> pending(1);
+    pending[0].cell = topCell;
+    while (!pending.empty()) {
+      Instance instance = pending.back();
+      pending.pop_back();
+      if (!relevant[instance.cell])
+        continue;
+      instances.push_back(instance);
+      const FrozenCell& frozen = layout.getCell(instance.cell);
+      for (std::size_t j = 0; j < frozen.references.size(); j++) {
+        const FrozenReference& ref = frozen.references[j];
+        Instance child = {ref.cell, instance.transform.after(
+            utils::Transform(ref.magnification, ref.rotation, ref.position))};
+        pending.push_back(child);
+      }
+      for (std::size_t j = 0; j < frozen.arrays.size(); j++) {
+        const FrozenArray& array = frozen.arrays[j];
+        if (!relevant[array.cell])
+          continue;
+        utils::Transform first(array.magnification, array.rotation, array.startingPos);
+        for (int col = 0; col < array.numCol; col++)
+          for (int row = 0; row < array.numRow; row++) {
+            Instance child = {array.cell, instance.transform.after(
+                first.shifted(col*array.xSpacing, row*array.ySpacing))};
+            pending.push_back(child);
+          }
+      }
+    }
+
+    // where each instance writes its shapes, layer by layer
+    std::size_t numInstances = instances.size();
+    std::vector<std::size_t> shapeOffset(numSlots*numInstances);
+    std::vector<std::size_t> vertexOffset(numSlots*numInstances);
+    std::size_t numShapes = 0, numVertices = 0;
+    this->layerStart.push_back(0);
+    for (std::size_t slot = 0; slot < numSlots; slot++) {
+      for (std::size_t i = 0; i < numInstances; i++) {
+        shapeOffset[slot*numInstances + i] = numShapes;
+        vertexOffset[slot*numInstances + i] = numVertices;
+        numShapes += ownPieces[instances[i].cell*numSlots + slot];
+        numVertices += ownVertices[instances[i].cell*numSlots + slot];
+      }
+      this->layerStart.push_back(numShapes);
+    }
+    if (numShapes >= UINT_MAX) {
+      std::stringstream errorMsg;
+      errorMsg << "The flattened cell has " << numShapes << " shapes, more than "
+               << "connectivity extraction supports.";
+      throw std::length_error(errorMsg.str());
+    }
+    this->coordinates.resize(numVertices);
+    this->shapes.resize(numShapes);
+    std::vector<Bounds> bounds(numShapes);
+
+    utils::parallelFor(numInstances, [&](std::size_t i) {
+        const Instance& instance = instances[i];
+        const FrozenCell& frozen = layout.getCell(instance.cell);
+        std::vector<std::size_t> nextShape(numSlots), nextVertex(numSlots);
+        for (std::size_t slot = 0; slot < numSlots; slot++) {
+          nextShape[slot] = shapeOffset[slot*numInstances + i];
+          nextVertex[slot] = vertexOffset[slot*numInstances + i];
+        }
+        for (std::size_t j = 0; j < frozen.polygons.size(); j++) {
+          const FrozenPolygon& polygon = frozen.polygons[j];
+          std::size_t slot = this->layerSlot(polygon.layer);
+          if (slot >= numSlots)
+            continue;
+          CoordPnt* target = &this->coordinates[nextVertex[slot]];
+          Bounds& box = bounds[nextShape[slot]];
+          for (std::size_t k = 0; k < polygon.vertices.size(); k++) {
+            target[k] = instance.transform.apply(polygon.vertices[k]);
+            box.add(target[k]);
+          }
+          FlatShape& shape = this->shapes[nextShape[slot]++];
+          shape.vertices = Span<const CoordPnt>(target, polygon.vertices.size());
+          shape.layer = polygon.layer;
+          shape.cell = instance.cell;
+          shape.element = j;
+          shape.fromPath = false;
+          shape.rectangle = (polygon.shapeClass & Polygon::RECTANGLE) &&
+            instance.transform.keepsAxes();
+          nextVertex[slot] += polygon.vertices.size();
+        }
+        double magnification = std::hypot(instance.transform.a, instance.transform.b);
+        for (std::size_t j = 0; j < frozen.paths.size(); j++) {
+          const FrozenPath& path = frozen.paths[j];
+          std::size_t slot = this->layerSlot(path.layer);
+          if (slot >= numSlots)
+            continue;
+          double half = path.width*magnification/2.;
+          std::size_t numPoints = path.points.size();
+          for (std::size_t k = 1; k < numPoints; k++) {
+            CoordPnt p0 = instance.transform.apply(path.points[k - 1]);
+            CoordPnt p1 = instance.transform.apply(path.points[k]);
+            if (path.points[k].getX() == path.points[k - 1].getX() &&
+                path.points[k].getY() == path.points[k - 1].getY())
+              continue;
+            // segments reach into the bends, and past the ends unless flush
+            double before = (k > 1 || path.pathType != 0) ? half : 0;
+            double after = (k + 1 < numPoints || path.pathType != 0) ? half : 0;
+            CoordPnt* target = &this->coordinates[nextVertex[slot]];
+            utils::pathSegmentQuad(p0, p1, half, before, after, target);
+            Bounds& box = bounds[nextShape[slot]];
+            for (int v = 0; v < 4; v++)
+              box.add(target[v]);
+            FlatShape& shape = this->shapes[nextShape[slot]++];
+            shape.vertices = Span<const CoordPnt>(target, 4);
+            shape.layer = path.layer;
+            shape.cell = instance.cell;
+            shape.element = j;
+            shape.fromPath = true;
+            shape.rectangle = p0.getX() == p1.getX() || p0.getY() == p1.getY();
+            nextVertex[slot] += 4;
+          }
+        }
+      });
+
+    this->indices.resize(numSlots);
+    utils::parallelFor(numSlots, [&](std::size_t slot) {
+        this->indices[slot] = SpatialIndex(std::vector<Bounds>(
+            bounds.begin() + this->layerStart[slot], bounds.begin() + this->layerStart[slot + 1]));
+      });
+    bounds.clear();
+    bounds.shrink_to_fit();
+
+    // merge the touching shapes of every pair of connected layers
+    ConcurrentUnionFind sets(numShapes);
+    struct Task {
+      std::size_t from; //!< The slot whose shapes look up neighbours.
+      std::size_t to; //!< The slot they are looked up in.
+      std::size_t first; //!< The first shape of the task in @from.
+    };
+    std::vector<Task> tasks;
+    const std::vector<std::pair<int, int> >& connections = stack.getConnections();
+    for (std::size_t c = 0; c < connections.size(); c++) {
+      std::size_t from = this->layerSlot(connections[c].first);
+      std::size_t to = this->layerSlot(connections[c].second);
+      for (std::size_t first = this->layerStart[from]; first < this->layerStart[from + 1];
+           first += SHAPES_PER_TASK) {
+        Task task = {from, to, first};
+        tasks.push_back(task);
+      }
+    }
+    utils::parallelFor(tasks.size(), [&](std::size_t t) {
+        const Task& task = tasks[t];
+        std::size_t last = std::min(task.first + SHAPES_PER_TASK, this->layerStart[task.from + 1]);
+        std::vector<unsigned int> found;
+        for (std::size_t i = task.first; i < last; i++) {
+          const FlatShape& shape = this->shapes[i];
+          const Bounds& box = this->getBounds(i);
+          found.clear();
+          this->indices[task.to].query(box, found);
+          for (std::size_t k = 0; k < found.size(); k++) {
+            std::size_t other = this->layerStart[task.to] + found[k];
+            if (task.from == task.to && other <= i)
+              continue;
+            const FlatShape& otherShape = this->shapes[other];
+            if ((shape.rectangle && otherShape.rectangle) ||
+                utils::polygonsTouch(shape.vertices, box, otherShape.vertices,
+                                     this->indices[task.to].getBounds(found[k])))
+              sets.unite(i, other);
+          }
+        }
+      });
+
+    // number the nets by their first shape, which is the root of its set
+    std::vector<unsigned int> roots(numShapes);
+    utils::parallelFor((numShapes + SHAPES_PER_TASK - 1)/SHAPES_PER_TASK, [&](std::size_t t) {
+        std::size_t last = std::min(numShapes, (t + 1)*SHAPES_PER_TASK);
+        for (std::size_t i = t*SHAPES_PER_TASK; i < last; i++)
+          roots[i] = sets.find(i);
+      });
+    this->nets.resize(numShapes);
+    unsigned int numNets = 0;
+    for (std::size_t i = 0; i < numShapes; i++)
+      this->nets[i] = roots[i] == i ? numNets++ : this->nets[roots[i]];
+    this->netStart.assign(numNets + 1, 0);
+    for (std::size_t i = 0; i < numShapes; i++)
+      this->netStart[this->nets[i] + 1]++;
+    for (std::size_t net = 0; net < numNets; net++)
+      this->netStart[net + 1] += this->netStart[net];
+    this->netShapes.resize(numShapes);
+    std::vector<unsigned int> fill(this->netStart.begin(), this->netStart.end() - 1);
+    for (std::size_t i = 0; i < numShapes; i++)
+      this->netShapes[fill[this->nets[i]]++] = i;
+  }
+
+  std::size_t Connectivity::layerSlot(int layer) const {
+    std::vector<int>::const_iterator it =
+      std::lower_bound(this->layers.begin(), this->layers.end(), layer);
+    if (it == this->layers.end() || *it != layer)
+      return this->layers.size();
+    return it - this->layers.begin();
+  }
+
+  std::size_t Connectivity::getShapeCount() const {
+    return this->shapes.size();
+  }
+
+  const FlatShape& Connectivity::getShape(std::size_t index) const {
+    if (index >= this->shapes.size()) {
+      std::stringstream errorMsg;
+      errorMsg << "There is no shape " << index << ", there are "
+               << this->shapes.size() << " shapes.";
+      throw std::out_of_range(errorMsg.str());
+    }
+    return this->shapes[index];
+  }
+
+  const Bounds& Connectivity::getBounds(std::size_t index) const {
+    this->getShape(index);
+    std::size_t slot = std::upper_bound(this->layerStart.begin(), this->layerStart.end(), index) -
+      this->layerStart.begin() - 1;
+    return this->indices[slot].getBounds(index - this->layerStart[slot]);
+  }
+
+  std::size_t Connectivity::getNetCount() const {
+    return this->netStart.empty() ? 0 : this->netStart.size() - 1;
+  }
+
+  unsigned int Connectivity::getNet(std::size_t index) const {
+    this->getShape(index);
+    return this->nets[index];
+  }
+
+  Span<const unsigned int> Connectivity::getNetShapes(unsigned int net) const {
+    if (net >= this->getNetCount()) {
+      std::stringstream errorMsg;
+      errorMsg << "There is no net " << net << ", there are "
+               << this->getNetCount() << " nets.";
+      throw std::out_of_range(errorMsg.str());
+    }
+    return Span<const unsigned int>(this->netShapes.data() + this->netStart[net],
+                                    this->netStart[net + 1] - this->netStart[net]);
+  }
+
+  unsigned int Connectivity::findNet(const CoordPnt& pnt, int layer) const {
+    std::size_t slot = this->layerSlot(layer);
+    if (slot >= this->layers.size())
+      return NO_NET;
+    std::vector<unsigned int> found;
+    this->indices[slot].query(Bounds(pnt.getX(), pnt.getY(), pnt.getX(), pnt.getY()), found);
+    std::sort(found.begin(), found.end());
+    for (std::size_t i = 0; i < found.size(); i++) {
+      const FlatShape& shape = this->shapes[this->layerStart[slot] + found[i]];
+      if (shape.rectangle || utils::pointInPolygon(pnt, shape.vertices))
+        return this->nets[this->layerStart[slot] + found[i]];
+    }
+    return NO_NET;
+  }
+
+  Span<const unsigned int> Connectivity::traceNet(const CoordPnt& pnt, int layer) const {
+    unsigned int net = this->findNet(pnt, layer);
+    if (net == NO_NET)
+      return Span<const unsigned int>();
+    return this->getNetShapes(net);
+  }
+
+}
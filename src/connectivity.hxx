@@ -0,0 +1,152 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef CONNECTIVITY_HXX
+#define CONNECTIVITY_HXX
+
+#include <climits>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "coord.hxx"
+#include "span.hxx"
+#include "spatialIndex.hxx"
+#include "frozenLayout.hxx"
+
+namespace sil {
+
+  /// class LayerStack
+  ///
+  /// \brief Which layers conduct and which of them connect to each
+  /// other, the input of Connectivity.
+  ///
+  /// Shapes on a conducting layer are connected where they touch or
+  /// overlap. A via layer also connects where its shapes touch the
+  /// shapes of the layer below and the layer above it.
+  class LayerStack {
+  private:
+    std::vector<int> layers; //!< The conducting layers, sorted.
+    std::vector<std::pair<int, int> > connections; //!< Pairs of layers that connect, sorted.
+
+  public:
+    /// \brief Makes @layer a conducting layer.
+    void addConductor(int layer);
+
+    /// \brief Makes @viaLayer a conducting layer that connects
+    /// @lowerLayer and @upperLayer, which become conducting too.
+    void addVia(int viaLayer, int lowerLayer, int upperLayer);
+
+    /// \brief Returns the conducting layers in ascending order.
+    const std::vector<int>& getLayers(void) const;
+
+    /// \brief Returns the pairs of layers whose shapes connect where
+    /// they touch, every pair (lower, higher) once, including (l, l) for
+    /// every layer l.
+    const std::vector<std::pair<int, int> >& getConnections(void) const;
+
+    /// \brief Returns true if shapes on @layerA connect to touching
+    /// shapes on @layerB.
+    bool connects(int layerA, int layerB) const;
+  };
+
+  /// \brief A shape of the flattened layout.
+  struct FlatShape {
+    Span<const CoordPnt> vertices; //!< In the coordinates of the top cell.
+    int layer; //!< The layer of the shape.
+    unsigned int cell; //!< The cell of the FrozenLayout the shape comes from.
+    unsigned int element; //!< Its index in the polygons, or paths, of that cell.
+    bool fromPath; //!< Whether this is a segment of a Path.
+    bool rectangle; //!< Whether this is an axis aligned rectangle.
+  };
+
+  /// class Connectivity
+  ///
+  /// \brief The nets of a flattened cell: which of its shapes are
+  /// electrically connected.
+  ///
+  /// The cell is flattened into the shapes on the layers of a
+  /// LayerStack, every placement of every placed cell, in parallel. Each
+  /// layer gets a SpatialIndex, every shape looks up the shapes it may
+  /// touch on the layers it connects to, and touching pairs are merged
+  /// with a lock free union-find shared by all threads. Rectangles are
+  /// touching as soon as their boxes meet, so Manhattan layouts need no
+  /// exact geometry at all.
+  ///
+  /// Paths are split into a rectangle per segment, which overlap at the
+  /// bends. Round ends are treated like square ones.
+  class Connectivity {
+  private:
+    std::vector<CoordPnt> coordinates; //!< The vertices of all shapes.
+    std::vector<FlatShape> shapes; //!< The shapes, grouped by layer.
+    std::vector<int> layers; //!< The layers of the LayerStack.
+    std::vector<std::size_t> layerStart; //!< The first shape of each layer, and the end.
+    std::vector<SpatialIndex> indices; //!< Over the shapes of each layer.
+    std::vector<unsigned int> nets; //!< The net of each shape.
+    std::vector<unsigned int> netStart; //!< The first entry of each net in @netShapes.
+    std::vector<unsigned int> netShapes; //!< The shapes of every net, net by net.
+
+    /// \brief Returns the position of @layer in @layers, or
+    /// layers.size() if it is not conducting.
+    std::size_t layerSlot(int layer) const;
+
+  public:
+    /// \brief Returned by findNet() when there is no net.
+    static const unsigned int NO_NET = UINT_MAX;
+
+    /// \brief Extracts the nets of the cell @topCell of @layout.
+    ///
+    /// Throws std::out_of_range if there is no such cell.
+    Connectivity(const FrozenLayout& layout, unsigned int topCell, const LayerStack& stack);
+
+    // the shapes view @coordinates
+    Connectivity(const Connectivity&) = delete;
+    Connectivity& operator=(const Connectivity&) = delete;
+    Connectivity(Connectivity&&) = default;
+    Connectivity& operator=(Connectivity&&) = default;
+
+    /// \brief Returns the number of shapes.
+    std::size_t getShapeCount(void) const;
+
+    /// \brief Returns the shape at @index.
+    const FlatShape& getShape(std::size_t index) const;
+
+    /// \brief Returns the bounding box of the shape at @index.
+    const Bounds& getBounds(std::size_t index) const;
+
+    /// \brief Returns the number of nets.
+    std::size_t getNetCount(void) const;
+
+    /// \brief Returns the net of the shape at @index.
+    ///
+    /// Nets are numbered by their first shape.
+    unsigned int getNet(std::size_t index) const;
+
+    /// \brief Returns the shapes of @net in ascending order.
+    Span<const unsigned int> getNetShapes(unsigned int net) const;
+
+    /// \brief Returns the net of a shape on @layer that contains @pnt,
+    /// or NO_NET if there is none.
+    unsigned int findNet(const CoordPnt& pnt, int layer) const;
+
+    /// \brief Returns the shapes connected to @pnt on @layer, nothing if
+    /// no shape contains @pnt.
+    Span<const unsigned int> traceNet(const CoordPnt& pnt, int layer) const;
+  };
+
+}
+
+#endif // CONNECTIVITY_HXX
@@ -0,0 +1,72 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "contentHash.hxx"
+#include <algorithm>
+
+namespace sil {
+
+  bool ContentHash::operator==(const ContentHash& other) const {
+    return this->high == other.high && this->low == other.low;
+  }
+
+  bool ContentHash::operator!=(const ContentHash& other) const {
+    return !(*this == other);
+  }
+
+  namespace utils {
+
+    uint64_t mix64(uint64_t value) {
+      value ^= value >> 30;
+      value *= 0xbf58476d1ce4e5b9ULL;
+      value ^= value >> 27;
+      value *= 0x94d049bb133111ebULL;
+      value ^= value >> 31;
+      return value;
+    }
+
+    ElementHasher::ElementHasher(uint64_t tag) :
+      high(mix64(tag)), low(mix64(tag ^ 0x9e3779b97f4a7c15ULL)) {}
+
+    void ElementHasher::addDouble(double value) {
+      uint64_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      this->add(bits);
+    }
+
+    void ElementHasher::addString(const std::string& value) {
+      this->add(value.size());
+      // eight characters at a time
+      for (std::size_t i = 0; i < value.size(); i += sizeof(uint64_t)) {
+        uint64_t chunk = 0;
+        std::memcpy(&chunk, value.data() + i,
+                    std::min(sizeof(uint64_t), value.size() - i));
+        this->add(chunk);
+      }
+    }
+
+    void ElementHasher::addHash(const ContentHash& hash) {
+      this->add(hash.high);
+      this->add(hash.low);
+    }
+
+    ContentHash ElementHasher::finish() const {
+      ContentHash result = { mix64(this->high), mix64(this->low) };
+      return result;
+    }
+
+  } // namespace utils
+} // namespace sil
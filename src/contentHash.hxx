@@ -0,0 +1,90 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTENT_HASH_HXX
+#define CONTENT_HASH_HXX
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <stdint.h> // cross-compiler integer datatypes
+
+namespace sil {
+
+  /// \brief A 128 bit digest of the contents of a Cell.
+  ///
+  /// Cells with the same geometry have the same ContentHash, even if
+  /// their names differ. The converse is only likely: the hash is not
+  /// cryptographic, so equal hashes call for an exact comparison before
+  /// two cells are treated as the same.
+  struct ContentHash {
+    uint64_t high;
+    uint64_t low;
+
+    bool operator==(const ContentHash& other) const;
+    bool operator!=(const ContentHash& other) const;
+  };
+
+  /// Prevent users from accidentally using utility methods that they should
+  /// not normally be using by nesting it within an obvious nested namespace.
+  namespace utils {
+
+    /// \brief The finalizer of splitmix64, a fast 64 bit mixing function.
+    uint64_t mix64(uint64_t value);
+
+    /// \brief Hashes a sequence of integers into a ContentHash.
+    ///
+    /// The two halves are computed independently so that a collision
+    /// needs both of them to collide.
+    class ElementHasher {
+    private:
+      uint64_t high;
+      uint64_t low;
+
+    public:
+      /// \brief Starts a hash, @tag separates different kinds of element.
+      ElementHasher(uint64_t tag);
+
+      /// \brief Adds @value to the hash.
+      void add(uint64_t value) {
+        this->high = mix64(this->high ^ value);
+        this->low = mix64(this->low + value*0x9e3779b97f4a7c15ULL);
+      }
+
+      /// \brief Adds the exact bit pattern of @value to the hash.
+      void addDouble(double value);
+
+      /// \brief Adds the length and characters of @value to the hash.
+      void addString(const std::string& value);
+
+      /// \brief Adds another hash to the hash.
+      void addHash(const ContentHash& hash);
+
+      /// \brief Returns the hash of everything added so far.
+      ContentHash finish(void) const;
+    };
+
+    /// \brief Lets ContentHash be the key of unordered containers.
+    struct ContentHashHasher {
+      std::size_t operator()(const ContentHash& hash) const {
+        return hash.low;
+      }
+    };
+
+  } // namespace utils
+} // namespace sil
+
+#endif // CONTENT_HASH_HXX
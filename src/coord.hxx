@@ -18,6 +18,7 @@
 #define COORD_HXX
 
 #include <string>
+#include "smallVector.hxx"
 
 namespace sil {
   
@@ -96,6 +97,22 @@ namespace sil {
   /// \brief Operator to subtract two points.
   CoordPnt operator-(const CoordPnt& coord1, const CoordPnt& coord2);
 
+  /// \brief The number of points a VertexList holds without allocating.
+  ///
+  /// Rectangles, squares and the small polygons that make up most
+  /// layouts fit, circles and other large shapes do not.
+  const std::size_t INLINE_VERTEX_COUNT = 8;
+
+  /// \brief The vertices of a Polygon or the points of a Path.
+  ///
+  /// Lists with more than INLINE_VERTEX_COUNT points take their memory
+  /// from a std::pmr::memory_resource, which is the one of the Cell
+  /// holding the shape (see Arena).
+  typedef SmallVector<CoordPnt, INLINE_VERTEX_COUNT> VertexList;
+
+  /// \brief The four corners of a bounding box.
+  typedef SmallVector<CoordPnt, 4> BoxList;
+
 }
 
 #endif // COORD_HXX
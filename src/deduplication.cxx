@@ -0,0 +1,292 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "deduplication.hxx"
+#include "cellGraph.hxx"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace sil {
+
+  // coordinates are compared on the database grid of the GDSII writer
+  const double HASH_GRID = 1e-3;
+  // magnifications and rotations (in radians) are compared to 1e-9
+  const double HASH_SCALE_GRID = 1e-9;
+
+  // element tags, so that e.g. a polygon can never hash like a path
+  const uint64_t HASH_POLYGON = 1;
+  const uint64_t HASH_PATH = 2;
+  const uint64_t HASH_REFERENCE = 3;
+  const uint64_t HASH_ARRAY = 4;
+
+  // The canonical form of one element: its tag followed by its values
+  // on the database grid. Two elements are the same if their keys are.
+  typedef std::vector<uint64_t> ElementKey;
+
+  // Quantizes @value to the database grid.
+  static uint64_t gridValue(double value) {
+    return static_cast<uint64_t>(std::llround(value/HASH_GRID));
+  }
+
+  // Quantizes a magnification or rotation.
+  static uint64_t scaleValue(double value) {
+    return static_cast<uint64_t>(std::llround(value/HASH_SCALE_GRID));
+  }
+
+  // Starts a polygon from its lowest (then leftmost) vertex so that the
+  // same outline has the same key whichever vertex it starts at.
+  static void polygonKey(const Polygon& polygon, ElementKey& key) {
+    key.push_back(HASH_POLYGON);
+    key.push_back(polygon.getLayer());
+    key.push_back(polygon.getDataType());
+    Span<const CoordPnt> vertices = polygon.getVertexSpan();
+    unsigned int start = 0;
+    for (unsigned int i = 1; i < vertices.size(); i++)
+      if (vertices[i].getY() < vertices[start].getY() ||
+          (vertices[i].getY() == vertices[start].getY() &&
+           vertices[i].getX() < vertices[start].getX()))
+        start = i;
+    key.push_back(vertices.size());
+    for (unsigned int i = 0; i < vertices.size(); i++) {
+      const CoordPnt& vertex = vertices[(start + i) % vertices.size()];
+      key.push_back(gridValue(vertex.getX()));
+      key.push_back(gridValue(vertex.getY()));
+    }
+  }
+
+  static void pathKey(const Path& path, ElementKey& key) {
+    key.push_back(HASH_PATH);
+    key.push_back(path.getLayer());
+    key.push_back(path.getDataType());
+    key.push_back(path.getPathType());
+    key.push_back(gridValue(path.getPathWidth()));
+    Span<const CoordPnt> points = path.getCoordPathSpan();
+    key.push_back(points.size());
+    for (unsigned int i = 0; i < points.size(); i++) {
+      key.push_back(gridValue(points[i].getX()));
+      key.push_back(gridValue(points[i].getY()));
+    }
+  }
+
+  // Calls @visit with the key of every element of node @node. @child
+  // appends the words that stand for a placed Cell, given its node.
+  static void forEachKey(const CellGraph& graph, unsigned int node,
+                         const std::function<void(unsigned int, ElementKey&)>& child,
+                         const std::function<void(const ElementKey&)>& visit) {
+    const Cell* cell = &graph.getCell(node);
+    ElementKey key;
+
+    PolygonList& polygons = cell->getPolygonList();
+    for (unsigned int i = 0; i < polygons.size(); i++) {
+      key.clear();
+      polygonKey(polygons[i], key);
+      visit(key);
+    }
+    PathList& paths = cell->getPathList();
+    for (unsigned int i = 0; i < paths.size(); i++) {
+      key.clear();
+      pathKey(paths[i], key);
+      visit(key);
+    }
+    CellReferenceList& refs = cell->getCellReferenceList();
+    for (unsigned int i = 0; i < refs.size(); i++) {
+      key.clear();
+      key.push_back(HASH_REFERENCE);
+      child(graph.getNode(refs[i].getReferencedCell()), key);
+      key.push_back(gridValue(refs[i].getCenter().getX()));
+      key.push_back(gridValue(refs[i].getCenter().getY()));
+      key.push_back(scaleValue(refs[i].getMagnification()));
+      key.push_back(scaleValue(refs[i].getRotation()));
+      visit(key);
+    }
+    CellArrayList& arrays = cell->getCellArrayList();
+    for (unsigned int i = 0; i < arrays.size(); i++) {
+      key.clear();
+      key.push_back(HASH_ARRAY);
+      child(graph.getNode(arrays[i].getReferencedCell()), key);
+      key.push_back(gridValue(arrays[i].getStartingPos().getX()));
+      key.push_back(gridValue(arrays[i].getStartingPos().getY()));
+      key.push_back(arrays[i].getNumCol());
+      key.push_back(arrays[i].getNumRow());
+      key.push_back(gridValue(arrays[i].getXSpacing()));
+      key.push_back(gridValue(arrays[i].getYSpacing()));
+      key.push_back(scaleValue(arrays[i].getMagnification()));
+      key.push_back(scaleValue(arrays[i].getRotation()));
+      visit(key);
+    }
+  }
+
+  // The hash of a Cell is the sum of the hashes of its elements, which
+  // does not depend on their order, mixed with the number of elements.
+  // A placed Cell is represented by its own hash.
+  static ContentHash hashCell(const CellGraph& graph,
+                              const std::vector<ContentHash>& hashes,
+                              unsigned int node) {
+    uint64_t sumHigh = 0;
+    uint64_t sumLow = 0;
+    uint64_t count = 0;
+    forEachKey(graph, node,
+               [&](unsigned int child, ElementKey& key) {
+                 key.push_back(hashes[child].high);
+                 key.push_back(hashes[child].low);
+               },
+               [&](const ElementKey& key) {
+                 utils::ElementHasher hasher(key[0]);
+                 for (std::size_t i = 1; i < key.size(); i++)
+                   hasher.add(key[i]);
+                 ContentHash element = hasher.finish();
+                 sumHigh += element.high;
+                 sumLow += element.low;
+                 count++;
+               });
+
+    utils::ElementHasher hasher(count);
+    hasher.add(sumHigh);
+    hasher.add(sumLow);
+    return hasher.finish();
+  }
+
+  // Returns the sorted keys of the elements of node @node, with a placed
+  // Cell represented by its class in @classes. Two cells whose children
+  // are classified have the same contents exactly if these are equal.
+  static std::vector<ElementKey> canonicalCell(const CellGraph& graph,
+                                               const std::vector<unsigned int>& classes,
+                                               unsigned int node) {
+    std::vector<ElementKey> keys;
+    forEachKey(graph, node,
+               [&](unsigned int child, ElementKey& key) {
+                 key.push_back(classes[child]);
+               },
+               [&](const ElementKey& key) {
+                 keys.push_back(key);
+               });
+    std::sort(keys.begin(), keys.end());
+    return keys;
+  }
+
+  static std::vector<ContentHash> hashGraph(const CellGraph& graph) {
+    std::vector<ContentHash> hashes(graph.size());
+    // every Cell is hashed after the cells it places
+    graph.parallelBottomUp([&](unsigned int node) {
+        hashes[node] = hashCell(graph, hashes, node);
+      });
+    return hashes;
+  }
+
+  std::vector<ContentHash> computeContentHashes(const Layout& layout) {
+    CellGraph graph(layout);
+    std::vector<ContentHash> hashes = hashGraph(graph);
+    hashes.resize(graph.getLayoutCellCount());
+    return hashes;
+  }
+
+  DeduplicationOptions::DeduplicationOptions() : mergeTopCells(false) {}
+
+  DeduplicationStats deduplicateCells(Layout& layout, DeduplicationOptions options) {
+    DeduplicationStats stats = { 0, 0 };
+    CellGraph graph(layout);
+    std::vector<ContentHash> hashes = hashGraph(graph);
+
+    // The hash only proposes candidates: a Cell joins the class of an
+    // earlier Cell with the same hash once their canonical forms match.
+    // Children are classified first, so a placed Cell is compared by its
+    // class. The keys of the first Cell of a class are only built once
+    // another Cell has its hash.
+    std::vector<unsigned int> classes(graph.size());
+    std::vector<unsigned int> representatives;
+    std::vector<std::vector<ElementKey> > classKeys;
+    std::vector<bool> hasKeys;
+    std::unordered_map<ContentHash, std::vector<unsigned int>, utils::ContentHashHasher> candidates;
+    std::vector<unsigned int> order = graph.topologicalOrder();
+    for (std::size_t i = 0; i < order.size(); i++) {
+      unsigned int node = order[i];
+      std::vector<unsigned int>& sameHash = candidates[hashes[node]];
+      std::vector<ElementKey> keys;
+      if (!sameHash.empty())
+        keys = canonicalCell(graph, classes, node);
+      std::size_t j = 0;
+      for (; j < sameHash.size(); j++) {
+        unsigned int candidate = sameHash[j];
+        if (!hasKeys[candidate]) {
+          classKeys[candidate] = canonicalCell(graph, classes, representatives[candidate]);
+          hasKeys[candidate] = true;
+        }
+        if (classKeys[candidate] == keys)
+          break;
+      }
+      if (j < sameHash.size()) {
+        classes[node] = sameHash[j];
+      } else {
+        classes[node] = representatives.size();
+        representatives.push_back(node);
+        hasKeys.push_back(!sameHash.empty());
+        classKeys.push_back(std::move(keys));
+        sameHash.push_back(classes[node]);
+      }
+    }
+
+    // the first Cell of each class survives, preferring the cells of the
+    // layout over the cells they merely reference; unless asked to, top
+    // cells are neither merged nor kept in place of another Cell
+    std::vector<bool> fixed(graph.size(), false);
+    if (!options.mergeTopCells) {
+      std::vector<unsigned int> tops = graph.topCells();
+      for (std::size_t i = 0; i < tops.size(); i++)
+        fixed[tops[i]] = true;
+    }
+    std::vector<unsigned int> first(representatives.size(), graph.size());
+    std::vector<unsigned int> survivor(graph.size());
+    for (unsigned int node = 0; node < graph.size(); node++) {
+      if (!fixed[node] && first[classes[node]] == graph.size())
+        first[classes[node]] = node;
+      survivor[node] = fixed[node] ? node : first[classes[node]];
+    }
+
+    for (unsigned int node = 0; node < graph.size(); node++) {
+      const Cell& cell = graph.getCell(node);
+      CellReferenceList& refs = cell.getCellReferenceList();
+      for (unsigned int j = 0; j < refs.size(); j++) {
+        unsigned int target = graph.getNode(refs[j].getReferencedCell());
+        if (survivor[target] != target) {
+          refs[j].setReferencedCell(graph.getCell(survivor[target]));
+          stats.referencesRetargeted++;
+        }
+      }
+      CellArrayList& arrays = cell.getCellArrayList();
+      for (unsigned int j = 0; j < arrays.size(); j++) {
+        unsigned int target = graph.getNode(arrays[j].getReferencedCell());
+        if (survivor[target] != target) {
+          arrays[j].setReferencedCell(graph.getCell(survivor[target]));
+          stats.referencesRetargeted++;
+        }
+      }
+    }
+
+    std::vector<const Cell*> merged;
+    for (unsigned int node = 0; node < graph.getLayoutCellCount(); node++)
+      if (survivor[node] != node)
+        merged.push_back(&graph.getCell(node));
+    layout.removeCells(merged);
+    stats.cellsMerged = merged.size();
+    return stats;
+  }
+
+}
@@ -0,0 +1,74 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DEDUPLICATION_HXX
+#define DEDUPLICATION_HXX
+
+#include <vector>
+#include "cell.hxx"
+#include "contentHash.hxx"
+#include "layout.hxx"
+
+namespace sil {
+
+  /// \brief A summary of the changes made by deduplicateCells().
+  struct DeduplicationStats {
+    unsigned int cellsMerged; //!< Cells removed because an identical Cell survived.
+    unsigned int referencesRetargeted; //!< CellReferences and CellArrays now pointing at a survivor.
+  };
+
+  /// \brief The settings used by deduplicateCells().
+  struct DeduplicationOptions {
+    /// \brief Whether top cells, which no other Cell places, may be
+    /// merged too. A merged top Cell disappears from the Layout along
+    /// with its name.
+    bool mergeTopCells;
+
+    /// \brief Sets the defaults: top cells are kept.
+    DeduplicationOptions(void);
+  };
+
+  /// \brief Returns the ContentHash of every distinct Cell of @layout, in
+  /// the order of Layout::getCells(). A Cell that was added more than
+  /// once only has a hash at its first position, as in CellGraph.
+  ///
+  /// The hash is a Merkle hash: it covers the polygons and paths of a
+  /// Cell (on the 1 nm database grid), and for its CellReferences and
+  /// CellArrays the hash of the referenced Cell and the placement. Cell
+  /// names are not part of the hash, nor is the order in which the
+  /// elements were added. Cells are hashed bottom-up, one level of the
+  /// hierarchy at a time, with the cells of a level hashed in parallel.
+  /// Throws std::logic_error if the hierarchy contains a cycle.
+  std::vector<ContentHash> computeContentHashes(const Layout& layout);
+
+  /// \brief Merges the cells of @layout that have identical contents.
+  ///
+  /// @layout The Layout to deduplicate.
+  /// @options Whether top cells may be merged.
+  ///
+  /// Cells with the same ContentHash are compared element by element
+  /// (on the database grid and regardless of order) before they are
+  /// merged, so a hash collision never merges different cells. Of every
+  /// set of identical cells the first one in Layout::getCells() survives.
+  /// Every CellReference and CellArray that refers to one of the others
+  /// is pointed at the survivor, and the others are removed from @layout
+  /// (and destroyed, if the Layout owns them).
+  DeduplicationStats deduplicateCells(Layout& layout,
+                                      DeduplicationOptions options = DeduplicationOptions());
+
+}
+
+#endif // DEDUPLICATION_HXX
@@ -0,0 +1,1097 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "designRules.hxx"
+#include "geometry.hxx"
+#include "parallel.hxx"
+#include "scanline.hxx"
+#include "spatialIndex.hxx"
+#include "validation.hxx"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <sstream>
+#include <stdexcept>
+
+namespace sil {
+
+  DesignRule::DesignRule(DesignRuleKind usrKind, int usrLayer, double usrValue,
+                         int usrOuterLayer) :
+    kind(usrKind), layer(usrLayer), outerLayer(usrOuterLayer), value(usrValue) {
+    if (!(usrValue > 0)) {
+      std::stringstream errorMsg;
+      errorMsg << "The value of a design rule must be positive, but "
+               << usrValue << " was given.";
+      throw std::invalid_argument(errorMsg.str());
+    }
+    if (usrKind == MIN_ENCLOSURE && usrOuterLayer < 0)
+      throw std::invalid_argument("An enclosure rule needs the layer of the enclosing shapes.");
+  }
+
+  bool DesignRuleReport::isClean() const {
+    return this->violations.empty();
+  }
+
+  std::size_t DesignRuleReport::count(std::size_t rule) const {
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < this->violations.size(); i++)
+      if (this->violations[i].rule == rule)
+        total++;
+    return total;
+  }
+
+  std::string DesignRuleReport::toString() const {
+    static const char* names[] = {"width", "spacing", "area", "enclosure"};
+    std::ostringstream out;
+    for (std::size_t i = 0; i < this->violations.size(); i++) {
+      const DesignRuleViolation& violation = this->violations[i];
+      Bounds box;
+      Span<const CoordPnt> vertices = violation.marker.getVertexSpan();
+      for (std::size_t j = 0; j < vertices.size(); j++)
+        box.add(vertices[j]);
+      out << violation.cellname;
+      if (violation.magnification != 1.0)
+        out << " (magnified " << violation.magnification << ")";
+      out << ": rule " << violation.rule << ", " << names[violation.kind]
+          << " on layer " << violation.marker.getLayer() << " is ";
+      if (violation.measured < 0)
+        out << "missing";
+      else
+        out << violation.measured;
+      out << ", needs " << violation.required << ", near ("
+          << (box.minX + box.maxX)/2. << ", " << (box.minY + box.maxY)/2. << ")\n";
+    }
+    return out.str();
+  }
+
+  namespace {
+
+    /// \brief The number of polygons of a cell checked by one task.
+    const std::size_t POLYGONS_PER_TASK = 1024;
+
+    /// \brief Marks a shape of the checked cell itself, rather than of
+    /// one of its placements.
+    const int OWN_SHAPES = -1;
+
+    /// \brief Returns true if @measured breaks the minimum @required,
+    /// forgiving rounding errors.
+    bool below(double measured, double required) {
+      return measured < required*(1 - 1e-9);
+    }
+
+    double cross(double ax, double ay, double bx, double by) {
+      return ax*by - ay*bx;
+    }
+
+    typedef utils::Transform Transform;
+
+    Bounds edgeBounds(const CoordPnt& e0, const CoordPnt& e1) {
+      Bounds box;
+      box.add(e0);
+      box.add(e1);
+      return box;
+    }
+
+    /// \brief A polygon taking part in a check, in the coordinates of
+    /// the checked cell.
+    struct Shape {
+      Span<const CoordPnt> vertices;
+      Bounds bounds;
+      double orientation; //!< 1 if the vertices run counterclockwise, -1 if not.
+      int layer;
+      int group; //!< The placement it came from, or OWN_SHAPES.
+      int col; //!< The element of that placement.
+      int row;
+    };
+
+    /// \brief Returns @polygon of the checked cell itself as a Shape.
+    Shape viewOf(const FrozenPolygon& polygon) {
+      Shape shape;
+      shape.vertices = polygon.vertices;
+      shape.bounds = polygon.bounds;
+      shape.orientation = polygon.signedArea < 0 ? -1 : 1;
+      shape.layer = polygon.layer;
+      shape.group = OWN_SHAPES;
+      shape.col = shape.row = 0;
+      return shape;
+    }
+
+    /// \brief Shapes with the storage of the ones that were transformed.
+    struct ShapeSet {
+      std::deque<std::vector<CoordPnt> > storage; //!< Never moves its vectors.
+      std::vector<Shape> shapes;
+
+      void addView(const FrozenPolygon& polygon) {
+        this->shapes.push_back(viewOf(polygon));
+      }
+
+      void addTransformed(Span<const CoordPnt> vertices, double orientation, int layer,
+                          const Transform& transform, int group, int col, int row) {
+        this->storage.push_back(std::vector<CoordPnt>());
+        std::vector<CoordPnt>& target = this->storage.back();
+        target.reserve(vertices.size());
+        Shape shape;
+        for (std::size_t i = 0; i < vertices.size(); i++) {
+          target.push_back(transform.apply(vertices[i]));
+          shape.bounds.add(target.back());
+        }
+        shape.vertices = Span<const CoordPnt>(target);
+        shape.orientation = orientation;
+        shape.layer = layer;
+        shape.group = group;
+        shape.col = col;
+        shape.row = row;
+        this->shapes.push_back(shape);
+      }
+    };
+
+    /// \brief Returns true if the outlines of two shapes meet or one
+    /// lies inside the other, which makes them one piece of material.
+    bool shapesTouch(const Shape& a, const Shape& b) {
+      return utils::polygonsTouch(a.vertices, a.bounds, b.vertices, b.bounds);
+    }
+
+    /// \brief Returns how far @inner lies inside @outer, or -1 if it
+    /// does not lie inside it at all.
+    double enclosureMargin(const Shape& inner, const Shape& outer) {
+      if (!outer.bounds.contains(inner.bounds))
+        return -1;
+      for (std::size_t i = 0; i < inner.vertices.size(); i++)
+        if (!utils::pointInPolygon(inner.vertices[i], outer.vertices))
+          return -1;
+      double margin = -1;
+      std::size_t n = inner.vertices.size(), k = outer.vertices.size();
+      CoordPnt pa, pb;
+      for (std::size_t i = 0; i < n; i++)
+        for (std::size_t j = 0; j < k; j++) {
+          double d = utils::segmentDistance(inner.vertices[i], inner.vertices[(i + 1)%n],
+                                     outer.vertices[j], outer.vertices[(j + 1)%k], pa, pb);
+          if (margin < 0 || d < margin)
+            margin = d;
+        }
+      return margin;
+    }
+
+    /// \brief Returns the marker for the edges [@a0, @a1] and [@b0,
+    /// @b1], whose closest points @pa and @pb are @distance apart: the
+    /// part of the first edge that faces the second and its counterpart,
+    /// or a square between the closest points if the edges only face
+    /// each other at a corner.
+    std::vector<CoordPnt> edgeMarker(const CoordPnt& a0, const CoordPnt& a1,
+                                     const CoordPnt& b0, const CoordPnt& b1,
+                                     const CoordPnt& pa, const CoordPnt& pb, double distance) {
+      double ex = a1.getX() - a0.getX();
+      double ey = a1.getY() - a0.getY();
+      double length2 = ex*ex + ey*ey;
+      double t0 = ((b0.getX() - a0.getX())*ex + (b0.getY() - a0.getY())*ey)/length2;
+      double t1 = ((b1.getX() - a0.getX())*ex + (b1.getY() - a0.getY())*ey)/length2;
+      double from = std::max(0., std::min(t0, t1));
+      double to = std::min(1., std::max(t0, t1));
+      std::vector<CoordPnt> marker;
+      if ((to - from)*std::sqrt(length2) > distance*1e-6) {
+        CoordPnt qa0(a0.getX() + from*ex, a0.getY() + from*ey);
+        CoordPnt qa1(a0.getX() + to*ex, a0.getY() + to*ey);
+        CoordPnt qb0, qb1;
+        utils::pointSegmentDistance(qa0, b0, b1, qb0);
+        utils::pointSegmentDistance(qa1, b0, b1, qb1);
+        marker.push_back(qa0);
+        marker.push_back(qa1);
+        marker.push_back(qb1);
+        marker.push_back(qb0);
+        double area = 0;
+        for (int i = 0; i < 4; i++)
+          area += cross(marker[i].getX(), marker[i].getY(),
+                        marker[(i + 1)%4].getX(), marker[(i + 1)%4].getY());
+        if (std::abs(area) > distance*distance*1e-6)
+          return marker;
+        marker.clear();
+      }
+      double vx = (pb.getX() - pa.getX())/distance;
+      double vy = (pb.getY() - pa.getY())/distance;
+      double half = distance/2.;
+      marker.push_back(CoordPnt(pa.getX() - vy*half, pa.getY() + vx*half));
+      marker.push_back(CoordPnt(pb.getX() - vy*half, pb.getY() + vx*half));
+      marker.push_back(CoordPnt(pb.getX() + vy*half, pb.getY() - vx*half));
+      marker.push_back(CoordPnt(pa.getX() + vy*half, pa.getY() - vx*half));
+      return marker;
+    }
+
+    /// \brief Returns the corner of @shape that @pnt is on, the end of
+    /// its edge @edge, or SIZE_MAX if it lies inside the edge.
+    std::size_t cornerAt(const Shape& shape, std::size_t edge, const CoordPnt& pnt,
+                         double tolerance) {
+      std::size_t n = shape.vertices.size();
+      for (std::size_t end = edge; end <= edge + 1; end++) {
+        const CoordPnt& corner = shape.vertices[end%n];
+        // rounding may move a clamped closest point off the corner
+        double slack = tolerance + 1e-12*(std::abs(corner.getX()) + std::abs(corner.getY()));
+        if (std::hypot(pnt.getX() - corner.getX(), pnt.getY() - corner.getY()) <= slack)
+          return end%n;
+      }
+      return SIZE_MAX;
+    }
+
+    /// \brief Returns true if the corner @corner of @shape turns away
+    /// from its inside, so that the inside reaches around it.
+    bool isReflex(const Shape& shape, std::size_t corner) {
+      std::size_t n = shape.vertices.size();
+      const CoordPnt& prev = shape.vertices[(corner + n - 1)%n];
+      const CoordPnt& here = shape.vertices[corner];
+      const CoordPnt& next = shape.vertices[(corner + 1)%n];
+      return shape.orientation*cross(here.getX() - prev.getX(), here.getY() - prev.getY(),
+                                     next.getX() - here.getX(), next.getY() - here.getY()) < 0;
+    }
+
+    /// \brief Returns false if the edges @i of @a and @j of @b do not
+    /// overlap along each other and their closest points @pa and @pb are
+    /// both corners that point away from the region between them,
+    /// measured @inside the shape or not.
+    bool cornersFace(const Shape& a, std::size_t i, const CoordPnt& pa,
+                     const Shape& b, std::size_t j, const CoordPnt& pb, bool inside,
+                     double tolerance) {
+      std::size_t cornerA = cornerAt(a, i, pa, tolerance);
+      std::size_t cornerB = cornerAt(b, j, pb, tolerance);
+      if (cornerA == SIZE_MAX || cornerB == SIZE_MAX)
+        return true;
+      const CoordPnt& a0 = a.vertices[i];
+      const CoordPnt& a1 = a.vertices[(i + 1)%a.vertices.size()];
+      const CoordPnt& b0 = b.vertices[j];
+      const CoordPnt& b1 = b.vertices[(j + 1)%b.vertices.size()];
+      double ex = a1.getX() - a0.getX(), ey = a1.getY() - a0.getY();
+      double length2 = ex*ex + ey*ey;
+      double t0 = ((b0.getX() - a0.getX())*ex + (b0.getY() - a0.getY())*ey)/length2;
+      double t1 = ((b1.getX() - a0.getX())*ex + (b1.getY() - a0.getY())*ey)/length2;
+      if (std::min(1., std::max(t0, t1)) - std::max(0., std::min(t0, t1)) > 1e-9)
+        return true;
+      return isReflex(a, cornerA) == inside || isReflex(b, cornerB) == inside;
+    }
+
+    /// \brief Calls @found(a0, a1, b0, b1, pa, pb, distance) for every
+    /// edge of @a and edge of @b that are less than @limit apart and
+    /// face each other through the inside of the shapes (@inside) or
+    /// through the outside. If @a and @b are the same shape every pair
+    /// of edges that are not neighbours is visited once, and only edges
+    /// that face each other measure a width or notch: they run in
+    /// roughly opposite directions, and a distance between two corners
+    /// needs one of them to point into the measured region. On a curved
+    /// outline the edges a few steps apart, or a quarter turn apart, are
+    /// close too, but they continue the same side.
+    template <typename Found>
+    void closeEdges(const Shape& a, const Shape& b, bool same, double limit, bool inside,
+                    Found found) {
+      std::size_t n = a.vertices.size(), k = b.vertices.size();
+      CoordPnt pa, pb;
+      // the edges that meet at a corner find the same closest points
+      std::vector<std::pair<CoordPnt, CoordPnt> > reported;
+      for (std::size_t i = 0; i < n; i++) {
+        const CoordPnt& a0 = a.vertices[i];
+        const CoordPnt& a1 = a.vertices[(i + 1)%n];
+        double ax = a1.getX() - a0.getX(), ay = a1.getY() - a0.getY();
+        if (ax == 0 && ay == 0)
+          continue;
+        Bounds box = edgeBounds(a0, a1).grown(limit);
+        for (std::size_t j = same ? i + 2 : 0; j < k; j++) {
+          if (same && i == 0 && j == n - 1)
+            continue; // the closing edge is a neighbour of the first
+          const CoordPnt& b0 = b.vertices[j];
+          const CoordPnt& b1 = b.vertices[(j + 1)%k];
+          double bx = b1.getX() - b0.getX(), by = b1.getY() - b0.getY();
+          if ((bx == 0 && by == 0) || !box.intersects(edgeBounds(b0, b1)))
+            continue;
+          double d = utils::segmentDistance(a0, a1, b0, b1, pa, pb);
+          if (d <= 0 || !below(d, limit) || (same && ax*bx + ay*by >= 0))
+            continue;
+          double vx = pb.getX() - pa.getX(), vy = pb.getY() - pa.getY();
+          double tolerance = 1e-9*d;
+          double sideA = a.orientation*cross(ax, ay, vx, vy)/std::hypot(ax, ay);
+          double sideB = b.orientation*cross(bx, by, -vx, -vy)/std::hypot(bx, by);
+          bool facing = inside ? (sideA > tolerance && sideB > tolerance)
+            : (sideA < -tolerance && sideB < -tolerance);
+          if (!facing || (same && !cornersFace(a, i, pa, b, j, pb, inside, tolerance)))
+            continue;
+          bool seen = false;
+          for (std::size_t r = 0; r < reported.size() && !seen; r++)
+            seen = reported[r].first.getX() == pa.getX() && reported[r].first.getY() == pa.getY() &&
+              reported[r].second.getX() == pb.getX() && reported[r].second.getY() == pb.getY();
+          if (seen)
+            continue;
+          reported.push_back(std::make_pair(pa, pb));
+          found(a0, a1, b0, b1, pa, pb, d);
+        }
+      }
+    }
+
+    /// \brief Returns the indices in [@minIndex, @maxIndex] of the
+    /// lattice positions i for which [@lo, @hi] + i*@pitch meets [@windowLo,
+    /// @windowHi], as @first and @last, or false if there are none.
+    bool latticeRange(double lo, double hi, double windowLo, double windowHi, double pitch,
+                      long minIndex, long maxIndex, long& first, long& last) {
+      if (minIndex > maxIndex)
+        return false;
+      if (pitch == 0) {
+        first = minIndex;
+        last = maxIndex;
+        return hi >= windowLo && lo <= windowHi;
+      }
+      double from = (windowLo - hi)/pitch;
+      double to = (windowHi - lo)/pitch;
+      if (pitch < 0)
+        std::swap(from, to);
+      from = std::max(double(minIndex), std::ceil(from - 1e-9));
+      to = std::min(double(maxIndex), std::floor(to + 1e-9));
+      if (from > to)
+        return false;
+      first = long(from);
+      last = long(to);
+      return true;
+    }
+
+    /// \brief A CellReference or CellArray placed (indirectly) in the
+    /// checked cell; a reference is an array of one element.
+    ///
+    /// The lattice of an array is axis aligned in the cell that places
+    /// it, which may be turned in the checked cell, so elements are
+    /// looked up in the coordinates of the placing cell.
+    struct Group {
+      unsigned int cell; //!< The placed cell.
+      double magnification; //!< The magnification of the placement.
+      Transform parent; //!< From the placing cell to the checked cell.
+      Transform local; //!< From the placed cell to the placing cell, for the first element.
+      long numCol;
+      long numRow;
+      double xSpacing; //!< In the placing cell.
+      double ySpacing;
+      Bounds first; //!< The extent of the first element in the placing cell.
+      Bounds extent; //!< The extent of every element in the checked cell.
+
+      Transform element(long col, long row) const {
+        return this->parent.after(this->local.shifted(col*this->xSpacing, row*this->ySpacing));
+      }
+
+      Bounds elementExtent(long col, long row) const {
+        double x = col*this->xSpacing, y = row*this->ySpacing;
+        return this->parent.apply(Bounds(this->first.minX + x, this->first.minY + y,
+                                         this->first.maxX + x, this->first.maxY + y));
+      }
+
+      /// \brief Finds the elements in columns [@firstCol, @lastCol] of
+      /// [@minCol, @maxCol] and rows [@firstRow, @lastRow] of [@minRow,
+      /// @maxRow] whose extent may meet @window, false if there are none.
+      bool elementsIn(const Bounds& window, long minCol, long maxCol, long minRow, long maxRow,
+                      long& firstCol, long& lastCol, long& firstRow, long& lastRow) const {
+        Bounds local = this->parent.invert(window);
+        return !this->first.isEmpty() && !local.isEmpty() &&
+          latticeRange(this->first.minX, this->first.maxX, local.minX, local.maxX,
+                       this->xSpacing, minCol, maxCol, firstCol, lastCol) &&
+          latticeRange(this->first.minY, this->first.maxY, local.minY, local.maxY,
+                       this->ySpacing, minRow, maxRow, firstRow, lastRow);
+      }
+
+      bool elementsIn(const Bounds& window, long& firstCol, long& lastCol,
+                      long& firstRow, long& lastRow) const {
+        return this->elementsIn(window, 0, this->numCol - 1, 0, this->numRow - 1,
+                                firstCol, lastCol, firstRow, lastRow);
+      }
+    };
+
+    /// \brief An inner shape that is not enclosed yet, handed to the
+    /// parents of its cell.
+    struct PendingEnclosure {
+      std::vector<CoordPnt> vertices; //!< In the coordinates of the cell.
+      double orientation;
+      double margin; //!< The best enclosure seen so far, -1 if none.
+    };
+
+    /// \brief A cell checked at one magnification.
+    struct Context {
+      unsigned int cell;
+      double magnification;
+      unsigned int height; //!< 0 for cells that place nothing.
+      std::vector<std::vector<PendingEnclosure> > pending; //!< Per rule.
+      std::vector<DesignRuleViolation> violations;
+    };
+
+    /// \brief Two placements, or the shapes of the cell and a
+    /// placement, whose shapes may be too close.
+    struct Interaction {
+      int groupA; //!< OWN_SHAPES or a Group.
+      long colA;
+      long rowA;
+      int groupB;
+      long colB;
+      long rowB;
+    };
+
+    class Checker {
+    private:
+      const FrozenLayout& layout;
+      const std::vector<DesignRule>& rules;
+      std::vector<SpatialIndex> indices; //!< Over the polygons of each cell.
+      std::vector<Context> contexts;
+      std::vector<std::vector<unsigned int> > cellContexts; //!< The contexts of each cell.
+      double maxSpacing; //!< The largest MIN_SPACING value.
+      std::vector<int> spacingLayers; //!< The layers with a MIN_SPACING rule, sorted.
+      std::vector<int> mergedLayers; //!< The layers with a MIN_WIDTH or MIN_AREA rule, sorted.
+
+      double limit(const DesignRule& rule, double magnification) const {
+        return rule.kind == MIN_AREA ? rule.value/(magnification*magnification)
+          : rule.value/magnification;
+      }
+
+      void report(const Context& context, std::vector<DesignRuleViolation>& out, std::size_t rule,
+                  double measured, const std::vector<CoordPnt>& marker) const {
+        // markers may be slivers that would not pass as shapes
+        DeferredValidation deferred;
+        DesignRuleViolation violation = {
+          rule, this->rules[rule].kind, context.cell,
+          this->layout.getCell(context.cell).cellname, context.magnification,
+          measured, this->rules[rule].value, Polygon(marker, this->rules[rule].layer, 0)
+        };
+        out.push_back(std::move(violation));
+      }
+
+      unsigned int findContext(unsigned int cell, double magnification) const {
+        const std::vector<unsigned int>& ids = this->cellContexts[cell];
+        for (std::size_t i = 0; i < ids.size(); i++)
+          if (std::abs(this->contexts[ids[i]].magnification - magnification) <=
+              1e-12*magnification)
+            return ids[i];
+        return UINT_MAX;
+      }
+
+      /// \brief Adds the polygons on @layers, of @cell placed with
+      /// @transform, that meet @window to @out.
+      void collect(unsigned int cell, const Transform& transform, const Bounds& window,
+                   const std::vector<int>& layers, int group, long col, long row,
+                   ShapeSet& out) const {
+        const FrozenCell& frozen = this->layout.getCell(cell);
+        Bounds local = transform.invert(window);
+        if (!frozen.extent.intersects(local))
+          return;
+        std::vector<unsigned int> ids;
+        this->indices[cell].query(local, ids);
+        std::sort(ids.begin(), ids.end());
+        for (std::size_t i = 0; i < ids.size(); i++) {
+          const FrozenPolygon& polygon = frozen.polygons[ids[i]];
+          if (std::binary_search(layers.begin(), layers.end(), polygon.layer))
+            out.addTransformed(polygon.vertices, polygon.signedArea < 0 ? -1 : 1,
+                               polygon.layer, transform, group, col, row);
+        }
+        std::vector<Group> groups = this->placements(cell, transform);
+        for (std::size_t g = 0; g < groups.size(); g++) {
+          long firstCol, lastCol, firstRow, lastRow;
+          if (!groups[g].elementsIn(window, firstCol, lastCol, firstRow, lastRow))
+            continue;
+          for (long c = firstCol; c <= lastCol; c++)
+            for (long r = firstRow; r <= lastRow; r++)
+              this->collect(groups[g].cell, groups[g].element(c, r), window, layers,
+                            group, col, row, out);
+        }
+      }
+
+      /// \brief Returns the placements of @cell, mapped by @transform.
+      std::vector<Group> placements(unsigned int cell, const Transform& transform) const {
+        const FrozenCell& frozen = this->layout.getCell(cell);
+        std::vector<Group> groups;
+        for (std::size_t i = 0; i < frozen.references.size() + frozen.arrays.size(); i++) {
+          Group group;
+          group.parent = transform;
+          if (i < frozen.references.size()) {
+            const FrozenReference& ref = frozen.references[i];
+            group.cell = ref.cell;
+            group.magnification = ref.magnification;
+            group.local = Transform(ref.magnification, ref.rotation, ref.position);
+            group.numCol = group.numRow = 1;
+            group.xSpacing = group.ySpacing = 0;
+          }
+          else {
+            const FrozenArray& array = frozen.arrays[i - frozen.references.size()];
+            group.cell = array.cell;
+            group.magnification = array.magnification;
+            group.local = Transform(array.magnification, array.rotation, array.startingPos);
+            group.numCol = std::max(1, array.numCol);
+            group.numRow = std::max(1, array.numRow);
+            group.xSpacing = array.xSpacing;
+            group.ySpacing = array.ySpacing;
+          }
+          group.first = group.local.apply(this->layout.getCell(group.cell).extent);
+          Bounds all = group.first;
+          all.add(Bounds(group.first.minX + (group.numCol - 1)*group.xSpacing,
+                         group.first.minY + (group.numRow - 1)*group.ySpacing,
+                         group.first.maxX + (group.numCol - 1)*group.xSpacing,
+                         group.first.maxY + (group.numRow - 1)*group.ySpacing));
+          group.extent = transform.apply(all);
+          groups.push_back(group);
+        }
+        return groups;
+      }
+
+      /// \brief Builds the contexts, from the top cells down.
+      void buildContexts(void) {
+        std::size_t numCells = this->layout.getCellCount();
+        this->cellContexts.resize(numCells);
+        Span<const unsigned int> order = this->layout.getHierarchicalOrder();
+        std::vector<unsigned int> height(numCells, 0);
+        for (std::size_t i = 0; i < order.size(); i++) {
+          const FrozenCell& cell = this->layout.getCell(order[i]);
+          for (std::size_t j = 0; j < cell.children.size(); j++)
+            height[order[i]] = std::max(height[order[i]], height[cell.children[j]] + 1);
+        }
+        Span<const unsigned int> tops = this->layout.getTopCells();
+        for (std::size_t i = 0; i < tops.size(); i++)
+          this->addContext(tops[i], 1.0, height[tops[i]]);
+        for (std::size_t i = order.size(); i-- > 0;) {
+          const FrozenCell& cell = this->layout.getCell(order[i]);
+          std::vector<unsigned int> ids = this->cellContexts[order[i]];
+          for (std::size_t c = 0; c < ids.size(); c++) {
+            double magnification = this->contexts[ids[c]].magnification;
+            for (std::size_t j = 0; j < cell.references.size(); j++)
+              this->addContext(cell.references[j].cell,
+                               magnification*cell.references[j].magnification,
+                               height[cell.references[j].cell]);
+            for (std::size_t j = 0; j < cell.arrays.size(); j++)
+              this->addContext(cell.arrays[j].cell,
+                               magnification*cell.arrays[j].magnification,
+                               height[cell.arrays[j].cell]);
+          }
+        }
+      }
+
+      void addContext(unsigned int cell, double magnification, unsigned int height) {
+        if (this->findContext(cell, magnification) != UINT_MAX)
+          return;
+        Context context;
+        context.cell = cell;
+        context.magnification = magnification;
+        context.height = height;
+        context.pending.resize(this->rules.size());
+        this->cellContexts[cell].push_back(this->contexts.size());
+        this->contexts.push_back(context);
+      }
+
+      /// \brief Collects the polygons of @cell on the layers of
+      /// @mergedLayers that touch another polygon on their layer into
+      /// @clusters of touching polygons, and returns which polygons are
+      /// in one.
+      std::vector<char> findClusters(unsigned int cell,
+                                     std::vector<std::vector<unsigned int> >& clusters) const {
+        const FrozenCell& frozen = this->layout.getCell(cell);
+        std::size_t numPolygons = frozen.polygons.size();
+        std::size_t tasks = (numPolygons + POLYGONS_PER_TASK - 1)/POLYGONS_PER_TASK;
+        std::vector<std::vector<std::pair<unsigned int, unsigned int> > > touching(tasks);
+        utils::parallelFor(tasks, [&](std::size_t task) {
+            std::vector<unsigned int> ids;
+            for (std::size_t i = task*POLYGONS_PER_TASK;
+                 i < std::min(numPolygons, (task + 1)*POLYGONS_PER_TASK); i++) {
+              const FrozenPolygon& polygon = frozen.polygons[i];
+              if (!std::binary_search(this->mergedLayers.begin(), this->mergedLayers.end(),
+                                      polygon.layer))
+                continue;
+              ids.clear();
+              this->indices[cell].query(polygon.bounds, ids);
+              for (std::size_t j = 0; j < ids.size(); j++)
+                if (ids[j] > i && frozen.polygons[ids[j]].layer == polygon.layer &&
+                    shapesTouch(viewOf(polygon), viewOf(frozen.polygons[ids[j]])))
+                  touching[task].push_back(std::make_pair(unsigned(i), ids[j]));
+            }
+          });
+
+        std::vector<unsigned int> parent(numPolygons);
+        for (std::size_t i = 0; i < numPolygons; i++)
+          parent[i] = i;
+        auto root = [&parent](unsigned int x) {
+          while (parent[x] != x)
+            x = parent[x] = parent[parent[x]];
+          return x;
+        };
+        std::vector<char> merged(numPolygons, 0);
+        for (std::size_t task = 0; task < tasks; task++)
+          for (std::size_t i = 0; i < touching[task].size(); i++) {
+            unsigned int a = root(touching[task][i].first), b = root(touching[task][i].second);
+            parent[std::max(a, b)] = std::min(a, b);
+            merged[touching[task][i].first] = merged[touching[task][i].second] = 1;
+          }
+        std::vector<unsigned int> clusterOf(numPolygons, UINT_MAX);
+        for (std::size_t i = 0; i < numPolygons; i++) {
+          if (!merged[i])
+            continue;
+          unsigned int top = root(i);
+          if (clusterOf[top] == UINT_MAX) {
+            clusterOf[top] = clusters.size();
+            clusters.push_back(std::vector<unsigned int>());
+          }
+          clusters[clusterOf[top]].push_back(i);
+        }
+        return merged;
+      }
+
+      /// \brief Checks MIN_WIDTH and MIN_AREA on the union of the
+      /// touching polygons @cluster of the cell of @context.
+      void checkCluster(const Context& context, const std::vector<unsigned int>& cluster,
+                        std::vector<DesignRuleViolation>& out) const {
+        const FrozenCell& cell = this->layout.getCell(context.cell);
+        double magnification = context.magnification;
+        int layer = cell.polygons[cluster[0]].layer;
+        utils::ScanlineSweep sweep;
+        for (std::size_t i = 0; i < cluster.size(); i++)
+          sweep.addPolygon(cell.polygons[cluster[i]].vertices, 0);
+        std::vector<Trapezoid> pieces;
+        sweep.sweep(utils::SWEEP_UNION, pieces);
+        std::vector<std::vector<CoordPnt> > outlines;
+        utils::traceOutlines(pieces, outlines);
+        double area = 0;
+        for (std::size_t i = 0; i < pieces.size(); i++)
+          area += pieces[i].getArea();
+
+        // the outlines keep the merged shape on their left
+        std::vector<Shape> shapes(outlines.size());
+        std::size_t largest = 0;
+        for (std::size_t i = 0; i < outlines.size(); i++) {
+          Shape& shape = shapes[i];
+          shape.vertices = Span<const CoordPnt>(outlines[i]);
+          for (std::size_t j = 0; j < outlines[i].size(); j++)
+            shape.bounds.add(outlines[i][j]);
+          shape.orientation = 1;
+          shape.layer = layer;
+          shape.group = OWN_SHAPES;
+          shape.col = shape.row = 0;
+          if (utils::signedArea(shape.vertices) > utils::signedArea(shapes[largest].vertices))
+            largest = i;
+        }
+        if (shapes.empty())
+          return;
+
+        for (std::size_t r = 0; r < this->rules.size(); r++) {
+          const DesignRule& rule = this->rules[r];
+          if (rule.layer != layer)
+            continue;
+          double required = this->limit(rule, magnification);
+          auto edgePair = [&](const CoordPnt& a0, const CoordPnt& a1, const CoordPnt& b0,
+                              const CoordPnt& b1, const CoordPnt& pa, const CoordPnt& pb,
+                              double d) {
+            this->report(context, out, r, d*magnification, edgeMarker(a0, a1, b0, b1, pa, pb, d));
+          };
+          if (rule.kind == MIN_WIDTH) {
+            // across an outline, or between a hole and the outline around it
+            for (std::size_t i = 0; i < shapes.size(); i++) {
+              closeEdges(shapes[i], shapes[i], true, required, true, edgePair);
+              for (std::size_t j = i + 1; j < shapes.size(); j++)
+                if (shapes[i].bounds.grown(required).intersects(shapes[j].bounds))
+                  closeEdges(shapes[i], shapes[j], false, required, true, edgePair);
+            }
+          }
+          else if (rule.kind == MIN_AREA && below(area, required))
+            this->report(context, out, r, area*magnification*magnification, outlines[largest]);
+        }
+      }
+
+      /// \brief Checks the polygons [@first, @last) of the cell of
+      /// @context against each other, reporting into @out. The polygons
+      /// flagged in @merged are left to checkCluster() for MIN_WIDTH and
+      /// MIN_AREA.
+      void checkOwnShapes(const Context& context, std::size_t first, std::size_t last,
+                          const std::vector<char>& merged,
+                          std::vector<DesignRuleViolation>& out) const {
+        const FrozenCell& cell = this->layout.getCell(context.cell);
+        double magnification = context.magnification;
+        std::vector<unsigned int> ids;
+        for (std::size_t i = first; i < last; i++) {
+          Shape shape = viewOf(cell.polygons[i]);
+          for (std::size_t r = 0; r < this->rules.size(); r++) {
+            const DesignRule& rule = this->rules[r];
+            if (rule.layer != shape.layer)
+              continue;
+            double required = this->limit(rule, magnification);
+            auto edgePair = [&](const CoordPnt& a0, const CoordPnt& a1, const CoordPnt& b0,
+                                const CoordPnt& b1, const CoordPnt& pa, const CoordPnt& pb,
+                                double d) {
+              this->report(context, out, r, d*magnification,
+                           edgeMarker(a0, a1, b0, b1, pa, pb, d));
+            };
+            if ((rule.kind == MIN_WIDTH || rule.kind == MIN_AREA) && merged[i])
+              continue;
+            if (rule.kind == MIN_WIDTH)
+              closeEdges(shape, shape, true, required, true, edgePair);
+            else if (rule.kind == MIN_AREA) {
+              double area = std::abs(cell.polygons[i].signedArea);
+              if (below(area, required))
+                this->report(context, out, r, area*magnification*magnification,
+                             std::vector<CoordPnt>(shape.vertices.begin(), shape.vertices.end()));
+            }
+            else if (rule.kind == MIN_SPACING) {
+              // notches of the polygon itself, then its neighbours
+              closeEdges(shape, shape, true, required, false, edgePair);
+              ids.clear();
+              this->indices[context.cell].query(shape.bounds.grown(required), ids);
+              std::sort(ids.begin(), ids.end());
+              for (std::size_t j = 0; j < ids.size(); j++) {
+                if (ids[j] <= i || cell.polygons[ids[j]].layer != rule.layer)
+                  continue;
+                Shape other = viewOf(cell.polygons[ids[j]]);
+                if (!shapesTouch(shape, other))
+                  closeEdges(shape, other, false, required, false, edgePair);
+              }
+            }
+          }
+        }
+      }
+
+      void checkOwnPaths(const Context& context, std::vector<DesignRuleViolation>& out) const {
+        const FrozenCell& cell = this->layout.getCell(context.cell);
+        for (std::size_t i = 0; i < cell.paths.size(); i++) {
+          const FrozenPath& path = cell.paths[i];
+          for (std::size_t r = 0; r < this->rules.size(); r++) {
+            const DesignRule& rule = this->rules[r];
+            if (rule.kind != MIN_WIDTH || rule.layer != path.layer ||
+                !below(path.width, this->limit(rule, context.magnification)) ||
+                path.bounds.isEmpty())
+              continue;
+            std::vector<CoordPnt> marker;
+            marker.push_back(CoordPnt(path.bounds.minX, path.bounds.minY));
+            marker.push_back(CoordPnt(path.bounds.maxX, path.bounds.minY));
+            marker.push_back(CoordPnt(path.bounds.maxX, path.bounds.maxY));
+            marker.push_back(CoordPnt(path.bounds.minX, path.bounds.maxY));
+            this->report(context, out, r, path.width*context.magnification, marker);
+          }
+        }
+      }
+
+      /// \brief Adds the shapes on @layers of one side of an interaction
+      /// that meet @window.
+      void gather(const Context& context, const std::vector<Group>& groups, int group,
+                  long col, long row, const Bounds& window, const std::vector<int>& layers,
+                  ShapeSet& out) const {
+        if (group == OWN_SHAPES) {
+          const FrozenCell& cell = this->layout.getCell(context.cell);
+          std::vector<unsigned int> ids;
+          this->indices[context.cell].query(window, ids);
+          std::sort(ids.begin(), ids.end());
+          for (std::size_t i = 0; i < ids.size(); i++)
+            if (std::binary_search(layers.begin(), layers.end(), cell.polygons[ids[i]].layer))
+              out.addView(cell.polygons[ids[i]]);
+          return;
+        }
+        this->collect(groups[group].cell, groups[group].element(col, row), window, layers,
+                      group, col, row, out);
+      }
+
+      Bounds sideExtent(const Context& context, const std::vector<Group>& groups, int group,
+                        long col, long row) const {
+        if (group == OWN_SHAPES)
+          return this->layout.getCell(context.cell).bounds;
+        return groups[group].elementExtent(col, row);
+      }
+
+      /// \brief Lists the pairs of placements whose shapes may be closer
+      /// than @reach.
+      std::vector<Interaction> interactions(const Context& context,
+                                            const std::vector<Group>& groups,
+                                            double reach) const {
+        std::vector<Interaction> found;
+        std::vector<Bounds> extents(groups.size());
+        for (std::size_t g = 0; g < groups.size(); g++)
+          extents[g] = groups[g].extent;
+        SpatialIndex index(extents);
+        Bounds own = this->layout.getCell(context.cell).bounds;
+
+        // the shapes of the cell and the elements of each placement
+        std::vector<unsigned int> ids;
+        index.query(own.grown(reach), ids);
+        for (std::size_t i = 0; i < ids.size(); i++) {
+          long firstCol, lastCol, firstRow, lastRow;
+          if (groups[ids[i]].elementsIn(own.grown(reach), firstCol, lastCol, firstRow, lastRow))
+            for (long c = firstCol; c <= lastCol; c++)
+              for (long r = firstRow; r <= lastRow; r++) {
+                Interaction pair = {OWN_SHAPES, 0, 0, int(ids[i]), c, r};
+                found.push_back(pair);
+              }
+        }
+
+        for (std::size_t g = 0; g < groups.size(); g++) {
+          const Group& group = groups[g];
+          // the elements of an array among themselves, one pair per offset
+          long firstCol, lastCol, firstRow, lastRow;
+          if ((group.numCol > 1 || group.numRow > 1) &&
+              group.elementsIn(group.elementExtent(0, 0).grown(reach), 0, group.numCol - 1,
+                               1 - group.numRow, group.numRow - 1,
+                               firstCol, lastCol, firstRow, lastRow))
+            for (long dc = firstCol; dc <= lastCol; dc++)
+              for (long dr = firstRow; dr <= lastRow; dr++) {
+                if (dc == 0 && dr <= 0)
+                  continue;
+                long row = std::max(0L, -dr);
+                Interaction pair = {int(g), 0, row, int(g), dc, row + dr};
+                found.push_back(pair);
+              }
+
+          // and with the elements of the later placements
+          ids.clear();
+          index.query(group.extent.grown(reach), ids);
+          std::sort(ids.begin(), ids.end());
+          for (std::size_t i = 0; i < ids.size(); i++) {
+            if (ids[i] <= g)
+              continue;
+            const Group& other = groups[ids[i]];
+            if (!group.elementsIn(other.extent.grown(reach), firstCol, lastCol, firstRow, lastRow))
+              continue;
+            for (long c = firstCol; c <= lastCol; c++)
+              for (long r = firstRow; r <= lastRow; r++) {
+                long otherFirstCol, otherLastCol, otherFirstRow, otherLastRow;
+                if (!other.elementsIn(group.elementExtent(c, r).grown(reach), otherFirstCol,
+                                      otherLastCol, otherFirstRow, otherLastRow))
+                  continue;
+                for (long oc = otherFirstCol; oc <= otherLastCol; oc++)
+                  for (long orow = otherFirstRow; orow <= otherLastRow; orow++) {
+                    Interaction pair = {int(g), c, r, int(ids[i]), oc, orow};
+                    found.push_back(pair);
+                  }
+              }
+          }
+        }
+        return found;
+      }
+
+      /// \brief Checks the spacing between the shapes of the two sides
+      /// of @pair.
+      void checkInteraction(const Context& context, const std::vector<Group>& groups,
+                            const Interaction& pair, double reach,
+                            std::vector<DesignRuleViolation>& out) const {
+        Bounds extentA = this->sideExtent(context, groups, pair.groupA, pair.colA, pair.rowA);
+        Bounds extentB = this->sideExtent(context, groups, pair.groupB, pair.colB, pair.rowB);
+        Bounds windowA = extentA.intersection(extentB.grown(reach));
+        Bounds windowB = extentB.intersection(extentA.grown(reach));
+        if (windowA.isEmpty() || windowB.isEmpty())
+          return;
+        ShapeSet sideA, sideB;
+        this->gather(context, groups, pair.groupA, pair.colA, pair.rowA, windowA,
+                     this->spacingLayers, sideA);
+        if (sideA.shapes.empty())
+          return;
+        this->gather(context, groups, pair.groupB, pair.colB, pair.rowB, windowB,
+                     this->spacingLayers, sideB);
+        for (std::size_t r = 0; r < this->rules.size(); r++) {
+          const DesignRule& rule = this->rules[r];
+          if (rule.kind != MIN_SPACING)
+            continue;
+          double required = this->limit(rule, context.magnification);
+          for (std::size_t i = 0; i < sideA.shapes.size(); i++) {
+            const Shape& a = sideA.shapes[i];
+            if (a.layer != rule.layer)
+              continue;
+            Bounds near = a.bounds.grown(required);
+            for (std::size_t j = 0; j < sideB.shapes.size(); j++) {
+              const Shape& b = sideB.shapes[j];
+              if (b.layer != rule.layer || !near.intersects(b.bounds) || shapesTouch(a, b))
+                continue;
+              closeEdges(a, b, false, required, false,
+                         [&](const CoordPnt& a0, const CoordPnt& a1, const CoordPnt& b0,
+                             const CoordPnt& b1, const CoordPnt& pa, const CoordPnt& pb,
+                             double d) {
+                           this->report(context, out, r, d*context.magnification,
+                                        edgeMarker(a0, a1, b0, b1, pa, pb, d));
+                         });
+            }
+          }
+        }
+      }
+
+      /// \brief Tries to enclose the inner shapes of the cell and those
+      /// its placements left open, for the enclosure rule @r. What stays
+      /// open is handed to the parents, or reported by top cells.
+      void checkEnclosure(Context& context, const std::vector<Group>& groups, std::size_t r,
+                          bool top) const {
+        const DesignRule& rule = this->rules[r];
+        const FrozenCell& cell = this->layout.getCell(context.cell);
+        double magnification = context.magnification;
+        std::vector<int> outerLayers(1, rule.outerLayer);
+
+        // the candidates: inner shapes of the cell, then the open ones of the placements
+        ShapeSet inner;
+        std::vector<double> margins;
+        for (std::size_t i = 0; i < cell.polygons.size(); i++)
+          if (cell.polygons[i].layer == rule.layer) {
+            inner.addView(cell.polygons[i]);
+            margins.push_back(-1);
+          }
+        for (std::size_t g = 0; g < groups.size(); g++) {
+          unsigned int child = this->findContext(groups[g].cell,
+                                                 magnification*groups[g].magnification);
+          if (child == UINT_MAX)
+            continue;
+          const std::vector<PendingEnclosure>& open = this->contexts[child].pending[r];
+          for (std::size_t i = 0; i < open.size(); i++)
+            for (long c = 0; c < groups[g].numCol; c++)
+              for (long row = 0; row < groups[g].numRow; row++) {
+                inner.addTransformed(Span<const CoordPnt>(open[i].vertices), open[i].orientation,
+                                     rule.layer, groups[g].element(c, row), g, c, row);
+                margins.push_back(open[i].margin);
+              }
+        }
+
+        std::vector<Bounds> extents(groups.size());
+        for (std::size_t g = 0; g < groups.size(); g++)
+          extents[g] = groups[g].extent;
+        SpatialIndex index(extents);
+        std::size_t numCandidates = inner.shapes.size();
+        std::size_t tasks = (numCandidates + POLYGONS_PER_TASK - 1)/POLYGONS_PER_TASK;
+        std::vector<char> enclosed(numCandidates, 0);
+        utils::parallelFor(tasks, [&](std::size_t task) {
+            std::vector<unsigned int> ids;
+            for (std::size_t i = task*POLYGONS_PER_TASK;
+                 i < std::min(numCandidates, (task + 1)*POLYGONS_PER_TASK); i++) {
+              const Shape& shape = inner.shapes[i];
+              ShapeSet outer;
+              this->gather(context, groups, OWN_SHAPES, 0, 0, shape.bounds, outerLayers, outer);
+              ids.clear();
+              index.query(shape.bounds, ids);
+              std::sort(ids.begin(), ids.end());
+              for (std::size_t j = 0; j < ids.size(); j++) {
+                long firstCol, lastCol, firstRow, lastRow;
+                if (!groups[ids[j]].elementsIn(shape.bounds, firstCol, lastCol, firstRow, lastRow))
+                  continue;
+                for (long c = firstCol; c <= lastCol; c++)
+                  for (long row = firstRow; row <= lastRow; row++)
+                    if (!(shape.group == int(ids[j]) && shape.col == c && shape.row == row))
+                      this->gather(context, groups, ids[j], c, row, shape.bounds, outerLayers,
+                                   outer);
+              }
+              for (std::size_t j = 0; j < outer.shapes.size() && !enclosed[i]; j++) {
+                double margin = enclosureMargin(shape, outer.shapes[j]);
+                if (margin < 0)
+                  continue;
+                margin *= magnification;
+                margins[i] = std::max(margins[i], margin);
+                enclosed[i] = !below(margin, rule.value);
+              }
+            }
+          });
+
+        for (std::size_t i = 0; i < numCandidates; i++) {
+          if (enclosed[i])
+            continue;
+          const Shape& shape = inner.shapes[i];
+          std::vector<CoordPnt> vertices(shape.vertices.begin(), shape.vertices.end());
+          if (top) {
+            this->report(context, context.violations, r, margins[i], vertices);
+            continue;
+          }
+          PendingEnclosure open;
+          open.vertices = vertices;
+          open.orientation = shape.orientation;
+          open.margin = margins[i];
+          context.pending[r].push_back(open);
+        }
+      }
+
+      void checkContext(Context& context) {
+        const FrozenCell& cell = this->layout.getCell(context.cell);
+        std::size_t numPolygons = cell.polygons.size();
+        std::size_t tasks = (numPolygons + POLYGONS_PER_TASK - 1)/POLYGONS_PER_TASK;
+        std::vector<std::vector<unsigned int> > clusters;
+        std::vector<char> merged = this->findClusters(context.cell, clusters);
+        std::vector<std::vector<DesignRuleViolation> > found(tasks + clusters.size());
+        utils::parallelFor(tasks + clusters.size(), [&](std::size_t task) {
+            if (task < tasks)
+              this->checkOwnShapes(context, task*POLYGONS_PER_TASK,
+                                   std::min(numPolygons, (task + 1)*POLYGONS_PER_TASK),
+                                   merged, found[task]);
+            else
+              this->checkCluster(context, clusters[task - tasks], found[task]);
+          });
+        for (std::size_t i = 0; i < found.size(); i++)
+          context.violations.insert(context.violations.end(), found[i].begin(), found[i].end());
+        this->checkOwnPaths(context, context.violations);
+
+        std::vector<Group> groups = this->placements(context.cell, Transform());
+        if (this->maxSpacing > 0 && !groups.empty()) {
+          double reach = this->maxSpacing/context.magnification;
+          std::vector<Interaction> pairs = this->interactions(context, groups, reach);
+          std::vector<std::vector<DesignRuleViolation> > between(pairs.size());
+          utils::parallelFor(pairs.size(), [&](std::size_t i) {
+              this->checkInteraction(context, groups, pairs[i], reach, between[i]);
+            });
+          for (std::size_t i = 0; i < pairs.size(); i++)
+            context.violations.insert(context.violations.end(), between[i].begin(),
+                                      between[i].end());
+        }
+
+        bool top = cell.parents.empty();
+        for (std::size_t r = 0; r < this->rules.size(); r++)
+          if (this->rules[r].kind == MIN_ENCLOSURE)
+            this->checkEnclosure(context, groups, r, top);
+      }
+
+    public:
+      Checker(const FrozenLayout& usrLayout, const std::vector<DesignRule>& usrRules) :
+        layout(usrLayout), rules(usrRules), maxSpacing(0) {
+        for (std::size_t r = 0; r < this->rules.size(); r++)
+          if (this->rules[r].kind == MIN_SPACING) {
+            this->maxSpacing = std::max(this->maxSpacing, this->rules[r].value);
+            this->spacingLayers.push_back(this->rules[r].layer);
+          }
+          else if (this->rules[r].kind == MIN_WIDTH || this->rules[r].kind == MIN_AREA)
+            this->mergedLayers.push_back(this->rules[r].layer);
+        std::sort(this->spacingLayers.begin(), this->spacingLayers.end());
+        std::sort(this->mergedLayers.begin(), this->mergedLayers.end());
+        this->indices.resize(this->layout.getCellCount());
+        utils::parallelFor(this->indices.size(), [&](std::size_t i) {
+            Span<const FrozenPolygon> polygons = this->layout.getCell(i).polygons;
+            std::vector<Bounds> boxes(polygons.size());
+            for (std::size_t j = 0; j < polygons.size(); j++)
+              boxes[j] = polygons[j].bounds;
+            this->indices[i] = SpatialIndex(boxes);
+          });
+        this->buildContexts();
+      }
+
+      DesignRuleReport run(void) {
+        // cells are checked level by level from the leaves, so that the
+        // shapes their placements leave open are known
+        std::vector<std::vector<unsigned int> > levels;
+        for (unsigned int i = 0; i < this->contexts.size(); i++) {
+          if (levels.size() <= this->contexts[i].height)
+            levels.resize(this->contexts[i].height + 1);
+          levels[this->contexts[i].height].push_back(i);
+        }
+        for (std::size_t level = 0; level < levels.size(); level++)
+          utils::parallelFor(levels[level].size(), [&](std::size_t i) {
+              this->checkContext(this->contexts[levels[level][i]]);
+            });
+        DesignRuleReport result;
+        for (std::size_t i = 0; i < this->contexts.size(); i++)
+          result.violations.insert(result.violations.end(), this->contexts[i].violations.begin(),
+                                   this->contexts[i].violations.end());
+        return result;
+      }
+    };
+
+  } // namespace
+
+  DesignRuleReport checkDesignRules(const FrozenLayout& layout,
+                                    const std::vector<DesignRule>& rules) {
+    Checker checker(layout, rules);
+    return checker.run();
+  }
+
+  DesignRuleReport checkDesignRules(const Layout& layout,
+                                    const std::vector<DesignRule>& rules) {
+    return checkDesignRules(*layout.freeze(), rules);
+  }
+
+}
@@ -0,0 +1,112 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef DESIGN_RULES_HXX
+#define DESIGN_RULES_HXX
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "polygon.hxx"
+#include "layout.hxx"
+#include "frozenLayout.hxx"
+
+namespace sil {
+
+  /// \brief The checks checkDesignRules() can run.
+  enum DesignRuleKind {
+    MIN_WIDTH, //!< The merged polygons and the paths on a layer are at least this wide.
+    MIN_SPACING, //!< Polygons on a layer are at least this far apart.
+    MIN_AREA, //!< The merged polygons on a layer have at least this area.
+    MIN_ENCLOSURE //!< Polygons on a layer lie this far inside a polygon of another.
+  };
+
+  /// \brief One rule of a design rule deck.
+  struct DesignRule {
+    DesignRuleKind kind; //!< What is checked.
+    int layer; //!< The layer checked, the inner layer for MIN_ENCLOSURE.
+    int outerLayer; //!< The layer that must enclose @layer, only used by MIN_ENCLOSURE.
+    double value; //!< The distance in user units, or the area in square user units.
+
+    /// \brief Creates a rule, throwing std::invalid_argument if @usrValue
+    /// is not positive or a MIN_ENCLOSURE rule has no outer layer.
+    DesignRule(DesignRuleKind usrKind, int usrLayer, double usrValue,
+               int usrOuterLayer = -1);
+  };
+
+  /// \brief One place where a rule is broken.
+  struct DesignRuleViolation {
+    std::size_t rule; //!< The position of the rule in the deck.
+    DesignRuleKind kind; //!< The kind of the rule.
+    unsigned int cell; //!< The cell of the FrozenLayout the marker is in.
+    std::string cellname; //!< The name of that cell.
+    double magnification; //!< The magnification the cell was checked at.
+    double measured; //!< The width, spacing, area or enclosure found, -1 if not enclosed at all.
+    double required; //!< The value of the rule.
+    Polygon marker; //!< The offending region, in the coordinates of the cell.
+  };
+
+  /// \brief The result of checkDesignRules().
+  struct DesignRuleReport {
+    /// \brief Every violation, grouped by the cell it was found in.
+    std::vector<DesignRuleViolation> violations;
+
+    /// \brief Returns true if no rule is broken.
+    bool isClean(void) const;
+
+    /// \brief Returns the number of violations of the rule at @rule.
+    std::size_t count(std::size_t rule) const;
+
+    /// \brief Returns a line per violation, prefixed with the cell name.
+    std::string toString(void) const;
+  };
+
+  /// \brief Checks the polygons and paths of @layout against @rules.
+  ///
+  /// @layout The layout to check.
+  /// @rules The rule deck.
+  ///
+  /// The check is hierarchical. Every cell is checked once for each
+  /// magnification it is placed at (usually just once), in its own
+  /// coordinates, and its violations are reported there however often
+  /// it is placed. Its parent then only checks what happens between
+  /// its instances and its own shapes: spacing between shapes that come
+  /// from different instances, and enclosure for inner shapes that
+  /// their own cell does not enclose. The elements of an array are
+  /// identical, so each distinct offset between two of them is checked
+  /// once. A spatial index over the shapes of every cell keeps all of
+  /// the searches local, and the cells of each level of the hierarchy,
+  /// as well as chunks of the shapes of large cells, are checked in
+  /// parallel.
+  ///
+  /// For MIN_WIDTH and MIN_AREA the polygons of a cell that overlap or
+  /// touch on a layer are merged with a scanline union first, so a
+  /// width or area is that of the merged shape; polygons from different
+  /// cells are not merged. MIN_SPACING and MIN_ENCLOSURE look at each
+  /// polygon on its own: overlapping or touching polygons are never too
+  /// close to each other, and an enclosing shape must be a single
+  /// polygon. Paths are only checked for MIN_WIDTH, against their width.
+  DesignRuleReport checkDesignRules(const FrozenLayout& layout,
+                                    const std::vector<DesignRule>& rules);
+
+  /// \brief Freezes @layout and checks it, see the function above.
+  DesignRuleReport checkDesignRules(const Layout& layout,
+                                    const std::vector<DesignRule>& rules);
+
+}
+
+#endif // DESIGN_RULES_HXX
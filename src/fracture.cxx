@@ -0,0 +1,341 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "fracture.hxx"
+#include "geometry.hxx"
+#include "layout.hxx"
+#include "parallel.hxx"
+#include <algorithm>
+#include <map>
+#include <utility>
+
+namespace sil {
+
+  FractureOptions::FractureOptions() :
+    sliverSize(1e-6), minFigureSize(0), mergeOverlaps(false) {}
+
+  namespace {
+
+    /// \brief The number of jobs fractured by one task.
+    const std::size_t JOBS_PER_BLOCK = 256;
+
+    /// \brief A polygon or path of a Cell.
+    struct ShapeRef {
+      bool path; //!< True for a path, false for a polygon.
+      unsigned int index; //!< The index in the polygons or paths of the Cell.
+    };
+
+    /// \brief Shapes of one Cell, layer and datatype that are fractured
+    /// together.
+    struct Job {
+      unsigned int cell;
+      int layer;
+      int dataType;
+      std::size_t firstShape; //!< The index of the first ShapeRef.
+      std::size_t shapeCount;
+    };
+
+    /// \brief The figures of a block of consecutive jobs.
+    struct Block {
+      std::vector<Trapezoid> trapezoids;
+      std::vector<std::size_t> counts; //!< The number of figures of each job.
+      std::vector<std::size_t> figuresDropped; //!< The figures each job dropped.
+      std::vector<double> droppedArea; //!< Their area.
+    };
+
+    /// \brief Fractures the shapes added to it together.
+    class Fracturer {
+    private:
+      const FractureOptions& options;
+      std::vector<CoordPnt> points; //!< The vertices of every outline.
+      std::vector<std::size_t> sizes; //!< The number of vertices of each outline.
+      std::vector<CoordPnt> quads;
+      std::vector<double> levels;
+      std::vector<double> snapped;
+      utils::ScanlineSweep sweep;
+
+    public:
+      std::size_t figuresDropped;
+      double droppedArea;
+
+      Fracturer(const FractureOptions& usrOptions) :
+        options(usrOptions), figuresDropped(0), droppedArea(0) {}
+
+      void addOutline(Span<const CoordPnt> vertices) {
+        this->points.insert(this->points.end(), vertices.begin(), vertices.end());
+        this->sizes.push_back(vertices.size());
+      }
+
+      void addPath(const FrozenPath& path) {
+        this->quads.clear();
+        std::size_t count = utils::pathQuads(path.points, path.width, path.pathType,
+                                             utils::Transform(), this->quads);
+        for (std::size_t i = 0; i < count; i++)
+          this->addOutline(Span<const CoordPnt>(&this->quads[4*i], 4));
+      }
+
+      /// \brief Moves the vertices closer than the sliver size in y
+      /// onto the lowest of them.
+      void snapLevels(void) {
+        this->levels.clear();
+        for (std::size_t i = 0; i < this->points.size(); i++)
+          this->levels.push_back(this->points[i].getY());
+        std::sort(this->levels.begin(), this->levels.end());
+        this->levels.erase(std::unique(this->levels.begin(), this->levels.end()),
+                           this->levels.end());
+        this->snapped.resize(this->levels.size());
+        double anchor = 0;
+        for (std::size_t i = 0; i < this->levels.size(); i++) {
+          if (i == 0 || this->levels[i] - anchor >= this->options.sliverSize)
+            anchor = this->levels[i];
+          this->snapped[i] = anchor;
+        }
+        for (std::size_t i = 0; i < this->points.size(); i++) {
+          double y = this->points[i].getY();
+          std::size_t level = std::lower_bound(this->levels.begin(), this->levels.end(), y) -
+            this->levels.begin();
+          if (this->snapped[level] != y)
+            this->points[i] = CoordPnt(this->points[i].getX(), this->snapped[level]);
+        }
+      }
+
+      /// \brief Returns the x coordinate of the chain from @lower to
+      /// @upper at @y.
+      static double xAt(const CoordPnt& lower, const CoordPnt& upper, double y) {
+        return lower.getX() + (y - lower.getY())*(upper.getX() - lower.getX())/
+          (upper.getY() - lower.getY());
+      }
+
+      /// \brief Appends the figures of a single outline that is monotone
+      /// in y to @result, slice by slice between its vertices.
+      ///
+      /// Returns false, leaving @result as it was, if the outline is not
+      /// monotone or its two chains cross, which needs the full sweep.
+      bool fillMonotone(std::vector<Trapezoid>& result) {
+        const std::vector<CoordPnt>& p = this->points;
+        std::size_t n = p.size();
+        std::size_t low = 0, high = 0;
+        for (std::size_t i = 1; i < n; i++) {
+          if (p[i].getY() < p[low].getY())
+            low = i;
+          if (p[i].getY() > p[high].getY())
+            high = i;
+        }
+        if (p[low].getY() == p[high].getY())
+          return true; // no area
+        // monotone outlines only turn from rising to falling once
+        int turns = 0, direction = 0;
+        for (std::size_t i = 0; i <= n; i++) {
+          double dy = p[(low + i + 1)%n].getY() - p[(low + i)%n].getY();
+          int now = dy > 0 ? 1 : dy < 0 ? -1 : direction;
+          turns += now != direction && direction != 0;
+          direction = now;
+        }
+        if (turns > 2)
+          return false;
+
+        if (this->options.sliverSize <= 0) {
+          this->levels.clear();
+          for (std::size_t i = 0; i < n; i++)
+            this->levels.push_back(p[i].getY());
+          std::sort(this->levels.begin(), this->levels.end());
+          this->levels.erase(std::unique(this->levels.begin(), this->levels.end()),
+                             this->levels.end());
+        } else // snapLevels() left the levels in snapped
+          this->levels.assign(this->snapped.begin(),
+                              std::unique(this->snapped.begin(), this->snapped.end()));
+        // walk up both chains from the lowest vertex to the highest
+        std::size_t start = result.size();
+        std::size_t a = low, b = low;
+        for (std::size_t k = 0; k + 1 < this->levels.size(); k++) {
+          double y0 = this->levels[k], y1 = this->levels[k + 1];
+          while (p[(a + 1)%n].getY() <= y0)
+            a = (a + 1)%n;
+          while (p[(b + n - 1)%n].getY() <= y0)
+            b = (b + n - 1)%n;
+          const CoordPnt& nextA = p[(a + 1)%n];
+          const CoordPnt& nextB = p[(b + n - 1)%n];
+          double a0 = xAt(p[a], nextA, y0), a1 = xAt(p[a], nextA, y1);
+          double b0 = xAt(p[b], nextB, y0), b1 = xAt(p[b], nextB, y1);
+          if ((a0 - b0)*(a1 - b1) < 0) {
+            result.resize(start);
+            return false;
+          }
+          bool aLeft = a0 + a1 < b0 + b1;
+          Trapezoid slice = {y0, y1, aLeft ? a0 : b0, aLeft ? b0 : a0,
+                             aLeft ? a1 : b1, aLeft ? b1 : a1};
+          if (slice.bottomRight > slice.bottomLeft || slice.topRight > slice.topLeft)
+            result.push_back(slice);
+        }
+        return true;
+      }
+
+      /// \brief Appends the figures of the outlines added so far to
+      /// @result and starts over.
+      void finish(std::vector<Trapezoid>& result) {
+        if (this->options.sliverSize > 0)
+          this->snapLevels();
+        std::size_t start = result.size();
+        if (this->sizes.size() != 1 || this->points.size() < 3 || !this->fillMonotone(result)) {
+          std::size_t first = 0;
+          for (std::size_t i = 0; i < this->sizes.size(); i++) {
+            this->sweep.addPolygon(Span<const CoordPnt>(this->points.data() + first,
+                                                        this->sizes[i]), 0);
+            first += this->sizes[i];
+          }
+          this->sweep.sweep(utils::SWEEP_UNION, result);
+        }
+        if (this->options.minFigureSize > 0) {
+          std::size_t kept = start;
+          for (std::size_t i = start; i < result.size(); i++) {
+            const Trapezoid& figure = result[i];
+            double width = std::max(figure.bottomRight - figure.bottomLeft,
+                                    figure.topRight - figure.topLeft);
+            if (figure.top - figure.bottom < this->options.minFigureSize &&
+                width < this->options.minFigureSize) {
+              this->figuresDropped++;
+              this->droppedArea += figure.getArea();
+            } else
+              result[kept++] = figure;
+          }
+          result.resize(kept);
+        }
+        this->sweep.clear();
+        this->points.clear();
+        this->sizes.clear();
+      }
+    };
+
+  } // namespace
+
+  std::size_t fracturePolygon(Span<const CoordPnt> vertices, const FractureOptions& options,
+                              std::vector<Trapezoid>& result) {
+    Fracturer fracturer(options);
+    fracturer.addOutline(vertices);
+    fracturer.finish(result);
+    return fracturer.figuresDropped;
+  }
+
+  std::vector<FracturedCell> fracture(const FrozenLayout& layout, FractureOptions options) {
+    // the shapes of every Cell, sorted by layer and datatype, in jobs
+    std::vector<ShapeRef> shapes;
+    std::vector<Job> jobs;
+    std::vector<std::size_t> firstJob(layout.getCellCount() + 1, 0);
+    for (std::size_t c = 0; c < layout.getCellCount(); c++) {
+      firstJob[c] = jobs.size();
+      const FrozenCell& cell = layout.getCell(c);
+      std::map<std::pair<int, int>, std::vector<ShapeRef>> byLayer;
+      for (std::size_t i = 0; i < cell.polygons.size(); i++) {
+        const FrozenPolygon& polygon = cell.polygons[i];
+        ShapeRef shape = {false, static_cast<unsigned int>(i)};
+        byLayer[std::make_pair(polygon.layer, polygon.dataType)].push_back(shape);
+      }
+      for (std::size_t i = 0; i < cell.paths.size(); i++) {
+        const FrozenPath& path = cell.paths[i];
+        ShapeRef shape = {true, static_cast<unsigned int>(i)};
+        byLayer[std::make_pair(path.layer, path.dataType)].push_back(shape);
+      }
+      for (auto it = byLayer.begin(); it != byLayer.end(); ++it) {
+        int layer = it->first.first;
+        if (!options.layers.empty() &&
+            std::find(options.layers.begin(), options.layers.end(), layer) == options.layers.end())
+          continue;
+        std::size_t first = shapes.size();
+        shapes.insert(shapes.end(), it->second.begin(), it->second.end());
+        if (options.mergeOverlaps) {
+          Job job = {static_cast<unsigned int>(c), layer, it->first.second, first,
+                     it->second.size()};
+          jobs.push_back(job);
+        } else
+          for (std::size_t i = 0; i < it->second.size(); i++) {
+            Job job = {static_cast<unsigned int>(c), layer, it->first.second, first + i, 1};
+            jobs.push_back(job);
+          }
+      }
+    }
+    firstJob[layout.getCellCount()] = jobs.size();
+
+    // fracture the jobs in blocks
+    std::vector<Block> blocks((jobs.size() + JOBS_PER_BLOCK - 1)/JOBS_PER_BLOCK);
+    utils::parallelFor(blocks.size(), [&](std::size_t b) {
+        Block& block = blocks[b];
+        Fracturer fracturer(options);
+        std::size_t end = std::min(jobs.size(), (b + 1)*JOBS_PER_BLOCK);
+        for (std::size_t j = b*JOBS_PER_BLOCK; j < end; j++) {
+          const FrozenCell& cell = layout.getCell(jobs[j].cell);
+          for (std::size_t s = 0; s < jobs[j].shapeCount; s++) {
+            const ShapeRef& shape = shapes[jobs[j].firstShape + s];
+            if (shape.path)
+              fracturer.addPath(cell.paths[shape.index]);
+            else
+              fracturer.addOutline(cell.polygons[shape.index].vertices);
+          }
+          std::size_t before = block.trapezoids.size();
+          fracturer.figuresDropped = 0;
+          fracturer.droppedArea = 0;
+          fracturer.finish(block.trapezoids);
+          block.counts.push_back(block.trapezoids.size() - before);
+          block.figuresDropped.push_back(fracturer.figuresDropped);
+          block.droppedArea.push_back(fracturer.droppedArea);
+        }
+      });
+
+    // where the figures of every job start in their block
+    std::vector<std::size_t> offsets(jobs.size());
+    for (std::size_t b = 0; b < blocks.size(); b++) {
+      std::size_t offset = 0;
+      for (std::size_t i = 0; i < blocks[b].counts.size(); i++) {
+        offsets[b*JOBS_PER_BLOCK + i] = offset;
+        offset += blocks[b].counts[i];
+      }
+    }
+
+    // gather the jobs of every Cell into one array
+    std::vector<FracturedCell> result(layout.getCellCount());
+    utils::parallelFor(result.size(), [&](std::size_t c) {
+        FracturedCell& target = result[c];
+        target.figuresDropped = 0;
+        target.droppedArea = 0;
+        std::size_t total = 0;
+        for (std::size_t j = firstJob[c]; j < firstJob[c + 1]; j++)
+          total += blocks[j/JOBS_PER_BLOCK].counts[j%JOBS_PER_BLOCK];
+        target.trapezoids.reserve(total);
+        for (std::size_t j = firstJob[c]; j < firstJob[c + 1]; j++) {
+          const Block& block = blocks[j/JOBS_PER_BLOCK];
+          std::size_t count = block.counts[j%JOBS_PER_BLOCK];
+          target.figuresDropped += block.figuresDropped[j%JOBS_PER_BLOCK];
+          target.droppedArea += block.droppedArea[j%JOBS_PER_BLOCK];
+          if (target.groups.empty() || target.groups.back().layer != jobs[j].layer ||
+              target.groups.back().dataType != jobs[j].dataType) {
+            FractureGroup group = {jobs[j].layer, jobs[j].dataType, target.trapezoids.size(), 0};
+            target.groups.push_back(group);
+          }
+          target.groups.back().count += count;
+          target.trapezoids.insert(target.trapezoids.end(),
+                                   block.trapezoids.begin() + offsets[j],
+                                   block.trapezoids.begin() + offsets[j] + count);
+        }
+      });
+    return result;
+  }
+
+  FracturedCell fracture(const Cell& cell, FractureOptions options) {
+    std::vector<FracturedCell> cells = fracture(*FrozenLayout::freeze(cell), options);
+    return std::move(cells[0]);
+  }
+
+}
@@ -0,0 +1,118 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef FRACTURE_HXX
+#define FRACTURE_HXX
+
+#include <cstddef>
+#include <vector>
+#include "cell.hxx"
+#include "coord.hxx"
+#include "frozenLayout.hxx"
+#include "scanline.hxx"
+#include "span.hxx"
+
+namespace sil {
+
+  /// \brief The settings used by fracture().
+  struct FractureOptions {
+    /// \brief Vertices whose y coordinates are closer than this are
+    /// moved onto one scanline first, so that no figure is cut thinner
+    /// than this at a vertex, at the cost of moving vertices by less
+    /// than @sliverSize.
+    ///
+    /// The default is far below the database unit of the writers and
+    /// only removes the slivers left by rounding, like the mirrored
+    /// vertices of a Circle that differ in their last bits. Larger
+    /// values also merge the thin slices at the top and bottom of a
+    /// Circle or Oval.
+    double sliverSize;
+
+    /// \brief Figures whose height and width are both below this are
+    /// too small for the mask writer and are dropped.
+    double minFigureSize;
+
+    /// \brief If true the overlapping shapes of each layer and datatype
+    /// of a Cell are merged before fracturing, so no area is exposed
+    /// twice. This fractures each layer of a Cell as a whole, which
+    /// runs less in parallel than fracturing shape by shape.
+    bool mergeOverlaps;
+
+    /// \brief The layers to fracture, or every layer if empty.
+    std::vector<int> layers;
+
+    /// \brief Sets the defaults: a 1e-6 sliver size, no minimum figure
+    /// size, shapes fractured one by one on every layer.
+    FractureOptions(void);
+  };
+
+  /// \brief The figures of one layer and datatype of a FracturedCell.
+  struct FractureGroup {
+    int layer;
+    int dataType;
+    std::size_t first; //!< The index of the first trapezoid of the group.
+    std::size_t count; //!< The number of trapezoids in the group.
+  };
+
+  /// \brief The trapezoids of the shapes of a Cell.
+  struct FracturedCell {
+    /// \brief Every figure, grouped by layer and datatype.
+    std::vector<Trapezoid> trapezoids;
+
+    /// \brief The groups of @trapezoids, by ascending layer and
+    /// datatype.
+    std::vector<FractureGroup> groups;
+
+    /// \brief The number of figures dropped for being smaller than the
+    /// minimum figure size.
+    std::size_t figuresDropped;
+
+    /// \brief The area of the dropped figures.
+    double droppedArea;
+  };
+
+  /// \brief Appends the horizontal trapezoids that cover the polygon
+  /// @vertices to @result.
+  ///
+  /// The polygon is decomposed with a scanline sweep, so it may be
+  /// concave or even cross itself (the nonzero winding rule applies).
+  /// Returns the number of figures dropped for being below
+  /// @options.minFigureSize.
+  std::size_t fracturePolygon(Span<const CoordPnt> vertices, const FractureOptions& options,
+                              std::vector<Trapezoid>& result);
+
+  /// \brief Fractures the polygons and paths of every Cell of @layout.
+  ///
+  /// @layout The layout to fracture.
+  /// @options The sliver control, minimum figure size and layers.
+  ///
+  /// Returns a FracturedCell for every Cell, in the order of @layout.
+  /// Each Cell only holds its own shapes; the figures of the cells it
+  /// places are found in their own FracturedCell, so the output keeps
+  /// the hierarchy of the input. Paths are fractured from the union of
+  /// their segment outlines, with round ends treated as square. The
+  /// shapes of all cells are fractured in parallel, in blocks, and
+  /// copied into one array per Cell.
+  std::vector<FracturedCell> fracture(const FrozenLayout& layout,
+                                      FractureOptions options = FractureOptions());
+
+  /// \brief Fractures the polygons and paths of @cell, see fracture().
+  FracturedCell fracture(const Cell& cell, FractureOptions options = FractureOptions());
+
+}
+
+#endif // FRACTURE_HXX
@@ -0,0 +1,276 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "frozenLayout.hxx"
+#include "cellGraph.hxx"
+#include "parallel.hxx"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace sil {
+
+  namespace {
+
+    /// \brief The start of the runs of a Cell in each table.
+    struct TableOffsets {
+      std::size_t coordinate;
+      std::size_t polygon;
+      std::size_t path;
+      std::size_t reference;
+      std::size_t array;
+    };
+
+    /// \brief Adds @child, magnified, rotated and moved to @origin, to
+    /// @target, once for every offset in the box [0, @latticeX] x [0,
+    /// @latticeY] (the elements of an array).
+    void addPlaced(Bounds& target, const Bounds& child, const CoordPnt& origin,
+                   double magnification, double rotation, double latticeX, double latticeY) {
+      if (child.isEmpty())
+        return;
+      double cosine = std::cos(rotation)*magnification;
+      double sine = std::sin(rotation)*magnification;
+      Bounds placed;
+      double xs[2] = {child.minX, child.maxX};
+      double ys[2] = {child.minY, child.maxY};
+      for (int i = 0; i < 2; i++)
+        for (int j = 0; j < 2; j++)
+          placed.add(CoordPnt(origin.getX() + cosine*xs[i] - sine*ys[j],
+                              origin.getY() + sine*xs[i] + cosine*ys[j]));
+      target.add(CoordPnt(placed.minX + std::min(0., latticeX), placed.minY + std::min(0., latticeY)));
+      target.add(CoordPnt(placed.maxX + std::max(0., latticeX), placed.maxY + std::max(0., latticeY)));
+    }
+
+  }
+
+  FrozenLayout::FrozenLayout() : numLayoutCells(0) {}
+
+  std::shared_ptr<const FrozenLayout> FrozenLayout::freeze(const Layout& layout) {
+    return freeze(CellGraph(layout));
+  }
+
+  std::shared_ptr<const FrozenLayout> FrozenLayout::freeze(const Cell& root) {
+    return freeze(CellGraph(root));
+  }
+
+  std::shared_ptr<const FrozenLayout> FrozenLayout::freeze(const CellGraph& graph) {
+    std::shared_ptr<FrozenLayout> frozen(new FrozenLayout());
+    frozen->order = graph.topologicalOrder(); // throws if the hierarchy is cyclic
+    frozen->tops = graph.topCells();
+    frozen->numLayoutCells = graph.getLayoutCellCount();
+    std::size_t numCells = graph.size();
+
+    // size every table first, so the records can be filled in parallel
+    std::vector<TableOffsets> offsets(numCells + 1);
+    TableOffsets next = {0, 0, 0, 0, 0};
+    for (std::size_t node = 0; node < numCells; node++) {
+      offsets[node] = next;
+      const Cell& cell = graph.getCell(node);
+      const PolygonList& cellPolygons = cell.getPolygonList();
+      for (std::size_t i = 0; i < cellPolygons.size(); i++)
+        next.coordinate += cellPolygons[i].getVertexSpan().size();
+      const PathList& cellPaths = cell.getPathList();
+      for (std::size_t i = 0; i < cellPaths.size(); i++)
+        next.coordinate += cellPaths[i].getCoordPathSpan().size();
+      next.polygon += cellPolygons.size();
+      next.path += cellPaths.size();
+      next.reference += cell.getCellReferenceList().size();
+      next.array += cell.getCellArrayList().size();
+    }
+    offsets[numCells] = next;
+    frozen->coordinates.resize(next.coordinate);
+    frozen->polygons.resize(next.polygon);
+    frozen->paths.resize(next.path);
+    frozen->references.resize(next.reference);
+    frozen->arrays.resize(next.array);
+    frozen->cells.resize(numCells);
+
+    std::vector<std::vector<int> > cellLayers(numCells);
+    utils::parallelFor(numCells, [&](std::size_t node) {
+        const Cell& cell = graph.getCell(node);
+        const TableOffsets& start = offsets[node];
+        const TableOffsets& end = offsets[node + 1];
+        FrozenCell& target = frozen->cells[node];
+        target.cellname = cell.getCellname();
+        CoordPnt* coordinate = frozen->coordinates.data() + start.coordinate;
+        std::vector<int>& layers = cellLayers[node];
+
+        const PolygonList& cellPolygons = cell.getPolygonList();
+        for (std::size_t i = 0; i < cellPolygons.size(); i++) {
+          const Polygon& polygon = cellPolygons[i];
+          FrozenPolygon& record = frozen->polygons[start.polygon + i];
+          Span<const CoordPnt> vertices = polygon.getVertexSpan();
+          std::copy(vertices.begin(), vertices.end(), coordinate);
+          record.vertices = Span<const CoordPnt>(coordinate, vertices.size());
+          coordinate += vertices.size();
+          record.layer = polygon.getLayer();
+          record.dataType = polygon.getDataType();
+          record.shapeClass = polygon.getShapeClass();
+          record.signedArea = polygon.getSignedArea();
+          record.perimeter = polygon.getPerimeter();
+          for (std::size_t j = 0; j < vertices.size(); j++)
+            record.bounds.add(vertices[j]);
+          target.bounds.add(record.bounds);
+          layers.push_back(record.layer);
+        }
+
+        const PathList& cellPaths = cell.getPathList();
+        for (std::size_t i = 0; i < cellPaths.size(); i++) {
+          const Path& path = cellPaths[i];
+          FrozenPath& record = frozen->paths[start.path + i];
+          Span<const CoordPnt> points = path.getCoordPathSpan();
+          std::copy(points.begin(), points.end(), coordinate);
+          record.points = Span<const CoordPnt>(coordinate, points.size());
+          coordinate += points.size();
+          record.layer = path.getLayer();
+          record.dataType = path.getDataType();
+          record.pathType = path.getPathType();
+          record.width = path.getPathWidth();
+          // the square ends of type 2 reach furthest along a diagonal
+          double margin = record.width/2.;
+          if (record.pathType == 2)
+            margin *= std::sqrt(2.);
+          for (std::size_t j = 0; j < points.size(); j++) {
+            record.bounds.add(CoordPnt(points[j].getX() - margin, points[j].getY() - margin));
+            record.bounds.add(CoordPnt(points[j].getX() + margin, points[j].getY() + margin));
+          }
+          target.bounds.add(record.bounds);
+          layers.push_back(record.layer);
+        }
+
+        const CellReferenceList& cellReferences = cell.getCellReferenceList();
+        for (std::size_t i = 0; i < cellReferences.size(); i++) {
+          FrozenReference& record = frozen->references[start.reference + i];
+          record.cell = graph.getNode(cellReferences[i].getReferencedCell());
+          record.position = cellReferences[i].getCenter();
+          record.magnification = cellReferences[i].getMagnification();
+          record.rotation = cellReferences[i].getRotation();
+        }
+
+        const CellArrayList& cellArrays = cell.getCellArrayList();
+        for (std::size_t i = 0; i < cellArrays.size(); i++) {
+          FrozenArray& record = frozen->arrays[start.array + i];
+          record.cell = graph.getNode(cellArrays[i].getReferencedCell());
+          record.startingPos = cellArrays[i].getStartingPos();
+          record.numCol = cellArrays[i].getNumCol();
+          record.numRow = cellArrays[i].getNumRow();
+          record.xSpacing = cellArrays[i].getXSpacing();
+          record.ySpacing = cellArrays[i].getYSpacing();
+          record.magnification = cellArrays[i].getMagnification();
+          record.rotation = cellArrays[i].getRotation();
+        }
+
+        std::sort(layers.begin(), layers.end());
+        layers.erase(std::unique(layers.begin(), layers.end()), layers.end());
+        target.polygons = Span<const FrozenPolygon>(frozen->polygons.data() + start.polygon,
+                                                    end.polygon - start.polygon);
+        target.paths = Span<const FrozenPath>(frozen->paths.data() + start.path,
+                                              end.path - start.path);
+        target.references = Span<const FrozenReference>(frozen->references.data() + start.reference,
+                                                         end.reference - start.reference);
+        target.arrays = Span<const FrozenArray>(frozen->arrays.data() + start.array,
+                                                end.array - start.array);
+      });
+
+    // the variable length indices, now that their sizes are known
+    std::size_t numAdjacent = 0;
+    std::size_t numLayers = 0;
+    for (std::size_t node = 0; node < numCells; node++) {
+      numAdjacent += graph.getChildren(node).size() + graph.getParents(node).size();
+      numLayers += cellLayers[node].size();
+    }
+    frozen->adjacency.reserve(numAdjacent);
+    frozen->layerTable.reserve(numLayers);
+    for (std::size_t node = 0; node < numCells; node++) {
+      FrozenCell& target = frozen->cells[node];
+      const std::vector<unsigned int>& nodeChildren = graph.getChildren(node);
+      const std::vector<unsigned int>& nodeParents = graph.getParents(node);
+      std::size_t first = frozen->adjacency.size();
+      frozen->adjacency.insert(frozen->adjacency.end(), nodeChildren.begin(), nodeChildren.end());
+      frozen->adjacency.insert(frozen->adjacency.end(), nodeParents.begin(), nodeParents.end());
+      target.children = Span<const unsigned int>(frozen->adjacency.data() + first,
+                                                 nodeChildren.size());
+      target.parents = Span<const unsigned int>(frozen->adjacency.data() + first + nodeChildren.size(),
+                                                nodeParents.size());
+      first = frozen->layerTable.size();
+      frozen->layerTable.insert(frozen->layerTable.end(), cellLayers[node].begin(),
+                                cellLayers[node].end());
+      target.layers = Span<const int>(frozen->layerTable.data() + first, cellLayers[node].size());
+      frozen->cellnameIndex.emplace(target.cellname, node); // keeps the first of each name
+    }
+
+    // extents from the leaves up
+    for (std::size_t i = 0; i < frozen->order.size(); i++) {
+      FrozenCell& target = frozen->cells[frozen->order[i]];
+      target.extent = target.bounds;
+      for (std::size_t j = 0; j < target.references.size(); j++) {
+        const FrozenReference& ref = target.references[j];
+        addPlaced(target.extent, frozen->cells[ref.cell].extent, ref.position,
+                  ref.magnification, ref.rotation, 0, 0);
+      }
+      for (std::size_t j = 0; j < target.arrays.size(); j++) {
+        const FrozenArray& array = target.arrays[j];
+        addPlaced(target.extent, frozen->cells[array.cell].extent, array.startingPos,
+                  array.magnification, array.rotation,
+                  (array.numCol - 1)*array.xSpacing, (array.numRow - 1)*array.ySpacing);
+      }
+    }
+    return frozen;
+  }
+
+  std::size_t FrozenLayout::getCellCount() const {
+    return this->cells.size();
+  }
+
+  std::size_t FrozenLayout::getLayoutCellCount() const {
+    return this->numLayoutCells;
+  }
+
+  const FrozenCell& FrozenLayout::getCell(std::size_t index) const {
+    if (index >= this->cells.size()) {
+      std::stringstream errorMsg;
+      errorMsg << "There is no cell " << index << " in a frozen layout of "
+               << this->cells.size() << " cells.";
+      throw std::out_of_range(errorMsg.str());
+    }
+    return this->cells[index];
+  }
+
+  std::size_t FrozenLayout::findCell(const std::string& cellname) const {
+    std::unordered_map<std::string, unsigned int>::const_iterator it =
+      this->cellnameIndex.find(cellname);
+    return it != this->cellnameIndex.end() ? it->second : this->cells.size();
+  }
+
+  Span<const unsigned int> FrozenLayout::getHierarchicalOrder() const {
+    return Span<const unsigned int>(this->order);
+  }
+
+  Span<const unsigned int> FrozenLayout::getTopCells() const {
+    return Span<const unsigned int>(this->tops);
+  }
+
+  std::size_t FrozenLayout::getPolygonCount() const {
+    return this->polygons.size();
+  }
+
+  std::size_t FrozenLayout::getPathCount() const {
+    return this->paths.size();
+  }
+
+}
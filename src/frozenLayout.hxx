@@ -0,0 +1,174 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef FROZEN_LAYOUT_HXX
+#define FROZEN_LAYOUT_HXX
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "coord.hxx"
+#include "span.hxx"
+#include "spatialIndex.hxx"
+#include "layout.hxx"
+
+namespace sil {
+
+  class CellGraph;
+
+  // A FrozenLayout is an immutable copy of a Layout. It is laid out like
+  // a snapshot file: flat tables of the records below, every Cell owning
+  // consecutive runs of them. Nothing in it is ever written after
+  // Layout::freeze() returns (there are no caches filled on first use),
+  // so any number of threads may read one without locking while the
+  // original Layout keeps being edited.
+
+  /// \brief A Polygon with its derived properties computed up front.
+  struct FrozenPolygon {
+    Span<const CoordPnt> vertices; //!< The vertices, in their original order.
+    int layer; //!< The layer of the Polygon.
+    int dataType; //!< The datatype of the Polygon.
+    unsigned int shapeClass; //!< The Polygon::ShapeClass flags.
+    double signedArea; //!< See Polygon::getSignedArea().
+    double perimeter; //!< See Polygon::getPerimeter().
+    Bounds bounds; //!< The bounding box of the vertices.
+  };
+
+  /// \brief A Path.
+  struct FrozenPath {
+    Span<const CoordPnt> points; //!< The points along the Path.
+    int layer; //!< The layer of the Path.
+    int dataType; //!< The datatype of the Path.
+    int pathType; //!< The path type (0, 1 or 2).
+    double width; //!< The width of the Path.
+    Bounds bounds; //!< A box that contains the outline of the Path.
+  };
+
+  /// \brief A CellReference.
+  struct FrozenReference {
+    unsigned int cell; //!< The index of the referenced cell.
+    CoordPnt position; //!< The position of the reference.
+    double magnification;
+    double rotation; //!< In radians.
+  };
+
+  /// \brief A CellArray.
+  struct FrozenArray {
+    unsigned int cell; //!< The index of the referenced cell.
+    CoordPnt startingPos; //!< The position of the first element.
+    int numCol;
+    int numRow;
+    double xSpacing;
+    double ySpacing;
+    double magnification;
+    double rotation; //!< In radians.
+  };
+
+  /// \brief A Cell and the indices computed for it.
+  struct FrozenCell {
+    std::string cellname; //!< The name of the Cell.
+    Span<const FrozenPolygon> polygons; //!< The polygons, in order.
+    Span<const FrozenPath> paths; //!< The paths, in order.
+    Span<const FrozenReference> references; //!< The references, in order.
+    Span<const FrozenArray> arrays; //!< The arrays, in order.
+    Span<const unsigned int> children; //!< The distinct cells placed by this one.
+    Span<const unsigned int> parents; //!< The distinct cells that place this one.
+    Span<const int> layers; //!< The distinct layers of the shapes, ascending.
+    Bounds bounds; //!< The bounding box of the shapes of the Cell itself.
+    Bounds extent; //!< The bounding box including all placed cells.
+  };
+
+  /// class FrozenLayout
+  ///
+  /// \brief An immutable, shareable copy of a Layout, made by
+  /// Layout::freeze().
+  ///
+  /// The cells are numbered like the nodes of a CellGraph: the cells of
+  /// the Layout first, in order, followed by any cells they reference
+  /// that were never added to it. Every accessor is const and only
+  /// reads, and the records handed out stay valid for as long as the
+  /// FrozenLayout exists.
+  class FrozenLayout {
+  private:
+    std::vector<CoordPnt> coordinates; //!< The vertices of every shape.
+    std::vector<FrozenPolygon> polygons; //!< The polygons of every Cell.
+    std::vector<FrozenPath> paths; //!< The paths of every Cell.
+    std::vector<FrozenReference> references; //!< The references of every Cell.
+    std::vector<FrozenArray> arrays; //!< The arrays of every Cell.
+    std::vector<unsigned int> adjacency; //!< The children and parents of every Cell.
+    std::vector<int> layerTable; //!< The layers of every Cell.
+    std::vector<FrozenCell> cells; //!< The cells, viewing the tables above.
+    std::size_t numLayoutCells; //!< The number of cells that belong to the Layout.
+    std::vector<unsigned int> order; //!< Every Cell after the cells it places.
+    std::vector<unsigned int> tops; //!< The cells no other Cell places.
+    std::unordered_map<std::string, unsigned int> cellnameIndex; //!< The first Cell of each name.
+
+    FrozenLayout(void);
+
+    /// \brief Copies the cells of @graph, numbered like its nodes.
+    static std::shared_ptr<const FrozenLayout> freeze(const CellGraph& graph);
+
+  public:
+    /// \brief Copies @layout, see Layout::freeze().
+    static std::shared_ptr<const FrozenLayout> freeze(const Layout& layout);
+
+    /// \brief Copies @root and the cells it places, as if @root were the
+    /// only Cell of a Layout: it becomes cell 0. @root is only read, and
+    /// is not added to any Layout.
+    static std::shared_ptr<const FrozenLayout> freeze(const Cell& root);
+
+    // the records view the tables of this object
+    FrozenLayout(const FrozenLayout&) = delete;
+    FrozenLayout& operator=(const FrozenLayout&) = delete;
+
+    /// \brief Returns the number of cells.
+    std::size_t getCellCount(void) const;
+
+    /// \brief Returns the number of cells that belong to the Layout.
+    ///
+    /// These are cells 0 to getLayoutCellCount() - 1.
+    std::size_t getLayoutCellCount(void) const;
+
+    /// \brief Returns the cell at @index, throwing std::out_of_range if
+    /// there is no such cell.
+    const FrozenCell& getCell(std::size_t index) const;
+
+    /// \brief Returns the index of the cell named @cellname, or
+    /// getCellCount() if there is none.
+    ///
+    /// If several cells share a name the first one is returned.
+    std::size_t findCell(const std::string& cellname) const;
+
+    /// \brief Returns the cells ordered so that every Cell comes after
+    /// all of the cells it places.
+    Span<const unsigned int> getHierarchicalOrder(void) const;
+
+    /// \brief Returns the cells that no other Cell places.
+    Span<const unsigned int> getTopCells(void) const;
+
+    /// \brief Returns the number of polygons in all cells.
+    std::size_t getPolygonCount(void) const;
+
+    /// \brief Returns the number of paths in all cells.
+    std::size_t getPathCount(void) const;
+  };
+
+}
+
+#endif // FROZEN_LAYOUT_HXX
@@ -21,9 +21,37 @@ namespace sil {
   /// not normally be using by nesting it within an obvious nested namespace.
   namespace utils {
 
+    GDS_WriteCache::GDS_WriteCache() {
+      this->hits = 0;
+      this->misses = 0;
+    }
+
+    void GDS_WriteCache::clear() {
+      this->entries.clear();
+      this->hits = 0;
+      this->misses = 0;
+    }
+
+    unsigned int GDS_WriteCache::getHits() const {
+      return this->hits;
+    }
+
+    unsigned int GDS_WriteCache::getMisses() const {
+      return this->misses;
+    }
+
+    std::size_t GDS_WriteCache::getSize() const {
+      std::size_t size = 0;
+      for (std::unordered_map<const Cell*, GDS_WriteCache::Entry>::const_iterator it =
+             this->entries.begin(); it != this->entries.end(); ++it)
+        size += it->second.bytes.size();
+      return size;
+    }
+
     // Basic bare bones constructor for this class.
     GDS_File::GDS_File(std::string usrFilename) :
       outputFile(usrFilename.c_str(), std::ios::out | std::ios::ate | std::ios::binary) {
+      this->output = &this->outputFile;
       this->filename = usrFilename;
       this->version = 0x0258; // version 600 aka 6.0
       this->libraryName = "MyLibrary";
@@ -44,40 +72,40 @@ namespace sil {
       this->WriteStructureHeaderRecords(cell);
 
       // Itteratively write the contents of each polygon element
-      std::vector<Polygon>::const_iterator firstPoly = cell->getPolygonList().begin();
-      std::vector<Polygon>::const_iterator lastPoly = cell->getPolygonList().end();
-      for (std::vector<Polygon>::const_iterator polygon = firstPoly; 
+      PolygonList::const_iterator firstPoly = cell->getPolygonList().begin();
+      PolygonList::const_iterator lastPoly = cell->getPolygonList().end();
+      for (PolygonList::const_iterator polygon = firstPoly; 
            polygon != lastPoly; ++polygon) {
         this->WriteElementHeaderRecords(BOUNDARY); // polygons are boundary typed
         this->WriteElementContentRecords(polygon);
         this->WriteElementTailRecords();
       }
 
-      std::vector<Path>::const_iterator firstPath = cell->getPathList().begin();
-      std::vector<Path>::const_iterator lastPath = cell->getPathList().end();
-      for (std::vector<Path>::const_iterator path = firstPath;
+      PathList::const_iterator firstPath = cell->getPathList().begin();
+      PathList::const_iterator lastPath = cell->getPathList().end();
+      for (PathList::const_iterator path = firstPath;
 	   path != lastPath; ++path) {
 	this->WriteElementHeaderRecords(PATH);
         this->WriteElementContentRecords(path);
         this->WriteElementTailRecords();
       }
 
-      std::vector<CellReference>::const_iterator firstRef = cell->getCellReferenceList().begin();
-      std::vector<CellReference>::const_iterator lastRef = cell->getCellReferenceList().end();
-      for (std::vector<CellReference>::const_iterator cellRef = firstRef;
+      CellReferenceList::const_iterator firstRef = cell->getCellReferenceList().begin();
+      CellReferenceList::const_iterator lastRef = cell->getCellReferenceList().end();
+      for (CellReferenceList::const_iterator cellRef = firstRef;
 	   cellRef != lastRef; ++cellRef) {
 	this->WriteElementHeaderRecords(SREF);
 	this->WriteElementContentRecords(cellRef);
-	this->WriteFileTailRecords();
+	this->WriteElementTailRecords();
       }
 
-      std::vector<CellArray>::const_iterator firstArray = cell->getCellArrayList().begin();
-      std::vector<CellArray>::const_iterator lastArray = cell->getCellArrayList().end();
-      for (std::vector<CellArray>::const_iterator cellArray = firstArray;
+      CellArrayList::const_iterator firstArray = cell->getCellArrayList().begin();
+      CellArrayList::const_iterator lastArray = cell->getCellArrayList().end();
+      for (CellArrayList::const_iterator cellArray = firstArray;
 	   cellArray != lastArray; ++cellArray) {
 	this->WriteElementHeaderRecords(AREF);
 	this->WriteElementContentRecords(cellArray);
-	this->WriteFileTailRecords();
+	this->WriteElementTailRecords();
       }
 
       // Write the ENDSTR that corresponds to this cell
@@ -85,16 +113,106 @@ namespace sil {
 
     }
 
-    void GDS_File::Write(const std::vector<Cell*> cellVec) {
+    void GDS_File::Write(const std::vector<Cell*> cellVec,
+                         GDS_WriteCache* cache) {
       
       this->WriteFileHeaderRecords();
       
-      for (uint i = 0; i < cellVec.size(); i++) 
-	this->WriteCell(cellVec[i]);
+      if (cache == NULL) {
+        for (uint i = 0; i < cellVec.size(); i++) 
+          this->WriteCell(cellVec[i]);
+        this->WriteFileTailRecords();
+        return;
+      }
+
+      cache->hits = 0;
+      cache->misses = 0;
+      std::unordered_map<const Cell*, GDS_WriteCache::Entry> entries;
+      for (uint i = 0; i < cellVec.size(); i++) {
+        ContentHash key = this->serializationKey(cellVec[i]);
+        GDS_WriteCache::Entry& entry = entries[cellVec[i]];
+        std::unordered_map<const Cell*, GDS_WriteCache::Entry>::iterator cached =
+          cache->entries.find(cellVec[i]);
+        if (cached != cache->entries.end() && cached->second.key == key) {
+          entry.bytes.swap(cached->second.bytes);
+          cache->hits++;
+        } else {
+          // serialize into memory so the bytes can be kept
+          std::ostringstream buffer;
+          this->output = &buffer;
+          this->WriteCell(cellVec[i]);
+          this->output = &this->outputFile;
+          entry.bytes = buffer.str();
+          cache->misses++;
+        }
+        entry.key = key;
+        this->output->write(entry.bytes.data(), entry.bytes.size());
+      }
+      // this also drops the entries of cells that are no longer written
+      cache->entries.swap(entries);
 
       this->WriteFileTailRecords();
     }
 
+    ContentHash GDS_File::serializationKey(const Cell* cell) const {
+      ElementHasher hasher(0);
+      hasher.addDouble(this->databaseUnits);
+      hasher.addString(cell->getCellname());
+
+      PolygonList& polygons = cell->getPolygonList();
+      hasher.add(polygons.size());
+      for (uint i = 0; i < polygons.size(); i++) {
+        hasher.add(polygons[i].getLayer());
+        hasher.add(polygons[i].getDataType());
+        Span<const CoordPnt> vertices = polygons[i].getVertexSpan();
+        hasher.add(vertices.size());
+        for (uint j = 0; j < vertices.size(); j++) {
+          hasher.add(this->toDatabaseUnits(vertices[j].getX()));
+          hasher.add(this->toDatabaseUnits(vertices[j].getY()));
+        }
+      }
+
+      PathList& paths = cell->getPathList();
+      hasher.add(paths.size());
+      for (uint i = 0; i < paths.size(); i++) {
+        hasher.add(paths[i].getLayer());
+        hasher.add(paths[i].getDataType());
+        hasher.add(paths[i].getPathType());
+        hasher.add(this->toDatabaseUnits(paths[i].getPathWidth()));
+        Span<const CoordPnt> points = paths[i].getCoordPathSpan();
+        hasher.add(points.size());
+        for (uint j = 0; j < points.size(); j++) {
+          hasher.add(this->toDatabaseUnits(points[j].getX()));
+          hasher.add(this->toDatabaseUnits(points[j].getY()));
+        }
+      }
+
+      CellReferenceList& refs = cell->getCellReferenceList();
+      hasher.add(refs.size());
+      for (uint i = 0; i < refs.size(); i++) {
+        hasher.addString(refs[i].getCellname());
+        hasher.addDouble(refs[i].getMagnification());
+        hasher.addDouble(refs[i].getRotation());
+        hasher.add(this->toDatabaseUnits(refs[i].getCenter().getX()));
+        hasher.add(this->toDatabaseUnits(refs[i].getCenter().getY()));
+      }
+
+      CellArrayList& arrays = cell->getCellArrayList();
+      hasher.add(arrays.size());
+      for (uint i = 0; i < arrays.size(); i++) {
+        hasher.addString(arrays[i].getCellname());
+        hasher.addDouble(arrays[i].getMagnification());
+        hasher.addDouble(arrays[i].getRotation());
+        hasher.add(arrays[i].getNumCol());
+        hasher.add(arrays[i].getNumRow());
+        hasher.addDouble(arrays[i].getStartingPos().getX());
+        hasher.addDouble(arrays[i].getStartingPos().getY());
+        hasher.addDouble(arrays[i].getXSpacing());
+        hasher.addDouble(arrays[i].getYSpacing());
+      }
+      return hasher.finish();
+    }
+
     void GDS_File::WriteFileHeaderRecords() {
       // the size of the label, the in16_t that details the size of the record -
       // including itself - as well as the part off the label that details 
@@ -215,20 +333,11 @@ namespace sil {
       this->writeInt16ToFile(second);
       //----------------------------------------------------------------------//
       // STRNAME
-      int strSize = cell->getCellname().size();
-      if (strSize % 2 != 0)
-	strSize++;
-      char cellnameChar[strSize];
-      std::string cellname = cell->getCellname();
-      int orgStrSize = cell->getCellname().size();
-      for (int i = 0; i < orgStrSize; i++)
-	cellnameChar[i] = cellname[i];
-      if (orgStrSize % 2 != 0)
-	cellnameChar[strSize - 1] = ' ';
-      recordSize = strSize*sizeof(char) + sizeof(STRNAME) + sizeof(int16_t);
+      const std::string& cellname = this->paddedCellname(cell);
+      recordSize = cellname.size()*sizeof(char) + RECORD_LABEL_SIZE;
       this->writeInt16ToFile(recordSize);
       this->writeInt16ToFile(STRNAME);
-      this->writeCharToFile(cellnameChar, strSize);
+      this->writeCharToFile(cellname.data(), cellname.size());
     }
 
     void GDS_File::WriteElementHeaderRecords(int16_t dataType) {
@@ -239,7 +348,7 @@ namespace sil {
       this->writeInt16ToFile(dataType);
     }
 
-    void GDS_File::WriteElementContentRecords(std::vector<Polygon>::const_iterator polygon) {
+    void GDS_File::WriteElementContentRecords(PolygonList::const_iterator polygon) {
       const int16_t RECORD_LABEL_SIZE = 2*sizeof(int16_t); 
       int16_t recordSize;
       // We already have wrote that we are in a "BOUNDARY" element
@@ -255,28 +364,28 @@ namespace sil {
       int16_t currentDataType = polygon->getDataType();
       this->writeInt16ToFile(currentDataType);
       // Now record each (x, y) coordinate pair
-      std::vector<CoordPnt> myVertices = polygon->getVertices();
+      Span<const CoordPnt> myVertices = polygon->getVertexSpan();
       recordSize = 2*(myVertices.size() + 1)*sizeof(int32_t) 
 	+ RECORD_LABEL_SIZE;
       this->writeInt16ToFile(recordSize);
       this->writeInt16ToFile(XY);
-      for (std::vector<CoordPnt>::iterator xy = myVertices.begin(); 
+      for (const CoordPnt* xy = myVertices.begin(); 
 	   xy != myVertices.end(); ++xy) {
-	int32_t curX = xy->getX()/this->databaseUnits;
+	int32_t curX = this->toDatabaseUnits(xy->getX());
 	this->writeInt32ToFile(curX);
-	int32_t curY = xy->getY()/this->databaseUnits;
+	int32_t curY = this->toDatabaseUnits(xy->getY());
 	this->writeInt32ToFile(curY);
       }
       // rerecord the first one as is GDS2 standard (marks the end of 
       // a polygon)
-      int32_t firstX = myVertices[0].getX()/this->databaseUnits;
+      int32_t firstX = this->toDatabaseUnits(myVertices[0].getX());
       this->writeInt32ToFile(firstX);
-      int32_t firstY = myVertices[0].getY()/this->databaseUnits;
+      int32_t firstY = this->toDatabaseUnits(myVertices[0].getY());
       this->writeInt32ToFile(firstY);
     }
 
     /// \brief Overridden for use with path elements
-    void GDS_File::WriteElementContentRecords(std::vector<Path>::const_iterator path) {
+    void GDS_File::WriteElementContentRecords(PathList::const_iterator path) {
       // Path
       const int16_t RECORD_LABEL_SIZE = 2*sizeof(int16_t); 
       int16_t recordSize;
@@ -305,7 +414,7 @@ namespace sil {
       }
       // -- Width
       recordSize = 0x0008;
-      int32_t width = path->getPathWidth();
+      int32_t width = this->toDatabaseUnits(path->getPathWidth());
       // only need to record path width if it is not zero as zero is 
       // assumed if this record does not exist.
       if (width != 0) {
@@ -315,188 +424,143 @@ namespace sil {
       }
       // -- XY
       // Now record each (x, y) coordinate pair
-      std::vector<CoordPnt> myVertices = path->getCoordPath();
-      recordSize = 2*(myVertices.size() + 1)*sizeof(int32_t) 
-	+ RECORD_LABEL_SIZE;
+      // (unlike polygons the first point is not repeated at the end)
+      Span<const CoordPnt> myVertices = path->getCoordPathSpan();
+      recordSize = 2*myVertices.size()*sizeof(int32_t) + RECORD_LABEL_SIZE;
       this->writeInt16ToFile(recordSize);
       this->writeInt16ToFile(XY);
-      for (std::vector<CoordPnt>::iterator xy = myVertices.begin(); 
+      for (const CoordPnt* xy = myVertices.begin(); 
 	   xy != myVertices.end(); ++xy) {
-	int32_t curX = xy->getX()/this->databaseUnits;
+	int32_t curX = this->toDatabaseUnits(xy->getX());
 	this->writeInt32ToFile(curX);
-	int32_t curY = xy->getY()/this->databaseUnits;
+	int32_t curY = this->toDatabaseUnits(xy->getY());
 	this->writeInt32ToFile(curY);
       }
     }
 
-    void GDS_File::WriteElementContentRecords(std::vector<CellReference>::const_iterator cellRef) {
+    void GDS_File::WriteElementContentRecords(CellReferenceList::const_iterator cellRef) {
       int16_t recordSize;
       const int16_t RECORD_LABEL_SIZE = 2*sizeof(int16_t); 
 
-      // -- SREF
-      recordSize = RECORD_LABEL_SIZE;
-      this->writeInt16ToFile(recordSize);
-      this->writeInt16ToFile(SREF);
-
       // -- SNAME
-      int strSize = cellRef->getCellname().size();
-      if (strSize % 2 != 0)
-	strSize++;
-      char cellnameChar[strSize];
-      std::string cellname = cellRef->getCellname();
-      int orgStrSize = cellRef->getCellname().size();
-      for (int i = 0; i < orgStrSize; i++)
-	cellnameChar[i] = cellname[i];
-      if (orgStrSize % 2 != 0)
-	cellnameChar[strSize - 1] = ' ';
-      recordSize = strSize*sizeof(char) + sizeof(STRNAME) + sizeof(int16_t);
-      this->writeInt16ToFile(recordSize);
-      this->writeInt16ToFile(STRNAME);
-      this->writeCharToFile(cellnameChar, strSize);      
+      this->WriteSnameRecord(cellRef->getReferencedCell());
 
-      // -- strans
-      char stransRecord[15];
-      recordSize = RECORD_LABEL_SIZE + sizeof(stransRecord);
-      this->writeInt16ToFile(recordSize);
-
-      this->writeInt16ToFile(STRANS);
-
-      // only certain parts of this record will not be zero, so make
-      // sure that zero is the "default."
-      for (uint i = 0; i < sizeof(stransRecord); i++)
-	stransRecord[i] = 0;
-      // setting bit 13 flags the reference has having non unity
-      // manification
-      if (cellRef->getMagnification() != 1.0)
-	stransRecord[12] = 1;
-      // Setting bit 14 flags the reference has having nonzero 
-      // rotation
-      if (cellRef->getRotation() != 0.0)
-	stransRecord[13] = 1;
-      this->writeCharToFile(stransRecord, sizeof(stransRecord));
-
-      // If no MAG record is there then the magnification is assumed
-      // to be one. Therefore, only write MAG if the magnification is
-      // not one.
-      if (cellRef->getMagnification() != 1.0) {
-	recordSize = RECORD_LABEL_SIZE + sizeof(float64);
-	this->writeInt16ToFile(recordSize);
-	this->writeInt16ToFile(MAG);
-	this->writeFloat64ToFile(cellRef->getMagnification());
-      }
-
-      // If no ANGLE record is present then the angle of rotation is 
-      // assumed to be zero (note that there can still be a reflection
-      // accross the x-axis which is in effect having a rotation of 
-      // 180 degrees but I will keep all rotation information in ANGLE)
-      if (cellRef->getRotation() != 0.0) {
-	recordSize = RECORD_LABEL_SIZE + sizeof(float64);
-	this->writeInt16ToFile(recordSize);
-	this->writeInt16ToFile(ANGLE);
-	this->writeFloat64ToFile(cellRef->getRotation());	
-      }      
+      // -- STRANS, MAG, ANGLE
+      this->WriteTransformRecords(cellRef->getMagnification(),
+				  cellRef->getRotation());
 
       // -- XY
       recordSize = RECORD_LABEL_SIZE + 2*sizeof(int32_t);
       this->writeInt16ToFile(recordSize);
       this->writeInt16ToFile(XY);
-      int32_t curX = cellRef->getCenter().getX()/this->databaseUnits;
+      int32_t curX = this->toDatabaseUnits(cellRef->getCenter().getX());
       this->writeInt32ToFile(curX);
-      int32_t curY = cellRef->getCenter().getY()/this->databaseUnits;
+      int32_t curY = this->toDatabaseUnits(cellRef->getCenter().getY());
       this->writeInt32ToFile(curY);
     }
 
-    void GDS_File::WriteElementContentRecords(std::vector<CellArray>::const_iterator cellArray) {
+    void GDS_File::WriteElementContentRecords(CellArrayList::const_iterator cellArray) {
       int16_t recordSize;
       const int16_t RECORD_LABEL_SIZE = 2*sizeof(int16_t); 
 
-      // -- AREF
-      recordSize = RECORD_LABEL_SIZE;
+      // -- SNAME
+      this->WriteSnameRecord(cellArray->getReferencedCell());
+
+      // -- STRANS, MAG, ANGLE
+      this->WriteTransformRecords(cellArray->getMagnification(),
+				  cellArray->getRotation());
+
+      // -- COLROW
+      recordSize = RECORD_LABEL_SIZE + 2*sizeof(int16_t);
       this->writeInt16ToFile(recordSize);
-      this->writeInt16ToFile(AREF);
+      this->writeInt16ToFile(COLROW);
+      this->writeInt16ToFile(cellArray->getNumCol());
+      this->writeInt16ToFile(cellArray->getNumRow());
 
-      // -- SNAME
-      int strSize = cellArray->getCellname().size();
-      if (strSize % 2 != 0)
-	strSize++;
-      char cellnameChar[strSize];
-      std::string cellname = cellArray->getCellname();
-      int orgStrSize = cellArray->getCellname().size();
-      for (int i = 0; i < orgStrSize; i++)
-	cellnameChar[i] = cellname[i];
-      if (orgStrSize % 2 != 0)
-	cellnameChar[strSize - 1] = ' ';
-      recordSize = strSize*sizeof(char) + sizeof(STRNAME) + sizeof(int16_t);
+      // -- XY
+      // The three points are the starting position, the position
+      // displaced by all of the columns and the position displaced by
+      // all of the rows.
+      recordSize = RECORD_LABEL_SIZE + 6*sizeof(int32_t);
       this->writeInt16ToFile(recordSize);
-      this->writeInt16ToFile(STRNAME);
-      this->writeCharToFile(cellnameChar, strSize);      
+      this->writeInt16ToFile(XY);
+      double startX = cellArray->getStartingPos().getX();
+      double startY = cellArray->getStartingPos().getY();
+      this->writeInt32ToFile(this->toDatabaseUnits(startX));
+      this->writeInt32ToFile(this->toDatabaseUnits(startY));
+
+      // record the furthest column
+      double extraDistance = cellArray->getXSpacing()*cellArray->getNumCol();
+      this->writeInt32ToFile(this->toDatabaseUnits(startX + extraDistance));
+      this->writeInt32ToFile(this->toDatabaseUnits(startY));
+
+      // record the furthest row
+      extraDistance = cellArray->getYSpacing()*cellArray->getNumRow();
+      this->writeInt32ToFile(this->toDatabaseUnits(startX));
+      this->writeInt32ToFile(this->toDatabaseUnits(startY + extraDistance));
+    }
+
+    void GDS_File::WriteSnameRecord(const Cell& cell) {
+      const int16_t RECORD_LABEL_SIZE = 2*sizeof(int16_t); 
+      const std::string& cellname = this->paddedCellname(&cell);
+      int16_t recordSize = cellname.size()*sizeof(char) + RECORD_LABEL_SIZE;
+      this->writeInt16ToFile(recordSize);
+      this->writeInt16ToFile(SNAME);
+      this->writeCharToFile(cellname.data(), cellname.size());
+    }
+
+    const std::string& GDS_File::paddedCellname(const Cell* cell) {
+      std::unordered_map<const Cell*, std::string>::iterator it =
+        this->paddedCellnames.find(cell);
+      if (it != this->paddedCellnames.end())
+        return it->second;
+      // every record must be even in number of bytes, so odd names get
+      // a terminating zero
+      std::string cellname = cell->getCellname();
+      if (cellname.size() % 2 != 0)
+        cellname.push_back('\0');
+      return this->paddedCellnames[cell] = cellname;
+    }
 
-      // -- strans
-      char stransRecord[15];
-      recordSize = RECORD_LABEL_SIZE + sizeof(stransRecord);
+    void GDS_File::WriteTransformRecords(double magnification, double rotation) {
+      const int16_t RECORD_LABEL_SIZE = 2*sizeof(int16_t); 
+      int16_t recordSize;
+      // With no STRANS record there is no reflection, magnification or
+      // rotation, so only write it when one of them is needed.
+      if (magnification == 1.0 && rotation == 0.0)
+	return;
+
+      // STRANS is a set of flags: bit 0 is reflection about the x-axis
+      // and bits 13 and 14 make the magnification and angle absolute.
+      // We use none of them, MAG and ANGLE follow when needed.
+      recordSize = RECORD_LABEL_SIZE + sizeof(int16_t);
       this->writeInt16ToFile(recordSize);
       this->writeInt16ToFile(STRANS);
-      // only certain parts of this record will not be zero, so make
-      // sure that zero is the "default."
-      for (uint i = 0; i < sizeof(stransRecord); i++)
-	stransRecord[i] = 0;
-      // setting bit 13 flags the reference has having non unity
-      // manification
-      if (cellArray->getMagnification() != 1.0)
-	stransRecord[12] = 1;
-      // Setting bit 14 flags the reference has having nonzero 
-      // rotation
-      if (cellArray->getRotation() != 0.0)
-	stransRecord[13] = 1;
-      this->writeCharToFile(stransRecord, sizeof(stransRecord));
+      this->writeInt16ToFile(0);
 
       // If no MAG record is there then the magnification is assumed
       // to be one. Therefore, only write MAG if the magnification is
       // not one.
-      if (cellArray->getMagnification() != 1.0) {
+      if (magnification != 1.0) {
 	recordSize = RECORD_LABEL_SIZE + sizeof(float64);
 	this->writeInt16ToFile(recordSize);
 	this->writeInt16ToFile(MAG);
-	this->writeFloat64ToFile(cellArray->getMagnification());
+	this->writeFloat64ToFile(magnification);
       }
 
       // If no ANGLE record is present then the angle of rotation is 
-      // assumed to be zero (note that there can still be a reflection
-      // accross the x-axis which is in effect having a rotation of 
-      // 180 degrees but I will keep all rotation information in ANGLE)
-      if (cellArray->getRotation() != 0.0) {
+      // assumed to be zero. GDSII angles are in degrees while ours
+      // are in radians.
+      if (rotation != 0.0) {
 	recordSize = RECORD_LABEL_SIZE + sizeof(float64);
 	this->writeInt16ToFile(recordSize);
 	this->writeInt16ToFile(ANGLE);
-	this->writeFloat64ToFile(cellArray->getRotation());	
-      }      
-
-      // -- COLROW
-      recordSize = RECORD_LABEL_SIZE + 2*sizeof(int16_t);
-      this->writeInt16ToFile(recordSize);
-      this->writeInt16ToFile(cellArray->getNumCol());
-      this->writeInt16ToFile(cellArray->getNumRow());
-
-      // -- XY
-      recordSize = RECORD_LABEL_SIZE + 6*sizeof(int32_t);
-      this->writeInt16ToFile(recordSize);
-      this->writeInt16ToFile(XY);
-      int32_t curX = cellArray->getStartingPos().getX()/this->databaseUnits;
-      this->writeInt32ToFile(curX);
-      int32_t curY = cellArray->getStartingPos().getY()/this->databaseUnits;
-      this->writeInt32ToFile(curY);
-
-      // record the furthest column
-      int32_t extraDistance =  
-	cellArray->getXSpacing()*cellArray->getNumCol()/this->databaseUnits;
-      this->writeInt32ToFile(curX + extraDistance);
-      this->writeInt32ToFile(curY);
+	this->writeFloat64ToFile(rotation*180./std::acos(-1.));
+      }
+    }
 
-      // record the furthest row
-      this->writeInt32ToFile(curX);
-      extraDistance = 
-	cellArray->getYSpacing()*cellArray->getNumRow()/this->databaseUnits;
-      this->writeInt32ToFile(curY + extraDistance);
+    int32_t GDS_File::toDatabaseUnits(double value) const {
+      return std::lround(value/this->databaseUnits);
     }
 
     void GDS_File::WriteElementTailRecords() {
@@ -509,14 +573,14 @@ namespace sil {
       // gdsII file format is written in big endian
       if (this->sysLittleEndian)
 	data = int16Swap(data);
-      this->outputFile.write(reinterpret_cast<char*>(&data), sizeof(int16_t));      
+      this->output->write(reinterpret_cast<char*>(&data), sizeof(int16_t));      
     }
 
     void GDS_File::writeInt32ToFile(int32_t data) {
       // gdsII file format is written in big endian
       if (this->sysLittleEndian)
 	data = int32Swap(data);
-      this->outputFile.write(reinterpret_cast<char*>(&data), sizeof(int32_t));      
+      this->output->write(reinterpret_cast<char*>(&data), sizeof(int32_t));      
     }
 
     void GDS_File::writeFloat64ToFile(float64 data) {
@@ -605,15 +669,15 @@ namespace sil {
 	}
       }
 
-      this->outputFile.write(reinterpret_cast<char*>(&output),
+      this->output->write(reinterpret_cast<char*>(&output),
 			     numBytes*sizeof(char));      
     }
 
-    void GDS_File::writeCharToFile(char data[], int size) {
+    void GDS_File::writeCharToFile(const char data[], int size) {
       // there is no difference between little endian and big endian data
       // for char data, as it is only one byte long thus there cannot be
       // byte swapping.
-      this->outputFile.write(data, size);      
+      this->output->write(data, size);      
     }
 
     // This is function contains a small trick to determine if a
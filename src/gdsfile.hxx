@@ -30,7 +30,11 @@ typedef double float64;
 #include <stdint.h> // cross-compiler integer datatypes
 #include <stdexcept>
 #include <typeinfo>
+#include <cmath>
+#include <sstream>
+#include <unordered_map>
 #include "cell.hxx"
+#include "contentHash.hxx"
 #include "polygon.hxx"
 
 namespace sil {
@@ -107,6 +111,54 @@ namespace sil {
     const int16_t ENDMASKS     = 0x3800;
 
 
+    /// \brief Remembers the serialized BGNSTR ... ENDSTR bytes of every
+    /// Cell written by a GDS_File so that later writes can reuse them.
+    ///
+    /// Each entry is keyed by a hash of everything that ends up in the
+    /// structure (the name, every element and the names of referenced
+    /// cells), so an entry is only reused while the Cell is unchanged.
+    /// Hashing a Cell is a quick read-only pass, much cheaper than
+    /// formatting and writing its records.
+    ///
+    /// A cache is only used when it is passed to a write, and each write
+    /// drops the entries of the cells it did not write, so it never holds
+    /// more than one copy of the structures of the last write. Entries
+    /// are found by the address of the Cell. A Cell destroyed after a
+    /// write may have its address reused by a new Cell. The entry is
+    /// then only reused if the new Cell hashes like the old one, that is
+    /// if it serializes to the same records anyway.
+    class GDS_WriteCache {
+    private:
+      struct Entry {
+        ContentHash key; //!< The hash of the contents the bytes were made from.
+        std::string bytes; //!< The BGNSTR ... ENDSTR records of the Cell.
+      };
+
+      std::unordered_map<const Cell*, Entry> entries; //!< The cached structures.
+      unsigned int hits; //!< Cells reused by the last write.
+      unsigned int misses; //!< Cells serialized by the last write.
+
+      friend class GDS_File;
+
+    public:
+      /// \brief Creates an empty cache.
+      GDS_WriteCache(void);
+
+      /// \brief Forgets all of the cached structures.
+      void clear(void);
+
+      /// \brief Returns the number of cells whose bytes were reused by
+      /// the last write.
+      unsigned int getHits(void) const;
+
+      /// \brief Returns the number of cells that were serialized by the
+      /// last write.
+      unsigned int getMisses(void) const;
+
+      /// \brief Returns the number of bytes held by the cache.
+      std::size_t getSize(void) const;
+    }; // class GDS_WriteCache
+
     class GDS_File {
     private:
       std::string filename; //!< The name of the output file.
@@ -120,8 +172,10 @@ namespace sil {
       float64 databaseUnits; //!< Relative size of units stored in the database to the user's defined units.
       float64 userUnits; //!< Size of a unit in meters.
       std::ofstream outputFile; //!< Reference to the iostream to the output file.
+      std::ostream* output; //!< Where records are written, the file or a cache buffer.
       bool sysLittleEndian; //!< Is the global variable to 
       Time timeCreated;
+      std::unordered_map<const Cell*, std::string> paddedCellnames; //!< The names of the cells written so far, see paddedCellname().
 
       /// \brief Writes the data at the top of the GDSII file that specifies
       /// pertanent information about the rest of the file.
@@ -211,16 +265,34 @@ namespace sil {
       /// ASCII STRING	  1906          Up to 512-character string
       /// NODETYPE	  2A02          2-byte integer
       /// BOXTYPE	  2E02          2-byte integer
-      void WriteElementContentRecords(std::vector<Polygon>::const_iterator polygon);
+      void WriteElementContentRecords(PolygonList::const_iterator polygon);
 
       /// \brief Overridden for use with Path elements
-      void WriteElementContentRecords(std::vector<Path>::const_iterator path);
+      void WriteElementContentRecords(PathList::const_iterator path);
 
       /// \brief Overridden for use with CellReference elements
-      void WriteElementContentRecords(std::vector<CellReference>::const_iterator cellRef);
+      void WriteElementContentRecords(CellReferenceList::const_iterator cellRef);
 
       /// \brief Overridden for use with CellArray elements
-      void WriteElementContentRecords(std::vector<CellArray>::const_iterator cellArray);
+      void WriteElementContentRecords(CellArrayList::const_iterator cellArray);
+
+      /// \brief Writes the SNAME record naming the Cell that a SREF or
+      /// AREF element refers to.
+      void WriteSnameRecord(const Cell& cell);
+
+      /// \brief Returns the name of @cell padded to an even length, as
+      /// it is written in STRNAME and SNAME records.
+      ///
+      /// Each name is padded once per GDS_File, however many SREF and
+      /// AREF elements refer to the Cell.
+      const std::string& paddedCellname(const Cell* cell);
+
+      /// \brief Writes the STRANS, MAG and ANGLE records of a SREF or
+      /// AREF element, omitting them when they hold default values.
+      ///
+      /// @magnification The magnification of the referenced Cell.
+      /// @rotation The rotation of the referenced Cell (in radians).
+      void WriteTransformRecords(double magnification, double rotation);
 
       /// \brief Marks the end of each element record.
       ///
@@ -234,7 +306,7 @@ namespace sil {
 
       // Writes input data to the file specified by outputFile in a size sensitive
       // and endian sensitive manner (gdsII are always big endian).
-      void writeCharToFile(char data[], int size);
+      void writeCharToFile(const char data[], int size);
 
       // Writes input data to the file specified by outputFile in a size sensitive
       // and endian sensitive manner (gdsII are always big endian).
@@ -244,6 +316,9 @@ namespace sil {
       // and endian sensitive manner (gdsII are always big endian).
       void writeFloat64ToFile(float64 data);
 
+      // Converts a coordinate in user units to the nearest database unit.
+      int32_t toDatabaseUnits(double value) const;
+
       // Tests if the system is little endian or big endian.
       // returns true if the system is a little endian system.
       bool sysIsLittleEndian(void);
@@ -253,6 +328,10 @@ namespace sil {
       /// to the file specified by the private field filename.
       void WriteCell(const Cell* cell);
 
+      /// \brief Returns the hash of everything WriteCell() writes for
+      /// @cell, apart from the time stamps.
+      ContentHash serializationKey(const Cell* cell) const;
+
     protected:
 
     public:
@@ -268,7 +347,13 @@ namespace sil {
       
       /// Write the supplied vector of cells to the specified GDSII
       /// file.
-      void Write(const std::vector<Cell*> cellVec);
+      ///
+      /// If @cache is given, cells that are unchanged since they were
+      /// last written with it are copied from the cache instead of
+      /// being serialized again, and the cache is updated with the
+      /// others. Entries for cells not in @cellVec are dropped.
+      void Write(const std::vector<Cell*> cellVec,
+                 GDS_WriteCache* cache = NULL);
 
       /// Read in the specified GDSII file. Return the corresponding
       /// vector of cell pointers that correspond to the GDSII record.
@@ -0,0 +1,305 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "geometry.hxx"
+#include <algorithm>
+#include <cmath>
+
+namespace sil {
+  namespace utils {
+
+    Transform::Transform() : a(1), b(0), dx(0), dy(0) {}
+
+    Transform::Transform(double magnification, double rotation, const CoordPnt& offset) :
+      a(magnification*std::cos(rotation)), b(magnification*std::sin(rotation)),
+      dx(offset.getX()), dy(offset.getY()) {
+      // keep quarter turns exact, so that rectangles stay rectangles
+      double quarter = rotation/(std::acos(-1.)/2.);
+      if (std::abs(quarter - std::round(quarter)) < 1e-12) {
+        long turns = (long(std::round(quarter))%4 + 4)%4;
+        static const double cosines[4] = {1, 0, -1, 0};
+        static const double sines[4] = {0, 1, 0, -1};
+        this->a = magnification*cosines[turns];
+        this->b = magnification*sines[turns];
+      }
+    }
+
+    CoordPnt Transform::apply(const CoordPnt& pnt) const {
+      return CoordPnt(this->a*pnt.getX() - this->b*pnt.getY() + this->dx,
+                      this->b*pnt.getX() + this->a*pnt.getY() + this->dy);
+    }
+
+    Bounds Transform::apply(const Bounds& box) const {
+      Bounds result;
+      if (box.isEmpty())
+        return result;
+      result.add(this->apply(CoordPnt(box.minX, box.minY)));
+      result.add(this->apply(CoordPnt(box.minX, box.maxY)));
+      result.add(this->apply(CoordPnt(box.maxX, box.minY)));
+      result.add(this->apply(CoordPnt(box.maxX, box.maxY)));
+      return result;
+    }
+
+    Bounds Transform::invert(const Bounds& box) const {
+      Bounds result;
+      if (box.isEmpty())
+        return result;
+      double scale = this->a*this->a + this->b*this->b;
+      double xs[2] = {box.minX - this->dx, box.maxX - this->dx};
+      double ys[2] = {box.minY - this->dy, box.maxY - this->dy};
+      for (int i = 0; i < 2; i++)
+        for (int j = 0; j < 2; j++)
+          result.add(CoordPnt((this->a*xs[i] + this->b*ys[j])/scale,
+                              (-this->b*xs[i] + this->a*ys[j])/scale));
+      return result;
+    }
+
+    Transform Transform::after(const Transform& inner) const {
+      Transform result;
+      result.a = this->a*inner.a - this->b*inner.b;
+      result.b = this->a*inner.b + this->b*inner.a;
+      CoordPnt offset = this->apply(CoordPnt(inner.dx, inner.dy));
+      result.dx = offset.getX();
+      result.dy = offset.getY();
+      return result;
+    }
+
+    Transform Transform::shifted(double x, double y) const {
+      Transform result = *this;
+      result.dx += x;
+      result.dy += y;
+      return result;
+    }
+
+    bool Transform::keepsAxes() const {
+      return this->a == 0 || this->b == 0;
+    }
+
+    static double cross(double ax, double ay, double bx, double by) {
+      return ax*by - ay*bx;
+    }
+
+    double pointSegmentDistance(const CoordPnt& pnt, const CoordPnt& s0,
+                                const CoordPnt& s1, CoordPnt& closest) {
+      double ex = s1.getX() - s0.getX();
+      double ey = s1.getY() - s0.getY();
+      double length2 = ex*ex + ey*ey;
+      double t = 0;
+      if (length2 > 0)
+        t = std::max(0., std::min(1., ((pnt.getX() - s0.getX())*ex +
+                                       (pnt.getY() - s0.getY())*ey)/length2));
+      closest = CoordPnt(s0.getX() + t*ex, s0.getY() + t*ey);
+      return std::hypot(pnt.getX() - closest.getX(), pnt.getY() - closest.getY());
+    }
+
+    static int turn(const CoordPnt& p, const CoordPnt& q, const CoordPnt& r) {
+      double value = cross(q.getX() - p.getX(), q.getY() - p.getY(),
+                           r.getX() - p.getX(), r.getY() - p.getY());
+      return value > 0 ? 1 : (value < 0 ? -1 : 0);
+    }
+
+    static bool onSegment(const CoordPnt& p, const CoordPnt& s0, const CoordPnt& s1) {
+      return std::min(s0.getX(), s1.getX()) <= p.getX() && p.getX() <= std::max(s0.getX(), s1.getX()) &&
+        std::min(s0.getY(), s1.getY()) <= p.getY() && p.getY() <= std::max(s0.getY(), s1.getY());
+    }
+
+    bool segmentsMeet(const CoordPnt& a0, const CoordPnt& a1,
+                      const CoordPnt& b0, const CoordPnt& b1) {
+      int t1 = turn(a0, a1, b0), t2 = turn(a0, a1, b1);
+      int t3 = turn(b0, b1, a0), t4 = turn(b0, b1, a1);
+      if (t1 != t2 && t3 != t4 && t1*t2 <= 0 && t3*t4 <= 0 &&
+          !(t1 == 0 && t2 == 0))
+        return true;
+      return (t1 == 0 && onSegment(b0, a0, a1)) || (t2 == 0 && onSegment(b1, a0, a1)) ||
+        (t3 == 0 && onSegment(a0, b0, b1)) || (t4 == 0 && onSegment(a1, b0, b1));
+    }
+
+    double segmentDistance(const CoordPnt& a0, const CoordPnt& a1,
+                           const CoordPnt& b0, const CoordPnt& b1,
+                           CoordPnt& pa, CoordPnt& pb) {
+      if (segmentsMeet(a0, a1, b0, b1)) {
+        pa = pb = a0;
+        return 0;
+      }
+      CoordPnt closest;
+      double best = pointSegmentDistance(a0, b0, b1, closest);
+      pa = a0;
+      pb = closest;
+      double d = pointSegmentDistance(a1, b0, b1, closest);
+      if (d < best) {
+        best = d;
+        pa = a1;
+        pb = closest;
+      }
+      d = pointSegmentDistance(b0, a0, a1, closest);
+      if (d < best) {
+        best = d;
+        pa = closest;
+        pb = b0;
+      }
+      d = pointSegmentDistance(b1, a0, a1, closest);
+      if (d < best) {
+        best = d;
+        pa = closest;
+        pb = b1;
+      }
+      return best;
+    }
+
+    bool pointInPolygon(const CoordPnt& pnt, Span<const CoordPnt> vertices) {
+      bool inside = false;
+      std::size_t n = vertices.size();
+      for (std::size_t i = 0, j = n - 1; i < n; j = i++) {
+        const CoordPnt& p = vertices[i];
+        const CoordPnt& q = vertices[j];
+        if (turn(q, p, pnt) == 0 && onSegment(pnt, q, p))
+          return true;
+        if ((p.getY() > pnt.getY()) != (q.getY() > pnt.getY()) &&
+            pnt.getX() < q.getX() + (pnt.getY() - q.getY())*(p.getX() - q.getX())/(p.getY() - q.getY()))
+          inside = !inside;
+      }
+      return inside;
+    }
+
+    static Bounds edgeBounds(const CoordPnt& e0, const CoordPnt& e1) {
+      Bounds box;
+      box.add(e0);
+      box.add(e1);
+      return box;
+    }
+
+    bool polygonsTouch(Span<const CoordPnt> a, const Bounds& boundsA,
+                       Span<const CoordPnt> b, const Bounds& boundsB) {
+      if (!boundsA.intersects(boundsB) || a.empty() || b.empty())
+        return false;
+      std::size_t n = a.size(), k = b.size();
+      for (std::size_t i = 0; i < n; i++) {
+        const CoordPnt& a0 = a[i];
+        const CoordPnt& a1 = a[(i + 1)%n];
+        Bounds box = edgeBounds(a0, a1);
+        if (!box.intersects(boundsB))
+          continue;
+        for (std::size_t j = 0; j < k; j++) {
+          const CoordPnt& b0 = b[j];
+          const CoordPnt& b1 = b[(j + 1)%k];
+          if (box.intersects(edgeBounds(b0, b1)) && segmentsMeet(a0, a1, b0, b1))
+            return true;
+        }
+      }
+      return pointInPolygon(a[0], b) || pointInPolygon(b[0], a);
+    }
+
+    double signedArea(Span<const CoordPnt> vertices) {
+      double area = 0;
+      std::size_t n = vertices.size();
+      for (std::size_t i = 0; i < n; i++)
+        area += cross(vertices[i].getX(), vertices[i].getY(),
+                      vertices[(i + 1)%n].getX(), vertices[(i + 1)%n].getY());
+      return area/2;
+    }
+
+    void pathSegmentQuad(const CoordPnt& p0, const CoordPnt& p1, double halfWidth,
+                         double before, double after, CoordPnt quad[4]) {
+      double length = std::hypot(p1.getX() - p0.getX(), p1.getY() - p0.getY());
+      double ux = (p1.getX() - p0.getX())/length, uy = (p1.getY() - p0.getY())/length;
+      double sx = p0.getX() - ux*before, sy = p0.getY() - uy*before;
+      double ex = p1.getX() + ux*after, ey = p1.getY() + uy*after;
+      quad[0] = CoordPnt(sx - uy*halfWidth, sy + ux*halfWidth);
+      quad[1] = CoordPnt(sx + uy*halfWidth, sy - ux*halfWidth);
+      quad[2] = CoordPnt(ex + uy*halfWidth, ey - ux*halfWidth);
+      quad[3] = CoordPnt(ex - uy*halfWidth, ey + ux*halfWidth);
+    }
+
+    std::size_t pathQuads(Span<const CoordPnt> points, double width, int pathType,
+                          const Transform& transform, std::vector<CoordPnt>& quads) {
+      double half = width*std::hypot(transform.a, transform.b)/2.;
+      std::size_t count = 0;
+      for (std::size_t k = 1; k < points.size(); k++) {
+        if (points[k].getX() == points[k - 1].getX() && points[k].getY() == points[k - 1].getY())
+          continue;
+        double before = (k > 1 || pathType != 0) ? half : 0;
+        double after = (k + 1 < points.size() || pathType != 0) ? half : 0;
+        CoordPnt quad[4];
+        pathSegmentQuad(transform.apply(points[k - 1]), transform.apply(points[k]),
+                        half, before, after, quad);
+        quads.insert(quads.end(), quad, quad + 4);
+        count++;
+      }
+      return count;
+    }
+
+    // Clips @input to the half plane on the inner side of one border of
+    // a box: @axis 0 for x and 1 for y, @upper if the border is a maximum.
+    static void clipToBorder(const std::vector<CoordPnt>& input, int axis, bool upper,
+                             double border, std::vector<CoordPnt>& output) {
+      output.clear();
+      std::size_t n = input.size();
+      for (std::size_t i = 0; i < n; i++) {
+        const CoordPnt& from = input[i];
+        const CoordPnt& to = input[(i + 1)%n];
+        double f = axis == 0 ? from.getX() : from.getY();
+        double t = axis == 0 ? to.getX() : to.getY();
+        bool fromInside = upper ? f <= border : f >= border;
+        bool toInside = upper ? t <= border : t >= border;
+        if (fromInside)
+          output.push_back(from);
+        if (fromInside != toInside) {
+          double s = (border - f)/(t - f);
+          double x = from.getX() + s*(to.getX() - from.getX());
+          double y = from.getY() + s*(to.getY() - from.getY());
+          output.push_back(axis == 0 ? CoordPnt(border, y) : CoordPnt(x, border));
+        }
+      }
+    }
+
+    void clipToBox(Span<const CoordPnt> vertices, const Bounds& box,
+                   std::vector<CoordPnt>& clipped) {
+      clipped.assign(vertices.begin(), vertices.end());
+      if (box.isEmpty()) {
+        clipped.clear();
+        return;
+      }
+      std::vector<CoordPnt> scratch;
+      clipToBorder(clipped, 0, false, box.minX, scratch);
+      clipToBorder(scratch, 0, true, box.maxX, clipped);
+      clipToBorder(clipped, 1, false, box.minY, scratch);
+      clipToBorder(scratch, 1, true, box.maxY, clipped);
+    }
+
+    bool latticeRange(double lo, double hi, double step, int count, double windowLo,
+                      double windowHi, bool inside, int& first, int& last) {
+      double from = inside ? windowLo - lo : windowLo - hi;
+      double to = inside ? windowHi - hi : windowHi - lo;
+      const double slack = 1e-9;
+      double kMin = 0, kMax = count - 1;
+      if (step == 0) {
+        if (from > slack || to < -slack)
+          return false;
+      } else {
+        double a = from/step, b = to/step;
+        kMin = std::max(kMin, std::ceil(std::min(a, b) - slack));
+        kMax = std::min(kMax, std::floor(std::max(a, b) + slack));
+      }
+      if (kMin > kMax)
+        return false;
+      first = int(kMin);
+      last = int(kMax);
+      return true;
+    }
+
+  } // namespace utils
+} // namespace sil
@@ -0,0 +1,140 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef GEOMETRY_HXX
+#define GEOMETRY_HXX
+
+#include <vector>
+#include "coord.hxx"
+#include "span.hxx"
+#include "spatialIndex.hxx"
+
+namespace sil {
+  namespace utils {
+
+    /// \brief A magnification, rotation and translation, mapping the
+    /// coordinates of a placed Cell into those of the Cell placing it.
+    ///
+    /// Placements compose: the transform of a Cell placed inside a
+    /// placed Cell is outer.after(inner).
+    struct Transform {
+      double a; //!< magnification*cos(rotation)
+      double b; //!< magnification*sin(rotation)
+      double dx; //!< The translation.
+      double dy;
+
+      /// \brief Creates the identity.
+      Transform(void);
+
+      /// \brief Creates the transform of a CellReference.
+      ///
+      /// @magnification The magnification.
+      /// @rotation The rotation in radians.
+      /// @offset The position of the reference.
+      Transform(double magnification, double rotation, const CoordPnt& offset);
+
+      /// \brief Maps @pnt.
+      CoordPnt apply(const CoordPnt& pnt) const;
+
+      /// \brief Returns the bounds of @box once mapped.
+      Bounds apply(const Bounds& box) const;
+
+      /// \brief Returns the bounds of the points that map into @box.
+      Bounds invert(const Bounds& box) const;
+
+      /// \brief Returns the transform that applies @inner, then this.
+      Transform after(const Transform& inner) const;
+
+      /// \brief Returns this transform moved by (@x, @y).
+      Transform shifted(double x, double y) const;
+
+      /// \brief Returns true if axis aligned rectangles stay axis
+      /// aligned, that is the rotation is a multiple of 90 degrees.
+      bool keepsAxes(void) const;
+    };
+
+    /// \brief Returns the distance from @pnt to the segment [@s0, @s1]
+    /// and its closest point in @closest.
+    double pointSegmentDistance(const CoordPnt& pnt, const CoordPnt& s0,
+                                const CoordPnt& s1, CoordPnt& closest);
+
+    /// \brief Returns true if the segments [@a0, @a1] and [@b0, @b1]
+    /// share a point.
+    bool segmentsMeet(const CoordPnt& a0, const CoordPnt& a1,
+                      const CoordPnt& b0, const CoordPnt& b1);
+
+    /// \brief Returns the distance between the segments [@a0, @a1] and
+    /// [@b0, @b1] and their closest points in @pa and @pb.
+    double segmentDistance(const CoordPnt& a0, const CoordPnt& a1,
+                           const CoordPnt& b0, const CoordPnt& b1,
+                           CoordPnt& pa, CoordPnt& pb);
+
+    /// \brief Returns true if @pnt lies inside the polygon @vertices or
+    /// on its boundary.
+    bool pointInPolygon(const CoordPnt& pnt, Span<const CoordPnt> vertices);
+
+    /// \brief Returns true if the outlines of polygons @a and @b, with
+    /// the bounding boxes @boundsA and @boundsB, meet or one lies inside
+    /// the other.
+    bool polygonsTouch(Span<const CoordPnt> a, const Bounds& boundsA,
+                       Span<const CoordPnt> b, const Bounds& boundsB);
+
+    /// \brief Returns the signed area of the polygon @vertices, positive
+    /// if they run counterclockwise.
+    double signedArea(Span<const CoordPnt> vertices);
+
+    /// \brief Writes the outline of one segment of a Path to @quad.
+    ///
+    /// @p0 The start of the segment.
+    /// @p1 The end of the segment, which must differ from @p0.
+    /// @halfWidth Half the width of the Path.
+    /// @before How far the outline reaches back past @p0.
+    /// @after How far the outline reaches on past @p1.
+    void pathSegmentQuad(const CoordPnt& p0, const CoordPnt& p1, double halfWidth,
+                         double before, double after, CoordPnt quad[4]);
+
+    /// \brief Appends the outline of a Path, mapped by @transform, to
+    /// @quads as one quad per segment and returns the number of quads.
+    ///
+    /// Every segment reaches half the width into the bends, so the quads
+    /// overlap there and together cover the Path. The ends are extended
+    /// for path types 1 and 2, round ends being treated as square ones.
+    /// Segments of zero length are skipped.
+    std::size_t pathQuads(Span<const CoordPnt> points, double width, int pathType,
+                          const Transform& transform, std::vector<CoordPnt>& quads);
+
+    /// \brief Clips the polygon @vertices to @box and writes the result
+    /// to @clipped (Sutherland-Hodgman).
+    ///
+    /// A concave polygon that leaves and reenters the box may come back
+    /// with zero width bridges along the border of the box; they cover
+    /// no area. @clipped is empty if nothing of the polygon is inside.
+    void clipToBox(Span<const CoordPnt> vertices, const Bounds& box,
+                   std::vector<CoordPnt>& clipped);
+
+    /// \brief Finds the indices k < @count for which [@lo, @hi] moved by
+    /// k*@step meets [@windowLo, @windowHi], or lies inside it if
+    /// @inside, as [@first, @last], and returns false if there are none.
+    ///
+    /// This picks the columns or rows of an array that a window needs.
+    bool latticeRange(double lo, double hi, double step, int count, double windowLo,
+                      double windowHi, bool inside, int& first, int& last);
+
+  } // namespace utils
+} // namespace sil
+
+#endif // GEOMETRY_HXX
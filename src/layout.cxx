@@ -15,27 +15,159 @@
 // limitations under the License.
 
 #include "layout.hxx"
+#include "cellGraph.hxx"
+#include "frozenLayout.hxx"
+#include <algorithm>
+#include <unordered_set>
 // keep the gdsfile header here so that it is not automatically 
 // included when one includes "sil.hxx". This will add a barrier for
 // users against creating and handling GDS_File classes themselves,
 // which they should not do.
 #include "gdsfile.hxx" 
+#include "oasisfile.hxx"
+#include "snapshot.hxx"
 
 namespace sil {
 
-  Layout::Layout() {}
+  Layout::Layout() : Layout::Layout(std::pmr::get_default_resource()) {}
+
+  Layout::Layout(std::pmr::memory_resource* resource) :
+    memoryResource(resource) {}
+
+  std::pmr::memory_resource* Layout::getMemoryResource() const {
+    return this->memoryResource;
+  }
+
+  Layout::~Layout() {
+    // the owned cells are destroyed afterwards and must not call back
+    for (uint i = 0; i < this->cellVec.size(); i++) {
+      Cell& cell = *this->cellVec[i];
+      std::lock_guard<std::mutex> lock(cell.layoutsMutex);
+      cell.layouts.erase(std::remove(cell.layouts.begin(), cell.layouts.end(), this),
+                         cell.layouts.end());
+    }
+  }
 
   void Layout::addCell(Cell& usrCell) {
+    {
+      std::lock_guard<std::mutex> lock(usrCell.layoutsMutex);
+      if (std::find(usrCell.layouts.begin(), usrCell.layouts.end(), this) ==
+          usrCell.layouts.end())
+        usrCell.layouts.push_back(this);
+      this->cellnameIndex[usrCell.getCellname()].push_back(&usrCell);
+    }
     this->cellVec.push_back(&usrCell);
   }
 
+  Cell& Layout::createCell(std::string usrCellname) {
+    this->ownedCells.push_back(std::unique_ptr<Cell>(new Cell(usrCellname, this->memoryResource)));
+    this->addCell(*this->ownedCells.back());
+    return *this->ownedCells.back();
+  }
+
+  Cell* Layout::findCell(const std::string& usrCellname) const {
+    std::unordered_map<std::string, std::vector<Cell*> >::const_iterator it =
+      this->cellnameIndex.find(usrCellname);
+    return it != this->cellnameIndex.end() ? it->second.front() : NULL;
+  }
+
+  std::size_t Layout::unindexCell(const Cell& usrCell, const std::string& usrCellname) {
+    std::unordered_map<std::string, std::vector<Cell*> >::iterator it =
+      this->cellnameIndex.find(usrCellname);
+    if (it == this->cellnameIndex.end())
+      return 0;
+    std::vector<Cell*>& cells = it->second;
+    std::size_t before = cells.size();
+    cells.erase(std::remove(cells.begin(), cells.end(), &usrCell), cells.end());
+    std::size_t removed = before - cells.size();
+    if (cells.empty())
+      this->cellnameIndex.erase(it);
+    return removed;
+  }
+
+  void Layout::renameCell(Cell& usrCell, const std::string& oldCellname) {
+    // a Cell added twice has two entries
+    std::size_t entries = this->unindexCell(usrCell, oldCellname);
+    std::vector<Cell*>& cells = this->cellnameIndex[usrCell.getCellname()];
+    cells.insert(cells.end(), entries, &usrCell);
+  }
+
+  void Layout::dropCell(const Cell& usrCell) {
+    this->unindexCell(usrCell, usrCell.getCellname());
+    this->cellVec.erase(std::remove(this->cellVec.begin(), this->cellVec.end(), &usrCell),
+                        this->cellVec.end());
+  }
+
+  void Layout::removeCell(const Cell& usrCell) {
+    this->removeCells(std::vector<const Cell*>(1, &usrCell));
+  }
+
+  void Layout::removeCells(const std::vector<const Cell*>& usrCells) {
+    if (usrCells.empty())
+      return;
+    std::unordered_set<const Cell*> removed(usrCells.begin(), usrCells.end());
+    for (std::unordered_set<const Cell*>::const_iterator it = removed.begin();
+         it != removed.end(); ++it) {
+      Cell& cell = const_cast<Cell&>(**it);
+      std::lock_guard<std::mutex> lock(cell.layoutsMutex);
+      cell.layouts.erase(std::remove(cell.layouts.begin(), cell.layouts.end(), this),
+                         cell.layouts.end());
+      this->unindexCell(cell, cell.getCellname());
+    }
+    this->cellVec.erase(std::remove_if(this->cellVec.begin(), this->cellVec.end(),
+                                       [&](Cell* cell) { return removed.count(cell) > 0; }),
+                        this->cellVec.end());
+    this->ownedCells.erase(std::remove_if(this->ownedCells.begin(), this->ownedCells.end(),
+                                          [&](const std::unique_ptr<Cell>& cell) {
+                                            return removed.count(cell.get()) > 0;
+                                          }),
+                           this->ownedCells.end());
+  }
+
+  std::vector<Cell*> Layout::hierarchicalOrder() const {
+    CellGraph graph(*this);
+    std::vector<unsigned int> order = graph.topologicalOrder();
+    // the graph's first nodes are this layout's distinct cells in the
+    // order they were added, so a Cell added twice is returned once
+    std::vector<Cell*> distinct;
+    std::unordered_set<const Cell*> seen;
+    for (uint i = 0; i < this->cellVec.size(); i++)
+      if (seen.insert(this->cellVec[i]).second)
+        distinct.push_back(this->cellVec[i]);
+    std::vector<Cell*> cells;
+    cells.reserve(distinct.size());
+    for (uint i = 0; i < order.size(); i++)
+      if (order[i] < graph.getLayoutCellCount())
+        cells.push_back(distinct[order[i]]);
+    return cells;
+  }
+
   std::vector<Cell*> Layout::getCells() const {
     return this->cellVec;
   }
 
+  std::shared_ptr<const FrozenLayout> Layout::freeze() const {
+    return FrozenLayout::freeze(*this);
+  }
+
   void Layout::write(std::string usrFilename) {
     sil::utils::GDS_File myFile(usrFilename);
-    myFile.Write(this->cellVec);
+    myFile.Write(this->hierarchicalOrder());
+  }
+
+  void Layout::write(std::string usrFilename, utils::GDS_WriteCache& cache) {
+    sil::utils::GDS_File myFile(usrFilename);
+    myFile.Write(this->hierarchicalOrder(), &cache);
+  }
+
+  void Layout::writeOASIS(std::string usrFilename, bool compress) {
+    sil::utils::OASIS_File myFile(usrFilename);
+    myFile.setCompression(compress);
+    myFile.Write(this->hierarchicalOrder());
+  }
+
+  void Layout::writeSnapshot(std::string usrFilename) const {
+    sil::writeSnapshot(*this, usrFilename);
   }
 
 } // namespace sil
@@ -20,10 +20,18 @@
 #include <vector>
 #include <string>
 #include <functional>
+#include <memory>
+#include <unordered_map>
 #include "cell.hxx"
 
 namespace sil {
 
+  namespace utils {
+    class GDS_WriteCache;
+  }
+
+  class FrozenLayout;
+
   /// class Layout
   ///
   /// This class is the overall container for sil. That is if you
@@ -35,6 +43,28 @@ namespace sil {
   private:
 
     std::vector<Cell*> cellVec; //!< \brief The collection of Cell pointers which constitute a Layout.
+    std::vector<std::unique_ptr<Cell> > ownedCells; //!< \brief Cells created by (and owned by) this Layout.
+    std::unordered_map<std::string, std::vector<Cell*> > cellnameIndex; //!< \brief The cells of @cellVec by name, in the order they took it, see findCell().
+    std::pmr::memory_resource* memoryResource; //!< \brief The memory resource of the cells made by createCell().
+
+    friend class Cell;
+
+    /// \brief Removes every entry of @usrCell under @usrCellname from
+    /// @cellnameIndex and returns how many there were.
+    std::size_t unindexCell(const Cell& usrCell, const std::string& usrCellname);
+
+    /// \brief Moves @usrCell from @oldCellname to its current name in
+    /// @cellnameIndex, called by Cell::setCellname().
+    void renameCell(Cell& usrCell, const std::string& oldCellname);
+
+    /// \brief Forgets @usrCell, which is being destroyed.
+    void dropCell(const Cell& usrCell);
+
+    /// \brief Returns the cells ordered so that every Cell comes after
+    /// the cells it places, throwing std::logic_error on a cycle.
+    ///
+    /// A Cell that was added more than once is returned once.
+    std::vector<Cell*> hierarchicalOrder(void) const;
 
   protected:
 
@@ -42,6 +72,23 @@ namespace sil {
     /// \brief The default constructor for this class.
     Layout(void);
 
+    /// \brief Creates a Layout whose createCell() allocates the shapes
+    /// of the new cells from @resource.
+    ///
+    /// @resource The memory resource, for example an Arena, that must
+    /// outlive the Layout.
+    ///
+    /// Loading a large file into an Arena replaces millions of small
+    /// heap allocations for vertex lists by a few large blocks.
+    explicit Layout(std::pmr::memory_resource* resource);
+
+    /// \brief Returns the memory resource used by createCell().
+    std::pmr::memory_resource* getMemoryResource(void) const;
+
+    /// \brief Destroys the Layout and the cells it owns; other cells
+    /// are only removed from it.
+    ~Layout(void);
+
     /// \brief The method used to add a Cell object to this Layout.
     ///
     /// @usrCell The Cell object you wish to add to this Layout.
@@ -55,14 +102,100 @@ namespace sil {
     /// many copies of the same thing.
     void addCell(Cell& usrCell);
 
+    /// \brief Creates a new Cell that is owned by this Layout.
+    ///
+    /// @usrCellname The name of the new Cell.
+    ///
+    /// Unlike addCell() the Layout manages the lifetime of the returned
+    /// Cell, which stays valid for as long as the Layout exists. This is
+    /// how passes such as detectArrays() add the cells they generate.
+    Cell& createCell(std::string usrCellname);
+
+    /// \brief Returns the Cell named @usrCellname, or NULL if there is
+    /// no such Cell in this Layout.
+    ///
+    /// Cells are kept in a hash table by name so this takes constant
+    /// time. Cell::setCellname() moves the renamed Cell in the table of
+    /// each Layout it is in, so lookups only read it: several threads
+    /// may call findCell() at once, as long as no Cell of this Layout is
+    /// added, removed or renamed meanwhile. If several cells share a
+    /// name the one that took it first is returned.
+    Cell* findCell(const std::string& usrCellname) const;
+
+    /// \brief Removes @usrCell from this Layout.
+    ///
+    /// @usrCell The Cell to remove.
+    ///
+    /// If the Cell was made by createCell() it is destroyed, so no
+    /// CellReference or CellArray may refer to it any longer.
+    void removeCell(const Cell& usrCell);
+
+    /// \brief Removes all of @usrCells from this Layout at once.
+    ///
+    /// @usrCells The cells to remove.
+    ///
+    /// This is removeCell() for many cells, taking time linear in the
+    /// size of the Layout rather than in the size times the count.
+    void removeCells(const std::vector<const Cell*>& usrCells);
+
     /// \brief Writes all of the contained Cell objects to a file.
     ///
     /// @filename The name of the file to write to.
+    ///
+    /// Cells are written after the cells they place. Throws
+    /// std::logic_error if a Cell places itself, directly or through
+    /// other cells, as such a hierarchy can not be stored.
     void write(std::string filename);
 
+    /// \brief Like write(), but reuses the structures @cache kept from
+    /// an earlier write.
+    ///
+    /// @filename The name of the file to write to.
+    /// @cache The structures of the previous write, updated by this one.
+    ///
+    /// Every Cell that has not changed since @cache last saw it is
+    /// copied verbatim, so rewriting a Layout costs little more than
+    /// serializing the cells that were edited. Structures taken from the
+    /// cache keep the time stamps of the write that produced them. The
+    /// cache only holds the cells of its last write; see
+    /// utils::GDS_WriteCache.
+    void write(std::string filename, utils::GDS_WriteCache& cache);
+
+    /// \brief Writes all of the contained Cell objects to an OASIS file.
+    ///
+    /// @filename The name of the file to write to.
+    /// @compress Whether the contents of each cell are compressed.
+    ///
+    /// OASIS files describe the same geometry as the GDSII files made
+    /// by write() but are typically many times smaller, especially for
+    /// layouts with many repeated shapes. Compression requires that
+    /// silhouette was built with zlib. Like write() this throws
+    /// std::logic_error if a Cell places itself.
+    void writeOASIS(std::string filename, bool compress = false);
+
+    /// \brief Writes all of the contained Cell objects to a snapshot.
+    ///
+    /// @filename The name of the file to write to.
+    ///
+    /// Snapshots are silhouette's own format for passing a Layout
+    /// between tools. They are opened with LayoutSnapshot, which maps
+    /// the file instead of parsing it (see snapshot.hxx).
+    void writeSnapshot(std::string filename) const;
+
     /// \brief Returns all of the Cell objects that are contained.
     std::vector<Cell*> getCells(void) const;
 
+    /// \brief Returns an immutable copy of this Layout and of every
+    /// Cell it places.
+    ///
+    /// The copy can be shared with any number of reader threads, which
+    /// need no locks, while this Layout is edited further (see
+    /// frozenLayout.hxx). Freezing reads the shapes and fills their
+    /// derived property caches, so it must not run concurrently with
+    /// edits of this Layout. Throws std::logic_error if a Cell places
+    /// itself.
+    std::shared_ptr<const FrozenLayout> freeze(void) const;
+
   };
 }
 
@@ -0,0 +1,436 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "layoutDiff.hxx"
+#include "deduplication.hxx"
+#include "geometry.hxx"
+#include "parallel.hxx"
+#include "scanline.hxx"
+#include "snapshot.hxx"
+#include "spatialIndex.hxx"
+#include "validation.hxx"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <set>
+#include <sstream>
+#include <tuple>
+#include <unordered_map>
+
+namespace sil {
+
+  LayoutDiffOptions::LayoutDiffOptions() : tileSize(0) {}
+
+  bool LayoutDiff::isIdentical() const {
+    return this->layers.empty();
+  }
+
+  std::string LayoutDiff::toString() const {
+    std::ostringstream out;
+    for (std::size_t i = 0; i < this->removedCells.size(); i++)
+      out << "removed cell " << this->removedCells[i] << "\n";
+    for (std::size_t i = 0; i < this->addedCells.size(); i++)
+      out << "added cell " << this->addedCells[i] << "\n";
+    for (std::size_t i = 0; i < this->changedCells.size(); i++)
+      out << "changed cell " << this->changedCells[i] << "\n";
+    for (std::size_t i = 0; i < this->layers.size(); i++)
+      out << "layer " << this->layers[i].layer << ": " << this->layers[i].area << " in "
+          << this->layers[i].polygons.size() << " polygons\n";
+    return out.str();
+  }
+
+  namespace {
+
+    // placements are matched on the grids the content hashes use
+    const double PLACEMENT_GRID = 1e-3;
+    const double PLACEMENT_SCALE_GRID = 1e-9;
+
+    /// \brief The number of changed shapes an automatically sized tile
+    /// holds on average.
+    const std::size_t SHAPES_PER_TILE = 1024;
+
+    /// \brief The flattened shapes of both layouts on one layer.
+    struct ShapeSet {
+      std::vector<CoordPnt> coordinates; //!< The vertices of every shape.
+      std::vector<std::size_t> starts; //!< Where each shape starts, and where the last ends.
+      std::vector<unsigned char> sides; //!< 0 for the first layout, 1 for the second.
+      std::vector<Bounds> bounds; //!< The bounding box of each shape.
+      SpatialIndex index; //!< The bounds, indexed once flattening is done.
+
+      ShapeSet(void) : starts(1, 0) {}
+    };
+
+    /// \brief A placement of a Cell whose contents are the same in both
+    /// layouts, by its index in the first.
+    struct SkippedInstance {
+      unsigned int cell;
+      utils::Transform transform;
+    };
+
+    typedef std::tuple<std::string, long long, long long, long long, long long> PlacementKey;
+
+    /// \brief A Cell placed by another, with the transformation into the
+    /// coordinates of the top cell.
+    struct Placement {
+      PlacementKey key; //!< The name of the Cell and the transformation on a grid.
+      unsigned int cell;
+      utils::Transform transform;
+
+      bool operator<(const Placement& other) const {
+        return this->key < other.key;
+      }
+    };
+
+    /// \brief A tile of one layer that holds changed shapes.
+    struct Tile {
+      int layer;
+      Bounds box;
+    };
+
+    class Differ {
+    private:
+      const FrozenLayout* layouts[2];
+      const std::vector<ContentHash>* hashes[2];
+      std::map<int, ShapeSet> changed; //!< The shapes left to compare, by layer.
+      std::vector<SkippedInstance> skipped;
+      std::vector<Bounds> skippedBounds;
+
+      /// \brief Returns true if @a of the first layout and @b of the
+      /// second are known to have the same contents.
+      bool same(unsigned int a, unsigned int b) const {
+        return a < this->hashes[0]->size() && b < this->hashes[1]->size() &&
+          (*this->hashes[0])[a] == (*this->hashes[1])[b];
+      }
+
+      /// \brief Adds the polygons and paths of @cell itself to the
+      /// changed shapes of @side.
+      void addShapes(unsigned int side, unsigned int cell, const utils::Transform& transform) {
+        const FrozenCell& frozen = this->layouts[side]->getCell(cell);
+        for (std::size_t i = 0; i < frozen.polygons.size(); i++) {
+          const FrozenPolygon& polygon = frozen.polygons[i];
+          ShapeSet& set = this->changed[polygon.layer];
+          Bounds box;
+          for (std::size_t j = 0; j < polygon.vertices.size(); j++) {
+            set.coordinates.push_back(transform.apply(polygon.vertices[j]));
+            box.add(set.coordinates.back());
+          }
+          set.starts.push_back(set.coordinates.size());
+          set.sides.push_back(side);
+          set.bounds.push_back(box);
+        }
+        for (std::size_t i = 0; i < frozen.paths.size(); i++) {
+          const FrozenPath& path = frozen.paths[i];
+          ShapeSet& set = this->changed[path.layer];
+          std::size_t quads = utils::pathQuads(path.points, path.width, path.pathType,
+                                               transform, set.coordinates);
+          for (std::size_t q = quads; q > 0; q--) {
+            Bounds box;
+            for (std::size_t j = set.coordinates.size() - 4*q; j < set.coordinates.size() - 4*(q - 1); j++)
+              box.add(set.coordinates[j]);
+            set.starts.push_back(set.coordinates.size() - 4*(q - 1));
+            set.sides.push_back(side);
+            set.bounds.push_back(box);
+          }
+        }
+      }
+
+      /// \brief Appends every Cell @cell of @side places, with arrays
+      /// expanded into their elements, to @result.
+      void placements(unsigned int side, unsigned int cell, const utils::Transform& transform,
+                      std::vector<Placement>& result) const {
+        const FrozenCell& frozen = this->layouts[side]->getCell(cell);
+        for (std::size_t i = 0; i < frozen.references.size(); i++) {
+          const FrozenReference& ref = frozen.references[i];
+          this->addPlacement(side, ref.cell, transform.after(
+              utils::Transform(ref.magnification, ref.rotation, ref.position)), result);
+        }
+        for (std::size_t i = 0; i < frozen.arrays.size(); i++) {
+          const FrozenArray& array = frozen.arrays[i];
+          utils::Transform first(array.magnification, array.rotation, array.startingPos);
+          for (int col = 0; col < array.numCol; col++)
+            for (int row = 0; row < array.numRow; row++)
+              this->addPlacement(side, array.cell, transform.after(
+                  first.shifted(col*array.xSpacing, row*array.ySpacing)), result);
+        }
+      }
+
+      void addPlacement(unsigned int side, unsigned int cell, const utils::Transform& transform,
+                        std::vector<Placement>& result) const {
+        Placement placement = {
+          PlacementKey(this->layouts[side]->getCell(cell).cellname,
+                       std::llround(transform.a/PLACEMENT_SCALE_GRID),
+                       std::llround(transform.b/PLACEMENT_SCALE_GRID),
+                       std::llround(transform.dx/PLACEMENT_GRID),
+                       std::llround(transform.dy/PLACEMENT_GRID)),
+          cell, transform};
+        result.push_back(placement);
+      }
+
+      /// \brief Brings the shapes on @layer of a skipped instance that
+      /// overlap @window into both operands of @sweep.
+      void addSkipped(unsigned int cell, const utils::Transform& transform, const Bounds& window,
+                      int layer, utils::ScanlineSweep& sweep, std::vector<CoordPnt>& scratch,
+                      std::vector<CoordPnt>& clipped) const {
+        const FrozenCell& frozen = this->layouts[0]->getCell(cell);
+        if (!transform.apply(frozen.extent).intersects(window))
+          return;
+        if (std::binary_search(frozen.layers.begin(), frozen.layers.end(), layer)) {
+          for (std::size_t i = 0; i < frozen.polygons.size(); i++) {
+            const FrozenPolygon& polygon = frozen.polygons[i];
+            if (polygon.layer != layer || !transform.apply(polygon.bounds).intersects(window))
+              continue;
+            scratch.clear();
+            for (std::size_t j = 0; j < polygon.vertices.size(); j++)
+              scratch.push_back(transform.apply(polygon.vertices[j]));
+            this->addClipped(Span<const CoordPnt>(scratch), window, sweep, clipped, 2);
+          }
+          for (std::size_t i = 0; i < frozen.paths.size(); i++) {
+            const FrozenPath& path = frozen.paths[i];
+            if (path.layer != layer || !transform.apply(path.bounds).intersects(window))
+              continue;
+            scratch.clear();
+            std::size_t quads = utils::pathQuads(path.points, path.width, path.pathType,
+                                                 transform, scratch);
+            for (std::size_t q = 0; q < quads; q++)
+              this->addClipped(Span<const CoordPnt>(&scratch[4*q], 4), window, sweep, clipped, 2);
+          }
+        }
+        for (std::size_t i = 0; i < frozen.references.size(); i++) {
+          const FrozenReference& ref = frozen.references[i];
+          this->addSkipped(ref.cell, transform.after(
+              utils::Transform(ref.magnification, ref.rotation, ref.position)),
+            window, layer, sweep, scratch, clipped);
+        }
+        for (std::size_t i = 0; i < frozen.arrays.size(); i++) {
+          const FrozenArray& array = frozen.arrays[i];
+          utils::Transform first(array.magnification, array.rotation, array.startingPos);
+          for (int col = 0; col < array.numCol; col++)
+            for (int row = 0; row < array.numRow; row++)
+              this->addSkipped(array.cell, transform.after(
+                  first.shifted(col*array.xSpacing, row*array.ySpacing)),
+                window, layer, sweep, scratch, clipped);
+        }
+      }
+
+      /// \brief Adds the part of @vertices inside @window to @operand of
+      /// @sweep, or to both operands if @operand is 2.
+      static void addClipped(Span<const CoordPnt> vertices, const Bounds& window,
+                             utils::ScanlineSweep& sweep, std::vector<CoordPnt>& clipped,
+                             unsigned int operand) {
+        utils::clipToBox(vertices, window, clipped);
+        if (clipped.size() < 3)
+          return;
+        for (unsigned int side = 0; side < 2; side++)
+          if (operand == side || operand == 2)
+            sweep.addPolygon(Span<const CoordPnt>(clipped), side);
+      }
+
+    public:
+      Differ(const FrozenLayout& first, const std::vector<ContentHash>& firstHashes,
+             const FrozenLayout& second, const std::vector<ContentHash>& secondHashes) {
+        this->layouts[0] = &first;
+        this->layouts[1] = &second;
+        this->hashes[0] = &firstHashes;
+        this->hashes[1] = &secondHashes;
+      }
+
+      /// \brief Walks the cells @a of the first and @b of the second
+      /// layout, placed at @transform in both.
+      void walkPair(unsigned int a, unsigned int b, const utils::Transform& transform) {
+        if (this->same(a, b)) {
+          SkippedInstance instance = {a, transform};
+          this->skipped.push_back(instance);
+          this->skippedBounds.push_back(transform.apply(this->layouts[0]->getCell(a).extent));
+          return;
+        }
+        this->addShapes(0, a, transform);
+        this->addShapes(1, b, transform);
+        std::vector<Placement> first, second;
+        this->placements(0, a, transform, first);
+        this->placements(1, b, transform, second);
+        std::sort(first.begin(), first.end());
+        std::sort(second.begin(), second.end());
+        std::size_t i = 0, j = 0;
+        while (i < first.size() || j < second.size()) {
+          if (j == second.size() || (i < first.size() && first[i] < second[j])) {
+            this->walkSingle(0, first[i].cell, first[i].transform);
+            i++;
+          } else if (i == first.size() || second[j] < first[i]) {
+            this->walkSingle(1, second[j].cell, second[j].transform);
+            j++;
+          } else {
+            this->walkPair(first[i].cell, second[j].cell, first[i].transform);
+            i++;
+            j++;
+          }
+        }
+      }
+
+      /// \brief Flattens @cell of @side, placed at @transform, into the
+      /// changed shapes.
+      void walkSingle(unsigned int side, unsigned int cell, const utils::Transform& transform) {
+        this->addShapes(side, cell, transform);
+        std::vector<Placement> children;
+        this->placements(side, cell, transform, children);
+        for (std::size_t i = 0; i < children.size(); i++)
+          this->walkSingle(side, children[i].cell, children[i].transform);
+      }
+
+      /// \brief XORs the changed shapes tile by tile and stores the
+      /// differences in @diff.
+      void compare(const LayoutDiffOptions& options, LayoutDiff& diff) {
+        std::vector<Tile> tiles;
+        for (std::map<int, ShapeSet>::iterator it = this->changed.begin();
+             it != this->changed.end(); ++it) {
+          ShapeSet& set = it->second;
+          Bounds all;
+          for (std::size_t i = 0; i < set.bounds.size(); i++)
+            all.add(set.bounds[i]);
+          set.index = SpatialIndex(set.bounds);
+          if (all.isEmpty())
+            continue;
+          double width = all.maxX - all.minX, height = all.maxY - all.minY;
+          double side = options.tileSize;
+          if (side <= 0)
+            side = std::max(width, height)/
+              std::ceil(std::sqrt(double(set.sides.size())/SHAPES_PER_TILE));
+          long columns = side > 0 ? std::max(1L, long(std::ceil(width/side))) : 1;
+          long rows = side > 0 ? std::max(1L, long(std::ceil(height/side))) : 1;
+          std::vector<unsigned int> found;
+          for (long row = 0; row < rows; row++)
+            for (long col = 0; col < columns; col++) {
+              Tile tile = {it->first, Bounds(all.minX + col*side, all.minY + row*side,
+                                             col + 1 == columns ? all.maxX : all.minX + (col + 1)*side,
+                                             row + 1 == rows ? all.maxY : all.minY + (row + 1)*side)};
+              found.clear();
+              set.index.query(tile.box, found);
+              if (!found.empty())
+                tiles.push_back(tile);
+            }
+        }
+        SpatialIndex skippedIndex(this->skippedBounds);
+
+        std::vector<std::vector<Trapezoid> > results(tiles.size());
+        utils::parallelFor(tiles.size(), [&](std::size_t t) {
+            const Tile& tile = tiles[t];
+            const ShapeSet& set = this->changed.find(tile.layer)->second;
+            utils::ScanlineSweep sweep;
+            std::vector<unsigned int> found;
+            std::vector<CoordPnt> scratch, clipped;
+            set.index.query(tile.box, found);
+            for (std::size_t i = 0; i < found.size(); i++) {
+              Span<const CoordPnt> vertices(set.coordinates.data() + set.starts[found[i]],
+                                            set.starts[found[i] + 1] - set.starts[found[i]]);
+              addClipped(vertices, tile.box, sweep, clipped, set.sides[found[i]]);
+            }
+            if (sweep.getEdgeCount() == 0)
+              return;
+            found.clear();
+            skippedIndex.query(tile.box, found);
+            for (std::size_t i = 0; i < found.size(); i++)
+              this->addSkipped(this->skipped[found[i]].cell, this->skipped[found[i]].transform,
+                               tile.box, tile.layer, sweep, scratch, clipped);
+            sweep.sweep(utils::SWEEP_XOR, results[t]);
+          });
+
+        DeferredValidation deferred;
+        for (std::size_t t = 0; t < tiles.size(); t++) {
+          if (results[t].empty())
+            continue;
+          if (diff.layers.empty() || diff.layers.back().layer != tiles[t].layer) {
+            LayerDifference layer;
+            layer.layer = tiles[t].layer;
+            layer.area = 0;
+            diff.layers.push_back(layer);
+          }
+          LayerDifference& layer = diff.layers.back();
+          for (std::size_t i = 0; i < results[t].size(); i++) {
+            layer.area += results[t][i].getArea();
+            layer.polygons.push_back(Polygon(results[t][i].getVertices(), layer.layer, 0));
+          }
+        }
+      }
+    };
+
+    /// \brief Fills in the cell lists of @diff from the cells of both
+    /// layouts and their hashes.
+    void compareCells(const FrozenLayout& first, const std::vector<ContentHash>& firstHashes,
+                      const FrozenLayout& second, const std::vector<ContentHash>& secondHashes,
+                      LayoutDiff& diff) {
+      std::unordered_map<std::string, unsigned int> secondCells;
+      for (std::size_t i = 0; i < second.getLayoutCellCount(); i++)
+        secondCells.insert(std::make_pair(second.getCell(i).cellname, i));
+      std::set<std::string> seen;
+      for (std::size_t i = 0; i < first.getLayoutCellCount(); i++) {
+        const std::string& cellname = first.getCell(i).cellname;
+        if (!seen.insert(cellname).second)
+          continue;
+        std::unordered_map<std::string, unsigned int>::const_iterator it =
+          secondCells.find(cellname);
+        if (it == secondCells.end())
+          diff.removedCells.push_back(cellname);
+        else if (firstHashes[i] != secondHashes[it->second])
+          diff.changedCells.push_back(cellname);
+      }
+      for (std::size_t i = 0; i < second.getLayoutCellCount(); i++) {
+        const std::string& cellname = second.getCell(i).cellname;
+        if (first.findCell(cellname) >= first.getLayoutCellCount() && seen.insert(cellname).second)
+          diff.addedCells.push_back(cellname);
+      }
+      std::sort(diff.removedCells.begin(), diff.removedCells.end());
+      std::sort(diff.addedCells.begin(), diff.addedCells.end());
+      std::sort(diff.changedCells.begin(), diff.changedCells.end());
+    }
+
+  } // namespace
+
+  LayoutDiff diffLayouts(const Layout& first, const Layout& second, LayoutDiffOptions options) {
+    std::shared_ptr<const FrozenLayout> frozen[2] = {first.freeze(), second.freeze()};
+    std::vector<ContentHash> hashes[2] = {computeContentHashes(first),
+                                          computeContentHashes(second)};
+    LayoutDiff diff;
+    compareCells(*frozen[0], hashes[0], *frozen[1], hashes[1], diff);
+
+    // walk the top cells of both layouts by name
+    std::set<std::string> tops;
+    for (int side = 0; side < 2; side++) {
+      Span<const unsigned int> cells = frozen[side]->getTopCells();
+      for (std::size_t i = 0; i < cells.size(); i++)
+        tops.insert(frozen[side]->getCell(cells[i]).cellname);
+    }
+    Differ differ(*frozen[0], hashes[0], *frozen[1], hashes[1]);
+    for (std::set<std::string>::const_iterator it = tops.begin(); it != tops.end(); ++it) {
+      std::size_t a = frozen[0]->findCell(*it), b = frozen[1]->findCell(*it);
+      if (a < frozen[0]->getCellCount() && b < frozen[1]->getCellCount())
+        differ.walkPair(a, b, utils::Transform());
+      else if (a < frozen[0]->getCellCount())
+        differ.walkSingle(0, a, utils::Transform());
+      else
+        differ.walkSingle(1, b, utils::Transform());
+    }
+    differ.compare(options, diff);
+    return diff;
+  }
+
+  LayoutDiff diffSnapshots(std::string first, std::string second, LayoutDiffOptions options) {
+    Layout layouts[2];
+    LayoutSnapshot(first).load(layouts[0]);
+    LayoutSnapshot(second).load(layouts[1]);
+    return diffLayouts(layouts[0], layouts[1], options);
+  }
+
+}
@@ -0,0 +1,92 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef LAYOUT_DIFF_HXX
+#define LAYOUT_DIFF_HXX
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "frozenLayout.hxx"
+#include "layout.hxx"
+#include "polygon.hxx"
+
+namespace sil {
+
+  /// \brief The settings used by diffLayouts().
+  struct LayoutDiffOptions {
+    /// \brief The side (in user units) of the square tiles the layers
+    /// are compared in, or 0 to size them so that each tile holds about
+    /// a thousand changed shapes.
+    double tileSize;
+
+    /// \brief Sets the defaults: automatically sized tiles.
+    LayoutDiffOptions(void);
+  };
+
+  /// \brief Where one layer of two layouts differs.
+  struct LayerDifference {
+    int layer; //!< The layer.
+    double area; //!< The area covered by exactly one of the layouts.
+    std::vector<Polygon> polygons; //!< The area as trapezoids, datatype 0.
+  };
+
+  /// \brief The result of diffLayouts().
+  struct LayoutDiff {
+    std::vector<std::string> removedCells; //!< Cells only the first layout has.
+    std::vector<std::string> addedCells; //!< Cells only the second layout has.
+    std::vector<std::string> changedCells; //!< Cells in both, with different contents.
+    std::vector<LayerDifference> layers; //!< The layers that differ, ascending.
+
+    /// \brief Returns true if the top cells of both layouts cover the
+    /// same area on every layer, even if their hierarchy differs.
+    bool isIdentical(void) const;
+
+    /// \brief Returns a line per changed cell and per layer that differs.
+    std::string toString(void) const;
+  };
+
+  /// \brief Compares the geometry of @first and @second.
+  ///
+  /// @first The old layout.
+  /// @second The new layout.
+  /// @options The settings of the comparison.
+  ///
+  /// Cells are matched by name and compared by their ContentHash (see
+  /// computeContentHashes()), which also fills in the cell lists of the
+  /// result. The top cells of the same name are then walked together:
+  /// a pair of cells with equal hashes is skipped without looking at
+  /// their shapes, and the placements of a changed pair are paired off
+  /// by cell name and transformation and walked the same way. What is
+  /// left is flattened, split into tiles layer by layer, and the tiles
+  /// that hold changed shapes are XORed on all cores with a scanline
+  /// sweep; shapes of the skipped cells are only brought into the tiles
+  /// they overlap. Paths are compared by their outlines, with round ends
+  /// treated as square. The differences are split at the tile borders.
+  LayoutDiff diffLayouts(const Layout& first, const Layout& second,
+                         LayoutDiffOptions options = LayoutDiffOptions());
+
+  /// \brief Compares the snapshot files @first and @second, see
+  /// writeSnapshot() and diffLayouts().
+  ///
+  /// Throws std::runtime_error if either file can not be read.
+  LayoutDiff diffSnapshots(std::string first, std::string second,
+                           LayoutDiffOptions options = LayoutDiffOptions());
+
+}
+
+#endif // LAYOUT_DIFF_HXX
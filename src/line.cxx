@@ -113,7 +113,7 @@ namespace sil {
     // http://www.dcs.gla.ac.uk/~pat/52233/slides/Geometry1x1.pdf
     CoordPnt firstToPnt = pnt - seg.getStartPnt();
     CoordPnt lastToPnt = seg.getEndPnt() - pnt;
-    int val = firstToPnt.getY()*lastToPnt.getX() -
+    double val = firstToPnt.getY()*lastToPnt.getX() -
       firstToPnt.getX()*lastToPnt.getY();
     //    int val = (q.y - p.y) * (r.x - q.x) -
     //         (q.x - p.x) * (r.y - q.y);
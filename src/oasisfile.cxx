@@ -0,0 +1,784 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "oasisfile.hxx"
+#include "SilhouetteConfig.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#ifdef SILHOUETTE_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace sil {
+  namespace utils {
+
+    // Every OASIS file starts with these 13 bytes.
+    const char OASIS_MAGIC[] = "%SEMI-OASIS\r\n";
+
+    // The END record is always exactly this long so that readers may
+    // find the table offsets by seeking from the end of the file.
+    const int END_RECORD_SIZE = 256;
+
+    // Basic bare bones constructor for this class.
+    OASIS_File::OASIS_File(std::string usrFilename) :
+      outputFile(usrFilename.c_str(), std::ios::out | std::ios::binary) {
+      this->filename = usrFilename;
+      this->version = "1.0";
+      this->databaseUnits = 1e-3; // same database unit as GDS_File
+      this->compress = false;
+      this->bytesWritten = 0;
+      this->resetModalVariables();
+    }
+
+    void OASIS_File::setCompression(bool usrCompress) {
+#ifndef SILHOUETTE_HAVE_ZLIB
+      if (usrCompress)
+        throw std::logic_error("CBLOCK compression requires silhouette to be built with zlib.");
+#endif
+      this->compress = usrCompress;
+    }
+
+    void OASIS_File::Write(const std::vector<Cell*> cellVec) {
+      // The CELLNAME table is written before any cell so every cell
+      // that is defined or referenced must be known up front.
+      this->cellnames.clear();
+      this->cellnameIndex.clear();
+      for (uint i = 0; i < cellVec.size(); i++)
+        this->cellnameReference(cellVec[i]->getCellname());
+      for (uint i = 0; i < cellVec.size(); i++) {
+        const CellReferenceList& refs = cellVec[i]->getCellReferenceList();
+        for (uint j = 0; j < refs.size(); j++)
+          this->cellnameReference(refs[j].getCellname());
+        const CellArrayList& arrays = cellVec[i]->getCellArrayList();
+        for (uint j = 0; j < arrays.size(); j++)
+          this->cellnameReference(arrays[j].getCellname());
+      }
+
+      this->WriteFileHeaderRecords();
+      uint64_t cellnameOffset = this->bytesWritten;
+      this->WriteCellnameRecords();
+      for (uint i = 0; i < cellVec.size(); i++)
+        this->WriteCell(cellVec[i]);
+      this->WriteFileTailRecords(this->cellnames.empty() ? 0 : cellnameOffset);
+      this->outputFile.flush();
+    }
+
+    void OASIS_File::WriteFileHeaderRecords() {
+      std::string record(OASIS_MAGIC, sizeof(OASIS_MAGIC) - 1);
+      record += static_cast<char>(OAS_START);
+      oasisWriteString(record, this->version);
+      // the unit is the number of database units per micron
+      oasisWriteReal(record, 1.0/this->databaseUnits);
+      // offset-flag of one places the table offsets in the END record
+      oasisWriteUnsigned(record, 1);
+      this->writeBytesToFile(record);
+    }
+
+    void OASIS_File::WriteCellnameRecords() {
+      // CELLNAME records without an explicit reference number are
+      // implicitly numbered 0, 1, 2... in the order they appear.
+      std::string record;
+      for (uint i = 0; i < this->cellnames.size(); i++) {
+        record += static_cast<char>(OAS_CELLNAME_IMPLICIT);
+        oasisWriteString(record, this->cellnames[i]);
+      }
+      this->writeBytesToFile(record);
+    }
+
+    void OASIS_File::WriteFileTailRecords(uint64_t cellnameOffset) {
+      std::string record;
+      record += static_cast<char>(OAS_END);
+      // table-offsets for the cellname, textstring, propname,
+      // propstring, layername and xname tables. Each is a strict flag
+      // followed by the byte offset (0 when the table is absent).
+      oasisWriteUnsigned(record, cellnameOffset != 0 ? 1 : 0);
+      oasisWriteUnsigned(record, cellnameOffset);
+      for (int i = 0; i < 5; i++) {
+        oasisWriteUnsigned(record, 0);
+        oasisWriteUnsigned(record, 0);
+      }
+      // the padding b-string takes up whatever is left over after the
+      // validation scheme byte.
+      int remaining = END_RECORD_SIZE - record.size() - 1;
+      int padLength = remaining - 1;
+      std::string lengthBytes;
+      oasisWriteUnsigned(lengthBytes, padLength);
+      while (padLength + (int) lengthBytes.size() > remaining) {
+        padLength--;
+        lengthBytes.clear();
+        oasisWriteUnsigned(lengthBytes, padLength);
+      }
+      record += lengthBytes;
+      record.append(padLength, '\0');
+      oasisWriteUnsigned(record, 0); // no validation
+      this->writeBytesToFile(record);
+    }
+
+    void OASIS_File::WriteCell(const Cell* cell) {
+      std::string header;
+      header += static_cast<char>(OAS_CELL_REFNUM);
+      oasisWriteUnsigned(header, this->cellnameReference(cell->getCellname()));
+      this->writeBytesToFile(header);
+
+      // modal variables (including the xy-mode) are reset by every CELL
+      this->resetModalVariables();
+      std::string body;
+      body += static_cast<char>(OAS_XYRELATIVE);
+      this->WritePolygonRecords(body, cell);
+      this->WritePathRecords(body, cell);
+      this->WritePlacementRecords(body, cell);
+
+#ifdef SILHOUETTE_HAVE_ZLIB
+      if (this->compress && !body.empty()) {
+        // CBLOCKs hold raw DEFLATE data (no zlib header)
+        z_stream stream;
+        std::memset(&stream, 0, sizeof(stream));
+        if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8,
+                         Z_DEFAULT_STRATEGY) != Z_OK)
+          throw std::runtime_error("Unable to initialize the DEFLATE stream.");
+        std::string compressed(deflateBound(&stream, body.size()), '\0');
+        stream.next_in = reinterpret_cast<Bytef*>(&body[0]);
+        stream.avail_in = body.size();
+        stream.next_out = reinterpret_cast<Bytef*>(&compressed[0]);
+        stream.avail_out = compressed.size();
+        int status = deflate(&stream, Z_FINISH);
+        compressed.resize(stream.total_out);
+        deflateEnd(&stream);
+        if (status != Z_STREAM_END)
+          throw std::runtime_error("Unable to compress the cell contents.");
+        // only keep the CBLOCK when it actually saves space
+        if (compressed.size() + 16 < body.size()) {
+          std::string record;
+          record += static_cast<char>(OAS_CBLOCK);
+          oasisWriteUnsigned(record, 0); // comp-type 0 is DEFLATE
+          oasisWriteUnsigned(record, body.size());
+          oasisWriteUnsigned(record, compressed.size());
+          record += compressed;
+          body.swap(record);
+        }
+      }
+#endif
+      this->writeBytesToFile(body);
+    }
+
+    // Shapes that only differ by a translation are grouped together
+    // so that they can be written as one record with a repetition.
+    struct OasisShapeGroup {
+      uint64_t layer;
+      uint64_t dataType;
+      bool isRectangle;
+      uint64_t width; // rectangles only
+      uint64_t height; // rectangles only
+      std::string pointList; // polygons only
+      std::vector<int64_t> positions; // x, y pairs
+    };
+
+    // Returns true if the four points form an axis aligned rectangle,
+    // in which case the lower left corner, width and height are set.
+    static bool isAxisAlignedRectangle(const std::vector<int64_t>& pnts,
+                                       int64_t& minX, int64_t& minY,
+                                       uint64_t& width, uint64_t& height) {
+      if (pnts.size() != 8)
+        return false;
+      for (int i = 0; i < 4; i++) {
+        int j = (i + 1) % 4;
+        if (pnts[2*i] != pnts[2*j] && pnts[2*i + 1] != pnts[2*j + 1])
+          return false;
+      }
+      minX = std::min(std::min(pnts[0], pnts[2]), std::min(pnts[4], pnts[6]));
+      minY = std::min(std::min(pnts[1], pnts[3]), std::min(pnts[5], pnts[7]));
+      int64_t maxX = std::max(std::max(pnts[0], pnts[2]), std::max(pnts[4], pnts[6]));
+      int64_t maxY = std::max(std::max(pnts[1], pnts[3]), std::max(pnts[5], pnts[7]));
+      width = maxX - minX;
+      height = maxY - minY;
+      return width > 0 && height > 0;
+    }
+
+    // Sorts the x, y pairs in @positions by y and then by x so that
+    // successive displacements are small and lattices are recognized.
+    static void sortPositions(std::vector<int64_t>& positions) {
+      std::vector<std::pair<int64_t, int64_t> > pairs;
+      pairs.reserve(positions.size()/2);
+      for (uint i = 0; i < positions.size(); i += 2)
+        pairs.push_back(std::make_pair(positions[i + 1], positions[i]));
+      std::sort(pairs.begin(), pairs.end());
+      for (uint i = 0; i < pairs.size(); i++) {
+        positions[2*i] = pairs[i].second;
+        positions[2*i + 1] = pairs[i].first;
+      }
+    }
+
+    // Builds the encoded repetition for the sorted positions of a group
+    // (empty if there is only a single position).
+    static std::string groupRepetition(const std::vector<int64_t>& positions) {
+      std::string repetition;
+      if (positions.size() <= 2)
+        return repetition;
+      std::vector<int64_t> relative(positions.size());
+      for (uint i = 0; i < positions.size(); i += 2) {
+        relative[i] = positions[i] - positions[0];
+        relative[i + 1] = positions[i + 1] - positions[1];
+      }
+      oasisWriteRepetition(repetition, relative);
+      return repetition;
+    }
+
+    void OASIS_File::WritePolygonRecords(std::string& out, const Cell* cell) {
+      std::vector<OasisShapeGroup> groups;
+      std::unordered_map<std::string, uint> groupIndex;
+      std::vector<int64_t> pnts;
+      std::vector<int64_t> deltas;
+      const PolygonList& polygons = cell->getPolygonList();
+      for (uint i = 0; i < polygons.size(); i++) {
+        Span<const CoordPnt> vertices = polygons[i].getVertexSpan();
+        pnts.clear();
+        for (uint j = 0; j < vertices.size(); j++) {
+          pnts.push_back(this->toDatabaseUnits(vertices[j].getX()));
+          pnts.push_back(this->toDatabaseUnits(vertices[j].getY()));
+        }
+        OasisShapeGroup group;
+        group.layer = polygons[i].getLayer();
+        group.dataType = polygons[i].getDataType();
+        int64_t posX, posY;
+        group.isRectangle = isAxisAlignedRectangle(pnts, posX, posY,
+                                                   group.width, group.height);
+        std::string key;
+        oasisWriteUnsigned(key, group.layer);
+        oasisWriteUnsigned(key, group.dataType);
+        if (group.isRectangle) {
+          key += 'R';
+          oasisWriteUnsigned(key, group.width);
+          oasisWriteUnsigned(key, group.height);
+        } else {
+          // the first vertex is the position, the rest are displacements
+          posX = pnts[0];
+          posY = pnts[1];
+          deltas.clear();
+          for (uint j = 2; j < pnts.size(); j++)
+            deltas.push_back(pnts[j] - pnts[j - 2]);
+          oasisWritePointList(group.pointList, deltas, true);
+          key += 'P';
+          key += group.pointList;
+        }
+        std::unordered_map<std::string, uint>::iterator found = groupIndex.find(key);
+        if (found == groupIndex.end()) {
+          found = groupIndex.insert(std::make_pair(key, (uint) groups.size())).first;
+          groups.push_back(group);
+        }
+        groups[found->second].positions.push_back(posX);
+        groups[found->second].positions.push_back(posY);
+      }
+
+      for (uint i = 0; i < groups.size(); i++) {
+        OasisShapeGroup& group = groups[i];
+        sortPositions(group.positions);
+        std::string repetition = groupRepetition(group.positions);
+        int64_t dx = group.positions[0] - this->modal.geometryX;
+        int64_t dy = group.positions[1] - this->modal.geometryY;
+        bool writeLayer = !this->modal.layerValid || this->modal.layer != group.layer;
+        bool writeDataType = !this->modal.dataTypeValid ||
+          this->modal.dataType != group.dataType;
+        unsigned char info = 0;
+        if (dx != 0) info |= 0x10;
+        if (dy != 0) info |= 0x08;
+        if (!repetition.empty()) info |= 0x04;
+        if (writeDataType) info |= 0x02;
+        if (writeLayer) info |= 0x01;
+
+        if (group.isRectangle) {
+          // 'SWHXYRDL'
+          bool square = group.width == group.height;
+          bool writeWidth = !this->modal.geometryWValid ||
+            this->modal.geometryW != group.width;
+          bool writeHeight = !square && (!this->modal.geometryHValid ||
+                                         this->modal.geometryH != group.height);
+          if (square) info |= 0x80;
+          if (writeWidth) info |= 0x40;
+          if (writeHeight) info |= 0x20;
+          out += static_cast<char>(OAS_RECTANGLE);
+          out += static_cast<char>(info);
+          if (writeLayer) oasisWriteUnsigned(out, group.layer);
+          if (writeDataType) oasisWriteUnsigned(out, group.dataType);
+          if (writeWidth) oasisWriteUnsigned(out, group.width);
+          if (writeHeight) oasisWriteUnsigned(out, group.height);
+          this->modal.geometryW = group.width;
+          this->modal.geometryWValid = true;
+          this->modal.geometryH = group.height;
+          this->modal.geometryHValid = true;
+        } else {
+          // '00PXYRDL'
+          bool writePoints = this->modal.polygonPointList != group.pointList;
+          if (writePoints) info |= 0x20;
+          out += static_cast<char>(OAS_POLYGON);
+          out += static_cast<char>(info);
+          if (writeLayer) oasisWriteUnsigned(out, group.layer);
+          if (writeDataType) oasisWriteUnsigned(out, group.dataType);
+          if (writePoints) out += group.pointList;
+          this->modal.polygonPointList = group.pointList;
+        }
+        if (dx != 0) oasisWriteSigned(out, dx);
+        if (dy != 0) oasisWriteSigned(out, dy);
+        if (!repetition.empty()) this->writeRepetition(out, repetition);
+        this->modal.layer = group.layer;
+        this->modal.layerValid = true;
+        this->modal.dataType = group.dataType;
+        this->modal.dataTypeValid = true;
+        this->modal.geometryX = group.positions[0];
+        this->modal.geometryY = group.positions[1];
+      }
+    }
+
+    void OASIS_File::WritePathRecords(std::string& out, const Cell* cell) {
+      std::vector<int64_t> deltas;
+      const PathList& paths = cell->getPathList();
+      for (uint i = 0; i < paths.size(); i++) {
+        Span<const CoordPnt> coords = paths[i].getCoordPathSpan();
+        int64_t posX = this->toDatabaseUnits(coords[0].getX());
+        int64_t posY = this->toDatabaseUnits(coords[0].getY());
+        deltas.clear();
+        int64_t prevX = posX;
+        int64_t prevY = posY;
+        for (uint j = 1; j < coords.size(); j++) {
+          int64_t curX = this->toDatabaseUnits(coords[j].getX());
+          int64_t curY = this->toDatabaseUnits(coords[j].getY());
+          deltas.push_back(curX - prevX);
+          deltas.push_back(curY - prevY);
+          prevX = curX;
+          prevY = curY;
+        }
+        std::string pointList;
+        oasisWritePointList(pointList, deltas, false);
+        uint64_t layer = paths[i].getLayer();
+        uint64_t dataType = paths[i].getDataType();
+        uint64_t halfwidth = std::llabs(this->toDatabaseUnits(paths[i].getPathWidth()/2.));
+        // GDSII path type 0 is flush, 2 is extended by half the width.
+        // OASIS has no round ends so path type 1 is written extended.
+        // The scheme is '0000SSEE' with 01 = flush and 10 = half width.
+        unsigned char extension = paths[i].getPathType() == 0 ? 0x05 : 0x0A;
+
+        int64_t dx = posX - this->modal.geometryX;
+        int64_t dy = posY - this->modal.geometryY;
+        bool writeLayer = !this->modal.layerValid || this->modal.layer != layer;
+        bool writeDataType = !this->modal.dataTypeValid || this->modal.dataType != dataType;
+        bool writeWidth = !this->modal.pathHalfwidthValid ||
+          this->modal.pathHalfwidth != halfwidth;
+        bool writePoints = this->modal.pathPointList != pointList;
+        // 'EWPXYRDL'
+        unsigned char info = 0x80; // always state the extension scheme
+        if (writeWidth) info |= 0x40;
+        if (writePoints) info |= 0x20;
+        if (dx != 0) info |= 0x10;
+        if (dy != 0) info |= 0x08;
+        if (writeDataType) info |= 0x02;
+        if (writeLayer) info |= 0x01;
+        out += static_cast<char>(OAS_PATH);
+        out += static_cast<char>(info);
+        if (writeLayer) oasisWriteUnsigned(out, layer);
+        if (writeDataType) oasisWriteUnsigned(out, dataType);
+        if (writeWidth) oasisWriteUnsigned(out, halfwidth);
+        oasisWriteUnsigned(out, extension);
+        if (writePoints) out += pointList;
+        if (dx != 0) oasisWriteSigned(out, dx);
+        if (dy != 0) oasisWriteSigned(out, dy);
+        this->modal.layer = layer;
+        this->modal.layerValid = true;
+        this->modal.dataType = dataType;
+        this->modal.dataTypeValid = true;
+        this->modal.pathHalfwidth = halfwidth;
+        this->modal.pathHalfwidthValid = true;
+        this->modal.pathPointList = pointList;
+        this->modal.geometryX = posX;
+        this->modal.geometryY = posY;
+      }
+    }
+
+    // A single PLACEMENT record, possibly with a repetition.
+    struct OasisPlacement {
+      uint64_t cell;
+      double magnification;
+      double rotation; // radians
+      int64_t x;
+      int64_t y;
+      std::string repetition;
+    };
+
+    // Builds the repetition of a CellArray. Positive spacings map onto
+    // the compact matrix forms while any other lattice needs g-deltas.
+    static std::string arrayRepetition(int numCol, int numRow,
+                                       int64_t xSpacing, int64_t ySpacing) {
+      std::string repetition;
+      if (numCol <= 1 && numRow <= 1)
+        return repetition;
+      if (numRow <= 1) {
+        if (xSpacing > 0) {
+          oasisWriteUnsigned(repetition, 2);
+          oasisWriteUnsigned(repetition, numCol - 2);
+          oasisWriteUnsigned(repetition, xSpacing);
+        } else {
+          oasisWriteUnsigned(repetition, 9);
+          oasisWriteUnsigned(repetition, numCol - 2);
+          oasisWriteGDelta(repetition, xSpacing, 0);
+        }
+      } else if (numCol <= 1) {
+        if (ySpacing > 0) {
+          oasisWriteUnsigned(repetition, 3);
+          oasisWriteUnsigned(repetition, numRow - 2);
+          oasisWriteUnsigned(repetition, ySpacing);
+        } else {
+          oasisWriteUnsigned(repetition, 9);
+          oasisWriteUnsigned(repetition, numRow - 2);
+          oasisWriteGDelta(repetition, 0, ySpacing);
+        }
+      } else if (xSpacing > 0 && ySpacing > 0) {
+        oasisWriteUnsigned(repetition, 1);
+        oasisWriteUnsigned(repetition, numCol - 2);
+        oasisWriteUnsigned(repetition, numRow - 2);
+        oasisWriteUnsigned(repetition, xSpacing);
+        oasisWriteUnsigned(repetition, ySpacing);
+      } else {
+        oasisWriteUnsigned(repetition, 8);
+        oasisWriteUnsigned(repetition, numCol - 2);
+        oasisWriteUnsigned(repetition, numRow - 2);
+        oasisWriteGDelta(repetition, xSpacing, 0);
+        oasisWriteGDelta(repetition, 0, ySpacing);
+      }
+      return repetition;
+    }
+
+    void OASIS_File::WritePlacementRecords(std::string& out, const Cell* cell) {
+      std::vector<OasisPlacement> placements;
+
+      // group plain references by cell and transformation so that
+      // repeated instances share one record
+      std::vector<std::vector<int64_t> > refPositions;
+      std::unordered_map<std::string, uint> groupIndex;
+      const CellReferenceList& refs = cell->getCellReferenceList();
+      for (uint i = 0; i < refs.size(); i++) {
+        OasisPlacement placement;
+        placement.cell = this->cellnameReference(refs[i].getCellname());
+        placement.magnification = refs[i].getMagnification();
+        placement.rotation = refs[i].getRotation();
+        std::string key;
+        oasisWriteUnsigned(key, placement.cell);
+        key.append(reinterpret_cast<const char*>(&placement.magnification), sizeof(double));
+        key.append(reinterpret_cast<const char*>(&placement.rotation), sizeof(double));
+        std::unordered_map<std::string, uint>::iterator found = groupIndex.find(key);
+        if (found == groupIndex.end()) {
+          found = groupIndex.insert(std::make_pair(key, (uint) placements.size())).first;
+          placements.push_back(placement);
+          refPositions.push_back(std::vector<int64_t>());
+        }
+        refPositions[found->second].push_back(this->toDatabaseUnits(refs[i].getCenter().getX()));
+        refPositions[found->second].push_back(this->toDatabaseUnits(refs[i].getCenter().getY()));
+      }
+      for (uint i = 0; i < placements.size(); i++) {
+        sortPositions(refPositions[i]);
+        placements[i].x = refPositions[i][0];
+        placements[i].y = refPositions[i][1];
+        placements[i].repetition = groupRepetition(refPositions[i]);
+      }
+
+      const CellArrayList& arrays = cell->getCellArrayList();
+      for (uint i = 0; i < arrays.size(); i++) {
+        OasisPlacement placement;
+        placement.cell = this->cellnameReference(arrays[i].getCellname());
+        placement.magnification = arrays[i].getMagnification();
+        placement.rotation = arrays[i].getRotation();
+        placement.x = this->toDatabaseUnits(arrays[i].getStartingPos().getX());
+        placement.y = this->toDatabaseUnits(arrays[i].getStartingPos().getY());
+        placement.repetition =
+          arrayRepetition(arrays[i].getNumCol(), arrays[i].getNumRow(),
+                          this->toDatabaseUnits(arrays[i].getXSpacing()),
+                          this->toDatabaseUnits(arrays[i].getYSpacing()));
+        placements.push_back(placement);
+      }
+
+      const double PI = std::acos(-1);
+      for (uint i = 0; i < placements.size(); i++) {
+        const OasisPlacement& placement = placements[i];
+        // rotations by multiples of 90 degrees without magnification
+        // fit in the info-byte of the short PLACEMENT record
+        double quarterTurns = placement.rotation/(PI/2.);
+        long quarter = std::lround(quarterTurns);
+        bool simple = placement.magnification == 1.0 &&
+          std::abs(quarterTurns - quarter) < 1e-9;
+        bool writeCell = !this->modal.placementCellValid ||
+          this->modal.placementCell != placement.cell;
+        int64_t dx = placement.x - this->modal.placementX;
+        int64_t dy = placement.y - this->modal.placementY;
+        unsigned char info = 0;
+        if (writeCell) info |= 0xC0; // 'C' and 'N' (by reference number)
+        if (dx != 0) info |= 0x20;
+        if (dy != 0) info |= 0x10;
+        if (!placement.repetition.empty()) info |= 0x08;
+        if (simple) {
+          // 'CNXYRAAF'
+          info |= ((quarter % 4 + 4) % 4) << 1;
+          out += static_cast<char>(OAS_PLACEMENT);
+          out += static_cast<char>(info);
+          if (writeCell) oasisWriteUnsigned(out, placement.cell);
+        } else {
+          // 'CNXYRMAF'
+          bool writeMag = placement.magnification != 1.0;
+          bool writeAngle = placement.rotation != 0.0;
+          if (writeMag) info |= 0x04;
+          if (writeAngle) info |= 0x02;
+          out += static_cast<char>(OAS_PLACEMENT_TRANSFORM);
+          out += static_cast<char>(info);
+          if (writeCell) oasisWriteUnsigned(out, placement.cell);
+          if (writeMag) oasisWriteReal(out, placement.magnification);
+          if (writeAngle) oasisWriteReal(out, placement.rotation*180./PI);
+        }
+        if (dx != 0) oasisWriteSigned(out, dx);
+        if (dy != 0) oasisWriteSigned(out, dy);
+        if (!placement.repetition.empty())
+          this->writeRepetition(out, placement.repetition);
+        this->modal.placementCell = placement.cell;
+        this->modal.placementCellValid = true;
+        this->modal.placementX = placement.x;
+        this->modal.placementY = placement.y;
+      }
+    }
+
+    uint64_t OASIS_File::cellnameReference(const std::string& cellname) {
+      std::unordered_map<std::string, uint64_t>::iterator found =
+        this->cellnameIndex.find(cellname);
+      if (found != this->cellnameIndex.end())
+        return found->second;
+      this->cellnameIndex[cellname] = this->cellnames.size();
+      this->cellnames.push_back(cellname);
+      return this->cellnames.size() - 1;
+    }
+
+    int64_t OASIS_File::toDatabaseUnits(double value) const {
+      return std::llround(value/this->databaseUnits);
+    }
+
+    void OASIS_File::resetModalVariables() {
+      this->modal.layerValid = false;
+      this->modal.layer = 0;
+      this->modal.dataTypeValid = false;
+      this->modal.dataType = 0;
+      this->modal.geometryX = 0;
+      this->modal.geometryY = 0;
+      this->modal.placementX = 0;
+      this->modal.placementY = 0;
+      this->modal.placementCellValid = false;
+      this->modal.placementCell = 0;
+      this->modal.geometryWValid = false;
+      this->modal.geometryW = 0;
+      this->modal.geometryHValid = false;
+      this->modal.geometryH = 0;
+      this->modal.pathHalfwidthValid = false;
+      this->modal.pathHalfwidth = 0;
+      this->modal.polygonPointList.clear();
+      this->modal.pathPointList.clear();
+      this->modal.repetition.clear();
+    }
+
+    void OASIS_File::writeRepetition(std::string& out, const std::string& repetition) {
+      if (repetition == this->modal.repetition) {
+        oasisWriteUnsigned(out, 0); // reuse the previous repetition
+      } else {
+        out += repetition;
+        this->modal.repetition = repetition;
+      }
+    }
+
+    void OASIS_File::writeBytesToFile(const std::string& data) {
+      this->outputFile.write(data.data(), data.size());
+      this->bytesWritten += data.size();
+    }
+
+    void oasisWriteUnsigned(std::string& out, uint64_t value) {
+      do {
+        unsigned char byte = value & 0x7F;
+        value >>= 7;
+        if (value != 0)
+          byte |= 0x80; // more bytes follow
+        out += static_cast<char>(byte);
+      } while (value != 0);
+    }
+
+    void oasisWriteSigned(std::string& out, int64_t value) {
+      if (value < 0)
+        oasisWriteUnsigned(out, (static_cast<uint64_t>(-value) << 1) | 1);
+      else
+        oasisWriteUnsigned(out, static_cast<uint64_t>(value) << 1);
+    }
+
+    void oasisWriteReal(std::string& out, double value) {
+      // whole numbers are stored as type 0 (positive) or 1 (negative),
+      // anything else as a little endian IEEE double (type 7)
+      if (value == std::floor(value) && std::abs(value) < 9007199254740992.) {
+        oasisWriteUnsigned(out, value < 0 ? 1 : 0);
+        oasisWriteUnsigned(out, static_cast<uint64_t>(std::abs(value)));
+        return;
+      }
+      oasisWriteUnsigned(out, 7);
+      uint64_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      for (int i = 0; i < 8; i++)
+        out += static_cast<char>((bits >> (8*i)) & 0xFF);
+    }
+
+    void oasisWriteString(std::string& out, const std::string& value) {
+      oasisWriteUnsigned(out, value.size());
+      out += value;
+    }
+
+    // Octangular displacements (horizontal, vertical or diagonal) are
+    // written in a single integer holding the magnitude and one of eight
+    // directions: 0 east, 1 north, 2 west, 3 south, 4 north east,
+    // 5 north west, 6 south west, 7 south east.
+    static bool octangularDirection(int64_t dx, int64_t dy,
+                                    uint64_t& direction, uint64_t& magnitude) {
+      if (dy == 0) {
+        direction = dx >= 0 ? 0 : 2;
+        magnitude = std::llabs(dx);
+      } else if (dx == 0) {
+        direction = dy > 0 ? 1 : 3;
+        magnitude = std::llabs(dy);
+      } else if (dx == dy) {
+        direction = dx > 0 ? 4 : 6;
+        magnitude = std::llabs(dx);
+      } else if (dx == -dy) {
+        direction = dx > 0 ? 7 : 5;
+        magnitude = std::llabs(dx);
+      } else {
+        return false;
+      }
+      return true;
+    }
+
+    void oasisWriteGDelta(std::string& out, int64_t dx, int64_t dy) {
+      uint64_t direction, magnitude;
+      if (octangularDirection(dx, dy, direction, magnitude)) {
+        oasisWriteUnsigned(out, (magnitude << 4) | (direction << 1));
+      } else {
+        // the second form: bit 0 marks the form, bit 1 the sign of x
+        uint64_t first = static_cast<uint64_t>(std::llabs(dx)) << 2;
+        first |= (dx < 0 ? 2 : 0) | 1;
+        oasisWriteUnsigned(out, first);
+        oasisWriteSigned(out, dy);
+      }
+    }
+
+    void oasisWritePointList(std::string& out,
+                             const std::vector<int64_t>& deltas, bool closed) {
+      // Find the most restrictive (and so most compact) point-list type
+      // that can hold every displacement.
+      bool manhattan = true;
+      bool octangular = true;
+      int64_t sumX = 0;
+      int64_t sumY = 0;
+      uint64_t direction, magnitude;
+      for (uint i = 0; i < deltas.size(); i += 2) {
+        if (deltas[i] != 0 && deltas[i + 1] != 0)
+          manhattan = false;
+        if (!octangularDirection(deltas[i], deltas[i + 1], direction, magnitude))
+          octangular = false;
+        sumX += deltas[i];
+        sumY += deltas[i + 1];
+      }
+      if (closed) {
+        if (sumX != 0 && sumY != 0)
+          manhattan = false;
+        if (!octangularDirection(-sumX, -sumY, direction, magnitude))
+          octangular = false;
+      }
+
+      uint64_t count = deltas.size()/2;
+      if (manhattan) {
+        oasisWriteUnsigned(out, 2);
+        oasisWriteUnsigned(out, count);
+        for (uint i = 0; i < deltas.size(); i += 2) {
+          octangularDirection(deltas[i], deltas[i + 1], direction, magnitude);
+          oasisWriteUnsigned(out, (magnitude << 2) | direction);
+        }
+      } else if (octangular) {
+        oasisWriteUnsigned(out, 3);
+        oasisWriteUnsigned(out, count);
+        for (uint i = 0; i < deltas.size(); i += 2) {
+          octangularDirection(deltas[i], deltas[i + 1], direction, magnitude);
+          oasisWriteUnsigned(out, (magnitude << 3) | direction);
+        }
+      } else {
+        oasisWriteUnsigned(out, 4);
+        oasisWriteUnsigned(out, count);
+        for (uint i = 0; i < deltas.size(); i += 2)
+          oasisWriteGDelta(out, deltas[i], deltas[i + 1]);
+      }
+    }
+
+    // Returns true if @values (sorted, unique) are evenly spaced.
+    static bool evenlySpaced(const std::vector<int64_t>& values) {
+      for (uint i = 2; i < values.size(); i++)
+        if (values[i] - values[i - 1] != values[1] - values[0])
+          return false;
+      return true;
+    }
+
+    void oasisWriteRepetition(std::string& out, const std::vector<int64_t>& xy) {
+      uint64_t count = xy.size()/2;
+      std::vector<int64_t> xs, ys;
+      std::vector<std::pair<int64_t, int64_t> > pnts;
+      for (uint i = 0; i < xy.size(); i += 2) {
+        xs.push_back(xy[i]);
+        ys.push_back(xy[i + 1]);
+        pnts.push_back(std::make_pair(xy[i], xy[i + 1]));
+      }
+      std::sort(xs.begin(), xs.end());
+      xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+      std::sort(ys.begin(), ys.end());
+      ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+      std::sort(pnts.begin(), pnts.end());
+      bool distinct = std::unique(pnts.begin(), pnts.end()) == pnts.end();
+
+      // A complete, evenly spaced grid that starts at the origin is a
+      // matrix (type 1), row (type 2) or column (type 3) repetition.
+      if (distinct && xs.size()*ys.size() == count && xs[0] == 0 &&
+          ys[0] == 0 && evenlySpaced(xs) && evenlySpaced(ys)) {
+        if (xs.size() > 1 && ys.size() > 1) {
+          oasisWriteUnsigned(out, 1);
+          oasisWriteUnsigned(out, xs.size() - 2);
+          oasisWriteUnsigned(out, ys.size() - 2);
+          oasisWriteUnsigned(out, xs[1]);
+          oasisWriteUnsigned(out, ys[1]);
+          return;
+        } else if (xs.size() > 1) {
+          oasisWriteUnsigned(out, 2);
+          oasisWriteUnsigned(out, xs.size() - 2);
+          oasisWriteUnsigned(out, xs[1]);
+          return;
+        } else if (ys.size() > 1) {
+          oasisWriteUnsigned(out, 3);
+          oasisWriteUnsigned(out, ys.size() - 2);
+          oasisWriteUnsigned(out, ys[1]);
+          return;
+        }
+      }
+
+      // Otherwise list every displacement relative to the previous one.
+      oasisWriteUnsigned(out, 10);
+      oasisWriteUnsigned(out, count - 2);
+      for (uint i = 2; i < xy.size(); i += 2)
+        oasisWriteGDelta(out, xy[i] - xy[i - 2], xy[i + 1] - xy[i - 1]);
+    }
+
+  } // namespace utils
+} // namespace sil
@@ -0,0 +1,200 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OASIS_FILE_HXX
+#define OASIS_FILE_HXX
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdint.h> // cross-compiler integer datatypes
+#include <stdexcept>
+#include "cell.hxx"
+#include "polygon.hxx"
+
+namespace sil {
+  /// Prevent users from accidentally using utility methods that they should
+  /// not normally be using by nesting it within an obvious nested namespace.
+  namespace utils {
+
+    // These are the record ids defined by the OASIS standard (SEMI P39).
+    // Unlike GDSII every OASIS record starts with a single unsigned
+    // integer that identifies it and carries no length field.
+    const uint8_t OAS_PAD                 = 0;
+    const uint8_t OAS_START               = 1;
+    const uint8_t OAS_END                 = 2;
+    const uint8_t OAS_CELLNAME_IMPLICIT   = 3;
+    const uint8_t OAS_CELLNAME            = 4;
+    const uint8_t OAS_CELL_REFNUM         = 13;
+    const uint8_t OAS_CELL_NAME           = 14;
+    const uint8_t OAS_XYABSOLUTE          = 15;
+    const uint8_t OAS_XYRELATIVE          = 16;
+    const uint8_t OAS_PLACEMENT           = 17;
+    const uint8_t OAS_PLACEMENT_TRANSFORM = 18;
+    const uint8_t OAS_RECTANGLE           = 20;
+    const uint8_t OAS_POLYGON             = 21;
+    const uint8_t OAS_PATH                = 22;
+    const uint8_t OAS_CBLOCK              = 34;
+
+    /// \brief Writes a collection of Cell objects to an OASIS (SEMI P39)
+    /// file.
+    ///
+    /// This is the OASIS counterpart of GDS_File. The two share the same
+    /// database unit so a Layout written in either format describes the
+    /// same geometry. OASIS is considerably more compact since it uses
+    /// variable length integers, stores points as deltas, remembers the
+    /// last value of most fields (modal variables) and folds identical
+    /// shapes and placements into a single record with a repetition.
+    class OASIS_File {
+    private:
+      /// \brief The modal variables of the OASIS standard that we make
+      /// use of. These are reset at the start of every CELL record.
+      struct ModalVariables {
+        bool layerValid;
+        uint64_t layer;
+        bool dataTypeValid;
+        uint64_t dataType;
+        int64_t geometryX;
+        int64_t geometryY;
+        int64_t placementX;
+        int64_t placementY;
+        bool placementCellValid;
+        uint64_t placementCell;
+        bool geometryWValid;
+        uint64_t geometryW;
+        bool geometryHValid;
+        uint64_t geometryH;
+        bool pathHalfwidthValid;
+        uint64_t pathHalfwidth;
+        std::string polygonPointList; //!< Encoded point-list, empty if undefined.
+        std::string pathPointList; //!< Encoded point-list, empty if undefined.
+        std::string repetition; //!< Encoded repetition, empty if undefined.
+      };
+
+      std::string filename; //!< The name of the output file.
+      std::string version; //!< The version of the OASIS standard we write.
+      double databaseUnits; //!< Relative size of units stored in the database to the user's defined units.
+      bool compress; //!< Whether cell contents are wrapped in CBLOCK records.
+      std::ofstream outputFile; //!< The stream to the output file.
+      uint64_t bytesWritten; //!< The number of bytes written so far, used for the table offsets.
+      ModalVariables modal; //!< The current state of the modal variables.
+      std::vector<std::string> cellnames; //!< The CELLNAME table, indexed by reference number.
+      std::unordered_map<std::string, uint64_t> cellnameIndex; //!< Reference number of each name in @cellnames.
+
+      /// \brief Writes the magic bytes and the START record.
+      void WriteFileHeaderRecords(void);
+
+      /// \brief Writes the CELLNAME records, one per entry of @cellnames.
+      void WriteCellnameRecords(void);
+
+      /// \brief Writes the END record which must be exactly 256 bytes long.
+      ///
+      /// @cellnameOffset The byte offset of the first CELLNAME record.
+      void WriteFileTailRecords(uint64_t cellnameOffset);
+
+      /// \brief Causes the OASIS_File object to write the specified Cell
+      /// object to the file.
+      void WriteCell(const Cell* cell);
+
+      /// \brief Appends the POLYGON and RECTANGLE records of @cell to @out.
+      void WritePolygonRecords(std::string& out, const Cell* cell);
+
+      /// \brief Appends the PATH records of @cell to @out.
+      void WritePathRecords(std::string& out, const Cell* cell);
+
+      /// \brief Appends the PLACEMENT records of @cell to @out.
+      void WritePlacementRecords(std::string& out, const Cell* cell);
+
+      /// \brief Returns the reference number of @cellname, adding it to
+      /// the CELLNAME table if it is not yet there.
+      uint64_t cellnameReference(const std::string& cellname);
+
+      /// \brief Converts a user unit coordinate to database units.
+      int64_t toDatabaseUnits(double value) const;
+
+      /// \brief Resets all of the modal variables to undefined.
+      void resetModalVariables(void);
+
+      /// \brief Appends the repetition to @out, or a reuse marker if it
+      /// equals the modal repetition.
+      void writeRepetition(std::string& out, const std::string& repetition);
+
+      /// \brief Writes @data to the output file and tracks the offset.
+      void writeBytesToFile(const std::string& data);
+
+    protected:
+
+    public:
+      /// \brief Creates an OASIS_File object which allows users to write
+      /// their data to a file of their choosing.
+      ///
+      /// @usrFilename The file which the data will be written to.
+      ///
+      /// This constructor only creates an internal object - it does NOT
+      /// create or modify any files until it is told to do so by calling
+      /// the object's member functions (e.g. Write()).
+      OASIS_File(std::string usrFilename);
+
+      /// \brief Enables or disables CBLOCK (DEFLATE) compression of the
+      /// cell contents.
+      ///
+      /// @usrCompress True to compress the contents of each cell.
+      ///
+      /// Compression is only available when silhouette was built with
+      /// zlib. Requesting it otherwise throws std::logic_error.
+      void setCompression(bool usrCompress);
+
+      /// Write the supplied vector of cells to the specified OASIS file.
+      void Write(const std::vector<Cell*> cellVec);
+    }; // class OASIS_File
+
+    // The low level encoders of the OASIS standard. They append to
+    // @out so that records may be assembled in memory before they are
+    // written or compressed.
+
+    /// \brief Appends an unsigned-integer (7 bits per byte, low first).
+    void oasisWriteUnsigned(std::string& out, uint64_t value);
+
+    /// \brief Appends a signed-integer (sign stored in the lowest bit).
+    void oasisWriteSigned(std::string& out, int64_t value);
+
+    /// \brief Appends a real, using the whole number form when possible.
+    void oasisWriteReal(std::string& out, double value);
+
+    /// \brief Appends an a-string, b-string or n-string.
+    void oasisWriteString(std::string& out, const std::string& value);
+
+    /// \brief Appends a g-delta displacement.
+    void oasisWriteGDelta(std::string& out, int64_t dx, int64_t dy);
+
+    /// \brief Appends a point-list of the successive displacements
+    /// @deltas (as x, y pairs), picking the most compact type.
+    ///
+    /// @closed True for polygons, whose implicit closing edge must also
+    /// be representable by the chosen type.
+    void oasisWritePointList(std::string& out,
+                             const std::vector<int64_t>& deltas, bool closed);
+
+    /// \brief Appends a repetition for the positions @xy (as x, y pairs
+    /// relative to the first position, which must be (0, 0)).
+    void oasisWriteRepetition(std::string& out,
+                              const std::vector<int64_t>& xy);
+
+  } // namespace utils
+} // namespace sil
+
+#endif // OASIS_FILE_HXX
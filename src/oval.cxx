@@ -33,6 +33,7 @@ namespace sil {
     const double PI = std::acos(-1); // compiler limited representation of pi
     double angularSep = 2*PI/numCoordPnts;
     double angularPos = 0.;
+    vertices.reserve(numCoordPnts);
     for (int i = 0; i < numCoordPnts; i++) {
       double localRadius = majorAxisLength*minorAxisLength/
         std::sqrt(std::pow(minorAxisLength*std::cos(angularPos), 2) +
@@ -49,7 +50,8 @@ namespace sil {
     this->minorLength = minorAxisLength;
     this->majorLength = majorAxisLength;
     this->eccentricity = findEccentricity();
-    this->center = usrCenter;
+    this->cache.center = usrCenter;
+    this->cache.valid |= CENTER_CACHED;
   }
 
   Oval::Oval(LineSeg majorAxis,
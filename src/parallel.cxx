@@ -0,0 +1,73 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "parallel.hxx"
+#include "threadPool.hxx"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+
+namespace sil {
+  namespace utils {
+
+    unsigned int threadCount() {
+      return getExecutor().getConcurrency();
+    }
+
+    void parallelFor(std::size_t count,
+                     const std::function<void(std::size_t)>& body) {
+      if (count == 0)
+        return;
+      Executor& executor = getExecutor();
+      std::size_t ways = std::min<std::size_t>(count, executor.getConcurrency());
+      if (ways <= 1) {
+        for (std::size_t i = 0; i < count; i++)
+          body(i);
+        return;
+      }
+
+      std::atomic<std::size_t> next(0);
+      std::atomic<bool> failed(false);
+      std::exception_ptr error;
+      std::mutex errorMutex;
+      auto loop = [&]() {
+        for (std::size_t i = next++; i < count; i = next++) {
+          if (failed)
+            continue; // stop doing work once an iteration failed
+          try {
+            body(i);
+          } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error)
+              error = std::current_exception();
+            failed = true;
+          }
+        }
+      };
+
+      // the calling thread does its share of the work as well
+      TaskGroup group(executor);
+      for (std::size_t t = 1; t < ways; t++)
+        group.run(loop);
+      loop();
+      group.wait();
+      if (error)
+        std::rethrow_exception(error);
+    }
+
+  } // namespace utils
+} // namespace sil
@@ -0,0 +1,48 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PARALLEL_HXX
+#define PARALLEL_HXX
+
+#include <cstddef>
+#include <functional>
+
+namespace sil {
+  namespace utils {
+
+    /// \brief Returns the number of threads parallel passes should use.
+    ///
+    /// This is the concurrency of getExecutor().
+    unsigned int threadCount(void);
+
+    /// \brief Calls @body(i) for every i in [0, @count), spreading the
+    /// calls over threadCount() threads.
+    ///
+    /// @count The number of iterations.
+    /// @body The work to do for one iteration. It must be safe to call
+    /// concurrently for different values of i.
+    ///
+    /// The loop runs as a TaskGroup on getExecutor(), so it may be nested
+    /// inside other parallel work. Iterations are handed out dynamically
+    /// so uneven work is balanced. The first exception thrown by @body is
+    /// rethrown once all of the threads have finished.
+    void parallelFor(std::size_t count,
+                     const std::function<void(std::size_t)>& body);
+
+  } // namespace utils
+} // namespace sil
+
+#endif // PARALLEL_HXX
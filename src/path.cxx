@@ -15,9 +15,28 @@
 // limitations under the License.
 
 #include "path.hxx"
+#include "validation.hxx"
 
 namespace sil {
 
+  Path::Path(const Path& other, const allocator_type& allocator) :
+    coordPath(other.coordPath, allocator), pathWidth(other.pathWidth),
+    pathType(other.pathType), layer(other.layer), dataType(other.dataType) {}
+
+  Path::Path(Path&& other, const allocator_type& allocator) :
+    coordPath(std::move(other.coordPath), allocator), pathWidth(other.pathWidth),
+    pathType(other.pathType), layer(other.layer), dataType(other.dataType) {}
+
+  Path::Path(std::allocator_arg_t, const allocator_type& allocator,
+	     Span<const CoordPnt> usrCoordPath, double usrPathWidth,
+	     int usrPathType, int usrLayer, int usrDataType) : coordPath(allocator) {
+    this->setCoordPath(usrCoordPath);
+    this->pathWidth = usrPathWidth;
+    this->setPathType(usrPathType);
+    this->setLayer(usrLayer);
+    this->setDataType(usrDataType);
+  }
+
   Path::Path(std::vector<CoordPnt> usrCoordPath, double usrPathWidth, 
 	     int usrPathType, int usrLayer, int usrDataType) {
     this->setCoordPath(usrCoordPath);
@@ -43,7 +62,7 @@ namespace sil {
   }
 
   void Path::setPathType(int newPathType) {
-    if (newPathType >= 0 && newPathType <= 2)
+    if ((newPathType >= 0 && newPathType <= 2) || DeferredValidation::isActive())
       this->pathType = newPathType;
     else  {
       std::ostringstream warning;
@@ -67,12 +86,17 @@ namespace sil {
   }
 
   std::vector<CoordPnt> Path::getCoordPath(void) const {
-    return this->coordPath;
+    return std::vector<CoordPnt>(this->coordPath.begin(), this->coordPath.end());
+  }
+
+  Span<const CoordPnt> Path::getCoordPathSpan(void) const {
+    return Span<const CoordPnt>(this->coordPath);
   }
 
-  void Path::setCoordPath(std::vector<CoordPnt> newCoordPath) {
-    if (newCoordPath.size() > 1 && newCoordPath.size() < 200) 
-      this->coordPath = newCoordPath;
+  void Path::setCoordPath(Span<const CoordPnt> newCoordPath) {
+    if ((newCoordPath.size() >= GDS_MIN_PATH_POINTS &&
+	 newCoordPath.size() <= GDS_MAX_PATH_POINTS) || DeferredValidation::isActive())
+      this->coordPath.assign(newCoordPath.begin(), newCoordPath.end());
     else {
       std::stringstream errorMsg;
       errorMsg << "The number of coordinates in a Path must"
@@ -83,7 +107,7 @@ namespace sil {
   }
 
   void Path::appendToCoordPath(CoordPnt nextCoordPnt) {
-    if (this->coordPath.size() < 199) // can have up to 199 coordiantes
+    if (this->coordPath.size() < GDS_MAX_PATH_POINTS || DeferredValidation::isActive())
       this->coordPath.push_back(nextCoordPnt);
     else {
       std::stringstream errorMsg;
@@ -93,7 +117,7 @@ namespace sil {
   }
 
   void Path::setDataType(int newDataType) {
-    if (newDataType >= 0 && newDataType < 64)
+    if ((newDataType >= 0 && newDataType <= GDS_MAX_DATATYPE) || DeferredValidation::isActive())
       this->dataType = newDataType;
     else {
       std::stringstream errorMsg;
@@ -109,8 +133,8 @@ namespace sil {
   }
 
   void Path::setLayer(int newLayer) {
-    if (newLayer >= 0 && newLayer < 64)
-      this->dataType = newLayer;
+    if ((newLayer >= 0 && newLayer <= GDS_MAX_LAYER) || DeferredValidation::isActive())
+      this->layer = newLayer;
     else {
       std::stringstream errorMsg;
       errorMsg << "Invalid layer. Layers must be "
@@ -18,6 +18,7 @@
 #define PATH_HXX
 
 #include "coord.hxx"
+#include "span.hxx"
 #include <vector>
 #include <stdexcept>
 #include <sstream>
@@ -26,7 +27,7 @@ namespace sil {
 
   class Path {
   private:
-    std::vector<CoordPnt> coordPath; //!< The points through which the path traverses.
+    VertexList coordPath; //!< The points through which the path traverses.
     double pathWidth; //!< The width of the path.
     int pathType; //!< Determines the shape of end points. Can be 0, 1, or 2.
     int layer;
@@ -35,6 +36,30 @@ namespace sil {
   protected:
     
   public:
+    /// \brief The allocator of the points, see Polygon::allocator_type.
+    typedef std::pmr::polymorphic_allocator<CoordPnt> allocator_type;
+
+    /// \brief Copies @other, allocating its points with @allocator.
+    Path(const Path& other, const allocator_type& allocator);
+
+    /// \brief Moves @other, allocating its points with @allocator if
+    /// @other uses a different memory resource.
+    Path(Path&& other, const allocator_type& allocator);
+
+    /// \brief Creates a path whose points are allocated with @allocator.
+    ///
+    /// This is the constructor std::pmr containers use to build a Path
+    /// in place, see Cell::emplacePath(). The other parameters are
+    /// those of the full constructor.
+    Path(std::allocator_arg_t, const allocator_type& allocator,
+	 Span<const CoordPnt> usrCoordPath, double usrPathWidth = 0,
+	 int usrPathType = 0, int usrLayer = 0, int usrDataType = 0);
+
+    Path(const Path& other) = default;
+    Path(Path&& other) = default;
+    Path& operator=(const Path& other) = default;
+    Path& operator=(Path&& other) = default;
+
     //! Full constructor for the path class.
     Path(std::vector<CoordPnt> usrCoordPath, double usrPathWidth, 
 	 int usrPathType, int usrLayer, int usrDataType);
@@ -57,9 +82,14 @@ namespace sil {
 
     void setPathWidth(double newPathWidth);
 
+    /// \brief Returns a copy of the points, see getCoordPathSpan().
     std::vector<CoordPnt> getCoordPath(void) const;
 
-    void setCoordPath(std::vector<CoordPnt> newCoordPath);
+    /// \brief Returns a read only view of the points, without copying
+    /// them.
+    Span<const CoordPnt> getCoordPathSpan(void) const;
+
+    void setCoordPath(Span<const CoordPnt> newCoordPath);
 
     void appendToCoordPath(CoordPnt nextCoordPnt);
 
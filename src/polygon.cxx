@@ -15,6 +15,9 @@
 // limitations under the License.
 
 #include "polygon.hxx"
+#include "validation.hxx"
+#include <algorithm>
+#include <thread>
 
 namespace sil {
 
@@ -31,39 +34,229 @@ namespace sil {
   Polygon::Polygon(std::vector<CoordPnt> usrVertices) :
     Polygon(usrVertices, 1) {}
 
+  Polygon::Polygon(const Polygon& other, const allocator_type& allocator) :
+    Layer(other.Layer), DataType(other.DataType),
+    vertices(other.vertices, allocator), cache(other.cache) {}
+
+  Polygon::Polygon(Polygon&& other, const allocator_type& allocator) :
+    Layer(other.Layer), DataType(other.DataType),
+    vertices(std::move(other.vertices), allocator), cache(other.cache) {}
+
+  Polygon::Polygon(std::allocator_arg_t, const allocator_type& allocator,
+		   Span<const CoordPnt> usrVertices, int usrLayer, int usrDataType) :
+    vertices(allocator) {
+    this->setVertices(usrVertices);
+    this->setLayer(usrLayer);
+    this->setDataType(usrDataType);
+  }
+
   Polygon::Polygon() {
     this->setLayer(1);
     this->setDataType(0);
   }
 
-  std::vector<CoordPnt> Polygon::findBoundingBox() const {
-    // Initialize the variables to store the maximum and minimum values of 
-    // x and y that we find
-    int maxY = vertices[0].getY();
-    int minY = vertices[0].getY();
-    int maxX = vertices[0].getX();
-    int minX = vertices[0].getX();
-    // Test to find out what the minimum and maximum extent of the x and y
-    // are and store them in the corresponding variables
-    for (std::vector<CoordPnt>::const_iterator it = vertices.begin(); 
-         it != vertices.end(); ++it) {
-      if (maxY < it->getY())
-        maxY = it->getY();
-      else if (minY > it->getY())
-        minY = it->getY();
-      if (maxX < it->getX())
-        maxX = it->getX();
-      else if (minX > it->getX())
-        minX = it->getX();
+  Polygon::Polygon(const allocator_type& allocator) :
+    vertices(allocator) {
+    this->setLayer(1);
+    this->setDataType(0);
+  }
+
+  Polygon::DerivedProperties::DerivedProperties() :
+    valid(0), shape(0), minX(0), minY(0), maxX(0), maxY(0),
+    signedArea(0), perimeter(0) {}
+
+  Polygon::DerivedProperties::DerivedProperties(const DerivedProperties& other) :
+    DerivedProperties() {
+    *this = other;
+  }
+
+  Polygon::DerivedProperties&
+  Polygon::DerivedProperties::operator=(const DerivedProperties& other) {
+    // a group that another thread is still computing is left out
+    unsigned int groups = other.valid.load(std::memory_order_acquire) & ~CACHE_FILLING;
+    if (groups & SHAPE_CACHED)
+      this->shape = other.shape;
+    if (groups & BOUNDS_CACHED) {
+      this->minX = other.minX;
+      this->minY = other.minY;
+      this->maxX = other.maxX;
+      this->maxY = other.maxY;
+    }
+    if (groups & CENTER_CACHED)
+      this->center = other.center;
+    if (groups & AREA_CACHED)
+      this->signedArea = other.signedArea;
+    if (groups & PERIMETER_CACHED)
+      this->perimeter = other.perimeter;
+    this->valid.store(groups, std::memory_order_release);
+    return *this;
+  }
+
+  void Polygon::invalidateProperties() {
+    this->cache.valid.store(0, std::memory_order_relaxed);
+  }
+
+  bool Polygon::beginFill(unsigned int property) const {
+    if (this->cache.valid.load(std::memory_order_acquire) & property)
+      return false;
+    while (this->cache.valid.fetch_or(CACHE_FILLING, std::memory_order_acquire) & CACHE_FILLING)
+      std::this_thread::yield();
+    // another thread may have computed it while this one waited
+    if (this->cache.valid.load(std::memory_order_relaxed) & property) {
+      this->cache.valid.fetch_and(~CACHE_FILLING, std::memory_order_release);
+      return false;
+    }
+    return true;
+  }
+
+  void Polygon::finishFill(unsigned int property) const {
+    this->cache.valid.fetch_or(property, std::memory_order_release);
+    this->cache.valid.fetch_and(~CACHE_FILLING, std::memory_order_release);
+  }
+
+  void Polygon::cacheBounds() const {
+    if (!this->beginFill(BOUNDS_CACHED))
+      return;
+    this->cache.minX = this->cache.maxX = 0;
+    this->cache.minY = this->cache.maxY = 0;
+    if (!this->vertices.empty()) {
+      this->cache.minX = this->cache.maxX = this->vertices[0].getX();
+      this->cache.minY = this->cache.maxY = this->vertices[0].getY();
+    }
+    for (uint i = 1; i < this->vertices.size(); i++) {
+      this->cache.minX = std::min(this->cache.minX, this->vertices[i].getX());
+      this->cache.maxX = std::max(this->cache.maxX, this->vertices[i].getX());
+      this->cache.minY = std::min(this->cache.minY, this->vertices[i].getY());
+      this->cache.maxY = std::max(this->cache.maxY, this->vertices[i].getY());
+    }
+    this->finishFill(BOUNDS_CACHED);
+  }
+
+  void Polygon::cacheShape() const {
+    if (!this->beginFill(SHAPE_CACHED))
+      return;
+    uint numVertices = this->vertices.size();
+    bool manhattan = numVertices >= 3;
+    bool turnsLeft = false;
+    bool turnsRight = false;
+    for (uint i = 0; i < numVertices; i++) {
+      const CoordPnt& a = this->vertices[i];
+      const CoordPnt& b = this->vertices[(i + 1) % numVertices];
+      const CoordPnt& c = this->vertices[(i + 2) % numVertices];
+      if (a.getX() != b.getX() && a.getY() != b.getY())
+	manhattan = false;
+      double cross = (b.getX() - a.getX())*(c.getY() - b.getY()) -
+	(b.getY() - a.getY())*(c.getX() - b.getX());
+      if (cross > 0)
+	turnsLeft = true;
+      else if (cross < 0)
+	turnsRight = true;
+    }
+    unsigned int shape = 0;
+    if (manhattan)
+      shape |= MANHATTAN;
+    if (numVertices >= 3 && !(turnsLeft && turnsRight))
+      shape |= CONVEX;
+    // four axis parallel edges can only form a rectangle
+    if (manhattan && numVertices == 4 && (shape & CONVEX))
+      shape |= RECTANGLE;
+    this->cache.shape = shape;
+    this->finishFill(SHAPE_CACHED);
+  }
+
+  BoxList Polygon::getBoundingBox() const {
+    this->cacheBounds();
+    BoxList box;
+    box.push_back(CoordPnt(this->cache.minX, this->cache.maxY)); // upper left corner
+    box.push_back(CoordPnt(this->cache.maxX, this->cache.maxY)); // upper right corner
+    box.push_back(CoordPnt(this->cache.maxX, this->cache.minY)); // lower right corner
+    box.push_back(CoordPnt(this->cache.minX, this->cache.minY)); // lower left corner
+    return box;
+  }
+
+  CoordPnt Polygon::getCenter() const {
+    if (this->beginFill(CENTER_CACHED)) {
+      double xSum = 0.;
+      double ySum = 0.;
+      for (uint i = 0; i < this->vertices.size(); i++) {
+	xSum += this->vertices[i].getX();
+	ySum += this->vertices[i].getY();
+      }
+      uint numVertices = std::max<uint>(this->vertices.size(), 1);
+      this->cache.center = CoordPnt(xSum/numVertices, ySum/numVertices);
+      this->finishFill(CENTER_CACHED);
     }
-    // create the std::vector to store the appropriate points in
-    std::vector<CoordPnt> newBoundingBox;
-    newBoundingBox.push_back(CoordPnt(minX, maxY)); // upper left corner
-    newBoundingBox.push_back(CoordPnt(maxX, maxY)); // upper right corner
-    newBoundingBox.push_back(CoordPnt(maxX, minY)); // lower right corner
-    newBoundingBox.push_back(CoordPnt(minX, minY)); // lower left corner
-    // return completed bounding box
-    return newBoundingBox;
+    return this->cache.center;
+  }
+
+  double Polygon::getSignedArea() const {
+    // the groups the area is taken from are computed before taking
+    // the CACHE_FILLING bit for the area itself
+    this->cacheShape();
+    bool rectangle = (this->cache.shape & RECTANGLE) != 0;
+    if (rectangle)
+      this->cacheBounds();
+    if (this->beginFill(AREA_CACHED)) {
+      if (rectangle) {
+	// the winding of a rectangle follows from its first corner
+	const CoordPnt& a = this->vertices[0];
+	const CoordPnt& b = this->vertices[1];
+	const CoordPnt& c = this->vertices[2];
+	double cross = (b.getX() - a.getX())*(c.getY() - b.getY()) -
+	  (b.getY() - a.getY())*(c.getX() - b.getX());
+	double area = (this->cache.maxX - this->cache.minX)*(this->cache.maxY - this->cache.minY);
+	this->cache.signedArea = cross < 0 ? -area : area;
+      }
+      else {
+	// the shoelace formula
+	double twiceArea = 0.;
+	uint numVertices = this->vertices.size();
+	for (uint i = 0; i < numVertices; i++) {
+	  const CoordPnt& a = this->vertices[i];
+	  const CoordPnt& b = this->vertices[(i + 1) % numVertices];
+	  twiceArea += a.getX()*b.getY() - b.getX()*a.getY();
+	}
+	this->cache.signedArea = twiceArea/2.;
+      }
+      this->finishFill(AREA_CACHED);
+    }
+    return this->cache.signedArea;
+  }
+
+  double Polygon::getArea() const {
+    return std::abs(this->getSignedArea());
+  }
+
+  double Polygon::getPerimeter() const {
+    if (this->beginFill(PERIMETER_CACHED)) {
+      double perimeter = 0.;
+      uint numVertices = this->vertices.size();
+      for (uint i = 0; i < numVertices; i++) {
+	const CoordPnt& a = this->vertices[i];
+	const CoordPnt& b = this->vertices[(i + 1) % numVertices];
+	perimeter += std::hypot(b.getX() - a.getX(), b.getY() - a.getY());
+      }
+      this->cache.perimeter = perimeter;
+      this->finishFill(PERIMETER_CACHED);
+    }
+    return this->cache.perimeter;
+  }
+
+  unsigned int Polygon::getShapeClass() const {
+    this->cacheShape();
+    return this->cache.shape;
+  }
+
+  bool Polygon::isManhattan() const {
+    return (this->getShapeClass() & MANHATTAN) != 0;
+  }
+
+  bool Polygon::isConvex() const {
+    return (this->getShapeClass() & CONVEX) != 0;
+  }
+
+  bool Polygon::isRectangle() const {
+    return (this->getShapeClass() & RECTANGLE) != 0;
   }
 
   // Rotates the Polygon objects about rotatePnt by rotationAngle radians.
@@ -81,7 +274,7 @@ namespace sil {
     // create a position column vector for the vertices
     double vertexVec[2];
     // Now rotate each vertex point about the rotatePnt
-    for (std::vector<CoordPnt>::iterator it = vertices.begin();
+    for (VertexList::iterator it = vertices.begin();
          it != vertices.end(); ++it) {
       // set up the position vector for this vertex
       vertexVec[0] = it->getX();
@@ -89,11 +282,12 @@ namespace sil {
       // make the rotation point the origin
       vertexVec[0] -= rotateVec[0];
       vertexVec[1] -= rotateVec[1];
-      // rotate the vertex
-      vertexVec[0] = rotationMatrix[0][0]*vertexVec[0] + 
+      // rotate the vertex, both rows use the unrotated position
+      double rotatedX = rotationMatrix[0][0]*vertexVec[0] + 
 	rotationMatrix[0][1]*vertexVec[1];
       vertexVec[1] = rotationMatrix[1][0]*vertexVec[0] + 
 	rotationMatrix[1][1]*vertexVec[1];
+      vertexVec[0] = rotatedX;
       // now shift the matrix back
       vertexVec[0] += rotateVec[0];
       vertexVec[1] += rotateVec[1];
@@ -101,23 +295,21 @@ namespace sil {
       it->setX(vertexVec[0]);
       it->setY(vertexVec[1]);
     }
-    // update the center field
-    this->findResetCenter();
+    // a rotation keeps the area and the perimeter but nothing else
+    this->cache.valid.fetch_and(AREA_CACHED | PERIMETER_CACHED, std::memory_order_relaxed);
   }
    
-  // Resets the center field
-  void Polygon::findResetCenter() {
-    int numVertices = 0;
-    double xSum = 0.;
-    double ySum = 0.;
-    for (std::vector<CoordPnt>::iterator it = vertices.begin(); 
-         it != vertices.end(); ++it) {
-      xSum += it->getX();
-      ySum += it->getY();
-      numVertices++;
-    }
-    // Reset the center field to be the average values from the vertices
-    this->center = CoordPnt(xSum/numVertices, ySum/numVertices);
+  // Shifts the vertices along with the derived center and bounding box
+  void Polygon::translate(CoordPnt offset) {
+    for (VertexList::iterator it = vertices.begin();
+         it != vertices.end(); ++it)
+      *it += offset;
+    // the other properties do not depend on the position
+    this->cache.minX += offset.getX();
+    this->cache.maxX += offset.getX();
+    this->cache.minY += offset.getY();
+    this->cache.maxY += offset.getY();
+    this->cache.center += offset;
   }
 
   int Polygon::getLayer() const {
@@ -125,14 +317,14 @@ namespace sil {
   }
 
   void Polygon::setLayer(int newLayer) {
-    if (newLayer >= 0 && newLayer < 64)
+    if ((newLayer >= 0 && newLayer <= GDS_MAX_LAYER) || DeferredValidation::isActive())
       this->Layer = newLayer;
     else {
       std::stringstream errorMsg;
       errorMsg << "The layer assigned out of range. User attempted to"
 	       << " assign a value of " << newLayer << ", but " 
 	       << "layers must be equal to or between 0 and 63.\n";
-      std::invalid_argument(errorMsg.str());
+      throw std::invalid_argument(errorMsg.str());
     }
   }
 
@@ -141,22 +333,31 @@ namespace sil {
   }
 
   void Polygon::setDataType(int newDataType) {
-    if (newDataType >= 0 && newDataType < 64)
-      this->Layer = newDataType;
+    if ((newDataType >= 0 && newDataType <= GDS_MAX_DATATYPE) || DeferredValidation::isActive())
+      this->DataType = newDataType;
     else {
       std::stringstream errorMsg;
       errorMsg << "The data type assigned out of range. User attempted"
 	       << " to assign a value of " << newDataType << ", but"
 	       << " data types must be equal to or between 0 and 63.\n";
-      std::invalid_argument(errorMsg.str());
+      throw std::invalid_argument(errorMsg.str());
     }
   }
 
-  std::vector<CoordPnt> &Polygon::getVertices() const {
-    return const_cast<std::vector<sil::CoordPnt> &> (this->vertices);
+  VertexList &Polygon::getVertices() {
+    this->invalidateProperties();
+    return this->vertices;
+  }
+
+  const VertexList &Polygon::getVertices() const {
+    return this->vertices;
+  }
+
+  Span<const CoordPnt> Polygon::getVertexSpan() const {
+    return Span<const CoordPnt>(this->vertices);
   }
 
-  bool Polygon::containsInternalVoid(std::vector<CoordPnt> usrVertices) {
+  bool Polygon::containsInternalVoid(Span<const CoordPnt> usrVertices) {
     // test to make sure what was passed in couuld actually be a polygon
     // if we don't the next test will always throw an error and it will
     // be harder to determine what went wrong than if we catch it here
@@ -171,11 +372,13 @@ namespace sil {
 
     // even a single intersection implies an internal void. neither
     // are allowed by gdsII standards so quit at the first one found.
-    uint upperLimit = usrVertices.size();
-    for (uint i = 0; i <= upperLimit; i++) {
-      LineSeg lin1(usrVertices[i], usrVertices[i + 1]);
-      for (uint j = i + 2; j <= upperLimit; i++) {
-	LineSeg lin2(usrVertices[j], usrVertices[j + 1]);
+    // edges that share a vertex are skipped, the last edge closes the
+    // polygon and shares a vertex with the first one.
+    uint numVertices = usrVertices.size();
+    for (uint i = 0; i < numVertices; i++) {
+      LineSeg lin1(usrVertices[i], usrVertices[(i + 1) % numVertices]);
+      for (uint j = i + 2; j < numVertices && (i > 0 || j + 1 < numVertices); j++) {
+	LineSeg lin2(usrVertices[j], usrVertices[(j + 1) % numVertices]);
 	if (lineSegIntersect(lin1, lin2))
 	  return true;
       }
@@ -184,8 +387,14 @@ namespace sil {
     return false;
   }
 
-  void Polygon::setVertices(std::vector<CoordPnt> usrVertices) {
-    if (usrVertices.size() < 3 || usrVertices.size() > 199) {
+  void Polygon::setVertices(Span<const CoordPnt> usrVertices) {
+    if (DeferredValidation::isActive()) {
+      this->vertices.assign(usrVertices.begin(), usrVertices.end());
+      this->invalidateProperties();
+      return;
+    }
+    if (usrVertices.size() < GDS_MIN_POLYGON_VERTICES ||
+	usrVertices.size() > GDS_MAX_POLYGON_VERTICES) {
       std::stringstream errorMsg;
       errorMsg << "Each polygon may only have 3-199 vertices. User"
 	       << " tried to initiate a polygon with " 
@@ -193,35 +402,37 @@ namespace sil {
       throw std::invalid_argument(errorMsg.str());
     }
 
-    if (!this->containsInternalVoid(usrVertices))
-      this->vertices = usrVertices;
-    // update the bounding box
-    this->boundingBox = this->findBoundingBox();
+    if (containsInternalVoid(usrVertices))
+      throw std::invalid_argument("The edges of a polygon may not cross each other.\n");
+    this->vertices.assign(usrVertices.begin(), usrVertices.end());
+    this->invalidateProperties();
   }
 
-  bool Polygon::pointInsidePolygon(CoordPnt pnt) {
+  bool Polygon::pointInsidePolygon(CoordPnt pnt) const {
+    // points on or outside of the bounding box are not inside, and for
+    // rectangles every other point is
+    this->cacheBounds();
+    if (pnt.getX() <= this->cache.minX || pnt.getX() >= this->cache.maxX ||
+	pnt.getY() <= this->cache.minY || pnt.getY() >= this->cache.maxY)
+      return false;
+    if (this->isRectangle())
+      return true;
+
     // for the ray casting techneique we need to use a point that is
     // garunteed to be outside of the polygon (we want to reuse the
     // algorithm for determining the intersection of two line segments)
     // Use the point that has the same y coordinate as @pnt but has
     // an x coordinate that is one unit towards +inf than the largest
     // x coordinate in the vertex list.
-    uint numVertices = this->boundingBox.size();
-    int maxXCoord = std::abs(this->boundingBox[0].getX());
-    int maxYCoord = std::abs(this->boundingBox[0].getY());
-    for (uint i = 1; i < numVertices; i++) {
-      if (std::abs(this->boundingBox[i].getX()) > maxXCoord) 
-	maxXCoord = std::abs(this->boundingBox[i].getX());
-      if (std::abs(this->boundingBox[i].getY()) > maxYCoord)
-	maxYCoord = std::abs(this->boundingBox[i].getY());
-    }
+    double maxXCoord = std::max(std::abs(this->cache.minX), std::abs(this->cache.maxX));
+    double maxYCoord = std::max(std::abs(this->cache.minY), std::abs(this->cache.maxY));
     CoordPnt rayCastCoord = CoordPnt(maxXCoord*1.1, pnt.getY());
     LineSeg rayCast = LineSeg(pnt, rayCastCoord);
 
     // now detect if the ray (rayCast) intersects any of the sides of
     // the polygon. If rayCast intersects an odd number of sides then
     // @pnt is inside the polygon, otherwise it is outside.
-    numVertices = this->vertices.size();
+    uint numVertices = this->vertices.size();
     int intersectionCount = 0;
     for (uint i = 0; i < numVertices - 1; i++) {
       LineSeg polySide = LineSeg(this->vertices[i], this->vertices[i + 1]);
@@ -18,10 +18,12 @@
 #define POLYGON_HXX
 
 #include <vector>
+#include <atomic>
 #include <cmath> // for trig functions
 #include <sstream>
 #include <stdexcept>
 #include "coord.hxx"
+#include "span.hxx"
 #include "line.hxx"
 
 namespace sil {
@@ -30,43 +32,83 @@ namespace sil {
   private:
 
   protected:
-    CoordPnt center; //!< Coordinate of the center of the polyon.
     int Layer; //!< The layer that the polygon belongs to. Usually corresponds to a fabrication step.
     int DataType; //!< Another number that details information, such as metal to be used.
-    std::vector<CoordPnt> boundingBox; //!< The bounding box of the structure. Good for collision detection.
     
     //!< a vector of verticies that can be used to define the nature of varius
     // objects
-    std::vector<CoordPnt> vertices;
+    VertexList vertices;
 
-    /// \brief Recalculates and relocates the center of the Polygon object.
-    void findResetCenter(void);
+    /// \brief The bits of DerivedProperties::valid, one for each group
+    /// of properties that is computed together.
+    enum CachedProperty {
+      BOUNDS_CACHED = 1, //!< minX, minY, maxX and maxY.
+      CENTER_CACHED = 2, //!< center.
+      AREA_CACHED = 4, //!< signedArea.
+      PERIMETER_CACHED = 8, //!< perimeter.
+      SHAPE_CACHED = 16, //!< shape.
+      CACHE_FILLING = 1u << 31 //!< A thread is computing one of the groups.
+    };
 
-    /// \brief Calcultes and returns the area of the polygon.
-    double getArea(void) const;
+    /// \brief The properties derived from the vertices.
+    ///
+    /// Each group is computed the first time it is asked for and kept
+    /// until the vertices change. Concurrent queries of the same Polygon
+    /// are safe: a group is computed by one thread while holding the
+    /// CACHE_FILLING bit, and its bit in @valid is only set with release
+    /// order after its fields are written, so readers that see the bit
+    /// with acquire order also see the fields. Changing the vertices
+    /// still must not race with anything else.
+    struct DerivedProperties {
+      std::atomic<unsigned int> valid; //!< The CachedProperty bits of the groups that are up to date.
+      unsigned int shape; //!< The ShapeClass bits of the polygon.
+      double minX; //!< The smallest x coordinate of the vertices.
+      double minY; //!< The smallest y coordinate of the vertices.
+      double maxX; //!< The largest x coordinate of the vertices.
+      double maxY; //!< The largest y coordinate of the vertices.
+      CoordPnt center; //!< The average of the vertices.
+      double signedArea; //!< The area, positive for counterclockwise vertices.
+      double perimeter; //!< The length of the outline.
+
+      /// \brief Creates a cache with nothing computed.
+      DerivedProperties(void);
+
+      /// \brief Copies the groups of @other that are up to date.
+      DerivedProperties(const DerivedProperties& other);
+
+      /// \brief Copies the groups of @other that are up to date.
+      DerivedProperties& operator=(const DerivedProperties& other);
+    };
+
+    mutable DerivedProperties cache; //!< See DerivedProperties.
+
+    /// \brief Forgets every derived property, to be called whenever the
+    /// vertices change.
+    void invalidateProperties(void);
+
+    /// \brief Returns true if the group @property is missing from the
+    /// cache, having taken the CACHE_FILLING bit to compute it. The
+    /// caller then writes the fields and calls finishFill().
+    bool beginFill(unsigned int property) const;
+
+    /// \brief Marks the group @property as up to date and releases the
+    /// CACHE_FILLING bit taken by beginFill().
+    void finishFill(unsigned int property) const;
+
+    /// \brief Computes the bounds into the cache if needed.
+    void cacheBounds(void) const;
+
+    /// \brief Computes the shape classification into the cache if needed.
+    void cacheShape(void) const;
 
     /// \brief Checks the vertices for their validity and conformity
     /// to the GDSII standards for BOUNDARY records, and then sets
     /// the polygons vertices to be usrVertices if all checks out.
-    void setVertices(std::vector<CoordPnt> usrVertices);
-
-    /// \brief Determines the bounding box from the "vertices" field.
     ///
-    /// This method itterates over the "vertices" field to find the maximum and
-    /// minimum displacements in the x and y directions. The resulting bounding
-    /// box will have its sides parallel to the x and y axis.
-    std::vector<CoordPnt> findBoundingBox(void) const;
+    /// Throws std::invalid_argument if they do not, unless a
+    /// DeferredValidation scope is open.
+    void setVertices(Span<const CoordPnt> usrVertices);
 
-    /// \brief Determines if the set of vertices passed in define a 
-    ///        Polygon that contains an internal void.
-    ///
-    /// @usrVertices The vector of vertices that defines a polygon.
-    ///
-    /// As per the GDSII standard we must avoid any polygon (i.e 
-    /// BOUNDARY record) that contains internal voids (same condition
-    /// as having edges that cross one another. If such a condition
-    /// exists this method returns true, otherwise it returns false.
-    bool containsInternalVoid(std::vector<CoordPnt> usrVertices);
 
     /// \brief Thd default constructor for the Polygon class.
     ///
@@ -75,8 +117,51 @@ namespace sil {
     /// shapes.
     Polygon(void);
 
+    /// \brief The default constructor, allocating the vertices of the
+    /// child class with @allocator.
+    explicit Polygon(const std::pmr::polymorphic_allocator<CoordPnt>& allocator);
+
   public:
 
+    /// \brief The classification flags returned by getShapeClass().
+    enum ShapeClass {
+      MANHATTAN = 1, //!< Every edge is horizontal or vertical.
+      CONVEX = 2, //!< No interior angle is larger than 180 degrees.
+      RECTANGLE = 4 //!< An axis aligned rectangle.
+    };
+
+    /// \brief The allocator of the vertices.
+    ///
+    /// Declaring it makes std::pmr containers of Polygon objects (such
+    /// as the lists of a Cell) store the vertices of their polygons with
+    /// their own memory resource.
+    typedef std::pmr::polymorphic_allocator<CoordPnt> allocator_type;
+
+    /// \brief Copies @other, allocating its vertices with @allocator.
+    Polygon(const Polygon& other, const allocator_type& allocator);
+
+    /// \brief Moves @other, allocating its vertices with @allocator if
+    /// @other uses a different memory resource.
+    Polygon(Polygon&& other, const allocator_type& allocator);
+
+    /// \brief Creates a polygon whose vertices are allocated with
+    /// @allocator.
+    ///
+    /// @usrVertices The vertices, which are copied once, straight into
+    /// memory from @allocator.
+    /// @usrLayer The layer at which the polygon will reside.
+    /// @usrDataType the data type of which the polygon will belong.
+    ///
+    /// This is the constructor std::pmr containers use to build a
+    /// Polygon in place, see Cell::emplacePolygon().
+    Polygon(std::allocator_arg_t, const allocator_type& allocator,
+	    Span<const CoordPnt> usrVertices, int usrLayer = 1, int usrDataType = 0);
+
+    Polygon(const Polygon& other) = default;
+    Polygon(Polygon&& other) = default;
+    Polygon& operator=(const Polygon& other) = default;
+    Polygon& operator=(Polygon&& other) = default;
+
     /// \brief The full constructor for the polygon class.
     ///
     /// @usrVertices The list of vertices that defines the polygon.
@@ -101,6 +186,17 @@ namespace sil {
     /// will be constructed by the points in the exact order they are passed in.
     Polygon(std::vector<CoordPnt> usrVertices);
 
+    /// \brief Determines if the set of vertices passed in define a 
+    ///        Polygon that contains an internal void.
+    ///
+    /// @usrVertices The vector of vertices that defines a polygon.
+    ///
+    /// As per the GDSII standard we must avoid any polygon (i.e 
+    /// BOUNDARY record) that contains internal voids (same condition
+    /// as having edges that cross one another. If such a condition
+    /// exists this method returns true, otherwise it returns false.
+    static bool containsInternalVoid(Span<const CoordPnt> usrVertices);
+
     /// \brief Allows the user to rotate any Polygon objects.
     ///
     /// @rotatePnt The CoordPnt object that defines the point about which the 
@@ -108,6 +204,11 @@ namespace sil {
     /// @rotationAngle The angle (in radians) to rotate the Polygon object by.
     void rotate(CoordPnt rotatePnt, double rotationAngle);
 
+    /// \brief Moves the Polygon object by the displacement @offset.
+    ///
+    /// @offset The displacement to add to every vertex.
+    void translate(CoordPnt offset);
+
     /// \brief Returns the int corresponding the the layer it is located on.
     int getLayer(void) const;
     
@@ -122,7 +223,51 @@ namespace sil {
 
     /// \brief Returns a reference to the coordinate point list that comprises
     /// a polygon.
-    std::vector<CoordPnt> &getVertices(void) const;
+    ///
+    /// The list may be modified through the reference, so this forgets
+    /// the derived properties.
+    VertexList &getVertices(void);
+
+    /// \brief Returns a read only reference to the coordinate point list
+    /// that comprises a polygon.
+    const VertexList &getVertices(void) const;
+
+    /// \brief Returns a read only view of the vertices, without copying
+    /// them.
+    Span<const CoordPnt> getVertexSpan(void) const;
+
+    /// \brief Returns the corners of the axis aligned bounding box: upper
+    /// left, upper right, lower right and lower left.
+    BoxList getBoundingBox(void) const;
+
+    /// \brief Returns the average of the vertices.
+    CoordPnt getCenter(void) const;
+
+    /// \brief Returns the enclosed area.
+    ///
+    /// Rectangles take it from their bounding box, other polygons from
+    /// the shoelace formula.
+    double getArea(void) const;
+
+    /// \brief Returns the area, positive if the vertices run
+    /// counterclockwise and negative if they run clockwise.
+    double getSignedArea(void) const;
+
+    /// \brief Returns the length of the outline, including the edge from
+    /// the last vertex back to the first.
+    double getPerimeter(void) const;
+
+    /// \brief Returns the ShapeClass bits that apply to this polygon.
+    unsigned int getShapeClass(void) const;
+
+    /// \brief Returns true if every edge is horizontal or vertical.
+    bool isManhattan(void) const;
+
+    /// \brief Returns true if the polygon is convex.
+    bool isConvex(void) const;
+
+    /// \brief Returns true if the polygon is an axis aligned rectangle.
+    bool isRectangle(void) const;
 
     /// \brief Determines if the coordinate point passed in lies
     /// within the polygon.
@@ -133,8 +278,9 @@ namespace sil {
     /// In this definition inside does not include the boundaries,
     /// therefore if @pnt lies on this's boundary this method will
     /// return false. To note this algorithm uses the "casting ray"
-    /// approach.
-    bool pointInsidePolygon(CoordPnt pnt);
+    /// approach, after rejecting points outside of the bounding box and
+    /// answering directly for rectangles.
+    bool pointInsidePolygon(CoordPnt pnt) const;
     
   }; // class polygon
 
@@ -0,0 +1,624 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "raster.hxx"
+#include "SilhouetteConfig.h"
+#include "geometry.hxx"
+#include "layout.hxx"
+#include "parallel.hxx"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <stdint.h>
+#ifdef SILHOUETTE_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace sil {
+
+  RasterOptions::RasterOptions() : antialias(false), bitsPerPixel(8) {}
+
+  Raster::Raster(unsigned int usrWidth, unsigned int usrHeight, unsigned int usrBitsPerPixel) :
+    width(usrWidth), height(usrHeight), bitsPerPixel(usrBitsPerPixel) {
+    if (usrBitsPerPixel != 1 && usrBitsPerPixel != 8) {
+      std::stringstream errorMsg;
+      errorMsg << "A raster has 1 or 8 bits per pixel, not " << usrBitsPerPixel << ".";
+      throw std::invalid_argument(errorMsg.str());
+    }
+    if (usrWidth == 0 || usrHeight == 0) {
+      std::stringstream errorMsg;
+      errorMsg << "A raster of " << usrWidth << " x " << usrHeight << " pixels is empty.";
+      throw std::invalid_argument(errorMsg.str());
+    }
+    this->rowSize = usrBitsPerPixel == 8 ? usrWidth : (usrWidth + 7)/8;
+    this->pixels.assign(this->rowSize*usrHeight, 0);
+  }
+
+  unsigned int Raster::getWidth() const {
+    return this->width;
+  }
+
+  unsigned int Raster::getHeight() const {
+    return this->height;
+  }
+
+  unsigned int Raster::getBitsPerPixel() const {
+    return this->bitsPerPixel;
+  }
+
+  std::size_t Raster::getRowSize() const {
+    return this->rowSize;
+  }
+
+  unsigned char* Raster::getRow(unsigned int row) {
+    return &this->pixels[row*this->rowSize];
+  }
+
+  const unsigned char* Raster::getRow(unsigned int row) const {
+    return &this->pixels[row*this->rowSize];
+  }
+
+  unsigned char Raster::getPixel(unsigned int x, unsigned int y) const {
+    if (x >= this->width || y >= this->height) {
+      std::stringstream errorMsg;
+      errorMsg << "The pixel (" << x << ", " << y << ") is outside of the "
+               << this->width << " x " << this->height << " raster.";
+      throw std::out_of_range(errorMsg.str());
+    }
+    const unsigned char* row = this->getRow(y);
+    if (this->bitsPerPixel == 8)
+      return row[x];
+    return (row[x/8] >> (7 - x%8)) & 1 ? 255 : 0;
+  }
+
+  void Raster::writePGM(std::string filename) const {
+    std::ofstream out(filename.c_str(), std::ios::out | std::ios::binary);
+    if (!out) {
+      std::stringstream errorMsg;
+      errorMsg << "Unable to open " << filename << " for writing.";
+      throw std::runtime_error(errorMsg.str());
+    }
+    out << "P5\n" << this->width << " " << this->height << "\n255\n";
+    std::vector<unsigned char> gray(this->width);
+    for (unsigned int y = 0; y < this->height; y++) {
+      if (this->bitsPerPixel == 8)
+        out.write(reinterpret_cast<const char*>(this->getRow(y)), this->width);
+      else {
+        for (unsigned int x = 0; x < this->width; x++)
+          gray[x] = this->getPixel(x, y);
+        out.write(reinterpret_cast<const char*>(gray.data()), this->width);
+      }
+    }
+    if (!out) {
+      std::stringstream errorMsg;
+      errorMsg << "Unable to write " << filename << ".";
+      throw std::runtime_error(errorMsg.str());
+    }
+  }
+
+  namespace {
+
+    /// \brief The number of rows rendered by one task.
+    const unsigned int ROWS_PER_BAND = 32;
+
+    /// \brief The most image data written to a single PNG IDAT chunk.
+    const std::size_t PNG_CHUNK_SIZE = 1 << 20;
+
+    /// \brief The most bytes of a DEFLATE block that is stored as is.
+    const std::size_t STORED_BLOCK_SIZE = 65535;
+
+    /// \brief The lookup table of the CRC-32 used by PNG chunks.
+    struct CRCTable {
+      uint32_t entries[256];
+
+      CRCTable(void) {
+        for (uint32_t n = 0; n < 256; n++) {
+          uint32_t c = n;
+          for (int k = 0; k < 8; k++)
+            c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+          this->entries[n] = c;
+        }
+      }
+    };
+
+    uint32_t crc32(uint32_t crc, const unsigned char* data, std::size_t size) {
+      static const CRCTable table;
+      crc = ~crc;
+      for (std::size_t i = 0; i < size; i++)
+        crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+      return ~crc;
+    }
+
+    void appendBigEndian(std::string& out, uint32_t value) {
+      for (int shift = 24; shift >= 0; shift -= 8)
+        out += static_cast<char>((value >> shift) & 0xFF);
+    }
+
+    /// \brief Writes PNG chunks to a stream.
+    class PNGWriter {
+    private:
+      std::ostream& out;
+
+    public:
+      PNGWriter(std::ostream& usrOut) : out(usrOut) {
+        static const char signature[8] = {'\x89', 'P', 'N', 'G', '\r', '\n', '\x1A', '\n'};
+        this->out.write(signature, 8);
+      }
+
+      void writeChunk(const char* type, const std::string& data) {
+        std::string chunk;
+        appendBigEndian(chunk, data.size());
+        chunk += type;
+        chunk += data;
+        uint32_t crc = crc32(0, reinterpret_cast<const unsigned char*>(chunk.data()) + 4,
+                             chunk.size() - 4);
+        appendBigEndian(chunk, crc);
+        this->out.write(chunk.data(), chunk.size());
+        if (!this->out)
+          throw std::runtime_error("Unable to write a PNG chunk.");
+      }
+    };
+
+    /// \brief An edge of a shape in pixel coordinates, relative to the
+    /// first row of a band.
+    struct PixelEdge {
+      double x0; //!< The upper end.
+      double y0;
+      double x1; //!< The lower end, with y1 > y0.
+      double y1;
+      int winding; //!< +1 if the edge runs downwards, -1 otherwise.
+    };
+
+    /// \brief Sets the pixels [@from, @to) of a 1 bit @row.
+    void setBits(unsigned char* row, unsigned int from, unsigned int to) {
+      for (; from < to && from%8 != 0; from++)
+        row[from/8] |= 0x80 >> (from%8);
+      for (; from + 8 <= to; from += 8)
+        row[from/8] = 0xFF;
+      for (; from < to; from++)
+        row[from/8] |= 0x80 >> (from%8);
+    }
+
+    /// \brief Adds the area to the right of the segment from (@x0, @y0)
+    /// down to (@x1, @y1) in each pixel to the rows of @acc.
+    ///
+    /// The running sum of a row then is the covered part of each pixel.
+    /// The segment lies within [0, width] x [0, rows].
+    void accumulate(float* acc, std::size_t stride, double x0, double y0, double x1, double y1,
+                    int winding) {
+      double slope = (x1 - x0)/(y1 - y0);
+      double x = x0;
+      int lastRow = int(std::ceil(y1));
+      for (int row = int(std::floor(y0)); row < lastRow; row++) {
+        double dy = std::min(double(row + 1), y1) - std::max(double(row), y0);
+        double next = x + slope*dy;
+        double d = dy*winding;
+        double lo = std::min(x, next), hi = std::max(x, next);
+        float* line = acc + row*stride;
+        double loFloor = std::floor(lo), hiCeil = std::ceil(hi);
+        int loPixel = int(loFloor), hiPixel = int(hiCeil);
+        if (hiPixel <= loPixel + 1) {
+          // within a single pixel
+          double middle = 0.5*(x + next) - loFloor;
+          line[loPixel] += d - d*middle;
+          line[loPixel + 1] += d*middle;
+        } else {
+          double inverse = 1/(hi - lo);
+          double loFraction = lo - loFloor;
+          double first = 0.5*inverse*(1 - loFraction)*(1 - loFraction);
+          double hiFraction = hi - hiCeil + 1;
+          double last = 0.5*inverse*hiFraction*hiFraction;
+          line[loPixel] += d*first;
+          if (hiPixel == loPixel + 2)
+            line[loPixel + 1] += d*(1 - first - last);
+          else {
+            double second = inverse*(1.5 - loFraction);
+            line[loPixel + 1] += d*(second - first);
+            for (int pixel = loPixel + 2; pixel < hiPixel - 1; pixel++)
+              line[pixel] += d*inverse;
+            double covered = second + (hiPixel - loPixel - 3)*inverse;
+            line[hiPixel - 1] += d*(1 - covered - last);
+          }
+          line[hiPixel] += d*last;
+        }
+        x = next;
+      }
+    }
+
+    /// \brief Renders the bands of one image.
+    class Renderer {
+    private:
+      const FrozenLayout& layout;
+      unsigned int cell;
+      Bounds window;
+      RasterOptions options;
+      Raster& raster;
+      double scaleX; //!< Pixels per user unit.
+      double scaleY;
+
+      bool wanted(int layer) const {
+        return this->options.layers.empty() ||
+          std::binary_search(this->options.layers.begin(), this->options.layers.end(), layer);
+      }
+
+      bool wantedIn(const FrozenCell& frozen) const {
+        if (this->options.layers.empty())
+          return !frozen.layers.empty();
+        for (std::size_t i = 0; i < frozen.layers.size(); i++)
+          if (this->wanted(frozen.layers[i]))
+            return true;
+        return false;
+      }
+
+      /// \brief Adds the edges of the polygon @vertices, placed by
+      /// @transform, that matter to the band of @rows rows from @firstRow
+      /// to @edges.
+      void addEdges(Span<const CoordPnt> vertices, const utils::Transform& transform,
+                    unsigned int firstRow, unsigned int rows, std::vector<PixelEdge>& edges) const {
+        std::size_t n = vertices.size();
+        if (n == 0)
+          return;
+        // map straight into pixels, with rows counted from the band
+        double ax = transform.a*this->scaleX, bx = -transform.b*this->scaleX;
+        double cx = (transform.dx - this->window.minX)*this->scaleX;
+        double ay = -transform.b*this->scaleY, by = -transform.a*this->scaleY;
+        double cy = (this->window.maxY - transform.dy)*this->scaleY - firstRow;
+        double lastX = 0, lastY = 0;
+        for (std::size_t i = 0; i <= n; i++) {
+          double x = vertices[i%n].getX(), y = vertices[i%n].getY();
+          double px = ax*x + bx*y + cx, py = ay*x + by*y + cy;
+          if (i > 0 && py != lastY) {
+            PixelEdge edge = lastY < py ? PixelEdge{lastX, lastY, px, py, 1} :
+              PixelEdge{px, py, lastX, lastY, -1};
+            // sampling only sees edges that cross the center of a row
+            bool needed = this->options.antialias ?
+              edge.y1 > 0 && edge.y0 < rows :
+              std::ceil(edge.y0 - 0.5) < std::min(double(rows), std::ceil(edge.y1 - 0.5)) &&
+              edge.y1 > 0.5;
+            if (needed)
+              edges.push_back(edge);
+          }
+          lastX = px;
+          lastY = py;
+        }
+      }
+
+      /// \brief Adds the edges of the shapes of @cell, placed by
+      /// @transform, that overlap @band to @edges.
+      void collect(unsigned int cell, const utils::Transform& transform, const Bounds& band,
+                   unsigned int firstRow, unsigned int rows, std::vector<PixelEdge>& edges,
+                   std::vector<CoordPnt>& scratch) const {
+        const FrozenCell& frozen = this->layout.getCell(cell);
+        if (!transform.apply(frozen.extent).intersects(band))
+          return;
+        if (this->wantedIn(frozen)) {
+          for (std::size_t i = 0; i < frozen.polygons.size(); i++) {
+            const FrozenPolygon& polygon = frozen.polygons[i];
+            if (!this->wanted(polygon.layer) || !transform.apply(polygon.bounds).intersects(band))
+              continue;
+            this->addEdges(polygon.vertices, transform, firstRow, rows, edges);
+          }
+          for (std::size_t i = 0; i < frozen.paths.size(); i++) {
+            const FrozenPath& path = frozen.paths[i];
+            if (!this->wanted(path.layer) || !transform.apply(path.bounds).intersects(band))
+              continue;
+            scratch.clear();
+            std::size_t quads = utils::pathQuads(path.points, path.width, path.pathType,
+                                                 transform, scratch);
+            for (std::size_t q = 0; q < quads; q++)
+              this->addEdges(Span<const CoordPnt>(&scratch[4*q], 4), utils::Transform(),
+                             firstRow, rows, edges);
+          }
+        }
+        for (std::size_t i = 0; i < frozen.references.size(); i++) {
+          const FrozenReference& ref = frozen.references[i];
+          this->collect(ref.cell, transform.after(
+              utils::Transform(ref.magnification, ref.rotation, ref.position)),
+            band, firstRow, rows, edges, scratch);
+        }
+        Bounds local = transform.invert(band);
+        for (std::size_t i = 0; i < frozen.arrays.size(); i++) {
+          const FrozenArray& array = frozen.arrays[i];
+          utils::Transform first(array.magnification, array.rotation, array.startingPos);
+          Bounds extent = first.apply(this->layout.getCell(array.cell).extent);
+          int col0, col1, row0, row1;
+          if (extent.isEmpty() ||
+              !utils::latticeRange(extent.minX, extent.maxX, array.xSpacing, array.numCol,
+                                   local.minX, local.maxX, false, col0, col1) ||
+              !utils::latticeRange(extent.minY, extent.maxY, array.ySpacing, array.numRow,
+                                   local.minY, local.maxY, false, row0, row1))
+            continue;
+          for (int col = col0; col <= col1; col++)
+            for (int row = row0; row <= row1; row++)
+              this->collect(array.cell, transform.after(
+                  first.shifted(col*array.xSpacing, row*array.ySpacing)),
+                band, firstRow, rows, edges, scratch);
+        }
+      }
+
+      /// \brief Sets the pixels whose centers are covered.
+      void sample(std::vector<PixelEdge>& edges, unsigned int firstRow, unsigned int rows) {
+        unsigned int width = this->raster.getWidth();
+        // the rows [first, last) whose centers an edge crosses
+        std::vector<std::pair<int, unsigned int> > starts;
+        for (std::size_t i = 0; i < edges.size(); i++) {
+          int first = std::max(0, int(std::ceil(edges[i].y0 - 0.5)));
+          int last = std::min(int(rows), int(std::ceil(edges[i].y1 - 0.5)));
+          if (first < last)
+            starts.push_back(std::make_pair(first, i));
+        }
+        std::sort(starts.begin(), starts.end());
+        std::vector<unsigned int> active;
+        std::vector<std::pair<double, int> > crossings;
+        std::size_t next = 0;
+        for (unsigned int row = 0; row < rows; row++) {
+          double center = row + 0.5;
+          active.erase(std::remove_if(active.begin(), active.end(), [&](unsigned int i) {
+                return edges[i].y1 - 0.5 <= row;
+              }), active.end());
+          for (; next < starts.size() && starts[next].first == int(row); next++)
+            active.push_back(starts[next].second);
+          crossings.clear();
+          for (std::size_t i = 0; i < active.size(); i++) {
+            const PixelEdge& edge = edges[active[i]];
+            crossings.push_back(std::make_pair(
+                edge.x0 + (center - edge.y0)*(edge.x1 - edge.x0)/(edge.y1 - edge.y0), edge.winding));
+          }
+          std::sort(crossings.begin(), crossings.end());
+          unsigned char* pixels = this->raster.getRow(firstRow + row);
+          int winding = 0;
+          double start = 0;
+          for (std::size_t i = 0; i < crossings.size(); i++) {
+            int before = winding;
+            winding += crossings[i].second;
+            if (before == 0 && winding != 0)
+              start = crossings[i].first;
+            else if (before != 0 && winding == 0) {
+              double from = std::max(0., std::ceil(start - 0.5));
+              double to = std::min(double(width), std::ceil(crossings[i].first - 0.5));
+              if (from >= to)
+                continue;
+              if (this->raster.getBitsPerPixel() == 8)
+                std::memset(pixels + std::size_t(from), 255, std::size_t(to - from));
+              else
+                setBits(pixels, unsigned(from), unsigned(to));
+            }
+          }
+        }
+      }
+
+      /// \brief Shades the pixels by the area covered.
+      void shade(const std::vector<PixelEdge>& edges, unsigned int firstRow, unsigned int rows) {
+        unsigned int width = this->raster.getWidth();
+        std::size_t stride = width + 2;
+        std::vector<float> acc(stride*rows, 0);
+        for (std::size_t i = 0; i < edges.size(); i++) {
+          PixelEdge edge = edges[i];
+          if (edge.y1 <= 0 || edge.y0 >= rows)
+            continue;
+          // clip to the band
+          double slope = (edge.x1 - edge.x0)/(edge.y1 - edge.y0);
+          if (edge.y0 < 0) {
+            edge.x0 -= edge.y0*slope;
+            edge.y0 = 0;
+          }
+          if (edge.y1 > rows) {
+            edge.x1 -= (edge.y1 - rows)*slope;
+            edge.y1 = rows;
+          }
+          if (std::min(edge.x0, edge.x1) >= 0 && std::max(edge.x0, edge.x1) <= width) {
+            accumulate(acc.data(), stride, edge.x0, edge.y0, edge.x1, edge.y1, edge.winding);
+            continue;
+          }
+          // split where the edge leaves the image on either side; left
+          // of the image it still covers everything to its right
+          double cuts[4] = {edge.y0, edge.y1, edge.y1, edge.y1};
+          int numCuts = 1;
+          if (edge.x0 != edge.x1) {
+            double borders[2] = {0, double(width)};
+            for (int b = 0; b < 2; b++) {
+              double t = (borders[b] - edge.x0)/(edge.x1 - edge.x0);
+              if (t > 0 && t < 1)
+                cuts[numCuts++] = edge.y0 + t*(edge.y1 - edge.y0);
+            }
+          }
+          cuts[numCuts++] = edge.y1;
+          std::sort(cuts, cuts + numCuts);
+          for (int c = 0; c + 1 < numCuts; c++) {
+            double top = cuts[c], bottom = cuts[c + 1];
+            if (bottom <= top)
+              continue;
+            double xTop = edge.x0 + (top - edge.y0)*slope;
+            double xBottom = edge.x0 + (bottom - edge.y0)*slope;
+            double middle = 0.5*(xTop + xBottom);
+            if (middle >= width)
+              continue;
+            if (middle <= 0)
+              xTop = xBottom = 0;
+            xTop = std::min(std::max(xTop, 0.), double(width));
+            xBottom = std::min(std::max(xBottom, 0.), double(width));
+            accumulate(acc.data(), stride, xTop, top, xBottom, bottom, edge.winding);
+          }
+        }
+        for (unsigned int row = 0; row < rows; row++) {
+          unsigned char* pixels = this->raster.getRow(firstRow + row);
+          const float* line = &acc[row*stride];
+          float sum = 0;
+          for (unsigned int x = 0; x < width; x++) {
+            sum += line[x];
+            float coverage = std::min(1.f, std::abs(sum));
+            if (this->raster.getBitsPerPixel() == 8)
+              pixels[x] = static_cast<unsigned char>(std::lround(coverage*255));
+            else if (coverage >= 0.5f)
+              pixels[x/8] |= 0x80 >> (x%8);
+          }
+        }
+      }
+
+    public:
+      Renderer(const FrozenLayout& usrLayout, unsigned int usrCell, const Bounds& usrWindow,
+               const RasterOptions& usrOptions, Raster& usrRaster) :
+        layout(usrLayout), cell(usrCell), window(usrWindow), options(usrOptions),
+        raster(usrRaster) {
+        std::sort(this->options.layers.begin(), this->options.layers.end());
+        this->scaleX = usrRaster.getWidth()/(usrWindow.maxX - usrWindow.minX);
+        this->scaleY = usrRaster.getHeight()/(usrWindow.maxY - usrWindow.minY);
+      }
+
+      /// \brief Renders the rows [@firstRow, @firstRow + @rows).
+      void renderBand(unsigned int firstRow, unsigned int rows) {
+        Bounds band(this->window.minX, this->window.maxY - (firstRow + rows)/this->scaleY,
+                    this->window.maxX, this->window.maxY - firstRow/this->scaleY);
+        std::vector<PixelEdge> edges;
+        std::vector<CoordPnt> scratch;
+        this->collect(this->cell, utils::Transform(), band, firstRow, rows, edges, scratch);
+        if (edges.empty())
+          return;
+        if (this->options.antialias)
+          this->shade(edges, firstRow, rows);
+        else
+          this->sample(edges, firstRow, rows);
+      }
+    };
+
+  } // namespace
+
+  void Raster::writePNG(std::string filename) const {
+    std::ofstream out(filename.c_str(), std::ios::out | std::ios::binary);
+    if (!out) {
+      std::stringstream errorMsg;
+      errorMsg << "Unable to open " << filename << " for writing.";
+      throw std::runtime_error(errorMsg.str());
+    }
+    try {
+      this->writePNG(out);
+    } catch (const std::runtime_error&) {
+      std::stringstream errorMsg;
+      errorMsg << "Unable to write " << filename << ".";
+      throw std::runtime_error(errorMsg.str());
+    }
+  }
+
+  void Raster::writePNG(std::ostream& out) const {
+    PNGWriter writer(out);
+    std::string header;
+    appendBigEndian(header, this->width);
+    appendBigEndian(header, this->height);
+    header += static_cast<char>(this->bitsPerPixel);
+    header += '\0'; // grayscale
+    header += '\0'; // DEFLATE
+    header += '\0'; // adaptive filtering, every row is filtered with None
+    header += '\0'; // not interlaced
+    writer.writeChunk("IHDR", header);
+
+    std::string data;
+    std::vector<unsigned char> row(this->rowSize + 1, 0);
+#ifdef SILHOUETTE_HAVE_ZLIB
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    if (deflateInit(&stream, Z_DEFAULT_COMPRESSION) != Z_OK)
+      throw std::runtime_error("Unable to initialize the DEFLATE stream.");
+    // small images, like tiles, do not need a whole chunk of buffer
+    std::size_t bound = deflateBound(&stream, (this->rowSize + 1)*this->height);
+    std::vector<unsigned char> compressed(std::min(PNG_CHUNK_SIZE, bound));
+    for (unsigned int y = 0; y <= this->height; y++) {
+      if (y < this->height) {
+        std::memcpy(&row[1], this->getRow(y), this->rowSize);
+        stream.next_in = row.data();
+        stream.avail_in = row.size();
+      }
+      int status;
+      do {
+        stream.next_out = compressed.data();
+        stream.avail_out = compressed.size();
+        status = deflate(&stream, y < this->height ? Z_NO_FLUSH : Z_FINISH);
+        data.append(reinterpret_cast<const char*>(compressed.data()),
+                    compressed.size() - stream.avail_out);
+        if (data.size() >= PNG_CHUNK_SIZE) {
+          writer.writeChunk("IDAT", data);
+          data.clear();
+        }
+      } while (stream.avail_out == 0 || (y == this->height && status == Z_OK));
+    }
+    deflateEnd(&stream);
+#else
+    // a zlib stream of stored blocks
+    data += '\x78';
+    data += '\x01';
+    uint32_t a = 1, b = 0;
+    std::string block;
+    for (unsigned int y = 0; y < this->height; y++) {
+      std::memcpy(&row[1], this->getRow(y), this->rowSize);
+      for (std::size_t i = 0; i < row.size(); i++) {
+        a = (a + row[i])%65521;
+        b = (b + a)%65521;
+      }
+      std::size_t offset = 0;
+      while (offset < row.size()) {
+        std::size_t size = std::min(row.size() - offset, STORED_BLOCK_SIZE - block.size());
+        block.append(reinterpret_cast<const char*>(&row[offset]), size);
+        offset += size;
+        bool last = y + 1 == this->height && offset == row.size();
+        if (block.size() == STORED_BLOCK_SIZE || last) {
+          data += static_cast<char>(last ? 1 : 0);
+          data += static_cast<char>(block.size() & 0xFF);
+          data += static_cast<char>(block.size() >> 8);
+          data += static_cast<char>(~block.size() & 0xFF);
+          data += static_cast<char>((~block.size() >> 8) & 0xFF);
+          data += block;
+          block.clear();
+        }
+        if (data.size() >= PNG_CHUNK_SIZE) {
+          writer.writeChunk("IDAT", data);
+          data.clear();
+        }
+      }
+    }
+    appendBigEndian(data, (b << 16) | a);
+#endif
+    writer.writeChunk("IDAT", data);
+    writer.writeChunk("IEND", std::string());
+  }
+
+  Raster rasterize(const FrozenLayout& layout, std::size_t cell, const Bounds& window,
+                   unsigned int width, unsigned int height, RasterOptions options) {
+    if (window.isEmpty() || window.maxX <= window.minX || window.maxY <= window.minY) {
+      std::stringstream errorMsg;
+      errorMsg << "The window [" << window.minX << ", " << window.maxX << "] x ["
+               << window.minY << ", " << window.maxY << "] is empty.";
+      throw std::invalid_argument(errorMsg.str());
+    }
+    layout.getCell(cell); // throws if there is no such cell
+    Raster raster(width, height, options.bitsPerPixel);
+    Renderer renderer(layout, cell, window, options, raster);
+    std::size_t bands = (height + ROWS_PER_BAND - 1)/ROWS_PER_BAND;
+    utils::parallelFor(bands, [&](std::size_t band) {
+        unsigned int firstRow = band*ROWS_PER_BAND;
+        renderer.renderBand(firstRow, std::min(ROWS_PER_BAND, height - firstRow));
+      });
+    return raster;
+  }
+
+  Raster rasterize(const Cell& cell, const Bounds& window, unsigned int width,
+                   unsigned int height, RasterOptions options) {
+    return rasterize(*FrozenLayout::freeze(cell), 0, window, width, height, options);
+  }
+
+}
@@ -0,0 +1,135 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef RASTER_HXX
+#define RASTER_HXX
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "cell.hxx"
+#include "frozenLayout.hxx"
+#include "spatialIndex.hxx"
+
+namespace sil {
+
+  /// \brief The settings used by rasterize().
+  struct RasterOptions {
+    /// \brief The layers to render, or every layer if empty.
+    std::vector<int> layers;
+
+    /// \brief If true pixels are shaded by how much of them is covered,
+    /// otherwise a pixel is set if its center is covered.
+    bool antialias;
+
+    /// \brief 8 for a gray level per pixel, 1 for a packed mask.
+    unsigned int bitsPerPixel;
+
+    /// \brief Sets the defaults: every layer, no anti-aliasing, 8 bits.
+    RasterOptions(void);
+  };
+
+  /// class Raster
+  ///
+  /// \brief A grayscale image, stored row by row from the top.
+  ///
+  /// Pixels hold 8 bit gray levels or, at 1 bit per pixel, are packed
+  /// eight to a byte with the leftmost pixel in the highest bit. Rows
+  /// start on whole bytes. Covered pixels are white.
+  class Raster {
+  private:
+    unsigned int width;
+    unsigned int height;
+    unsigned int bitsPerPixel;
+    std::size_t rowSize; //!< The number of bytes per row.
+    std::vector<unsigned char> pixels;
+
+  public:
+    /// \brief Creates a black image of @usrWidth x @usrHeight pixels.
+    ///
+    /// Throws std::invalid_argument if @usrBitsPerPixel is not 1 or 8.
+    Raster(unsigned int usrWidth, unsigned int usrHeight, unsigned int usrBitsPerPixel);
+
+    unsigned int getWidth(void) const;
+
+    unsigned int getHeight(void) const;
+
+    unsigned int getBitsPerPixel(void) const;
+
+    /// \brief Returns the number of bytes per row.
+    std::size_t getRowSize(void) const;
+
+    /// \brief Returns the first byte of row @row.
+    unsigned char* getRow(unsigned int row);
+
+    /// \brief Returns the first byte of row @row.
+    const unsigned char* getRow(unsigned int row) const;
+
+    /// \brief Returns the gray level of pixel (@x, @y), 0 or 255 for
+    /// 1 bit images. Throws std::out_of_range outside of the image.
+    unsigned char getPixel(unsigned int x, unsigned int y) const;
+
+    /// \brief Writes the image as a binary PGM file, 1 bit images as
+    /// black and white.
+    ///
+    /// Throws std::runtime_error if the file can not be written.
+    void writePGM(std::string filename) const;
+
+    /// \brief Writes the image as a grayscale PNG file of the same bit
+    /// depth.
+    ///
+    /// The image data is compressed with zlib if silhouette is built
+    /// with it, and stored uncompressed otherwise. Throws
+    /// std::runtime_error if the file can not be written.
+    void writePNG(std::string filename) const;
+
+    /// \brief Writes the image as a PNG to @out, see writePNG().
+    ///
+    /// Throws std::runtime_error if @out fails.
+    void writePNG(std::ostream& out) const;
+  };
+
+  /// \brief Renders the shapes of @cell in @window into an image of
+  /// @width x @height pixels.
+  ///
+  /// @layout The layout to render from.
+  /// @cell The index of the Cell in @layout.
+  /// @window The area to render, in the coordinates of @cell.
+  /// @width The width of the image in pixels.
+  /// @height The height of the image in pixels.
+  /// @options The layers and pixel format.
+  ///
+  /// The image is split into bands of rows that are rendered in
+  /// parallel. Each band walks the hierarchy for the shapes it
+  /// overlaps, skipping cells and array elements outside of it, and
+  /// fills them with an edge table scanline fill (or, anti-aliased,
+  /// by accumulating the exact area every edge covers in each pixel).
+  /// Overlapping shapes count once. Paths are drawn by their outlines,
+  /// with round ends treated as square. Throws std::invalid_argument if
+  /// @window is empty and std::out_of_range if there is no Cell @cell.
+  Raster rasterize(const FrozenLayout& layout, std::size_t cell, const Bounds& window,
+                   unsigned int width, unsigned int height,
+                   RasterOptions options = RasterOptions());
+
+  /// \brief Renders @cell, see rasterize().
+  Raster rasterize(const Cell& cell, const Bounds& window, unsigned int width,
+                   unsigned int height, RasterOptions options = RasterOptions());
+
+}
+
+#endif // RASTER_HXX
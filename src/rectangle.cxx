@@ -25,7 +25,6 @@ namespace sil {
 
   // The usual constructor for this class
   Rectangle::Rectangle(CoordPnt usrCenter, double width, double height) {
-    center = usrCenter;
     double maxX = usrCenter.getX() + width/2;
     double minX = usrCenter.getX() - width/2;
     double maxY = usrCenter.getY() + height/2;
@@ -34,6 +33,13 @@ namespace sil {
     vertices.push_back(CoordPnt(maxX, maxY)); // upper right corner
     vertices.push_back(CoordPnt(maxX, minY)); // lower right corner
     vertices.push_back(CoordPnt(minX, minY)); // lower left corner
-    boundingBox = vertices; // for rectangles these are the same
+    // the derived properties are known without looking at the vertices
+    cache.minX = minX;
+    cache.maxX = maxX;
+    cache.minY = minY;
+    cache.maxY = maxY;
+    cache.center = usrCenter;
+    cache.shape = MANHATTAN | CONVEX | RECTANGLE;
+    cache.valid = BOUNDS_CACHED | CENTER_CACHED | SHAPE_CACHED;
   }
 }
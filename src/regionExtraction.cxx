@@ -0,0 +1,388 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "regionExtraction.hxx"
+#include "geometry.hxx"
+#include "parallel.hxx"
+#include "scanline.hxx"
+#include "validation.hxx"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+
+namespace sil {
+
+  RegionExtractionOptions::RegionExtractionOptions() : flatten(false) {}
+
+  namespace {
+
+    // clipped copies are shared between windows that agree on this grid
+    const double WINDOW_GRID = 1e-3;
+
+    /// \brief The transform of the element in row @row and column @col
+    /// of @array.
+    utils::Transform elementTransform(const FrozenArray& array, int col, int row) {
+      return utils::Transform(array.magnification, array.rotation, array.startingPos)
+        .shifted(col*array.xSpacing, row*array.ySpacing);
+    }
+
+    typedef std::tuple<unsigned int, long long, long long, long long, long long> ClipKey;
+
+    /// \brief The state of a single call to RegionExtractor::extract().
+    class Extraction {
+    private:
+      const FrozenLayout& layout;
+      const std::vector<SpatialIndex>& indices;
+      Layout& target;
+      std::unordered_map<unsigned int, Cell*> copies; //!< Whole copies, by source Cell.
+      std::map<ClipKey, Cell*> clippedCopies; //!< Clipped copies, NULL if empty.
+      std::vector<unsigned int> found;
+      std::vector<CoordPnt> scratch, clipped;
+
+      /// \brief Returns @name, or @name with a suffix if @target
+      /// already has a Cell with that name.
+      std::string uniqueName(const std::string& name) const {
+        if (this->target.findCell(name) == NULL)
+          return name;
+        for (unsigned int suffix = 1; ; suffix++) {
+          std::stringstream candidate;
+          candidate << name << "_" << suffix;
+          if (this->target.findCell(candidate.str()) == NULL)
+            return candidate.str();
+        }
+      }
+
+      /// \brief Returns the elements of @cell that overlap @window, as
+      /// ids of its SpatialIndex.
+      std::vector<unsigned int> query(unsigned int cell, const Bounds& window) {
+        this->found.clear();
+        this->indices[cell].query(window, this->found);
+        std::sort(this->found.begin(), this->found.end());
+        return this->found;
+      }
+
+      /// \brief Adds the part of the polygon @vertices inside @window to
+      /// @out.
+      void addClipped(Cell& out, Span<const CoordPnt> vertices, bool convex, int layer,
+                      int dataType, const Bounds& window) {
+        if (convex) {
+          utils::clipToBox(vertices, window, this->clipped);
+          if (this->clipped.size() >= 3 && utils::signedArea(Span<const CoordPnt>(this->clipped)) != 0)
+            out.emplacePolygon(Span<const CoordPnt>(this->clipped), layer, dataType);
+          return;
+        }
+        utils::ScanlineSweep sweep;
+        sweep.addPolygon(vertices, 0);
+        CoordPnt corners[4] = {CoordPnt(window.minX, window.minY), CoordPnt(window.maxX, window.minY),
+                               CoordPnt(window.maxX, window.maxY), CoordPnt(window.minX, window.maxY)};
+        sweep.addPolygon(Span<const CoordPnt>(corners, 4), 1);
+        std::vector<Trapezoid> pieces;
+        sweep.sweep(utils::SWEEP_INTERSECTION, pieces);
+        for (std::size_t i = 0; i < pieces.size(); i++) {
+          std::vector<CoordPnt> corners = pieces[i].getVertices();
+          out.emplacePolygon(Span<const CoordPnt>(corners), layer, dataType);
+        }
+      }
+
+      /// \brief Adds the outline of @path, mapped by @transform, clipped
+      /// to @window to @out.
+      void addClippedPath(Cell& out, const FrozenPath& path, const utils::Transform& transform,
+                          const Bounds& window) {
+        this->scratch.clear();
+        std::size_t quads = utils::pathQuads(path.points, path.width, path.pathType, transform,
+                                             this->scratch);
+        for (std::size_t q = 0; q < quads; q++)
+          this->addClipped(out, Span<const CoordPnt>(&this->scratch[4*q], 4), true,
+                           path.layer, path.dataType, window);
+      }
+
+      /// \brief Adds a reference to @cell with the placement of
+      /// @transform, given by @magnification, @rotation and its offset.
+      static void addReference(Cell& out, Cell& cell, const utils::Transform& transform,
+                               double magnification, double rotation) {
+        CellReference ref(cell, CoordPnt(transform.dx, transform.dy));
+        ref.setMagneification(magnification);
+        ref.setRotation(rotation);
+        out.addCellReference(ref);
+      }
+
+      /// \brief Places @cell, whose outline under @transform straddles
+      /// @window, in @out.
+      void addStraddling(Cell& out, unsigned int cell, const utils::Transform& transform,
+                         double magnification, double rotation, const Bounds& window) {
+        if (!transform.keepsAxes()) {
+          this->flattenInto(out, cell, transform, window);
+          return;
+        }
+        Bounds inner = transform.invert(window).intersection(this->layout.getCell(cell).extent);
+        ClipKey key(cell, std::llround(inner.minX/WINDOW_GRID), std::llround(inner.minY/WINDOW_GRID),
+                    std::llround(inner.maxX/WINDOW_GRID), std::llround(inner.maxY/WINDOW_GRID));
+        std::map<ClipKey, Cell*>::iterator it = this->clippedCopies.find(key);
+        if (it == this->clippedCopies.end()) {
+          Cell& copy = this->target.createCell(
+              this->uniqueName(this->layout.getCell(cell).cellname + "_clip"));
+          this->clipInto(copy, cell, inner);
+          bool empty = copy.getPolygonList().empty() && copy.getPathList().empty() &&
+            copy.getCellReferenceList().empty() && copy.getCellArrayList().empty();
+          if (empty)
+            this->target.removeCell(copy);
+          it = this->clippedCopies.insert(std::make_pair(key, empty ? NULL : &copy)).first;
+        }
+        if (it->second != NULL)
+          addReference(out, *it->second, transform, magnification, rotation);
+      }
+
+    public:
+      Extraction(const FrozenLayout& usrLayout, const std::vector<SpatialIndex>& usrIndices,
+                 Layout& usrTarget) :
+        layout(usrLayout), indices(usrIndices), target(usrTarget) {}
+
+      /// \brief Returns a copy of all of @cell in the target.
+      Cell& copyCell(unsigned int cell) {
+        std::unordered_map<unsigned int, Cell*>::const_iterator it = this->copies.find(cell);
+        if (it != this->copies.end())
+          return *it->second;
+        const FrozenCell& frozen = this->layout.getCell(cell);
+        Cell& copy = this->target.createCell(this->uniqueName(frozen.cellname));
+        this->copies.insert(std::make_pair(cell, &copy));
+        for (std::size_t i = 0; i < frozen.polygons.size(); i++)
+          copy.emplacePolygon(frozen.polygons[i].vertices, frozen.polygons[i].layer,
+                              frozen.polygons[i].dataType);
+        for (std::size_t i = 0; i < frozen.paths.size(); i++)
+          copy.emplacePath(frozen.paths[i].points, frozen.paths[i].width, frozen.paths[i].pathType,
+                           frozen.paths[i].layer, frozen.paths[i].dataType);
+        for (std::size_t i = 0; i < frozen.references.size(); i++) {
+          const FrozenReference& ref = frozen.references[i];
+          addReference(copy, this->copyCell(ref.cell),
+                       utils::Transform(ref.magnification, ref.rotation, ref.position),
+                       ref.magnification, ref.rotation);
+        }
+        for (std::size_t i = 0; i < frozen.arrays.size(); i++) {
+          const FrozenArray& array = frozen.arrays[i];
+          CellArray element(this->copyCell(array.cell), array.startingPos, array.numCol,
+                            array.numRow, array.xSpacing, array.ySpacing);
+          element.setMagnification(array.magnification);
+          element.setRotation(array.rotation);
+          copy.addCellArray(element);
+        }
+        return copy;
+      }
+
+      /// \brief Copies the part of @cell in @window, in the coordinates
+      /// of @cell, into @out, keeping the hierarchy.
+      void clipInto(Cell& out, unsigned int cell, const Bounds& window) {
+        const FrozenCell& frozen = this->layout.getCell(cell);
+        std::size_t numPolygons = frozen.polygons.size(), numPaths = frozen.paths.size();
+        std::size_t numReferences = frozen.references.size();
+        std::vector<unsigned int> elements = this->query(cell, window);
+        for (std::size_t e = 0; e < elements.size(); e++) {
+          std::size_t id = elements[e];
+          if (id < numPolygons) {
+            const FrozenPolygon& polygon = frozen.polygons[id];
+            if (window.contains(polygon.bounds))
+              out.emplacePolygon(polygon.vertices, polygon.layer, polygon.dataType);
+            else
+              this->addClipped(out, polygon.vertices, polygon.shapeClass & Polygon::CONVEX,
+                               polygon.layer, polygon.dataType, window);
+          } else if ((id -= numPolygons) < numPaths) {
+            const FrozenPath& path = frozen.paths[id];
+            if (window.contains(path.bounds))
+              out.emplacePath(path.points, path.width, path.pathType, path.layer, path.dataType);
+            else
+              this->addClippedPath(out, path, utils::Transform(), window);
+          } else if ((id -= numPaths) < numReferences) {
+            const FrozenReference& ref = frozen.references[id];
+            utils::Transform transform(ref.magnification, ref.rotation, ref.position);
+            Bounds extent = transform.apply(this->layout.getCell(ref.cell).extent);
+            if (window.contains(extent))
+              addReference(out, this->copyCell(ref.cell), transform, ref.magnification, ref.rotation);
+            else
+              this->addStraddling(out, ref.cell, transform, ref.magnification, ref.rotation, window);
+          } else {
+            const FrozenArray& array = frozen.arrays[id - numReferences];
+            Bounds first = elementTransform(array, 0, 0).apply(this->layout.getCell(array.cell).extent);
+            int col0, col1, row0, row1;
+            if (!utils::latticeRange(first.minX, first.maxX, array.xSpacing, array.numCol,
+                                     window.minX, window.maxX, false, col0, col1) ||
+                !utils::latticeRange(first.minY, first.maxY, array.ySpacing, array.numRow,
+                                     window.minY, window.maxY, false, row0, row1))
+              continue;
+            // the elements inside form a block, the rest of the range straddles
+            int inCol0 = 0, inCol1 = -1, inRow0 = 0, inRow1 = -1;
+            if (utils::latticeRange(first.minX, first.maxX, array.xSpacing, array.numCol,
+                                    window.minX, window.maxX, true, inCol0, inCol1) &&
+                utils::latticeRange(first.minY, first.maxY, array.ySpacing, array.numRow,
+                                    window.minY, window.maxY, true, inRow0, inRow1)) {
+              Cell& copy = this->copyCell(array.cell);
+              utils::Transform corner = elementTransform(array, inCol0, inRow0);
+              if (inCol0 == inCol1 && inRow0 == inRow1)
+                addReference(out, copy, corner, array.magnification, array.rotation);
+              else {
+                CellArray block(copy, CoordPnt(corner.dx, corner.dy), inCol1 - inCol0 + 1,
+                                inRow1 - inRow0 + 1, array.xSpacing, array.ySpacing);
+                block.setMagnification(array.magnification);
+                block.setRotation(array.rotation);
+                out.addCellArray(block);
+              }
+            } else {
+              inCol0 = inRow0 = 0;
+              inCol1 = inRow1 = -1;
+            }
+            for (int col = col0; col <= col1; col++)
+              for (int row = row0; row <= row1; row++)
+                if (col < inCol0 || col > inCol1 || row < inRow0 || row > inRow1)
+                  this->addStraddling(out, array.cell, elementTransform(array, col, row),
+                                      array.magnification, array.rotation, window);
+          }
+        }
+      }
+
+      /// \brief Copies the shapes of @cell, mapped by @transform, that lie
+      /// in @window into @out.
+      void flattenInto(Cell& out, unsigned int cell, const utils::Transform& transform,
+                       const Bounds& window) {
+        const FrozenCell& frozen = this->layout.getCell(cell);
+        std::size_t numPolygons = frozen.polygons.size(), numPaths = frozen.paths.size();
+        std::size_t numReferences = frozen.references.size();
+        Bounds local = transform.invert(window);
+        double magnification = std::hypot(transform.a, transform.b);
+        std::vector<unsigned int> elements = this->query(cell, local);
+        std::vector<CoordPnt> mapped;
+        for (std::size_t e = 0; e < elements.size(); e++) {
+          std::size_t id = elements[e];
+          if (id < numPolygons) {
+            const FrozenPolygon& polygon = frozen.polygons[id];
+            mapped.clear();
+            Bounds box;
+            for (std::size_t i = 0; i < polygon.vertices.size(); i++) {
+              mapped.push_back(transform.apply(polygon.vertices[i]));
+              box.add(mapped.back());
+            }
+            if (window.contains(box))
+              out.emplacePolygon(Span<const CoordPnt>(mapped), polygon.layer, polygon.dataType);
+            else if (box.intersects(window))
+              this->addClipped(out, Span<const CoordPnt>(mapped), polygon.shapeClass & Polygon::CONVEX,
+                               polygon.layer, polygon.dataType, window);
+          } else if ((id -= numPolygons) < numPaths) {
+            const FrozenPath& path = frozen.paths[id];
+            if (window.contains(transform.apply(path.bounds))) {
+              mapped.clear();
+              for (std::size_t i = 0; i < path.points.size(); i++)
+                mapped.push_back(transform.apply(path.points[i]));
+              out.emplacePath(Span<const CoordPnt>(mapped), path.width*magnification,
+                              path.pathType, path.layer, path.dataType);
+            } else
+              this->addClippedPath(out, path, transform, window);
+          } else if ((id -= numPaths) < numReferences) {
+            const FrozenReference& ref = frozen.references[id];
+            this->flattenInto(out, ref.cell, transform.after(
+                utils::Transform(ref.magnification, ref.rotation, ref.position)), window);
+          } else {
+            const FrozenArray& array = frozen.arrays[id - numReferences];
+            Bounds first = elementTransform(array, 0, 0).apply(this->layout.getCell(array.cell).extent);
+            int col0, col1, row0, row1;
+            if (utils::latticeRange(first.minX, first.maxX, array.xSpacing, array.numCol,
+                                    local.minX, local.maxX, false, col0, col1) &&
+                utils::latticeRange(first.minY, first.maxY, array.ySpacing, array.numRow,
+                                    local.minY, local.maxY, false, row0, row1))
+              for (int col = col0; col <= col1; col++)
+                for (int row = row0; row <= row1; row++)
+                  this->flattenInto(out, array.cell,
+                                    transform.after(elementTransform(array, col, row)), window);
+          }
+        }
+      }
+
+      /// \brief Returns a new, empty Cell named after @cell.
+      Cell& createTop(unsigned int cell) {
+        return this->target.createCell(this->uniqueName(this->layout.getCell(cell).cellname));
+      }
+    };
+
+  } // namespace
+
+  RegionExtractor::RegionExtractor(const Layout& layout) : layout(layout.freeze()) {
+    this->buildIndices();
+  }
+
+  RegionExtractor::RegionExtractor(std::shared_ptr<const FrozenLayout> frozen) : layout(frozen) {
+    this->buildIndices();
+  }
+
+  void RegionExtractor::buildIndices() {
+    const FrozenLayout& frozen = *this->layout;
+    this->indices.resize(frozen.getCellCount());
+    utils::parallelFor(frozen.getCellCount(), [&](std::size_t i) {
+        const FrozenCell& cell = frozen.getCell(i);
+        std::vector<Bounds> boxes;
+        boxes.reserve(cell.polygons.size() + cell.paths.size() + cell.references.size() +
+                      cell.arrays.size());
+        for (std::size_t j = 0; j < cell.polygons.size(); j++)
+          boxes.push_back(cell.polygons[j].bounds);
+        for (std::size_t j = 0; j < cell.paths.size(); j++)
+          boxes.push_back(cell.paths[j].bounds);
+        for (std::size_t j = 0; j < cell.references.size(); j++) {
+          const FrozenReference& ref = cell.references[j];
+          boxes.push_back(utils::Transform(ref.magnification, ref.rotation, ref.position)
+                          .apply(frozen.getCell(ref.cell).extent));
+        }
+        for (std::size_t j = 0; j < cell.arrays.size(); j++) {
+          const FrozenArray& array = cell.arrays[j];
+          const Bounds& extent = frozen.getCell(array.cell).extent;
+          Bounds lattice = elementTransform(array, 0, 0).apply(extent);
+          lattice.add(elementTransform(array, array.numCol - 1, array.numRow - 1).apply(extent));
+          boxes.push_back(lattice);
+        }
+        this->indices[i] = SpatialIndex(boxes);
+      });
+  }
+
+  const FrozenLayout& RegionExtractor::getLayout() const {
+    return *this->layout;
+  }
+
+  Cell& RegionExtractor::extract(std::size_t cell, const Bounds& window, Layout& target,
+                                 RegionExtractionOptions options) const {
+    if (window.isEmpty()) {
+      std::stringstream errorMsg;
+      errorMsg << "The window [" << window.minX << ", " << window.maxX << "] x ["
+               << window.minY << ", " << window.maxY << "] is empty.";
+      throw std::invalid_argument(errorMsg.str());
+    }
+    this->layout->getCell(cell); // throws if there is no such cell
+    // the shapes are copied as they are, valid or not
+    DeferredValidation deferred;
+    Extraction extraction(*this->layout, this->indices, target);
+    Cell& top = extraction.createTop(cell);
+    if (options.flatten)
+      extraction.flattenInto(top, cell, utils::Transform(), window);
+    else
+      extraction.clipInto(top, cell, window);
+    return top;
+  }
+
+  Cell& extractRegion(const Cell& cell, const Bounds& window, Layout& target,
+                      RegionExtractionOptions options) {
+    RegionExtractor extractor(FrozenLayout::freeze(cell));
+    return extractor.extract(0, window, target, options);
+  }
+
+}
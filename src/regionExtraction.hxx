@@ -0,0 +1,105 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef REGION_EXTRACTION_HXX
+#define REGION_EXTRACTION_HXX
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "cell.hxx"
+#include "frozenLayout.hxx"
+#include "layout.hxx"
+#include "spatialIndex.hxx"
+
+namespace sil {
+
+  /// \brief The settings used by RegionExtractor::extract().
+  struct RegionExtractionOptions {
+    /// \brief If true every shape in the window is copied into the new
+    /// top cell, otherwise the hierarchy is kept where possible.
+    bool flatten;
+
+    /// \brief Sets the defaults: the hierarchy is kept.
+    RegionExtractionOptions(void);
+  };
+
+  /// class RegionExtractor
+  ///
+  /// \brief Cuts windows out of the cells of a layout into new layouts.
+  ///
+  /// The constructor indexes the elements of every Cell (polygons,
+  /// paths, references and arrays) in a SpatialIndex, in parallel, so
+  /// each extraction afterwards only visits what overlaps its window.
+  /// The extractor keeps a frozen copy of the layout and may be used by
+  /// several threads at once.
+  class RegionExtractor {
+  private:
+    std::shared_ptr<const FrozenLayout> layout;
+    std::vector<SpatialIndex> indices; //!< The elements of each Cell.
+
+    /// \brief Builds @indices.
+    void buildIndices(void);
+
+  public:
+    /// \brief Freezes and indexes @layout.
+    explicit RegionExtractor(const Layout& layout);
+
+    /// \brief Indexes the frozen layout @frozen.
+    explicit RegionExtractor(std::shared_ptr<const FrozenLayout> frozen);
+
+    /// \brief Returns the frozen layout the extractor reads.
+    const FrozenLayout& getLayout(void) const;
+
+    /// \brief Copies the part of @cell that lies in @window into @target
+    /// and returns the new top Cell.
+    ///
+    /// @cell The index of the Cell in getLayout().
+    /// @window The window, in the coordinates of @cell.
+    /// @target The Layout the new cells are created in.
+    /// @options The settings of the extraction.
+    ///
+    /// Polygons and paths inside the window are copied and those that
+    /// straddle its border are clipped: convex polygons with a convex
+    /// window clipper, other polygons with a scanline sweep into
+    /// trapezoids, and paths as one clipped polygon per segment.
+    /// References and array elements that lie inside the window keep
+    /// pointing at a copy of their Cell (arrays are cut down to the
+    /// elements inside). Those that straddle it point at a clipped copy
+    /// of their Cell, which is shared by every placement that clips it
+    /// the same way, or have their shapes copied into the placing Cell
+    /// if they are rotated by other than a multiple of 90 degrees.
+    /// Everything else is dropped, so @target only receives the cells
+    /// the window needs. Cells keep their names; clipped copies and
+    /// cells whose name is already taken in @target get a suffix.
+    /// Throws std::invalid_argument if @window is empty and
+    /// std::out_of_range if there is no Cell @cell.
+    Cell& extract(std::size_t cell, const Bounds& window, Layout& target,
+                  RegionExtractionOptions options = RegionExtractionOptions()) const;
+  };
+
+  /// \brief Copies the part of @cell in @window into @target, see
+  /// RegionExtractor::extract().
+  ///
+  /// This indexes all of @cell's hierarchy first; use a RegionExtractor
+  /// to cut several windows out of the same cell.
+  Cell& extractRegion(const Cell& cell, const Bounds& window, Layout& target,
+                      RegionExtractionOptions options = RegionExtractionOptions());
+
+}
+
+#endif // REGION_EXTRACTION_HXX
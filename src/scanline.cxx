@@ -0,0 +1,443 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "scanline.hxx"
+#include "geometry.hxx"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace sil {
+
+  double Trapezoid::getArea() const {
+    return (this->bottomRight - this->bottomLeft + this->topRight - this->topLeft)*
+      (this->top - this->bottom)/2;
+  }
+
+  std::vector<CoordPnt> Trapezoid::getVertices() const {
+    std::vector<CoordPnt> corners;
+    corners.push_back(CoordPnt(this->bottomLeft, this->bottom));
+    if (this->bottomRight != this->bottomLeft)
+      corners.push_back(CoordPnt(this->bottomRight, this->bottom));
+    corners.push_back(CoordPnt(this->topRight, this->top));
+    if (this->topLeft != this->topRight)
+      corners.push_back(CoordPnt(this->topLeft, this->top));
+    return corners;
+  }
+
+  namespace utils {
+
+    namespace {
+
+      /// \brief An edge crossing the current stretch of the sweep.
+      struct ActiveEdge {
+        unsigned int edge; //!< The index of the edge.
+        double from; //!< The x coordinate at the bottom of the stretch.
+        double to; //!< The x coordinate at the top of the stretch.
+      };
+
+      /// \brief A trapezoid that is still growing upwards.
+      struct OpenTrapezoid {
+        unsigned int left; //!< The edge on its left.
+        unsigned int right; //!< The edge on its right.
+        double bottom; //!< Where it started.
+      };
+
+      bool holds(SweepOperation operation, bool insideA, bool insideB) {
+        switch (operation) {
+        case SWEEP_UNION: return insideA || insideB;
+        case SWEEP_INTERSECTION: return insideA && insideB;
+        case SWEEP_DIFFERENCE: return insideA && !insideB;
+        default: return insideA != insideB;
+        }
+      }
+
+      /// \brief A piece of an outline, with the covered area on its left.
+      struct OutlineEdge {
+        CoordPnt from;
+        CoordPnt to;
+      };
+
+      /// \brief Where the bottoms or tops of trapezoids at a height begin
+      /// or end.
+      struct OutlineBreak {
+        double y;
+        double x;
+        int bottoms; //!< +1 where a bottom begins, -1 where it ends.
+        int tops; //!< The same for tops.
+      };
+
+      bool pointLess(const CoordPnt& a, const CoordPnt& b) {
+        return a.getY() < b.getY() || (a.getY() == b.getY() && a.getX() < b.getX());
+      }
+
+      bool samePoint(const CoordPnt& a, const CoordPnt& b) {
+        return a.getX() == b.getX() && a.getY() == b.getY();
+      }
+
+      /// \brief Returns the angle from @back clockwise to @out, in (0, 2pi].
+      double clockwiseAngle(double backX, double backY, double outX, double outY) {
+        const double fullTurn = 2*std::acos(-1.);
+        double angle = std::atan2(backY, backX) - std::atan2(outY, outX);
+        while (angle <= 0)
+          angle += fullTurn;
+        while (angle > fullTurn)
+          angle -= fullTurn;
+        return angle;
+      }
+
+      /// \brief Drops the corners of @outline that repeat their
+      /// predecessor, up to rounding, or lie on a straight line.
+      void dropStraightCorners(std::vector<CoordPnt>& outline) {
+        bool changed = true;
+        while (changed && outline.size() >= 3) {
+          changed = false;
+          std::vector<CoordPnt> kept;
+          kept.reserve(outline.size());
+          std::size_t n = outline.size();
+          for (std::size_t i = 0; i < n; i++) {
+            const CoordPnt& prev = kept.empty() ? outline[n - 1] : kept.back();
+            const CoordPnt& here = outline[i];
+            const CoordPnt& next = outline[(i + 1)%n];
+            double inX = here.getX() - prev.getX(), inY = here.getY() - prev.getY();
+            double outX = next.getX() - here.getX(), outY = next.getY() - here.getY();
+            double slack = 1e-12*(std::abs(here.getX()) + std::abs(here.getY()));
+            bool repeated = std::hypot(inX, inY) <= slack;
+            bool straight = std::abs(inX*outY - inY*outX) <=
+              1e-12*std::hypot(inX, inY)*std::hypot(outX, outY) && inX*outX + inY*outY > 0;
+            if (repeated || straight)
+              changed = true;
+            else
+              kept.push_back(here);
+          }
+          outline.swap(kept);
+        }
+      }
+
+    } // namespace
+
+    double ScanlineSweep::xAt(const Edge& edge, double y) {
+      if (y <= edge.lower.getY())
+        return edge.lower.getX();
+      if (y >= edge.upper.getY())
+        return edge.upper.getX();
+      return edge.lower.getX() + (y - edge.lower.getY())*(edge.upper.getX() - edge.lower.getX())/
+        (edge.upper.getY() - edge.lower.getY());
+    }
+
+    void ScanlineSweep::addPolygon(Span<const CoordPnt> vertices, unsigned int operand) {
+      if (operand > 1) {
+        std::stringstream errorMsg;
+        errorMsg << "A sweep has the operands 0 and 1, not " << operand << ".";
+        throw std::invalid_argument(errorMsg.str());
+      }
+      // counterclockwise, the edges going down are on the left
+      int down = signedArea(vertices) < 0 ? -1 : 1;
+      std::size_t n = vertices.size();
+      for (std::size_t i = 0; i < n; i++) {
+        const CoordPnt& from = vertices[i];
+        const CoordPnt& to = vertices[(i + 1)%n];
+        if (from.getY() == to.getY())
+          continue;
+        Edge edge;
+        bool up = to.getY() > from.getY();
+        edge.lower = up ? from : to;
+        edge.upper = up ? to : from;
+        edge.winding = up ? -down : down;
+        edge.operand = operand;
+        this->edges.push_back(edge);
+      }
+    }
+
+    std::size_t ScanlineSweep::getEdgeCount() const {
+      return this->edges.size();
+    }
+
+    void ScanlineSweep::clear() {
+      this->edges.clear();
+    }
+
+    void ScanlineSweep::sweep(SweepOperation operation, std::vector<Trapezoid>& result) const {
+      if (this->edges.empty())
+        return;
+      std::vector<unsigned int> byLower(this->edges.size());
+      std::vector<double> stops;
+      stops.reserve(2*this->edges.size());
+      for (std::size_t i = 0; i < this->edges.size(); i++) {
+        byLower[i] = i;
+        stops.push_back(this->edges[i].lower.getY());
+        stops.push_back(this->edges[i].upper.getY());
+      }
+      std::sort(byLower.begin(), byLower.end(), [this](unsigned int a, unsigned int b) {
+          return this->edges[a].lower.getY() < this->edges[b].lower.getY();
+        });
+      std::sort(stops.begin(), stops.end());
+      stops.erase(std::unique(stops.begin(), stops.end()), stops.end());
+
+      const unsigned int NONE = UINT_MAX;
+      std::vector<ActiveEdge> active;
+      std::vector<OpenTrapezoid> open, stillOpen;
+      std::vector<unsigned int> openByLeft(this->edges.size(), NONE);
+      std::vector<char> extended;
+      std::size_t nextEdge = 0, stop = 0;
+      double y0 = stops[0];
+      while (true) {
+        double target = stop + 1 < stops.size() ? stops[stop + 1] : y0;
+        // update the active edges and bring them into order at y0
+        active.erase(std::remove_if(active.begin(), active.end(), [&](const ActiveEdge& a) {
+              return this->edges[a.edge].upper.getY() <= y0;
+            }), active.end());
+        for (; nextEdge < byLower.size() && this->edges[byLower[nextEdge]].lower.getY() <= y0;
+             nextEdge++) {
+          ActiveEdge added = {byLower[nextEdge], 0, 0};
+          active.push_back(added);
+        }
+        for (std::size_t i = 0; i < active.size(); i++) {
+          active[i].from = xAt(this->edges[active[i].edge], y0);
+          active[i].to = xAt(this->edges[active[i].edge], target);
+        }
+        for (std::size_t i = 1; i < active.size(); i++) {
+          ActiveEdge moved = active[i];
+          std::size_t j = i;
+          for (; j > 0 && (active[j - 1].from > moved.from ||
+                           (active[j - 1].from == moved.from && active[j - 1].to > moved.to)); j--)
+            active[j] = active[j - 1];
+          active[j] = moved;
+        }
+        // the first crossing is between neighbours, stop there; edges
+        // that meet at y0 itself but round into the wrong order swap
+        double y1 = target;
+        bool swapped = true;
+        while (swapped) {
+          swapped = false;
+          y1 = target;
+          for (std::size_t i = 0; i + 1 < active.size(); i++)
+            if (active[i].to > active[i + 1].to) {
+              double gap = active[i + 1].from - active[i].from;
+              double t = gap/(gap - (active[i + 1].to - active[i].to));
+              double crossing = y0 + t*(target - y0);
+              if (crossing <= y0) {
+                std::swap(active[i], active[i + 1]);
+                swapped = true;
+              }
+              else if (crossing < y1)
+                y1 = crossing;
+            }
+        }
+
+        // extend the trapezoids that keep their edges, close the others
+        stillOpen.clear();
+        extended.assign(open.size(), 0);
+        if (y1 > y0) {
+          int count[2] = {0, 0};
+          bool inside = false;
+          unsigned int left = NONE;
+          for (std::size_t i = 0; i < active.size(); i++) {
+            const Edge& edge = this->edges[active[i].edge];
+            count[edge.operand] += edge.winding;
+            // coincident edges are crossed together, so no empty run starts between them
+            if (i + 1 < active.size() && active[i + 1].from == active[i].from &&
+                active[i + 1].to == active[i].to)
+              continue;
+            bool now = holds(operation, count[0] != 0, count[1] != 0);
+            if (now && !inside)
+              left = active[i].edge;
+            else if (!now && inside) {
+              unsigned int previous = openByLeft[left];
+              if (previous != NONE && open[previous].right == active[i].edge) {
+                extended[previous] = 1;
+                stillOpen.push_back(open[previous]);
+              } else {
+                OpenTrapezoid started = {left, active[i].edge, y0};
+                stillOpen.push_back(started);
+              }
+            }
+            inside = now;
+          }
+        }
+        for (std::size_t i = 0; i < open.size(); i++) {
+          openByLeft[open[i].left] = NONE;
+          if (extended[i])
+            continue;
+          const Edge& left = this->edges[open[i].left];
+          const Edge& right = this->edges[open[i].right];
+          Trapezoid closed = {open[i].bottom, y0, xAt(left, open[i].bottom),
+                              xAt(right, open[i].bottom), xAt(left, y0), xAt(right, y0)};
+          if (closed.bottomRight > closed.bottomLeft || closed.topRight > closed.topLeft)
+            result.push_back(closed);
+        }
+        open.swap(stillOpen);
+        for (std::size_t i = 0; i < open.size(); i++)
+          openByLeft[open[i].left] = i;
+        if (stop + 1 >= stops.size())
+          break;
+        y0 = y1;
+        if (y1 >= target)
+          stop++;
+      }
+    }
+
+    void traceOutlines(const std::vector<Trapezoid>& trapezoids,
+                       std::vector<std::vector<CoordPnt> >& result) {
+      // a sweep stops so close to some crossings that the trapezoids
+      // between are slivers that rounding may twist, so heights and
+      // then corners that close are welded and the slivers dropped
+      double scale = 0;
+      std::vector<double> heights;
+      heights.reserve(2*trapezoids.size());
+      for (std::size_t i = 0; i < trapezoids.size(); i++) {
+        const Trapezoid& figure = trapezoids[i];
+        heights.push_back(figure.bottom);
+        heights.push_back(figure.top);
+        scale = std::max(scale, std::max(std::abs(figure.bottom), std::abs(figure.top)));
+        scale = std::max(scale, std::max(std::abs(figure.bottomLeft), std::abs(figure.bottomRight)));
+        scale = std::max(scale, std::max(std::abs(figure.topLeft), std::abs(figure.topRight)));
+      }
+      double slack = 1e-12*scale;
+      std::sort(heights.begin(), heights.end());
+      heights.erase(std::unique(heights.begin(), heights.end()), heights.end());
+      std::vector<double> levels(heights.size());
+      for (std::size_t i = 0; i < heights.size(); i++)
+        levels[i] = i > 0 && heights[i] - levels[i - 1] <= slack ? levels[i - 1] : heights[i];
+      auto level = [&heights, &levels](double y) {
+        return levels[std::lower_bound(heights.begin(), heights.end(), y) - heights.begin()];
+      };
+
+      // the sides of the trapezoids are outline; bottoms and tops only
+      // where no other trapezoid continues them
+      std::vector<OutlineEdge> edges;
+      std::vector<OutlineBreak> breaks;
+      for (std::size_t i = 0; i < trapezoids.size(); i++) {
+        const Trapezoid& figure = trapezoids[i];
+        double bottom = level(figure.bottom), top = level(figure.top);
+        if (bottom == top)
+          continue;
+        OutlineEdge right = {CoordPnt(figure.bottomRight, bottom), CoordPnt(figure.topRight, top)};
+        OutlineEdge left = {CoordPnt(figure.topLeft, top), CoordPnt(figure.bottomLeft, bottom)};
+        edges.push_back(right);
+        edges.push_back(left);
+        if (figure.bottomRight > figure.bottomLeft) {
+          OutlineBreak begin = {bottom, figure.bottomLeft, 1, 0};
+          OutlineBreak end = {bottom, figure.bottomRight, -1, 0};
+          breaks.push_back(begin);
+          breaks.push_back(end);
+        }
+        if (figure.topRight > figure.topLeft) {
+          OutlineBreak begin = {top, figure.topLeft, 0, 1};
+          OutlineBreak end = {top, figure.topRight, 0, -1};
+          breaks.push_back(begin);
+          breaks.push_back(end);
+        }
+      }
+      std::sort(breaks.begin(), breaks.end(), [](const OutlineBreak& a, const OutlineBreak& b) {
+          return a.y < b.y || (a.y == b.y && a.x < b.x);
+        });
+      for (std::size_t i = 0; i < breaks.size();) {
+        int bottoms = 0, tops = 0;
+        double y = breaks[i].y;
+        while (i < breaks.size() && breaks[i].y == y) {
+          double x = breaks[i].x;
+          for (; i < breaks.size() && breaks[i].y == y && breaks[i].x == x; i++) {
+            bottoms += breaks[i].bottoms;
+            tops += breaks[i].tops;
+          }
+          if (i == breaks.size() || breaks[i].y != y)
+            break;
+          // covered above but not below runs right, the other way left
+          CoordPnt from(x, y), to(breaks[i].x, y);
+          if ((bottoms > 0) != (tops > 0)) {
+            OutlineEdge edge = {bottoms > 0 ? from : to, bottoms > 0 ? to : from};
+            edges.push_back(edge);
+          }
+        }
+      }
+
+      // trapezoids that meet where two edges cross see the crossing
+      // rounded differently
+      std::vector<CoordPnt> corners;
+      corners.reserve(2*edges.size());
+      for (std::size_t i = 0; i < edges.size(); i++) {
+        corners.push_back(edges[i].from);
+        corners.push_back(edges[i].to);
+      }
+      std::sort(corners.begin(), corners.end(), pointLess);
+      corners.erase(std::unique(corners.begin(), corners.end(), samePoint), corners.end());
+      std::vector<CoordPnt> welded(corners.size());
+      for (std::size_t i = 0; i < corners.size(); i++)
+        welded[i] = i > 0 && corners[i].getY() == corners[i - 1].getY() &&
+          corners[i].getX() - welded[i - 1].getX() <= slack ? welded[i - 1] : corners[i];
+      std::size_t kept = 0;
+      for (std::size_t i = 0; i < edges.size(); i++) {
+        OutlineEdge edge = edges[i];
+        edge.from = welded[std::lower_bound(corners.begin(), corners.end(), edge.from,
+                                            pointLess) - corners.begin()];
+        edge.to = welded[std::lower_bound(corners.begin(), corners.end(), edge.to,
+                                          pointLess) - corners.begin()];
+        if (!samePoint(edge.from, edge.to))
+          edges[kept++] = edge;
+      }
+      edges.resize(kept);
+
+      // follow the edges, turning into the covered area at shared corners
+      std::vector<unsigned int> byStart(edges.size());
+      for (std::size_t i = 0; i < edges.size(); i++)
+        byStart[i] = i;
+      std::sort(byStart.begin(), byStart.end(), [&edges](unsigned int a, unsigned int b) {
+          return pointLess(edges[a].from, edges[b].from);
+        });
+      std::vector<char> used(edges.size(), 0);
+      for (std::size_t s = 0; s < byStart.size(); s++) {
+        unsigned int first = byStart[s];
+        if (used[first])
+          continue;
+        std::vector<CoordPnt> outline;
+        unsigned int current = first;
+        while (true) {
+          used[current] = 1;
+          outline.push_back(edges[current].from);
+          const OutlineEdge& edge = edges[current];
+          std::vector<unsigned int>::const_iterator it =
+            std::lower_bound(byStart.begin(), byStart.end(), edge.to,
+                             [&edges](unsigned int a, const CoordPnt& p) {
+                               return pointLess(edges[a].from, p);
+                             });
+          unsigned int next = UINT_MAX;
+          double best = 0;
+          for (; it != byStart.end() && samePoint(edges[*it].from, edge.to); ++it) {
+            double angle = clockwiseAngle(edge.from.getX() - edge.to.getX(),
+                                          edge.from.getY() - edge.to.getY(),
+                                          edges[*it].to.getX() - edges[*it].from.getX(),
+                                          edges[*it].to.getY() - edges[*it].from.getY());
+            if (next == UINT_MAX || angle < best) {
+              next = *it;
+              best = angle;
+            }
+          }
+          if (next == UINT_MAX || used[next])
+            break;
+          current = next;
+        }
+        dropStraightCorners(outline);
+        if (outline.size() >= 3)
+          result.push_back(outline);
+      }
+    }
+
+  } // namespace utils
+} // namespace sil
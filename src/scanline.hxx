@@ -0,0 +1,117 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef SCANLINE_HXX
+#define SCANLINE_HXX
+
+#include <cstddef>
+#include <vector>
+#include "coord.hxx"
+#include "span.hxx"
+
+namespace sil {
+
+  /// \brief A trapezoid whose bottom and top are horizontal.
+  ///
+  /// Either of them may have zero length, which makes it a triangle.
+  struct Trapezoid {
+    double bottom; //!< The y coordinate of the bottom.
+    double top; //!< The y coordinate of the top.
+    double bottomLeft; //!< The x coordinate where the bottom starts.
+    double bottomRight; //!< The x coordinate where the bottom ends.
+    double topLeft; //!< The x coordinate where the top starts.
+    double topRight; //!< The x coordinate where the top ends.
+
+    /// \brief Returns the area of the trapezoid.
+    double getArea(void) const;
+
+    /// \brief Returns the corners counterclockwise from the bottom left,
+    /// leaving out the second corner of a side of zero length.
+    std::vector<CoordPnt> getVertices(void) const;
+  };
+
+  namespace utils {
+
+    /// \brief How a ScanlineSweep combines its two operands.
+    enum SweepOperation {
+      SWEEP_UNION, //!< Inside either operand.
+      SWEEP_INTERSECTION, //!< Inside both operands.
+      SWEEP_DIFFERENCE, //!< Inside operand 0 but not operand 1.
+      SWEEP_XOR //!< Inside exactly one operand.
+    };
+
+    /// class ScanlineSweep
+    ///
+    /// \brief Decomposes the boolean combination of two sets of polygons
+    /// into horizontal trapezoids with a scanline sweep.
+    ///
+    /// Each polygon is oriented counterclockwise when it is added, so a
+    /// point is inside an operand if it lies inside any of its polygons
+    /// (the nonzero winding rule). The sweep stops at every vertex and at
+    /// every crossing of two edges; between two stops no edges cross,
+    /// and every run of the active edges over which the operation holds
+    /// becomes a trapezoid. Coincident edges are crossed together, so
+    /// polygons that share an edge are not cut apart along it. A
+    /// trapezoid is carried on to the next stop as long as it keeps the
+    /// same pair of edges, so rectangles come out whole. The active edges
+    /// stay sorted from one stop to the next, which makes a stop cost
+    /// time linear in the number of edges it crosses.
+    class ScanlineSweep {
+    private:
+      struct Edge {
+        CoordPnt lower; //!< The end with the smaller y.
+        CoordPnt upper; //!< The end with the larger y.
+        int winding; //!< Added to the count when crossed left to right.
+        unsigned int operand; //!< 0 or 1.
+      };
+
+      std::vector<Edge> edges; //!< Every edge that is not horizontal.
+
+      /// \brief Returns the x coordinate of @edge at @y.
+      static double xAt(const Edge& edge, double y);
+
+    public:
+      /// \brief Adds the polygon @vertices to @operand (0 or 1).
+      ///
+      /// Throws std::invalid_argument if @operand is not 0 or 1.
+      void addPolygon(Span<const CoordPnt> vertices, unsigned int operand);
+
+      /// \brief Returns the number of edges added so far.
+      std::size_t getEdgeCount(void) const;
+
+      /// \brief Removes every polygon.
+      void clear(void);
+
+      /// \brief Appends the trapezoids that cover the area where
+      /// @operation holds to @result.
+      void sweep(SweepOperation operation, std::vector<Trapezoid>& result) const;
+    };
+
+    /// \brief Appends the outlines of the area covered by @trapezoids,
+    /// which must not overlap (like the result of a sweep), to @result.
+    ///
+    /// Every outline keeps the covered area on its left, so outer
+    /// outlines run counterclockwise and those of holes clockwise.
+    /// Outlines that touch at a corner are kept apart, and corners
+    /// between collinear edges are left out.
+    void traceOutlines(const std::vector<Trapezoid>& trapezoids,
+                       std::vector<std::vector<CoordPnt> >& result);
+
+  } // namespace utils
+} // namespace sil
+
+#endif // SCANLINE_HXX
@@ -32,5 +32,29 @@
 #include "layout.hxx"
 #include "path.hxx" 
 #include "square.hxx"
+#include "arrayDetection.hxx"
+#include "contentHash.hxx"
+#include "cellGraph.hxx"
+#include "deduplication.hxx"
+#include "snapshot.hxx"
+#include "arena.hxx"
+#include "span.hxx"
+#include "smallVector.hxx"
+#include "validation.hxx"
+#include "cellShards.hxx"
+#include "threadPool.hxx"
+#include "frozenLayout.hxx"
+#include "spatialIndex.hxx"
+#include "designRules.hxx"
+#include "connectivity.hxx"
+#include "scanline.hxx"
+#include "layoutDiff.hxx"
+#include "regionExtraction.hxx"
+#include "raster.hxx"
+#include "tilePyramid.hxx"
+#include "svgExport.hxx"
+#include "fracture.hxx"
+#include "triangulation.hxx"
+#include "simplification.hxx"
 
 #endif // SILHOUETTE_HXX
@@ -0,0 +1,513 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "simplification.hxx"
+#include "parallel.hxx"
+#include "validation.hxx"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+
+namespace sil {
+
+  SimplificationOptions::SimplificationOptions() : grid(1e-3), tolerance(0) {}
+
+  namespace {
+
+    /// \brief The number of shapes simplified by one task.
+    const std::size_t JOBS_PER_BLOCK = 256;
+
+    /// \brief Coordinate differences (in grid units) from which the
+    /// integer tests could overflow. GDSII coordinates are 32 bit
+    /// integers, so this is never reached by shapes that can be written.
+    const long long UNIT_LIMIT = 1LL << 31;
+
+    /// \brief A vertex, in grid units or in user units, and the index
+    /// of the original vertex it came from.
+    template <typename T>
+    struct Vertex {
+      T x;
+      T y;
+      std::size_t index;
+    };
+
+    struct Point {
+      double x;
+      double y;
+    };
+
+    template <typename T>
+    bool same(const Vertex<T>& a, const Vertex<T>& b) {
+      return a.x == b.x && a.y == b.y;
+    }
+
+    /// \brief Returns true if @a, @b and @c lie on one line, or false
+    /// if that cannot be decided exactly.
+    bool onLine(const Vertex<long long>& a, const Vertex<long long>& b,
+                const Vertex<long long>& c) {
+      long long ux = b.x - a.x, uy = b.y - a.y, vx = c.x - b.x, vy = c.y - b.y;
+      if (std::llabs(ux) >= UNIT_LIMIT || std::llabs(uy) >= UNIT_LIMIT ||
+          std::llabs(vx) >= UNIT_LIMIT || std::llabs(vy) >= UNIT_LIMIT)
+        return false;
+      return ux*vy == uy*vx;
+    }
+
+    bool onLine(const Vertex<double>& a, const Vertex<double>& b, const Vertex<double>& c) {
+      return (b.x - a.x)*(c.y - b.y) == (b.y - a.y)*(c.x - b.x);
+    }
+
+    /// \brief Returns true if @b lies on the straight edge from @a to
+    /// @c, so leaving it out does not change the outline.
+    template <typename T>
+    bool straight(const Vertex<T>& a, const Vertex<T>& b, const Vertex<T>& c) {
+      return onLine(a, b, c) && (b.x - a.x)*(c.x - b.x) + (b.y - a.y)*(c.y - b.y) > 0;
+    }
+
+    /// \brief Removes repeated vertices and vertices on straight edges
+    /// from @vertices, keeping the ends of an open path.
+    template <typename T>
+    void removeRedundant(std::vector<Vertex<T>>& vertices, bool closed) {
+      std::size_t count = 0;
+      for (std::size_t i = 0; i < vertices.size(); i++) {
+        Vertex<T> vertex = vertices[i];
+        if (count > 0 && same(vertices[count - 1], vertex))
+          continue;
+        while (count >= 2 && straight(vertices[count - 2], vertices[count - 1], vertex))
+          count--;
+        vertices[count++] = vertex;
+      }
+      vertices.resize(count);
+      if (!closed) {
+        if (count == 1)
+          vertices.push_back(vertices[0]);
+        return;
+      }
+      // the seam where the outline closes
+      std::size_t first = 0;
+      while (vertices.size() - first >= 3) {
+        const Vertex<T>& last = vertices.back();
+        if (same(last, vertices[first]) ||
+            straight(vertices[vertices.size() - 2], last, vertices[first]))
+          vertices.pop_back();
+        else if (straight(last, vertices[first], vertices[first + 1]))
+          first++;
+        else
+          break;
+      }
+      vertices.erase(vertices.begin(), vertices.begin() + first);
+    }
+
+    /// \brief Returns true if @vertices enclose no area.
+    template <typename T>
+    bool collapsed(const std::vector<Vertex<T>>& vertices) {
+      if (vertices.size() < 3)
+        return true;
+      for (std::size_t i = 2; i < vertices.size(); i++)
+        if (!onLine(vertices[0], vertices[1], vertices[i]))
+          return false;
+      return true;
+    }
+
+    double orientation(const Point& a, const Point& b, const Point& c) {
+      return (b.x - a.x)*(c.y - a.y) - (b.y - a.y)*(c.x - a.x);
+    }
+
+    int sign(double value) {
+      return (value > 0) - (value < 0);
+    }
+
+    /// \brief Returns the distance from @pnt to the segment from @a to
+    /// @b.
+    double segmentDistance(const Point& pnt, const Point& a, const Point& b) {
+      double dx = b.x - a.x, dy = b.y - a.y;
+      double length = dx*dx + dy*dy;
+      double t = length > 0 ? ((pnt.x - a.x)*dx + (pnt.y - a.y)*dy)/length : 0;
+      t = std::min(1., std::max(0., t));
+      return std::hypot(pnt.x - a.x - t*dx, pnt.y - a.y - t*dy);
+    }
+
+    /// \brief Simplifies the points of shapes one after another, reusing
+    /// its buffers.
+    class Simplifier {
+    private:
+      const SimplificationOptions& options;
+      std::vector<Vertex<long long>> units;
+      std::vector<Vertex<double>> exact;
+      std::vector<std::size_t> origin; //!< The original index of every remaining vertex.
+      std::vector<Point> points; //!< The remaining vertices, snapped.
+      std::vector<char> kept; //!< Whether Douglas-Peucker keeps each remaining vertex.
+      std::vector<std::pair<std::size_t, std::size_t>> ranges;
+      std::vector<std::size_t> ring; //!< The kept vertices.
+      std::vector<std::size_t> bySegment;
+      std::vector<char> crossed;
+
+      /// \brief Returns the vertex of @points strictly between @first
+      /// and @last (counted around the outline) furthest from the edge
+      /// between them, and that distance.
+      std::pair<std::size_t, double> furthest(std::size_t first, std::size_t last) const {
+        std::size_t n = this->points.size();
+        const Point& a = this->points[first%n];
+        const Point& b = this->points[last%n];
+        std::pair<std::size_t, double> result(first, -1.);
+        for (std::size_t i = first + 1; i < last; i++) {
+          double distance = segmentDistance(this->points[i%n], a, b);
+          if (distance > result.second)
+            result = std::make_pair(i, distance);
+        }
+        return result;
+      }
+
+      /// \brief Keeps the vertices Douglas-Peucker needs between
+      /// @first and @last, which are kept.
+      void thin(std::size_t first, std::size_t last) {
+        this->ranges.clear();
+        this->ranges.push_back(std::make_pair(first, last));
+        while (!this->ranges.empty()) {
+          std::pair<std::size_t, std::size_t> range = this->ranges.back();
+          this->ranges.pop_back();
+          if (range.second - range.first < 2)
+            continue;
+          std::pair<std::size_t, double> split = this->furthest(range.first, range.second);
+          if (split.second <= this->options.tolerance)
+            continue;
+          this->kept[split.first%this->points.size()] = 1;
+          this->ranges.push_back(std::make_pair(range.first, split.first));
+          this->ranges.push_back(std::make_pair(split.first, range.second));
+        }
+      }
+
+      /// \brief Marks the edges of @ring that touch another edge that
+      /// is not next to them in @crossed, returning how many there are.
+      std::size_t findCrossings(void) {
+        std::size_t m = this->ring.size();
+        this->crossed.assign(m, 0);
+        this->bySegment.resize(m);
+        for (std::size_t s = 0; s < m; s++)
+          this->bySegment[s] = s;
+        const std::vector<Point>& pnts = this->points;
+        const std::vector<std::size_t>& ring = this->ring;
+        auto minX = [&](std::size_t s) {
+          return std::min(pnts[ring[s]].x, pnts[ring[(s + 1)%m]].x);
+        };
+        std::sort(this->bySegment.begin(), this->bySegment.end(),
+                  [&](std::size_t a, std::size_t b) { return minX(a) < minX(b); });
+        std::size_t found = 0;
+        // sweep over x, comparing the edges whose x ranges overlap
+        for (std::size_t i = 0; i < m; i++) {
+          std::size_t s = this->bySegment[i];
+          const Point& a = pnts[ring[s]];
+          const Point& b = pnts[ring[(s + 1)%m]];
+          double maxX = std::max(a.x, b.x);
+          for (std::size_t j = i + 1; j < m && minX(this->bySegment[j]) <= maxX; j++) {
+            std::size_t t = this->bySegment[j];
+            if (t == (s + 1)%m || s == (t + 1)%m)
+              continue;
+            const Point& c = pnts[ring[t]];
+            const Point& d = pnts[ring[(t + 1)%m]];
+            if (std::max(c.y, d.y) < std::min(a.y, b.y) || std::max(a.y, b.y) < std::min(c.y, d.y))
+              continue;
+            if (sign(orientation(a, b, c))*sign(orientation(a, b, d)) <= 0 &&
+                sign(orientation(c, d, a))*sign(orientation(c, d, b)) <= 0) {
+              found += !this->crossed[s] + !this->crossed[t];
+              this->crossed[s] = 1;
+              this->crossed[t] = 1;
+            }
+          }
+        }
+        return found;
+      }
+
+      /// \brief Thins out the closed outline in @points.
+      void thinOutline(void) {
+        std::size_t n = this->points.size();
+        this->kept.assign(n, 0);
+        // start from two vertices that any simplification keeps
+        std::size_t first = 0;
+        for (std::size_t i = 1; i < n; i++)
+          if (this->points[i].x < this->points[first].x ||
+              (this->points[i].x == this->points[first].x &&
+               this->points[i].y < this->points[first].y))
+            first = i;
+        std::size_t second = first;
+        double distance = -1;
+        for (std::size_t i = 0; i < n; i++) {
+          const Point& pnt = this->points[i];
+          double d = std::hypot(pnt.x - this->points[first].x, pnt.y - this->points[first].y);
+          if (d > distance) {
+            distance = d;
+            second = i;
+          }
+        }
+        this->kept[first] = 1;
+        this->kept[second] = 1;
+        std::size_t end = second > first ? second : second + n;
+        this->thin(first, end);
+        this->thin(end, first + n);
+
+        // refine the edges that touch other edges until none do
+        for (;;) {
+          this->ring.clear();
+          for (std::size_t i = 0; i < n; i++)
+            if (this->kept[i])
+              this->ring.push_back(i);
+          std::size_t m = this->ring.size();
+          if (m < 3 || this->findCrossings() == 0)
+            break;
+          bool refined = false;
+          for (std::size_t s = 0; s < m; s++) {
+            std::size_t from = this->ring[s];
+            std::size_t to = s + 1 < m ? this->ring[s + 1] : this->ring[0] + n;
+            if (this->crossed[s] && to - from > 1) {
+              this->kept[this->furthest(from, to).first%n] = 1;
+              refined = true;
+            }
+          }
+          // the edges left touching were already in the original
+          if (!refined)
+            break;
+        }
+
+        // keep the outline if it would collapse or turn over
+        double before = 0, after = 0;
+        for (std::size_t i = 0; i < n; i++)
+          before += orientation(this->points[0], this->points[i], this->points[(i + 1)%n]);
+        for (std::size_t i = 0; i < this->ring.size(); i++)
+          after += orientation(this->points[this->ring[0]], this->points[this->ring[i]],
+                               this->points[this->ring[(i + 1)%this->ring.size()]]);
+        if (this->ring.size() < 3 || sign(before) != sign(after))
+          return;
+        this->compact();
+      }
+
+      /// \brief Thins out the open path in @points.
+      void thinPath(void) {
+        std::size_t n = this->points.size();
+        this->kept.assign(n, 0);
+        this->kept[0] = 1;
+        this->kept[n - 1] = 1;
+        this->thin(0, n - 1);
+        this->compact();
+      }
+
+      /// \brief Drops the vertices that are not kept.
+      void compact(void) {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < this->points.size(); i++)
+          if (this->kept[i]) {
+            this->points[count] = this->points[i];
+            this->origin[count++] = this->origin[i];
+          }
+        this->points.resize(count);
+        this->origin.resize(count);
+      }
+
+      template <typename T>
+      void takeRemaining(const std::vector<Vertex<T>>& vertices, double scale) {
+        this->origin.resize(vertices.size());
+        this->points.resize(vertices.size());
+        for (std::size_t i = 0; i < vertices.size(); i++) {
+          this->origin[i] = vertices[i].index;
+          this->points[i].x = vertices[i].x*scale;
+          this->points[i].y = vertices[i].y*scale;
+        }
+      }
+
+    public:
+      Simplifier(const SimplificationOptions& usrOptions) : options(usrOptions) {}
+
+      /// \brief Simplifies @vertices into @result, returning false if
+      /// the outline collapses.
+      ///
+      /// @vertices The vertices of a polygon or the points of a path.
+      /// @closed True for a polygon.
+      /// @result Where the new vertices go.
+      bool simplify(Span<const CoordPnt> vertices, bool closed, std::vector<CoordPnt>& result) {
+        result.clear();
+        double grid = this->options.grid;
+        bool isCollapsed;
+        if (grid > 0) {
+          this->units.resize(vertices.size());
+          for (std::size_t i = 0; i < vertices.size(); i++) {
+            this->units[i].x = std::llround(vertices[i].getX()/grid);
+            this->units[i].y = std::llround(vertices[i].getY()/grid);
+            this->units[i].index = i;
+          }
+          removeRedundant(this->units, closed);
+          isCollapsed = closed && collapsed(this->units);
+          this->takeRemaining(this->units, grid);
+        } else {
+          this->exact.resize(vertices.size());
+          for (std::size_t i = 0; i < vertices.size(); i++) {
+            this->exact[i].x = vertices[i].getX();
+            this->exact[i].y = vertices[i].getY();
+            this->exact[i].index = i;
+          }
+          removeRedundant(this->exact, closed);
+          isCollapsed = closed && collapsed(this->exact);
+          this->takeRemaining(this->exact, 1);
+        }
+        if (isCollapsed)
+          return false;
+        if (this->options.tolerance > 0 && this->points.size() > (closed ? 3 : 2)) {
+          if (closed)
+            this->thinOutline();
+          else
+            this->thinPath();
+        }
+        for (std::size_t i = 0; i < this->points.size(); i++) {
+          // vertices already on the grid keep their exact value
+          const CoordPnt& original = vertices[this->origin[i]];
+          double x = this->points[i].x, y = this->points[i].y;
+          if (std::abs(original.getX() - x) <= 1e-9*grid)
+            x = original.getX();
+          if (std::abs(original.getY() - y) <= 1e-9*grid)
+            y = original.getY();
+          result.push_back(CoordPnt(x, y));
+        }
+        return true;
+      }
+    };
+
+    /// \brief A polygon or path of one of the cells.
+    struct Job {
+      unsigned int cell;
+      bool path; //!< True for a path, false for a polygon.
+      unsigned int index; //!< The index in the polygons or paths of the Cell.
+    };
+
+    /// \brief The results of a block of consecutive jobs.
+    struct Block {
+      SimplificationStats stats;
+      std::vector<std::size_t> removed; //!< The jobs whose polygon collapsed.
+    };
+
+    bool changed(Span<const CoordPnt> before, const std::vector<CoordPnt>& after) {
+      if (before.size() != after.size())
+        return true;
+      for (std::size_t i = 0; i < after.size(); i++)
+        if (before[i].getX() != after[i].getX() || before[i].getY() != after[i].getY())
+          return true;
+      return false;
+    }
+
+    SimplificationStats simplifyCells(const std::vector<Cell*>& cells,
+                                      const SimplificationOptions& options) {
+      std::vector<Job> jobs;
+      for (std::size_t c = 0; c < cells.size(); c++) {
+        const PolygonList& polygons = cells[c]->getPolygonList();
+        const PathList& paths = cells[c]->getPathList();
+        for (std::size_t i = 0; i < polygons.size(); i++)
+          if (options.layers.empty() ||
+              std::find(options.layers.begin(), options.layers.end(),
+                        polygons[i].getLayer()) != options.layers.end()) {
+            Job job = {static_cast<unsigned int>(c), false, static_cast<unsigned int>(i)};
+            jobs.push_back(job);
+          }
+        for (std::size_t i = 0; i < paths.size(); i++)
+          if (options.layers.empty() ||
+              std::find(options.layers.begin(), options.layers.end(),
+                        paths[i].getLayer()) != options.layers.end()) {
+            Job job = {static_cast<unsigned int>(c), true, static_cast<unsigned int>(i)};
+            jobs.push_back(job);
+          }
+      }
+
+      // each job rewrites its own shape; the new points never outnumber
+      // the old ones, so they fit the memory the shape already has
+      std::vector<Block> blocks((jobs.size() + JOBS_PER_BLOCK - 1)/JOBS_PER_BLOCK);
+      utils::parallelFor(blocks.size(), [&](std::size_t b) {
+          Block& block = blocks[b];
+          block.stats = SimplificationStats();
+          // the shapes were valid before and only lose vertices
+          DeferredValidation deferred;
+          Simplifier simplifier(options);
+          std::vector<CoordPnt> result;
+          std::size_t end = std::min(jobs.size(), (b + 1)*JOBS_PER_BLOCK);
+          for (std::size_t j = b*JOBS_PER_BLOCK; j < end; j++) {
+            const Job& job = jobs[j];
+            if (job.path) {
+              Path& path = cells[job.cell]->getPathList()[job.index];
+              Span<const CoordPnt> points = path.getCoordPathSpan();
+              block.stats.verticesBefore += points.size();
+              simplifier.simplify(points, false, result);
+              block.stats.verticesAfter += result.size();
+              if (changed(points, result)) {
+                path.setCoordPath(result);
+                block.stats.pathsSimplified++;
+              }
+            } else {
+              Polygon& polygon = cells[job.cell]->getPolygonList()[job.index];
+              Span<const CoordPnt> vertices = polygon.getVertexSpan();
+              block.stats.verticesBefore += vertices.size();
+              if (!simplifier.simplify(vertices, true, result)) {
+                block.removed.push_back(j);
+                continue;
+              }
+              block.stats.verticesAfter += result.size();
+              if (changed(vertices, result)) {
+                polygon.getVertices().assign(result.begin(), result.end());
+                block.stats.polygonsSimplified++;
+              }
+            }
+          }
+        });
+
+      SimplificationStats stats = SimplificationStats();
+      std::vector<std::vector<char>> removed(cells.size());
+      for (std::size_t b = 0; b < blocks.size(); b++) {
+        stats.verticesBefore += blocks[b].stats.verticesBefore;
+        stats.verticesAfter += blocks[b].stats.verticesAfter;
+        stats.polygonsSimplified += blocks[b].stats.polygonsSimplified;
+        stats.pathsSimplified += blocks[b].stats.pathsSimplified;
+        for (std::size_t i = 0; i < blocks[b].removed.size(); i++) {
+          const Job& job = jobs[blocks[b].removed[i]];
+          if (removed[job.cell].empty())
+            removed[job.cell].assign(cells[job.cell]->getPolygonList().size(), 0);
+          removed[job.cell][job.index] = 1;
+          stats.polygonsRemoved++;
+        }
+      }
+
+      // drop the collapsed polygons, keeping the order of the others
+      for (std::size_t c = 0; c < cells.size(); c++) {
+        if (removed[c].empty())
+          continue;
+        PolygonList& polygons = cells[c]->getPolygonList();
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < polygons.size(); i++)
+          if (!removed[c][i]) {
+            if (count != i)
+              polygons[count] = std::move(polygons[i]);
+            count++;
+          }
+        polygons.erase(polygons.begin() + count, polygons.end());
+      }
+      return stats;
+    }
+
+  } // namespace
+
+  SimplificationStats simplifyGeometry(Cell& cell, SimplificationOptions options) {
+    return simplifyCells(std::vector<Cell*>(1, &cell), options);
+  }
+
+  SimplificationStats simplifyGeometry(Layout& layout, SimplificationOptions options) {
+    return simplifyCells(layout.getCells(), options);
+  }
+
+}
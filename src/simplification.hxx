@@ -0,0 +1,88 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef SIMPLIFICATION_HXX
+#define SIMPLIFICATION_HXX
+
+#include <cstddef>
+#include <vector>
+#include "cell.hxx"
+#include "layout.hxx"
+
+namespace sil {
+
+  /// \brief The settings used by simplifyGeometry().
+  struct SimplificationOptions {
+    /// \brief The grid (in user units) the vertices are snapped to, or
+    /// 0 to leave them where they are.
+    ///
+    /// Defaults to the database unit of the GDSII and OASIS writers, so
+    /// snapping moves nothing that writing would not move anyway.
+    double grid;
+
+    /// \brief How far (in user units) the simplified outline may stray
+    /// from the original, or 0 to only remove vertices that do not
+    /// change the shape.
+    double tolerance;
+
+    /// \brief The layers to simplify, or every layer if empty.
+    std::vector<int> layers;
+
+    /// \brief Sets the defaults: a 1 nm grid and exact simplification
+    /// only, on every layer.
+    SimplificationOptions(void);
+  };
+
+  /// \brief A summary of the changes made by simplifyGeometry().
+  struct SimplificationStats {
+    std::size_t verticesBefore; //!< Polygon vertices and path points looked at.
+    std::size_t verticesAfter; //!< The ones left, without the removed polygons.
+    unsigned int polygonsSimplified; //!< Polygons whose vertices changed.
+    unsigned int pathsSimplified; //!< Paths whose points changed.
+    unsigned int polygonsRemoved; //!< Polygons snapping collapsed to a line or a point.
+  };
+
+  /// \brief Removes the vertices of the polygons and paths of @cell that
+  /// do not contribute to its shapes.
+  ///
+  /// @cell The Cell to simplify.
+  /// @options The grid, tolerance and layers.
+  ///
+  /// The vertices are snapped to @options.grid first. Then repeated
+  /// vertices and vertices on the straight line between their
+  /// neighbours are removed, which leaves every shape exactly as it
+  /// was; on a grid this is decided in integer arithmetic. A vertex
+  /// where the outline doubles back is kept. If @options.tolerance is
+  /// set, outlines are then thinned out with the Douglas-Peucker
+  /// algorithm: a run of vertices is replaced by a single edge if none
+  /// of them is further than the tolerance from it. Edges that would
+  /// touch another edge of the polygon are refined again until they
+  /// do not, so a simplified polygon never crosses itself, and a
+  /// polygon is left as it was if it would collapse. Paths keep their
+  /// end points and may cross themselves anyway, so only the tolerance
+  /// applies to them. Polygons that snapping leaves without any area
+  /// are removed. The shapes are simplified in parallel.
+  SimplificationStats simplifyGeometry(Cell& cell,
+                                       SimplificationOptions options = SimplificationOptions());
+
+  /// \brief Simplifies every Cell of @layout, see simplifyGeometry().
+  SimplificationStats simplifyGeometry(Layout& layout,
+                                       SimplificationOptions options = SimplificationOptions());
+
+}
+
+#endif // SIMPLIFICATION_HXX
@@ -0,0 +1,248 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef SMALL_VECTOR_HXX
+#define SMALL_VECTOR_HXX
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace sil {
+
+  /// \brief A vector that keeps up to N elements inside the object and
+  /// only allocates, from a std::pmr::memory_resource, when it grows
+  /// beyond that.
+  ///
+  /// This is the storage of the points of the shapes. Most polygons are
+  /// rectangles or have only a few more vertices, so with a large enough
+  /// N they never allocate and their vertices sit next to the rest of
+  /// the Polygon in memory. Like std::pmr::vector the memory resource is
+  /// fixed at construction; copies use the default resource unless one
+  /// is given and assignments keep the resource of the target.
+  ///
+  /// Unlike std::vector the elements live inside the object while there
+  /// are at most N of them, so moving a SmallVector invalidates pointers
+  /// to those elements.
+  template <typename T, std::size_t N>
+  class SmallVector {
+    static_assert(N > 0, "a SmallVector needs room for at least one inline element");
+
+  public:
+    typedef T value_type;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+    typedef std::size_t size_type;
+    typedef std::pmr::polymorphic_allocator<T> allocator_type;
+
+  private:
+    T* first; //!< The elements, either @buffer or memory from @allocator.
+    std::size_t count; //!< The number of elements.
+    std::size_t capacityCount; //!< The number of elements @first has room for.
+    allocator_type allocator; //!< Where the elements go once there are more than N.
+    alignas(T) unsigned char buffer[N * sizeof(T)]; //!< The inline elements.
+
+    T* inlineData(void) {
+      return reinterpret_cast<T*>(this->buffer);
+    }
+
+    bool isInline(void) const {
+      return this->first == reinterpret_cast<const T*>(this->buffer);
+    }
+
+    /// \brief Moves the elements to heap memory with room for
+    /// @newCapacity elements.
+    void reallocate(std::size_t newCapacity) {
+      T* elements = this->allocator.allocate(newCapacity);
+      for (std::size_t i = 0; i < this->count; i++) {
+        ::new (static_cast<void*>(elements + i)) T(std::move(this->first[i]));
+        this->first[i].~T();
+      }
+      if (!this->isInline())
+        this->allocator.deallocate(this->first, this->capacityCount);
+      this->first = elements;
+      this->capacityCount = newCapacity;
+    }
+
+    /// \brief Destroys the elements and returns to the inline buffer.
+    void reset(void) {
+      this->clear();
+      if (!this->isInline())
+        this->allocator.deallocate(this->first, this->capacityCount);
+      this->first = this->inlineData();
+      this->capacityCount = N;
+    }
+
+    /// \brief Takes the elements of @other, which must use an equal
+    /// allocator, leaving it empty. This must be empty and inline.
+    void steal(SmallVector& other) {
+      if (other.isInline()) {
+        for (std::size_t i = 0; i < other.count; i++)
+          ::new (static_cast<void*>(this->first + i)) T(std::move(other.first[i]));
+        this->count = other.count;
+        other.clear();
+      }
+      else {
+        this->first = other.first;
+        this->count = other.count;
+        this->capacityCount = other.capacityCount;
+        other.first = other.inlineData();
+        other.count = 0;
+        other.capacityCount = N;
+      }
+    }
+
+  public:
+    /// \brief Creates an empty SmallVector using the default resource.
+    SmallVector(void) : SmallVector(allocator_type()) {}
+
+    /// \brief Creates an empty SmallVector that allocates with
+    /// @usrAllocator.
+    explicit SmallVector(const allocator_type& usrAllocator) :
+      first(inlineData()), count(0), capacityCount(N), allocator(usrAllocator) {}
+
+    SmallVector(const SmallVector& other) : SmallVector(other, allocator_type()) {}
+
+    SmallVector(const SmallVector& other, const allocator_type& usrAllocator) :
+      SmallVector(usrAllocator) {
+      this->assign(other.begin(), other.end());
+    }
+
+    SmallVector(SmallVector&& other) noexcept : SmallVector(other.allocator) {
+      this->steal(other);
+    }
+
+    /// \brief Moves @other, copying its elements when @usrAllocator and
+    /// the allocator of @other are not equal.
+    SmallVector(SmallVector&& other, const allocator_type& usrAllocator) :
+      SmallVector(usrAllocator) {
+      if (this->allocator == other.allocator)
+        this->steal(other);
+      else
+        this->assign(std::make_move_iterator(other.begin()),
+                     std::make_move_iterator(other.end()));
+    }
+
+    ~SmallVector(void) {
+      this->reset();
+    }
+
+    SmallVector& operator=(const SmallVector& other) {
+      if (this != &other)
+        this->assign(other.begin(), other.end());
+      return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) {
+      if (this == &other)
+        return *this;
+      if (this->allocator == other.allocator) {
+        this->reset();
+        this->steal(other);
+      }
+      else
+        this->assign(std::make_move_iterator(other.begin()),
+                     std::make_move_iterator(other.end()));
+      return *this;
+    }
+
+    /// \brief Replaces the elements by those in [@begin, @end).
+    template <typename InputIt>
+    void assign(InputIt begin, InputIt end) {
+      this->clear();
+      typedef typename std::iterator_traits<InputIt>::iterator_category Category;
+      if constexpr (std::is_base_of<std::forward_iterator_tag, Category>::value)
+        this->reserve(std::distance(begin, end));
+      for (; begin != end; ++begin)
+        this->emplace_back(*begin);
+    }
+
+    /// \brief Makes room for @newCapacity elements.
+    void reserve(std::size_t newCapacity) {
+      if (newCapacity > this->capacityCount)
+        this->reallocate(newCapacity);
+    }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+      if (this->count == this->capacityCount) {
+        // the arguments may refer to an element, so build it first
+        T value(std::forward<Args>(args)...);
+        this->reallocate(std::max<std::size_t>(2*this->capacityCount, 1));
+        ::new (static_cast<void*>(this->first + this->count)) T(std::move(value));
+      }
+      else
+        ::new (static_cast<void*>(this->first + this->count)) T(std::forward<Args>(args)...);
+      return this->first[this->count++];
+    }
+
+    void push_back(const T& value) {
+      this->emplace_back(value);
+    }
+
+    void push_back(T&& value) {
+      this->emplace_back(std::move(value));
+    }
+
+    void pop_back(void) {
+      this->first[--this->count].~T();
+    }
+
+    /// \brief Destroys the elements but keeps the memory.
+    void clear(void) {
+      for (std::size_t i = 0; i < this->count; i++)
+        this->first[i].~T();
+      this->count = 0;
+    }
+
+    allocator_type get_allocator(void) const { return this->allocator; }
+
+    std::size_t size(void) const { return this->count; }
+
+    std::size_t capacity(void) const { return this->capacityCount; }
+
+    bool empty(void) const { return this->count == 0; }
+
+    /// \brief Returns true while the elements are stored inline.
+    bool isSmall(void) const { return this->isInline(); }
+
+    T* data(void) { return this->first; }
+    const T* data(void) const { return this->first; }
+
+    T* begin(void) { return this->first; }
+    const T* begin(void) const { return this->first; }
+
+    T* end(void) { return this->first + this->count; }
+    const T* end(void) const { return this->first + this->count; }
+
+    T& operator[](std::size_t i) { return this->first[i]; }
+    const T& operator[](std::size_t i) const { return this->first[i]; }
+
+    T& front(void) { return this->first[0]; }
+    const T& front(void) const { return this->first[0]; }
+
+    T& back(void) { return this->first[this->count - 1]; }
+    const T& back(void) const { return this->first[this->count - 1]; }
+  };
+
+} // namespace sil
+
+#endif // SMALL_VECTOR_HXX
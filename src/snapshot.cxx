@@ -0,0 +1,514 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot.hxx"
+#include "cellGraph.hxx"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sil {
+
+  // the tables are only aligned if every record is a multiple of 8 bytes
+  static_assert(sizeof(SnapshotHeader) % 8 == 0, "unaligned SnapshotHeader");
+  static_assert(sizeof(SnapshotCell) % 8 == 0, "unaligned SnapshotCell");
+  static_assert(sizeof(SnapshotVertex) % 8 == 0, "unaligned SnapshotVertex");
+  static_assert(sizeof(SnapshotPolygon) % 8 == 0, "unaligned SnapshotPolygon");
+  static_assert(sizeof(SnapshotPath) % 8 == 0, "unaligned SnapshotPath");
+  static_assert(sizeof(SnapshotReference) % 8 == 0, "unaligned SnapshotReference");
+  static_assert(sizeof(SnapshotArray) % 8 == 0, "unaligned SnapshotArray");
+
+  const char SNAPSHOT_MAGIC[8] = "SILSNAP";
+  const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+  static bool sysIsLittleEndian(void) {
+    uint16_t num = 1;
+    return (*(char *)&num == 1);
+  }
+
+  // Polygons in a snapshot were checked when they were first made, so
+  // they are restored the way Rectangle and Oval build theirs rather
+  // than through the validating Polygon constructor.
+  class SnapshotShape : public Polygon {
+  public:
+    SnapshotShape(const allocator_type& allocator, const SnapshotVertex* first,
+                  const SnapshotPolygon& polygon) : Polygon(allocator) {
+      this->vertices.reserve(polygon.vertexCount);
+      for (uint32_t i = 0; i < polygon.vertexCount; i++)
+        this->vertices.push_back(CoordPnt(first[i].x, first[i].y));
+      // the record keeps the bounds
+      this->cache.minX = polygon.minX;
+      this->cache.minY = polygon.minY;
+      this->cache.maxX = polygon.maxX;
+      this->cache.maxY = polygon.maxY;
+      this->cache.valid = BOUNDS_CACHED;
+      this->setLayer(polygon.layer);
+      this->setDataType(polygon.dataType);
+    }
+  };
+
+  template <typename T>
+  static void writeRecord(std::ofstream& file, const T& record) {
+    file.write(reinterpret_cast<const char*>(&record), sizeof(T));
+  }
+
+  template <typename Points>
+  static void writeVertices(std::ofstream& file, const Points& points) {
+    for (unsigned int i = 0; i < points.size(); i++) {
+      SnapshotVertex vertex = { points[i].getX(), points[i].getY() };
+      writeRecord(file, vertex);
+    }
+  }
+
+  void writeSnapshot(const Layout& layout, std::string filename) {
+    if (!sysIsLittleEndian())
+      throw std::logic_error("Snapshots can only be written on little endian systems.\n");
+
+    // the layout's cells, followed by any other cells they reference
+    CellGraph graph(layout);
+    std::vector<const Cell*> cells;
+    for (unsigned int node = 0; node < graph.size(); node++)
+      cells.push_back(&graph.getCell(node));
+
+    // size up every table so that the header can be written first
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.cellCount = cells.size();
+    for (unsigned int i = 0; i < cells.size(); i++) {
+      PolygonList& polygons = cells[i]->getPolygonList();
+      header.polygonCount += polygons.size();
+      for (unsigned int j = 0; j < polygons.size(); j++)
+        header.vertexCount += polygons[j].getVertexSpan().size();
+      PathList& paths = cells[i]->getPathList();
+      header.pathCount += paths.size();
+      for (unsigned int j = 0; j < paths.size(); j++)
+        header.vertexCount += paths[j].getCoordPathSpan().size();
+      header.referenceCount += cells[i]->getCellReferenceList().size();
+      header.arrayCount += cells[i]->getCellArrayList().size();
+      header.namePoolSize += cells[i]->getCellname().size();
+    }
+    header.cellOffset = sizeof(SnapshotHeader);
+    header.polygonOffset = header.cellOffset + header.cellCount*sizeof(SnapshotCell);
+    header.pathOffset = header.polygonOffset + header.polygonCount*sizeof(SnapshotPolygon);
+    header.referenceOffset = header.pathOffset + header.pathCount*sizeof(SnapshotPath);
+    header.arrayOffset = header.referenceOffset + header.referenceCount*sizeof(SnapshotReference);
+    header.vertexOffset = header.arrayOffset + header.arrayCount*sizeof(SnapshotArray);
+    header.nameIndexOffset = header.vertexOffset + header.vertexCount*sizeof(SnapshotVertex);
+    header.namePoolOffset = header.nameIndexOffset + header.cellCount*sizeof(uint64_t);
+    header.fileSize = header.namePoolOffset + header.namePoolSize;
+
+    std::ofstream file(filename.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!file) {
+      std::stringstream errorMsg;
+      errorMsg << "Could not open " << filename << " for writing.\n";
+      throw std::runtime_error(errorMsg.str());
+    }
+    writeRecord(file, header);
+
+    // -- cells
+    SnapshotCell cell;
+    std::memset(&cell, 0, sizeof(cell));
+    for (unsigned int i = 0; i < cells.size(); i++) {
+      cell.nameLength = cells[i]->getCellname().size();
+      cell.polygonCount = cells[i]->getPolygonList().size();
+      cell.pathCount = cells[i]->getPathList().size();
+      cell.referenceCount = cells[i]->getCellReferenceList().size();
+      cell.arrayCount = cells[i]->getCellArrayList().size();
+      writeRecord(file, cell);
+      cell.nameOffset += cell.nameLength;
+      cell.firstPolygon += cell.polygonCount;
+      cell.firstPath += cell.pathCount;
+      cell.firstReference += cell.referenceCount;
+      cell.firstArray += cell.arrayCount;
+    }
+
+    // -- polygons
+    uint64_t nextVertex = 0;
+    for (unsigned int i = 0; i < cells.size(); i++) {
+      PolygonList& polygons = cells[i]->getPolygonList();
+      for (unsigned int j = 0; j < polygons.size(); j++) {
+        Span<const CoordPnt> vertices = polygons[j].getVertexSpan();
+        SnapshotPolygon polygon;
+        std::memset(&polygon, 0, sizeof(polygon));
+        polygon.firstVertex = nextVertex;
+        polygon.vertexCount = vertices.size();
+        polygon.layer = polygons[j].getLayer();
+        polygon.dataType = polygons[j].getDataType();
+        BoxList box = polygons[j].getBoundingBox();
+        polygon.minX = box[3].getX();
+        polygon.minY = box[3].getY();
+        polygon.maxX = box[1].getX();
+        polygon.maxY = box[1].getY();
+        writeRecord(file, polygon);
+        nextVertex += vertices.size();
+      }
+    }
+
+    // -- paths (their points follow all of the polygon vertices)
+    for (unsigned int i = 0; i < cells.size(); i++) {
+      PathList& paths = cells[i]->getPathList();
+      for (unsigned int j = 0; j < paths.size(); j++) {
+        SnapshotPath path;
+        std::memset(&path, 0, sizeof(path));
+        path.firstVertex = nextVertex;
+        path.vertexCount = paths[j].getCoordPathSpan().size();
+        path.layer = paths[j].getLayer();
+        path.dataType = paths[j].getDataType();
+        path.pathType = paths[j].getPathType();
+        path.width = paths[j].getPathWidth();
+        writeRecord(file, path);
+        nextVertex += path.vertexCount;
+      }
+    }
+
+    // -- references
+    for (unsigned int i = 0; i < cells.size(); i++) {
+      CellReferenceList& refs = cells[i]->getCellReferenceList();
+      for (unsigned int j = 0; j < refs.size(); j++) {
+        SnapshotReference ref = { graph.getNode(refs[j].getReferencedCell()),
+                                  refs[j].getCenter().getX(),
+                                  refs[j].getCenter().getY(),
+                                  refs[j].getMagnification(),
+                                  refs[j].getRotation() };
+        writeRecord(file, ref);
+      }
+    }
+
+    // -- arrays
+    for (unsigned int i = 0; i < cells.size(); i++) {
+      CellArrayList& arrays = cells[i]->getCellArrayList();
+      for (unsigned int j = 0; j < arrays.size(); j++) {
+        SnapshotArray array = { graph.getNode(arrays[j].getReferencedCell()),
+                                arrays[j].getNumCol(),
+                                arrays[j].getNumRow(),
+                                arrays[j].getStartingPos().getX(),
+                                arrays[j].getStartingPos().getY(),
+                                arrays[j].getXSpacing(),
+                                arrays[j].getYSpacing(),
+                                arrays[j].getMagnification(),
+                                arrays[j].getRotation() };
+        writeRecord(file, array);
+      }
+    }
+
+    // -- vertices, in the order the polygons and paths were written
+    for (unsigned int i = 0; i < cells.size(); i++) {
+      PolygonList& polygons = cells[i]->getPolygonList();
+      for (unsigned int j = 0; j < polygons.size(); j++)
+        writeVertices(file, polygons[j].getVertexSpan());
+    }
+    for (unsigned int i = 0; i < cells.size(); i++) {
+      PathList& paths = cells[i]->getPathList();
+      for (unsigned int j = 0; j < paths.size(); j++)
+        writeVertices(file, paths[j].getCoordPathSpan());
+    }
+
+    // -- name index
+    std::vector<uint64_t> byName(cells.size());
+    for (unsigned int i = 0; i < cells.size(); i++)
+      byName[i] = i;
+    std::stable_sort(byName.begin(), byName.end(), [&](uint64_t a, uint64_t b) {
+        return cells[a]->getCellname() < cells[b]->getCellname();
+      });
+    for (unsigned int i = 0; i < byName.size(); i++)
+      writeRecord(file, byName[i]);
+
+    // -- name pool
+    for (unsigned int i = 0; i < cells.size(); i++) {
+      std::string cellname = cells[i]->getCellname();
+      file.write(cellname.data(), cellname.size());
+    }
+
+    if (!file) {
+      std::stringstream errorMsg;
+      errorMsg << "Could not write the snapshot " << filename << ".\n";
+      throw std::runtime_error(errorMsg.str());
+    }
+  }
+
+  LayoutSnapshot::LayoutSnapshot(std::string filename) : filename(filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 ||
+        (std::size_t) info.st_size < sizeof(SnapshotHeader)) {
+      if (fd >= 0)
+        close(fd);
+      std::stringstream errorMsg;
+      errorMsg << "Could not read the snapshot " << filename << ".\n";
+      throw std::runtime_error(errorMsg.str());
+    }
+    this->size = info.st_size;
+    void* mapping = mmap(NULL, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file open
+    if (mapping == MAP_FAILED) {
+      std::stringstream errorMsg;
+      errorMsg << "Could not map the snapshot " << filename << ".\n";
+      throw std::runtime_error(errorMsg.str());
+    }
+    this->data = static_cast<const char*>(mapping);
+    this->header = reinterpret_cast<const SnapshotHeader*>(this->data);
+    try {
+      this->validate();
+    } catch (...) {
+      munmap(const_cast<char*>(this->data), this->size);
+      throw;
+    }
+  }
+
+  LayoutSnapshot::~LayoutSnapshot() {
+    munmap(const_cast<char*>(this->data), this->size);
+  }
+
+  // Checks that the table of @count records of @recordSize bytes at
+  // @offset lies within a file of @size bytes and is aligned.
+  static bool tableFits(uint64_t offset, uint64_t count, uint64_t recordSize,
+                        uint64_t size) {
+    return offset % 8 == 0 && offset <= size &&
+      count <= (size - offset)/recordSize;
+  }
+
+  // Checks that the run [first, first + count) lies within [0, total).
+  static bool runFits(uint64_t first, uint64_t count, uint64_t total) {
+    return first <= total && count <= total - first;
+  }
+
+  void LayoutSnapshot::validate() const {
+    const SnapshotHeader& head = *this->header;
+    std::stringstream errorMsg;
+    errorMsg << this->filename << " is not a valid snapshot: ";
+    if (std::memcmp(head.magic, SNAPSHOT_MAGIC, sizeof(head.magic)) != 0)
+      errorMsg << "it does not start with " << SNAPSHOT_MAGIC << ".\n";
+    else if (head.byteOrder != SNAPSHOT_BYTE_ORDER)
+      errorMsg << "its byte order does not match this system.\n";
+    else if (head.version != SNAPSHOT_VERSION)
+      errorMsg << "it has version " << head.version << " but only version "
+               << SNAPSHOT_VERSION << " is supported.\n";
+    else if (head.fileSize != this->size)
+      errorMsg << "it should be " << head.fileSize << " bytes but it is "
+               << this->size << ".\n";
+    else if (!tableFits(head.cellOffset, head.cellCount, sizeof(SnapshotCell), this->size) ||
+             !tableFits(head.polygonOffset, head.polygonCount, sizeof(SnapshotPolygon), this->size) ||
+             !tableFits(head.pathOffset, head.pathCount, sizeof(SnapshotPath), this->size) ||
+             !tableFits(head.referenceOffset, head.referenceCount, sizeof(SnapshotReference), this->size) ||
+             !tableFits(head.arrayOffset, head.arrayCount, sizeof(SnapshotArray), this->size) ||
+             !tableFits(head.vertexOffset, head.vertexCount, sizeof(SnapshotVertex), this->size) ||
+             !tableFits(head.nameIndexOffset, head.cellCount, sizeof(uint64_t), this->size) ||
+             !tableFits(head.namePoolOffset, head.namePoolSize, 1, this->size))
+      errorMsg << "one of its tables lies outside of the file.\n";
+    else
+      return; // the records are checked as they are handed out
+    throw std::runtime_error(errorMsg.str());
+  }
+
+  std::runtime_error LayoutSnapshot::badRecord() const {
+    std::stringstream errorMsg;
+    errorMsg << this->filename << " is not a valid snapshot: "
+             << "one of its records refers outside of a table.\n";
+    return std::runtime_error(errorMsg.str());
+  }
+
+  void LayoutSnapshot::verify() const {
+    const SnapshotHeader& head = *this->header;
+    for (std::size_t i = 0; i < head.cellCount; i++)
+      this->getCell(i);
+    const SnapshotPolygon* polygons =
+      reinterpret_cast<const SnapshotPolygon*>(this->data + head.polygonOffset);
+    for (std::size_t i = 0; i < head.polygonCount; i++)
+      this->getVertices(polygons[i]);
+    const SnapshotPath* paths =
+      reinterpret_cast<const SnapshotPath*>(this->data + head.pathOffset);
+    for (std::size_t i = 0; i < head.pathCount; i++)
+      this->getVertices(paths[i]);
+    const SnapshotReference* refs =
+      reinterpret_cast<const SnapshotReference*>(this->data + head.referenceOffset);
+    for (std::size_t i = 0; i < head.referenceCount; i++)
+      if (refs[i].cell >= head.cellCount)
+        throw this->badRecord();
+    const SnapshotArray* arrays =
+      reinterpret_cast<const SnapshotArray*>(this->data + head.arrayOffset);
+    for (std::size_t i = 0; i < head.arrayCount; i++)
+      if (arrays[i].cell >= head.cellCount)
+        throw this->badRecord();
+    const uint64_t* byName =
+      reinterpret_cast<const uint64_t*>(this->data + head.nameIndexOffset);
+    for (std::size_t i = 0; i < head.cellCount; i++)
+      if (byName[i] >= head.cellCount)
+        throw this->badRecord();
+  }
+
+  const SnapshotHeader& LayoutSnapshot::getHeader() const {
+    return *this->header;
+  }
+
+  std::size_t LayoutSnapshot::getCellCount() const {
+    return this->header->cellCount;
+  }
+
+  const SnapshotCell& LayoutSnapshot::getCell(std::size_t index) const {
+    const SnapshotHeader& head = *this->header;
+    if (index >= head.cellCount) {
+      std::stringstream errorMsg;
+      errorMsg << "The snapshot has " << head.cellCount
+               << " cells, there is no cell " << index << ".\n";
+      throw std::out_of_range(errorMsg.str());
+    }
+    const SnapshotCell& cell =
+      reinterpret_cast<const SnapshotCell*>(this->data + head.cellOffset)[index];
+    if (!runFits(cell.nameOffset, cell.nameLength, head.namePoolSize) ||
+        !runFits(cell.firstPolygon, cell.polygonCount, head.polygonCount) ||
+        !runFits(cell.firstPath, cell.pathCount, head.pathCount) ||
+        !runFits(cell.firstReference, cell.referenceCount, head.referenceCount) ||
+        !runFits(cell.firstArray, cell.arrayCount, head.arrayCount))
+      throw this->badRecord();
+    return cell;
+  }
+
+  const char* LayoutSnapshot::getName(const SnapshotCell& cell) const {
+    return this->data + this->header->namePoolOffset + cell.nameOffset;
+  }
+
+  std::string LayoutSnapshot::getCellname(std::size_t index) const {
+    const SnapshotCell& cell = this->getCell(index);
+    return std::string(this->getName(cell), cell.nameLength);
+  }
+
+  std::size_t LayoutSnapshot::findCell(std::string cellname) const {
+    const uint64_t* byName =
+      reinterpret_cast<const uint64_t*>(this->data + this->header->nameIndexOffset);
+    // compares the name of the cell at @position in the index with @cellname
+    auto compare = [&](std::size_t position) {
+      uint64_t index = byName[position];
+      if (index >= this->header->cellCount)
+        throw this->badRecord();
+      const SnapshotCell& cell = this->getCell(index);
+      int order = std::memcmp(this->getName(cell), cellname.data(),
+                              std::min<std::size_t>(cell.nameLength, cellname.size()));
+      if (order != 0)
+        return order;
+      return cell.nameLength < cellname.size() ? -1 : (cell.nameLength > cellname.size() ? 1 : 0);
+    };
+    // the first position whose name is not less than @cellname
+    std::size_t first = 0;
+    std::size_t count = this->header->cellCount;
+    while (count > 0) {
+      std::size_t half = count/2;
+      if (compare(first + half) < 0) {
+        first += half + 1;
+        count -= half + 1;
+      }
+      else
+        count = half;
+    }
+    if (first < this->header->cellCount && compare(first) == 0)
+      return byName[first];
+    return this->header->cellCount;
+  }
+
+  const SnapshotPolygon* LayoutSnapshot::getPolygons(const SnapshotCell& cell) const {
+    return reinterpret_cast<const SnapshotPolygon*>(this->data + this->header->polygonOffset)
+      + cell.firstPolygon;
+  }
+
+  const SnapshotPath* LayoutSnapshot::getPaths(const SnapshotCell& cell) const {
+    return reinterpret_cast<const SnapshotPath*>(this->data + this->header->pathOffset)
+      + cell.firstPath;
+  }
+
+  const SnapshotReference* LayoutSnapshot::getReferences(const SnapshotCell& cell) const {
+    return reinterpret_cast<const SnapshotReference*>(this->data + this->header->referenceOffset)
+      + cell.firstReference;
+  }
+
+  const SnapshotArray* LayoutSnapshot::getArrays(const SnapshotCell& cell) const {
+    return reinterpret_cast<const SnapshotArray*>(this->data + this->header->arrayOffset)
+      + cell.firstArray;
+  }
+
+  const SnapshotVertex* LayoutSnapshot::getVertices(const SnapshotPolygon& polygon) const {
+    if (!runFits(polygon.firstVertex, polygon.vertexCount, this->header->vertexCount))
+      throw this->badRecord();
+    return reinterpret_cast<const SnapshotVertex*>(this->data + this->header->vertexOffset)
+      + polygon.firstVertex;
+  }
+
+  const SnapshotVertex* LayoutSnapshot::getVertices(const SnapshotPath& path) const {
+    if (!runFits(path.firstVertex, path.vertexCount, this->header->vertexCount))
+      throw this->badRecord();
+    return reinterpret_cast<const SnapshotVertex*>(this->data + this->header->vertexOffset)
+      + path.firstVertex;
+  }
+
+  void LayoutSnapshot::load(Layout& layout) const {
+    std::vector<Cell*> cells;
+    for (std::size_t i = 0; i < this->getCellCount(); i++)
+      cells.push_back(&layout.createCell(this->getCellname(i)));
+
+    std::vector<CoordPnt> coordPath; // reused by every path
+    for (std::size_t i = 0; i < this->getCellCount(); i++) {
+      const SnapshotCell& cell = this->getCell(i);
+      Cell& target = *cells[i];
+
+      const SnapshotPolygon* polygons = this->getPolygons(cell);
+      target.getPolygonList().reserve(cell.polygonCount);
+      for (uint64_t j = 0; j < cell.polygonCount; j++)
+        target.emplacePolygon(SnapshotShape(target.getMemoryResource(),
+                                            this->getVertices(polygons[j]), polygons[j]));
+
+      const SnapshotPath* paths = this->getPaths(cell);
+      for (uint64_t j = 0; j < cell.pathCount; j++) {
+        const SnapshotVertex* points = this->getVertices(paths[j]);
+        coordPath.clear();
+        for (uint32_t k = 0; k < paths[j].vertexCount; k++)
+          coordPath.push_back(CoordPnt(points[k].x, points[k].y));
+        target.emplacePath(coordPath, paths[j].width, paths[j].pathType,
+                           paths[j].layer, paths[j].dataType);
+      }
+
+      const SnapshotReference* refs = this->getReferences(cell);
+      for (uint64_t j = 0; j < cell.referenceCount; j++) {
+        if (refs[j].cell >= cells.size())
+          throw this->badRecord();
+        CellReference ref(*cells[refs[j].cell], CoordPnt(refs[j].x, refs[j].y));
+        ref.setMagneification(refs[j].magnification);
+        ref.setRotation(refs[j].rotation);
+        target.addCellReference(ref);
+      }
+
+      const SnapshotArray* arrays = this->getArrays(cell);
+      for (uint64_t j = 0; j < cell.arrayCount; j++) {
+        if (arrays[j].cell >= cells.size())
+          throw this->badRecord();
+        CellArray array(*cells[arrays[j].cell], CoordPnt(arrays[j].x, arrays[j].y),
+                        arrays[j].numCol, arrays[j].numRow,
+                        arrays[j].xSpacing, arrays[j].ySpacing);
+        array.setMagnification(arrays[j].magnification);
+        array.setRotation(arrays[j].rotation);
+        target.addCellArray(array);
+      }
+    }
+  }
+
+}
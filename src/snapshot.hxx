@@ -0,0 +1,235 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SNAPSHOT_HXX
+#define SNAPSHOT_HXX
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <stdint.h> // cross-compiler integer datatypes
+#include "layout.hxx"
+
+namespace sil {
+
+  // The snapshot format is silhouette's own binary format for handing a
+  // Layout from one tool to the next. Everything is stored little endian
+  // in flat, 8 byte aligned tables of the records below, so a mapped
+  // snapshot can be used in place without decoding anything. A file is
+  // a SnapshotHeader followed by the cell, polygon, path, reference,
+  // array and vertex tables, the name index and finally the pool of
+  // cell names.
+
+  /// \brief The version of the snapshot format written by this build.
+  ///
+  /// Version 2 added the name index.
+  const uint32_t SNAPSHOT_VERSION = 2;
+
+  /// \brief The first record of every snapshot.
+  struct SnapshotHeader {
+    char magic[8]; //!< "SILSNAP" and a terminating zero.
+    uint32_t version; //!< The SNAPSHOT_VERSION the file was written with.
+    uint32_t byteOrder; //!< 0x01020304, to recognize big endian files.
+    uint64_t fileSize; //!< The size of the whole file in bytes.
+    uint64_t cellCount; //!< The number of SnapshotCell records.
+    uint64_t cellOffset; //!< The byte offset of the first SnapshotCell.
+    uint64_t polygonCount; //!< The number of SnapshotPolygon records.
+    uint64_t polygonOffset; //!< The byte offset of the first SnapshotPolygon.
+    uint64_t pathCount; //!< The number of SnapshotPath records.
+    uint64_t pathOffset; //!< The byte offset of the first SnapshotPath.
+    uint64_t referenceCount; //!< The number of SnapshotReference records.
+    uint64_t referenceOffset; //!< The byte offset of the first SnapshotReference.
+    uint64_t arrayCount; //!< The number of SnapshotArray records.
+    uint64_t arrayOffset; //!< The byte offset of the first SnapshotArray.
+    uint64_t vertexCount; //!< The number of SnapshotVertex records.
+    uint64_t vertexOffset; //!< The byte offset of the first SnapshotVertex.
+    uint64_t nameIndexOffset; //!< The byte offset of the name index.
+    uint64_t namePoolSize; //!< The number of bytes in the name pool.
+    uint64_t namePoolOffset; //!< The byte offset of the name pool.
+  };
+
+  // The name index holds cellCount uint64_t cell indices, ordered by the
+  // bytes of the cell names and, for equal names, by index, so that
+  // cells can be looked up by name with a binary search.
+
+  /// \brief A Cell. Its elements are consecutive runs of the shape tables.
+  struct SnapshotCell {
+    uint64_t nameOffset; //!< Where the name starts in the name pool.
+    uint64_t nameLength; //!< The length of the name (it is not zero terminated).
+    uint64_t firstPolygon; //!< The index of the first polygon of the Cell.
+    uint64_t polygonCount; //!< The number of polygons in the Cell.
+    uint64_t firstPath; //!< The index of the first path of the Cell.
+    uint64_t pathCount; //!< The number of paths in the Cell.
+    uint64_t firstReference; //!< The index of the first reference of the Cell.
+    uint64_t referenceCount; //!< The number of references in the Cell.
+    uint64_t firstArray; //!< The index of the first array of the Cell.
+    uint64_t arrayCount; //!< The number of arrays in the Cell.
+  };
+
+  /// \brief A vertex, in user units.
+  struct SnapshotVertex {
+    double x;
+    double y;
+  };
+
+  /// \brief A Polygon, with its bounding box for quick culling.
+  struct SnapshotPolygon {
+    uint64_t firstVertex; //!< The index of the first vertex.
+    uint32_t vertexCount; //!< The number of vertices.
+    int32_t layer; //!< The layer of the Polygon.
+    int32_t dataType; //!< The datatype of the Polygon.
+    uint32_t reserved; //!< Always zero.
+    double minX; //!< The bounding box of the vertices.
+    double minY;
+    double maxX;
+    double maxY;
+  };
+
+  /// \brief A Path.
+  struct SnapshotPath {
+    uint64_t firstVertex; //!< The index of the first point.
+    uint32_t vertexCount; //!< The number of points.
+    int32_t layer; //!< The layer of the Path.
+    int32_t dataType; //!< The datatype of the Path.
+    int32_t pathType; //!< The path type (0, 1 or 2).
+    double width; //!< The width of the Path.
+  };
+
+  /// \brief A CellReference.
+  struct SnapshotReference {
+    uint64_t cell; //!< The index of the referenced Cell.
+    double x; //!< The position of the reference.
+    double y;
+    double magnification;
+    double rotation; //!< In radians.
+  };
+
+  /// \brief A CellArray.
+  struct SnapshotArray {
+    uint64_t cell; //!< The index of the referenced Cell.
+    int32_t numCol;
+    int32_t numRow;
+    double x; //!< The starting position of the array.
+    double y;
+    double xSpacing;
+    double ySpacing;
+    double magnification;
+    double rotation; //!< In radians.
+  };
+
+  /// \brief Writes @layout to the snapshot file @filename.
+  ///
+  /// Cells that are referenced by the cells of @layout but were never
+  /// added to it are written as well, so every snapshot is complete.
+  /// Throws std::runtime_error if the file can not be written, and
+  /// std::logic_error on big endian systems.
+  void writeSnapshot(const Layout& layout, std::string filename);
+
+  /// \brief A read-only view of a snapshot file.
+  ///
+  /// The file is mapped into memory and its tables are handed out as
+  /// they are, so opening even a large snapshot only costs checking
+  /// that its tables lie within the file. The indices in a record are
+  /// checked when the record is handed out, and getCell(),
+  /// getVertices(), findCell() and load() throw std::runtime_error for
+  /// one that is out of range; verify() checks every record up front.
+  /// The records stay valid for as long as the LayoutSnapshot exists.
+  class LayoutSnapshot {
+  private:
+    std::string filename; //!< The name of the mapped file, for error messages.
+    const char* data; //!< The start of the mapped file.
+    std::size_t size; //!< The size of the mapped file.
+    const SnapshotHeader* header; //!< The header at the start of @data.
+
+    /// \brief Checks that the header is consistent and every table lies
+    /// within the file, throwing std::runtime_error if not.
+    void validate(void) const;
+
+    /// \brief Returns the error for a record that refers outside of a
+    /// table.
+    std::runtime_error badRecord(void) const;
+
+    /// \brief Returns the name of @cell, which must be checked already.
+    const char* getName(const SnapshotCell& cell) const;
+
+    // copying would unmap the file twice
+    LayoutSnapshot(const LayoutSnapshot&);
+    LayoutSnapshot& operator=(const LayoutSnapshot&);
+
+  public:
+    /// \brief Maps the snapshot file @filename.
+    ///
+    /// Throws std::runtime_error if the file can not be read or is not
+    /// a valid snapshot of this version.
+    LayoutSnapshot(std::string filename);
+
+    /// \brief Unmaps the file.
+    ~LayoutSnapshot(void);
+
+    /// \brief Returns the header of the snapshot.
+    const SnapshotHeader& getHeader(void) const;
+
+    /// \brief Returns the number of cells in the snapshot.
+    std::size_t getCellCount(void) const;
+
+    /// \brief Returns the cell at @index.
+    const SnapshotCell& getCell(std::size_t index) const;
+
+    /// \brief Returns the name of the cell at @index.
+    std::string getCellname(std::size_t index) const;
+
+    /// \brief Returns the index of the cell named @cellname, or
+    /// getCellCount() if there is none.
+    ///
+    /// This is a binary search of the name index. If several cells have
+    /// the name the first of them is returned.
+    std::size_t findCell(std::string cellname) const;
+
+    /// \brief Returns the first of @cell.polygonCount polygons.
+    const SnapshotPolygon* getPolygons(const SnapshotCell& cell) const;
+
+    /// \brief Returns the first of @cell.pathCount paths.
+    const SnapshotPath* getPaths(const SnapshotCell& cell) const;
+
+    /// \brief Returns the first of @cell.referenceCount references.
+    const SnapshotReference* getReferences(const SnapshotCell& cell) const;
+
+    /// \brief Returns the first of @cell.arrayCount arrays.
+    const SnapshotArray* getArrays(const SnapshotCell& cell) const;
+
+    /// \brief Returns the first of @polygon.vertexCount vertices.
+    const SnapshotVertex* getVertices(const SnapshotPolygon& polygon) const;
+
+    /// \brief Returns the first of @path.vertexCount points.
+    const SnapshotVertex* getVertices(const SnapshotPath& path) const;
+
+    /// \brief Checks every record of the snapshot, throwing
+    /// std::runtime_error at the first that refers outside of a table.
+    ///
+    /// This reads the whole file, so it is left to callers that want to
+    /// reject a damaged snapshot before using any of it.
+    void verify(void) const;
+
+    /// \brief Recreates every cell of the snapshot in @layout.
+    ///
+    /// The cells are created with Layout::createCell(), in the order of
+    /// the snapshot, and their references point at the new cells.
+    void load(Layout& layout) const;
+  };
+
+}
+
+#endif // SNAPSHOT_HXX
@@ -0,0 +1,89 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef SPAN_HXX
+#define SPAN_HXX
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace sil {
+
+  /// \brief A view of @count contiguous objects of type T owned by
+  /// someone else.
+  ///
+  /// This is what the shapes hand out instead of copies of their points,
+  /// and what they accept so that callers can pass a std::vector or a
+  /// VertexList without converting it first. A Span is only valid for as
+  /// long as the storage it views is neither destroyed nor resized.
+  ///
+  /// There is deliberately no constructor from a braced list: its array
+  /// dies with the full expression, so `Span<const int> s = {1, 2};`
+  /// would dangle. Put the values in a named container instead.
+  template <typename T>
+  class Span {
+  private:
+    T* first; //!< The first object, NULL for an empty Span.
+    std::size_t count; //!< The number of objects.
+
+  public:
+    typedef typename std::remove_cv<T>::type value_type;
+    typedef T* iterator;
+    typedef T* const_iterator;
+
+    /// \brief Creates an empty Span.
+    Span(void) : first(NULL), count(0) {}
+
+    /// \brief Views the @usrCount objects starting at @usrFirst.
+    Span(T* usrFirst, std::size_t usrCount) : first(usrFirst), count(usrCount) {}
+
+    /// \brief Views the elements of a contiguous container such as a
+    /// std::vector or a VertexList.
+    template <typename Container,
+              typename = typename std::enable_if<
+                std::is_convertible<decltype(std::declval<Container&>().data()),
+                                    T*>::value>::type>
+    Span(Container& container) : first(container.data()), count(container.size()) {}
+
+    /// \brief Views the elements of a const contiguous container.
+    template <typename Container,
+              typename = typename std::enable_if<
+                std::is_convertible<decltype(std::declval<const Container&>().data()),
+                                    T*>::value>::type>
+    Span(const Container& container) : first(container.data()), count(container.size()) {}
+
+    T* begin(void) const { return this->first; }
+
+    T* end(void) const { return this->first + this->count; }
+
+    T* data(void) const { return this->first; }
+
+    std::size_t size(void) const { return this->count; }
+
+    bool empty(void) const { return this->count == 0; }
+
+    T& operator[](std::size_t i) const { return this->first[i]; }
+
+    T& front(void) const { return this->first[0]; }
+
+    T& back(void) const { return this->first[this->count - 1]; }
+  };
+
+} // namespace sil
+
+#endif // SPAN_HXX
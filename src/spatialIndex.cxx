@@ -0,0 +1,191 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "spatialIndex.hxx"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace sil {
+
+  Bounds::Bounds() : minX(1), minY(1), maxX(-1), maxY(-1) {}
+
+  Bounds::Bounds(double usrMinX, double usrMinY, double usrMaxX, double usrMaxY) :
+    minX(usrMinX), minY(usrMinY), maxX(usrMaxX), maxY(usrMaxY) {}
+
+  bool Bounds::isEmpty() const {
+    return this->minX > this->maxX || this->minY > this->maxY;
+  }
+
+  void Bounds::add(const CoordPnt& pnt) {
+    if (this->isEmpty()) {
+      this->minX = this->maxX = pnt.getX();
+      this->minY = this->maxY = pnt.getY();
+      return;
+    }
+    this->minX = std::min(this->minX, pnt.getX());
+    this->maxX = std::max(this->maxX, pnt.getX());
+    this->minY = std::min(this->minY, pnt.getY());
+    this->maxY = std::max(this->maxY, pnt.getY());
+  }
+
+  void Bounds::add(const Bounds& other) {
+    if (other.isEmpty())
+      return;
+    this->add(CoordPnt(other.minX, other.minY));
+    this->add(CoordPnt(other.maxX, other.maxY));
+  }
+
+  bool Bounds::intersects(const Bounds& other) const {
+    return !this->isEmpty() && !other.isEmpty() &&
+      this->minX <= other.maxX && other.minX <= this->maxX &&
+      this->minY <= other.maxY && other.minY <= this->maxY;
+  }
+
+  bool Bounds::contains(const Bounds& other) const {
+    return !this->isEmpty() && !other.isEmpty() &&
+      this->minX <= other.minX && other.maxX <= this->maxX &&
+      this->minY <= other.minY && other.maxY <= this->maxY;
+  }
+
+  Bounds Bounds::intersection(const Bounds& other) const {
+    if (!this->intersects(other))
+      return Bounds();
+    return Bounds(std::max(this->minX, other.minX), std::max(this->minY, other.minY),
+                  std::min(this->maxX, other.maxX), std::min(this->maxY, other.maxY));
+  }
+
+  Bounds Bounds::grown(double margin) const {
+    if (this->isEmpty())
+      return *this;
+    return Bounds(this->minX - margin, this->minY - margin,
+                  this->maxX + margin, this->maxY + margin);
+  }
+
+  namespace {
+
+    double centerX(const Bounds& box) {
+      return (box.minX + box.maxX)/2.;
+    }
+
+    double centerY(const Bounds& box) {
+      return (box.minY + box.maxY)/2.;
+    }
+
+    /// \brief Orders @ids, indices into @boxes, so that every run of
+    /// @capacity of them is a compact group (sort-tile-recursive).
+    void tileOrder(const std::vector<Bounds>& boxes, std::vector<unsigned int>& ids,
+                   std::size_t capacity) {
+      std::size_t numGroups = (ids.size() + capacity - 1)/capacity;
+      std::size_t numSlices = std::ceil(std::sqrt(double(numGroups)));
+      std::size_t sliceSize = numSlices*capacity;
+      std::sort(ids.begin(), ids.end(), [&](unsigned int a, unsigned int b) {
+          return centerX(boxes[a]) < centerX(boxes[b]);
+        });
+      for (std::size_t first = 0; first < ids.size(); first += sliceSize) {
+        std::size_t last = std::min(first + sliceSize, ids.size());
+        std::sort(ids.begin() + first, ids.begin() + last, [&](unsigned int a, unsigned int b) {
+            return centerY(boxes[a]) < centerY(boxes[b]);
+          });
+      }
+    }
+
+  }
+
+  SpatialIndex::SpatialIndex() {}
+
+  SpatialIndex::SpatialIndex(std::vector<Bounds> usrBoxes) : boxes(std::move(usrBoxes)) {
+    for (unsigned int id = 0; id < this->boxes.size(); id++)
+      if (!this->boxes[id].isEmpty())
+        this->items.push_back(id);
+    if (this->items.empty())
+      return;
+    tileOrder(this->boxes, this->items, NODE_CAPACITY);
+
+    std::vector<Node> level;
+    for (std::size_t first = 0; first < this->items.size(); first += NODE_CAPACITY) {
+      Node node;
+      node.first = first;
+      node.count = std::min(NODE_CAPACITY, this->items.size() - first);
+      for (unsigned int i = 0; i < node.count; i++)
+        node.bounds.add(this->boxes[this->items[first + i]]);
+      level.push_back(node);
+    }
+    // pack every level into the one above until a single root is left
+    while (level.size() > 1) {
+      std::vector<Bounds> nodeBounds(level.size());
+      std::vector<unsigned int> order(level.size());
+      for (unsigned int i = 0; i < level.size(); i++) {
+        nodeBounds[i] = level[i].bounds;
+        order[i] = i;
+      }
+      tileOrder(nodeBounds, order, NODE_CAPACITY);
+      std::vector<Node> sorted(level.size());
+      for (std::size_t i = 0; i < order.size(); i++)
+        sorted[i] = level[order[i]];
+      this->levels.push_back(sorted);
+      std::vector<Node> parents;
+      for (std::size_t first = 0; first < sorted.size(); first += NODE_CAPACITY) {
+        Node node;
+        node.first = first;
+        node.count = std::min(NODE_CAPACITY, sorted.size() - first);
+        for (unsigned int i = 0; i < node.count; i++)
+          node.bounds.add(sorted[first + i].bounds);
+        parents.push_back(node);
+      }
+      level.swap(parents);
+    }
+    this->levels.push_back(level);
+  }
+
+  std::size_t SpatialIndex::size() const {
+    return this->boxes.size();
+  }
+
+  const Bounds& SpatialIndex::getBounds(unsigned int id) const {
+    if (id >= this->boxes.size()) {
+      std::stringstream errorMsg;
+      errorMsg << "There is no box " << id << " in a spatial index of "
+               << this->boxes.size() << " boxes.";
+      throw std::out_of_range(errorMsg.str());
+    }
+    return this->boxes[id];
+  }
+
+  void SpatialIndex::query(const Bounds& window, std::vector<unsigned int>& result) const {
+    if (this->levels.empty() || window.isEmpty())
+      return;
+    // (level, node) pairs still to visit
+    std::vector<std::pair<std::size_t, unsigned int> > stack;
+    stack.push_back(std::make_pair(this->levels.size() - 1, 0u));
+    while (!stack.empty()) {
+      std::size_t level = stack.back().first;
+      const Node& node = this->levels[level][stack.back().second];
+      stack.pop_back();
+      if (!node.bounds.intersects(window))
+        continue;
+      for (unsigned int i = node.first; i < node.first + node.count; i++) {
+        if (level > 0)
+          stack.push_back(std::make_pair(level - 1, i));
+        else if (this->boxes[this->items[i]].intersects(window))
+          result.push_back(this->items[i]);
+      }
+    }
+  }
+
+}
@@ -0,0 +1,110 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef SPATIAL_INDEX_HXX
+#define SPATIAL_INDEX_HXX
+
+#include <cstddef>
+#include <vector>
+#include "coord.hxx"
+
+namespace sil {
+
+  /// \brief An axis aligned box, empty while minX > maxX.
+  struct Bounds {
+    double minX;
+    double minY;
+    double maxX;
+    double maxY;
+
+    /// \brief Creates an empty box.
+    Bounds(void);
+
+    /// \brief Creates the box [@usrMinX, @usrMaxX] x [@usrMinY, @usrMaxY].
+    Bounds(double usrMinX, double usrMinY, double usrMaxX, double usrMaxY);
+
+    /// \brief Returns true if nothing was added to the box.
+    bool isEmpty(void) const;
+
+    /// \brief Grows the box to contain @pnt.
+    void add(const CoordPnt& pnt);
+
+    /// \brief Grows the box to contain @other.
+    void add(const Bounds& other);
+
+    /// \brief Returns true if the boxes share at least one point.
+    bool intersects(const Bounds& other) const;
+
+    /// \brief Returns true if @other lies inside this box.
+    bool contains(const Bounds& other) const;
+
+    /// \brief Returns the part of this box that lies inside @other.
+    Bounds intersection(const Bounds& other) const;
+
+    /// \brief Returns this box grown by @margin on every side.
+    Bounds grown(double margin) const;
+  };
+
+  /// class SpatialIndex
+  ///
+  /// \brief A static R-tree over a set of boxes, answering which of them
+  /// intersect a query box.
+  ///
+  /// The tree is packed with the sort-tile-recursive method: the boxes
+  /// are sorted into vertical slices by x and every slice by y, so each
+  /// node holds up to NODE_CAPACITY neighbours. Building takes
+  /// O(n log n) time and a query visits O(log n + k) nodes for k
+  /// results. The index never changes after it is built, so any number
+  /// of threads may query it at once.
+  class SpatialIndex {
+  private:
+    /// \brief The most children, or boxes, of one node.
+    static constexpr std::size_t NODE_CAPACITY = 16;
+
+    struct Node {
+      Bounds bounds; //!< The bounds of everything below the node.
+      unsigned int first; //!< The first child in the level below, or item.
+      unsigned int count; //!< The number of children or items.
+    };
+
+    std::vector<Bounds> boxes; //!< The boxes, by id.
+    std::vector<unsigned int> items; //!< The ids in leaf order.
+    std::vector<std::vector<Node> > levels; //!< The leaves first, the root last.
+
+  public:
+    /// \brief Creates an empty index.
+    SpatialIndex(void);
+
+    /// \brief Indexes @usrBoxes, whose ids are their positions.
+    ///
+    /// Empty boxes are never returned by a query.
+    explicit SpatialIndex(std::vector<Bounds> usrBoxes);
+
+    /// \brief Returns the number of boxes.
+    std::size_t size(void) const;
+
+    /// \brief Returns the box with @id.
+    const Bounds& getBounds(unsigned int id) const;
+
+    /// \brief Appends the ids of the boxes that intersect @window to
+    /// @result, in no particular order.
+    void query(const Bounds& window, std::vector<unsigned int>& result) const;
+  };
+
+}
+
+#endif // SPATIAL_INDEX_HXX
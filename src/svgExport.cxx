@@ -0,0 +1,383 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "svgExport.hxx"
+#include "geometry.hxx"
+#include "layout.hxx"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+namespace sil {
+
+  SVGExportOptions::SVGExportOptions() : width(1024), minFeature(1), boxSmallShapes(false) {}
+
+  namespace {
+
+    /// \brief The fill colors of the layers, used in turn.
+    const char* const LAYER_COLORS[] = {"#1f77b4", "#d62728", "#2ca02c", "#ff7f0e",
+                                        "#9467bd", "#8c564b", "#e377c2", "#17becf"};
+    const std::size_t NUM_LAYER_COLORS = sizeof(LAYER_COLORS)/sizeof(LAYER_COLORS[0]);
+
+    /// \brief Returns the longer side of @box.
+    double largestSide(const Bounds& box) {
+      return std::max(box.maxX - box.minX, box.maxY - box.minY);
+    }
+
+    /// \brief Writes the symbols of a cell hierarchy as they are made.
+    class SVGWriter {
+    private:
+      const FrozenLayout& layout;
+      std::ostream& out;
+      const SVGExportOptions& options;
+      double pixelSize; //!< The size of a pixel in the units of the top Cell.
+      std::vector<double> scales; //!< The largest magnification of each Cell, 0 if unused.
+      SVGExportStats stats;
+
+      bool wanted(int layer) const {
+        return this->options.layers.empty() ||
+          std::find(this->options.layers.begin(), this->options.layers.end(), layer) !=
+          this->options.layers.end();
+      }
+
+      /// \brief Returns true if @box, in the coordinates of @cell, is
+      /// too small to be drawn.
+      bool isSmall(const Bounds& box, std::size_t cell) const {
+        return largestSide(box)*this->scales[cell] < this->options.minFeature*this->pixelSize;
+      }
+
+      /// \brief Returns the bounds of the first element of @array, in the
+      /// coordinates of the Cell that places it.
+      Bounds elementBounds(const FrozenArray& array) const {
+        utils::Transform transform(array.magnification, array.rotation, array.startingPos);
+        return transform.apply(this->layout.getCell(array.cell).extent);
+      }
+
+      /// \brief Returns the bounds of every element of @array.
+      Bounds latticeBounds(const FrozenArray& array) const {
+        Bounds first = this->elementBounds(array);
+        Bounds lattice = first;
+        double latticeX = (array.numCol - 1)*array.xSpacing;
+        double latticeY = (array.numRow - 1)*array.ySpacing;
+        lattice.add(Bounds(first.minX + latticeX, first.minY + latticeY,
+                           first.maxX + latticeX, first.maxY + latticeY));
+        return lattice;
+      }
+
+      Bounds referenceBounds(const FrozenReference& ref) const {
+        utils::Transform transform(ref.magnification, ref.rotation, ref.position);
+        return transform.apply(this->layout.getCell(ref.cell).extent);
+      }
+
+      /// \brief Finds the largest magnification every Cell below @top is
+      /// drawn with, leaving out the placements that are culled.
+      void findScales(std::size_t top) {
+        this->scales.assign(this->layout.getCellCount(), 0);
+        this->scales[top] = 1;
+        Span<const unsigned int> order = this->layout.getHierarchicalOrder();
+        // every Cell comes after the cells it places, so walk backwards
+        for (std::size_t i = order.size(); i-- > 0;) {
+          unsigned int index = order[i];
+          if (this->scales[index] == 0)
+            continue;
+          const FrozenCell& cell = this->layout.getCell(index);
+          for (std::size_t j = 0; j < cell.references.size(); j++) {
+            const FrozenReference& ref = cell.references[j];
+            if (!this->isSmall(this->referenceBounds(ref), index))
+              this->scales[ref.cell] = std::max(this->scales[ref.cell], this->scales[index]*
+                                                std::abs(ref.magnification));
+          }
+          for (std::size_t j = 0; j < cell.arrays.size(); j++) {
+            const FrozenArray& array = cell.arrays[j];
+            if (!this->isSmall(this->elementBounds(array), index))
+              this->scales[array.cell] = std::max(this->scales[array.cell], this->scales[index]*
+                                                  std::abs(array.magnification));
+          }
+        }
+      }
+
+      void writeMatrix(const utils::Transform& transform) {
+        this->out << " transform=\"matrix(" << transform.a << " " << transform.b << " "
+                  << -transform.b << " " << transform.a << " " << transform.dx << " "
+                  << transform.dy << ")\"";
+      }
+
+      void writeBox(const Bounds& box, const std::string& style) {
+        this->out << "<rect class=\"" << style << "\" x=\"" << box.minX << "\" y=\""
+                  << box.minY << "\" width=\"" << box.maxX - box.minX << "\" height=\""
+                  << box.maxY - box.minY << "\"/>\n";
+      }
+
+      void writePoints(Span<const CoordPnt> points) {
+        this->out << " points=\"";
+        for (std::size_t i = 0; i < points.size(); i++)
+          this->out << (i > 0 ? " " : "") << points[i].getX() << "," << points[i].getY();
+        this->out << "\"";
+      }
+
+      /// \brief Returns the id of the group of 2^@power elements (of a
+      /// row if @row is false, of rows otherwise) of @array of @cell.
+      std::string groupId(std::size_t cell, std::size_t array, bool row, int power) const {
+        std::stringstream id;
+        id << "a" << cell << "_" << array << (row ? "_y" : "_x") << power;
+        return id.str();
+      }
+
+      /// \brief Writes the groups that double the elements of @array of
+      /// @cell, the first element transformed and the rest shifted.
+      void writeArrayGroups(std::size_t cell, std::size_t index, const FrozenArray& array) {
+        this->out << "<defs>\n";
+        this->out << "<g id=\"" << this->groupId(cell, index, false, 0) << "\"><use href=\"#c"
+                  << array.cell << "\"";
+        this->writeMatrix(utils::Transform(array.magnification, array.rotation,
+                                           array.startingPos));
+        this->out << "/></g>\n";
+        // rows of 2, 4, 8, ... elements
+        int power = 1;
+        for (; (1 << power) <= array.numCol; power++) {
+          std::string half = this->groupId(cell, index, false, power - 1);
+          this->out << "<g id=\"" << this->groupId(cell, index, false, power) << "\"><use href=\"#"
+                    << half << "\"/><use href=\"#" << half << "\" x=\""
+                    << (1 << (power - 1))*array.xSpacing << "\"/></g>\n";
+        }
+        // a whole row is the sum of the powers of two in numCol
+        this->out << "<g id=\"" << this->groupId(cell, index, true, 0) << "\">";
+        int offset = 0;
+        for (power = 0; (1 << power) <= array.numCol; power++) {
+          if (!(array.numCol & (1 << power)))
+            continue;
+          this->out << "<use href=\"#" << this->groupId(cell, index, false, power) << "\"";
+          if (offset > 0)
+            this->out << " x=\"" << offset*array.xSpacing << "\"";
+          this->out << "/>";
+          offset += 1 << power;
+        }
+        this->out << "</g>\n";
+        // and blocks of 2, 4, 8, ... rows
+        for (power = 1; (1 << power) <= array.numRow; power++) {
+          std::string half = this->groupId(cell, index, true, power - 1);
+          this->out << "<g id=\"" << this->groupId(cell, index, true, power) << "\"><use href=\"#"
+                    << half << "\"/><use href=\"#" << half << "\" y=\""
+                    << (1 << (power - 1))*array.ySpacing << "\"/></g>\n";
+        }
+        this->out << "</defs>\n";
+      }
+
+      /// \brief Places the rows of @array of @cell, once its groups were
+      /// written.
+      void writeArrayUses(std::size_t cell, std::size_t index, const FrozenArray& array) {
+        int offset = 0;
+        for (int power = 0; (1 << power) <= array.numRow; power++) {
+          if (!(array.numRow & (1 << power)))
+            continue;
+          this->out << "<use href=\"#" << this->groupId(cell, index, true, power) << "\"";
+          if (offset > 0)
+            this->out << " y=\"" << offset*array.ySpacing << "\"";
+          this->out << "/>\n";
+          offset += 1 << power;
+        }
+      }
+
+      /// \brief Writes the symbol of @index, after the groups of its
+      /// arrays.
+      void writeCell(std::size_t index) {
+        const FrozenCell& cell = this->layout.getCell(index);
+        std::vector<bool> drawn(cell.arrays.size());
+        for (std::size_t j = 0; j < cell.arrays.size(); j++) {
+          const FrozenArray& array = cell.arrays[j];
+          drawn[j] = array.numCol > 0 && array.numRow > 0 &&
+            !this->layout.getCell(array.cell).extent.isEmpty() &&
+            !this->isSmall(this->elementBounds(array), index);
+          if (drawn[j])
+            this->writeArrayGroups(index, j, array);
+        }
+
+        this->out << "<symbol id=\"c" << index << "\" overflow=\"visible\"><title>"
+                  << cell.cellname << "</title>\n"; // names need no escaping
+        for (std::size_t j = 0; j < cell.polygons.size(); j++) {
+          const FrozenPolygon& polygon = cell.polygons[j];
+          if (!this->wanted(polygon.layer))
+            continue;
+          std::stringstream style;
+          style << "l" << polygon.layer;
+          if (this->isSmall(polygon.bounds, index)) {
+            if (this->options.boxSmallShapes) {
+              this->writeBox(polygon.bounds, style.str());
+              this->stats.shapesBoxed++;
+            } else
+              this->stats.shapesDropped++;
+            continue;
+          }
+          this->out << "<polygon class=\"" << style.str() << "\"";
+          this->writePoints(polygon.vertices);
+          this->out << "/>\n";
+          this->stats.shapesWritten++;
+        }
+        for (std::size_t j = 0; j < cell.paths.size(); j++) {
+          const FrozenPath& path = cell.paths[j];
+          if (!this->wanted(path.layer))
+            continue;
+          std::stringstream style;
+          style << "l" << path.layer;
+          if (this->isSmall(path.bounds, index)) {
+            if (this->options.boxSmallShapes) {
+              this->writeBox(path.bounds, style.str());
+              this->stats.shapesBoxed++;
+            } else
+              this->stats.shapesDropped++;
+            continue;
+          }
+          static const char* const caps[3] = {"butt", "round", "square"};
+          this->out << "<polyline class=\"" << style.str() << "\" stroke-width=\""
+                    << std::abs(path.width) << "\" stroke-linecap=\""
+                    << caps[path.pathType >= 0 && path.pathType < 3 ? path.pathType : 0] << "\"";
+          this->writePoints(path.points);
+          this->out << "/>\n";
+          this->stats.shapesWritten++;
+        }
+        for (std::size_t j = 0; j < cell.references.size(); j++) {
+          const FrozenReference& ref = cell.references[j];
+          if (this->layout.getCell(ref.cell).extent.isEmpty())
+            continue;
+          Bounds placed = this->referenceBounds(ref);
+          if (this->isSmall(placed, index)) {
+            if (this->options.boxSmallShapes) {
+              this->writeBox(placed, "lod");
+              this->stats.instancesBoxed++;
+            } else
+              this->stats.instancesDropped++;
+            continue;
+          }
+          this->out << "<use href=\"#c" << ref.cell << "\"";
+          this->writeMatrix(utils::Transform(ref.magnification, ref.rotation, ref.position));
+          this->out << "/>\n";
+          this->stats.instancesWritten++;
+        }
+        for (std::size_t j = 0; j < cell.arrays.size(); j++) {
+          const FrozenArray& array = cell.arrays[j];
+          if (drawn[j]) {
+            this->writeArrayUses(index, j, array);
+            this->stats.instancesWritten++;
+          } else if (array.numCol > 0 && array.numRow > 0 &&
+                     !this->layout.getCell(array.cell).extent.isEmpty()) {
+            if (this->options.boxSmallShapes) {
+              this->writeBox(this->latticeBounds(array), "lod");
+              this->stats.instancesBoxed++;
+            } else
+              this->stats.instancesDropped++;
+          }
+        }
+        this->out << "</symbol>\n";
+        this->stats.cellsWritten++;
+      }
+
+    public:
+      SVGWriter(const FrozenLayout& usrLayout, std::ostream& usrOut,
+                const SVGExportOptions& usrOptions) :
+        layout(usrLayout), out(usrOut), options(usrOptions), pixelSize(0) {
+        std::memset(&this->stats, 0, sizeof(this->stats));
+      }
+
+      SVGExportStats write(std::size_t top) {
+        Bounds extent = this->layout.getCell(top).extent;
+        if (extent.isEmpty())
+          extent = Bounds(0, 0, 1, 1);
+        double side = largestSide(extent);
+        if (side <= 0)
+          side = 1;
+        this->pixelSize = side/this->options.width;
+        this->findScales(top);
+
+        std::set<int> layers;
+        for (std::size_t i = 0; i < this->scales.size(); i++) {
+          if (this->scales[i] == 0)
+            continue;
+          Span<const int> cellLayers = this->layout.getCell(i).layers;
+          for (std::size_t j = 0; j < cellLayers.size(); j++)
+            if (this->wanted(cellLayers[j]))
+              layers.insert(cellLayers[j]);
+        }
+
+        // y points down in SVG, so the drawing is flipped inside the view
+        this->out.precision(12);
+        this->out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                  << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\""
+                  << std::max(1., std::ceil((extent.maxX - extent.minX)/this->pixelSize))
+                  << "\" height=\""
+                  << std::max(1., std::ceil((extent.maxY - extent.minY)/this->pixelSize))
+                  << "\" viewBox=\"" << extent.minX << " " << -extent.maxY << " "
+                  << std::max(extent.maxX - extent.minX, this->pixelSize) << " "
+                  << std::max(extent.maxY - extent.minY, this->pixelSize) << "\">\n";
+        this->out << "<style>\npolygon, rect { stroke: none; }\npolyline { fill: none; }\n"
+                  << ".lod { fill: #808080; fill-opacity: 0.5; }\n";
+        std::size_t color = 0;
+        for (std::set<int>::const_iterator it = layers.begin(); it != layers.end(); ++it) {
+          const char* fill = LAYER_COLORS[color++%NUM_LAYER_COLORS];
+          this->out << ".l" << *it << " { fill: " << fill << "; stroke: " << fill
+                    << "; fill-opacity: 0.5; stroke-opacity: 0.5; }\n";
+        }
+        this->out << "</style>\n";
+
+        Span<const unsigned int> order = this->layout.getHierarchicalOrder();
+        for (std::size_t i = 0; i < order.size(); i++)
+          if (this->scales[order[i]] > 0)
+            this->writeCell(order[i]);
+        this->out << "<g transform=\"scale(1 -1)\"><use href=\"#c" << top << "\"/></g>\n"
+                  << "</svg>\n";
+        if (!this->out)
+          throw std::runtime_error("Unable to write the SVG image.");
+        return this->stats;
+      }
+    };
+
+  } // namespace
+
+  SVGExportStats writeSVG(const FrozenLayout& layout, std::size_t cell, std::ostream& out,
+                          SVGExportOptions options) {
+    if (options.width == 0)
+      throw std::invalid_argument("An SVG image must be at least 1 pixel wide.");
+    layout.getCell(cell); // throws if there is no such cell
+    SVGWriter writer(layout, out, options);
+    return writer.write(cell);
+  }
+
+  SVGExportStats writeSVG(const FrozenLayout& layout, std::size_t cell, std::string filename,
+                          SVGExportOptions options) {
+    std::ofstream out(filename.c_str(), std::ios::out | std::ios::trunc);
+    if (!out) {
+      std::stringstream errorMsg;
+      errorMsg << "Unable to open " << filename << " for writing.";
+      throw std::runtime_error(errorMsg.str());
+    }
+    try {
+      return writeSVG(layout, cell, out, options);
+    } catch (const std::runtime_error&) {
+      std::stringstream errorMsg;
+      errorMsg << "Unable to write " << filename << ".";
+      throw std::runtime_error(errorMsg.str());
+    }
+  }
+
+  SVGExportStats writeSVG(const Cell& cell, std::string filename, SVGExportOptions options) {
+    return writeSVG(*FrozenLayout::freeze(cell), 0, filename, options);
+  }
+
+}
@@ -0,0 +1,99 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef SVG_EXPORT_HXX
+#define SVG_EXPORT_HXX
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "cell.hxx"
+#include "frozenLayout.hxx"
+
+namespace sil {
+
+  /// \brief The settings used by writeSVG().
+  struct SVGExportOptions {
+    /// \brief The width of the image in pixels, which sets the size of
+    /// a pixel for the level of detail.
+    unsigned int width;
+
+    /// \brief Shapes and placed cells smaller than this many pixels
+    /// (in both directions) are left out, 0 keeps everything.
+    double minFeature;
+
+    /// \brief If true the shapes and placed cells that are too small
+    /// are drawn as their bounding boxes instead of being dropped.
+    bool boxSmallShapes;
+
+    /// \brief The layers to write, or every layer if empty.
+    std::vector<int> layers;
+
+    /// \brief Sets the defaults: 1024 pixels wide, features smaller
+    /// than a pixel dropped, every layer.
+    SVGExportOptions(void);
+  };
+
+  /// \brief A summary of what writeSVG() wrote.
+  struct SVGExportStats {
+    std::size_t cellsWritten; //!< Cells written as symbols.
+    std::size_t shapesWritten; //!< Polygons and paths written as they are.
+    std::size_t shapesBoxed; //!< Small shapes written as their bounding boxes.
+    std::size_t shapesDropped; //!< Small shapes left out.
+    std::size_t instancesWritten; //!< References and arrays written as uses.
+    std::size_t instancesBoxed; //!< Small references and arrays written as boxes.
+    std::size_t instancesDropped; //!< Small references and arrays left out.
+  };
+
+  /// \brief Writes @cell as an SVG image to @out.
+  ///
+  /// @layout The layout to export from.
+  /// @cell The index of the Cell in @layout.
+  /// @out The stream to write to.
+  /// @options The size of the image, the level of detail and the layers.
+  ///
+  /// Every Cell that is drawn becomes one <symbol>, written after the
+  /// cells it places, and every CellReference a <use> of it. A CellArray
+  /// is built by doubling: groups of 1, 2, 4, ... elements per row and
+  /// then of rows, so an array of n elements costs O(log n) <use>
+  /// elements. The size of the file therefore follows the size of the
+  /// hierarchy, not of the flat design. Every layer gets a CSS class,
+  /// "l" followed by its number, and the boxes of culled cells the
+  /// class "lod".
+  ///
+  /// A symbol is culled at the largest magnification it is placed with,
+  /// so nothing that is large enough anywhere is lost. Symbols are
+  /// written straight to @out, so memory use only depends on the number
+  /// of cells. Throws std::invalid_argument if the width is 0,
+  /// std::out_of_range if there is no Cell @cell and std::runtime_error
+  /// if @out fails.
+  SVGExportStats writeSVG(const FrozenLayout& layout, std::size_t cell, std::ostream& out,
+                          SVGExportOptions options = SVGExportOptions());
+
+  /// \brief Writes @cell of @layout to the SVG file @filename, see
+  /// writeSVG().
+  SVGExportStats writeSVG(const FrozenLayout& layout, std::size_t cell, std::string filename,
+                          SVGExportOptions options = SVGExportOptions());
+
+  /// \brief Writes @cell to the SVG file @filename, see writeSVG().
+  SVGExportStats writeSVG(const Cell& cell, std::string filename,
+                          SVGExportOptions options = SVGExportOptions());
+
+}
+
+#endif // SVG_EXPORT_HXX
@@ -0,0 +1,269 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "threadPool.hxx"
+#include "validation.hxx"
+#include <chrono>
+
+namespace sil {
+
+  // the pool and the index of the worker that runs on this thread
+  static thread_local const ThreadPool* currentPool = NULL;
+  static thread_local std::size_t currentWorker = 0;
+
+  Executor::~Executor() {}
+
+  bool Executor::runPendingTask() {
+    return false;
+  }
+
+  ThreadPool::ThreadPool(unsigned int workerCount) : queued(0), stopping(false) {
+    if (workerCount == 0)
+      workerCount = std::thread::hardware_concurrency();
+    if (workerCount == 0)
+      workerCount = 1;
+    for (unsigned int i = 0; i < workerCount; i++)
+      this->workers.push_back(std::unique_ptr<Worker>(new Worker()));
+    for (unsigned int i = 0; i < workerCount; i++)
+      this->threads.push_back(std::thread(&ThreadPool::work, this, i));
+  }
+
+  ThreadPool::~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(this->sleepMutex);
+      this->stopping = true;
+    }
+    this->wakeUp.notify_all();
+    for (std::size_t i = 0; i < this->threads.size(); i++)
+      this->threads[i].join();
+  }
+
+  void ThreadPool::execute(std::function<void()> task) {
+    if (currentPool == this) {
+      Worker& worker = *this->workers[currentWorker];
+      std::lock_guard<std::mutex> lock(worker.mutex);
+      worker.tasks.push_back(std::move(task));
+    }
+    else {
+      std::lock_guard<std::mutex> lock(this->sharedMutex);
+      this->sharedTasks.push_back(std::move(task));
+    }
+    this->queued++;
+    {
+      // a worker that is about to sleep has checked @queued already
+      std::lock_guard<std::mutex> lock(this->sleepMutex);
+    }
+    this->wakeUp.notify_one();
+  }
+
+  bool ThreadPool::takeTask(std::size_t index, std::function<void()>& task) {
+    if (this->queued == 0)
+      return false;
+    std::size_t numWorkers = this->workers.size();
+    // newest own task first
+    if (index < numWorkers) {
+      Worker& worker = *this->workers[index];
+      std::lock_guard<std::mutex> lock(worker.mutex);
+      if (!worker.tasks.empty()) {
+        task = std::move(worker.tasks.back());
+        worker.tasks.pop_back();
+        this->queued--;
+        return true;
+      }
+    }
+    {
+      std::lock_guard<std::mutex> lock(this->sharedMutex);
+      if (!this->sharedTasks.empty()) {
+        task = std::move(this->sharedTasks.front());
+        this->sharedTasks.pop_front();
+        this->queued--;
+        return true;
+      }
+    }
+    // then the oldest task of another worker
+    std::size_t start = index < numWorkers ? index + 1 : 0;
+    for (std::size_t i = 0; i < numWorkers; i++) {
+      Worker& victim = *this->workers[(start + i) % numWorkers];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.tasks.empty()) {
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        this->queued--;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void ThreadPool::work(std::size_t index) {
+    currentPool = this;
+    currentWorker = index;
+    std::function<void()> task;
+    while (true) {
+      if (this->takeTask(index, task)) {
+        task();
+        task = nullptr;
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(this->sleepMutex);
+      this->wakeUp.wait(lock, [this]() { return this->stopping || this->queued > 0; });
+      if (this->stopping && this->queued == 0)
+        return;
+    }
+  }
+
+  unsigned int ThreadPool::getConcurrency() const {
+    return this->workers.size();
+  }
+
+  bool ThreadPool::runPendingTask() {
+    std::function<void()> task;
+    if (!this->takeTask(currentPool == this ? currentWorker : this->workers.size(), task))
+      return false;
+    task();
+    return true;
+  }
+
+  //--------------------------------------------------------------------//
+  // The executor of the library
+
+  static std::mutex executorMutex; // guards the three below
+  static std::shared_ptr<Executor> libraryExecutor;
+  static bool ownExecutor = false; // whether @libraryExecutor is our ThreadPool
+  static unsigned int configuredWorkers = 0;
+
+  Executor& getExecutor() {
+    std::lock_guard<std::mutex> lock(executorMutex);
+    if (!libraryExecutor) {
+      libraryExecutor = std::make_shared<ThreadPool>(configuredWorkers);
+      ownExecutor = true;
+    }
+    return *libraryExecutor;
+  }
+
+  void setExecutor(std::shared_ptr<Executor> executor) {
+    std::shared_ptr<Executor> previous;
+    {
+      std::lock_guard<std::mutex> lock(executorMutex);
+      previous = libraryExecutor;
+      libraryExecutor = executor;
+      ownExecutor = false;
+    }
+    // a replaced pool is joined here, outside of the lock
+  }
+
+  void setWorkerCount(unsigned int workerCount) {
+    std::shared_ptr<Executor> previous;
+    {
+      std::lock_guard<std::mutex> lock(executorMutex);
+      configuredWorkers = workerCount;
+      if (ownExecutor) {
+        previous = libraryExecutor;
+        libraryExecutor.reset();
+        ownExecutor = false;
+      }
+    }
+  }
+
+  //--------------------------------------------------------------------//
+  // TaskGroup
+
+  struct TaskGroup::Task {
+    std::function<void()> function;
+    std::atomic<bool> claimed;
+
+    explicit Task(std::function<void()> usrFunction) :
+      function(std::move(usrFunction)), claimed(false) {}
+  };
+
+  struct TaskGroup::State {
+    std::vector<std::shared_ptr<Task> > tasks; //!< Only used by the owner of the group.
+    std::atomic<std::size_t> pending; //!< The tasks that have not finished.
+    std::mutex mutex; //!< Guards @error and waiting on @finished.
+    std::condition_variable finished; //!< Signaled when @pending drops to 0.
+    std::exception_ptr error; //!< The first exception thrown by a task.
+
+    State(void) : pending(0) {}
+
+    // Runs @task unless another thread started it already.
+    void runTask(Task& task) {
+      if (task.claimed.exchange(true))
+        return;
+      try {
+        task.function();
+      }
+      catch (...) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (!this->error)
+          this->error = std::current_exception();
+      }
+      task.function = nullptr;
+      if (--this->pending == 0) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->finished.notify_all();
+      }
+    }
+  };
+
+  TaskGroup::TaskGroup(Executor& usrExecutor) :
+    executor(usrExecutor), state(std::make_shared<State>()) {}
+
+  TaskGroup::~TaskGroup() {
+    try {
+      this->wait();
+    }
+    catch (...) {}
+  }
+
+  void TaskGroup::run(std::function<void()> task) {
+    std::shared_ptr<Task> shared = std::make_shared<Task>(std::move(task));
+    this->state->tasks.push_back(shared);
+    this->state->pending++;
+    std::shared_ptr<State> groupState = this->state;
+    // the task sees the DeferredValidation scopes of this thread, not
+    // those of whichever thread happens to run it
+    unsigned int deferred = DeferredValidation::isActive() ? 1 : 0;
+    this->executor.execute([groupState, shared, deferred]() {
+        unsigned int outer = DeferredValidation::exchangeDepth(deferred);
+        groupState->runTask(*shared);
+        DeferredValidation::exchangeDepth(outer);
+      });
+  }
+
+  void TaskGroup::wait() {
+    // run the tasks no thread has started, newest first
+    for (std::size_t i = this->state->tasks.size(); i-- > 0;)
+      this->state->runTask(*this->state->tasks[i]);
+    // then help with other work until the started ones are done
+    while (this->state->pending > 0) {
+      if (this->executor.runPendingTask())
+        continue;
+      std::unique_lock<std::mutex> lock(this->state->mutex);
+      this->state->finished.wait_for(lock, std::chrono::milliseconds(1),
+                                     [this]() { return this->state->pending == 0; });
+    }
+    this->state->tasks.clear();
+    std::exception_ptr error;
+    {
+      std::lock_guard<std::mutex> lock(this->state->mutex);
+      std::swap(error, this->state->error);
+    }
+    if (error)
+      std::rethrow_exception(error);
+  }
+
+} // namespace sil
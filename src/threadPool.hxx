@@ -0,0 +1,173 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef THREAD_POOL_HXX
+#define THREAD_POOL_HXX
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sil {
+
+  /// \brief Runs the tasks of the parallel passes of the library.
+  ///
+  /// The library uses a ThreadPool by default. Applications that have
+  /// their own scheduler can implement this interface and install it
+  /// with setExecutor(), so that the library runs on the threads of the
+  /// application instead of starting its own.
+  ///
+  /// The library never relies on a task being started: whoever waits
+  /// for a task that no thread has picked up yet runs it itself. An
+  /// Executor that is saturated or even never runs anything therefore
+  /// only costs parallelism, it can not deadlock the library.
+  class Executor {
+  public:
+    virtual ~Executor(void);
+
+    /// \brief Runs @task at some point, on any thread.
+    ///
+    /// @task must not throw.
+    virtual void execute(std::function<void()> task) = 0;
+
+    /// \brief Returns the number of tasks that should be run at once,
+    /// which is how many ways the parallel passes split their work.
+    virtual unsigned int getConcurrency(void) const = 0;
+
+    /// \brief Runs one queued task on the calling thread, returning
+    /// false if there was none.
+    ///
+    /// Threads that wait for other tasks call this to help instead of
+    /// blocking. The default does nothing.
+    virtual bool runPendingTask(void);
+  };
+
+  /// \brief A work stealing thread pool.
+  ///
+  /// Every worker has its own queue. Tasks submitted from a worker go to
+  /// the back of its queue and it takes its own work from there (so
+  /// nested work runs depth first and stays in cache), while idle
+  /// workers steal from the front of the other queues. Tasks submitted
+  /// from other threads are queued on a shared queue.
+  class ThreadPool : public Executor {
+  private:
+    struct Worker {
+      std::mutex mutex; //!< Guards @tasks.
+      std::deque<std::function<void()> > tasks; //!< The queue of this worker.
+    };
+
+    std::vector<std::unique_ptr<Worker> > workers; //!< A queue per thread.
+    std::vector<std::thread> threads; //!< The worker threads.
+    std::mutex sharedMutex; //!< Guards @sharedTasks.
+    std::deque<std::function<void()> > sharedTasks; //!< Tasks from outside of the pool.
+    std::atomic<std::size_t> queued; //!< The number of tasks in all queues.
+    std::mutex sleepMutex; //!< Guards sleeping on @wakeUp.
+    std::condition_variable wakeUp; //!< Signaled when a task is queued.
+    bool stopping; //!< Set, under @sleepMutex, when the pool is destroyed.
+
+    /// \brief Takes a task for the worker with @index (or for a thread
+    /// outside of the pool if it is not a valid index) into @task.
+    bool takeTask(std::size_t index, std::function<void()>& task);
+
+    /// \brief The loop of the worker thread with @index.
+    void work(std::size_t index);
+
+  public:
+    /// \brief Starts @workerCount threads, or one per hardware thread if
+    /// @workerCount is 0.
+    explicit ThreadPool(unsigned int workerCount = 0);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// \brief Runs the queued tasks and stops the workers.
+    ~ThreadPool(void);
+
+    void execute(std::function<void()> task) override;
+
+    /// \brief Returns the number of worker threads.
+    unsigned int getConcurrency(void) const override;
+
+    bool runPendingTask(void) override;
+  };
+
+  /// \brief Returns the Executor every parallel pass of the library runs
+  /// on.
+  ///
+  /// Unless setExecutor() was called this is a ThreadPool, created on
+  /// first use, with the number of workers set by setWorkerCount().
+  Executor& getExecutor(void);
+
+  /// \brief Makes the library run its parallel passes on @executor.
+  ///
+  /// @executor The Executor to use, or NULL for the library's own
+  /// ThreadPool.
+  ///
+  /// Must not be called while a parallel pass is running.
+  void setExecutor(std::shared_ptr<Executor> executor);
+
+  /// \brief Sets the number of workers of the library's own ThreadPool,
+  /// 0 for one per hardware thread, replacing the current pool.
+  ///
+  /// This caps the number of cores the library uses. Must not be called
+  /// while a parallel pass is running.
+  void setWorkerCount(unsigned int workerCount);
+
+  /// \brief Runs tasks in parallel and waits for all of them, the fork
+  /// and join building block of the parallel passes.
+  ///
+  /// Groups may be nested: a task may create its own TaskGroup and wait
+  /// for it. Waiting helps run queued tasks, and tasks of this group that
+  /// have not started yet are run by the waiting thread itself.
+  class TaskGroup {
+  private:
+    struct Task;
+    struct State;
+
+    Executor& executor; //!< Where the tasks are submitted.
+    std::shared_ptr<State> state; //!< Shared with the submitted tasks.
+
+  public:
+    /// \brief Creates a group that runs its tasks on @usrExecutor.
+    explicit TaskGroup(Executor& usrExecutor = getExecutor());
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    /// \brief Waits for the tasks, ignoring their exceptions.
+    ~TaskGroup(void);
+
+    /// \brief Starts @task.
+    ///
+    /// Whichever thread runs it, @task is inside a DeferredValidation
+    /// scope if and only if the calling thread is.
+    void run(std::function<void()> task);
+
+    /// \brief Waits until every task has finished, then rethrows the
+    /// first exception a task threw.
+    void wait(void);
+  };
+
+} // namespace sil
+
+#endif // THREAD_POOL_HXX
@@ -0,0 +1,530 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "tilePyramid.hxx"
+#include "contentHash.hxx"
+#include "geometry.hxx"
+#include "layout.hxx"
+#include "parallel.hxx"
+#include "raster.hxx"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sil {
+
+  // the tables are only aligned if every record is a multiple of 8 bytes
+  static_assert(sizeof(TilePyramidHeader) % 8 == 0, "unaligned TilePyramidHeader");
+  static_assert(sizeof(TilePyramidLayer) % 8 == 0, "unaligned TilePyramidLayer");
+  static_assert(sizeof(TileRecord) % 8 == 0, "unaligned TileRecord");
+
+  const char TILE_PYRAMID_MAGIC[8] = "SILTILE";
+  const uint32_t TILE_PYRAMID_BYTE_ORDER = 0x01020304;
+
+  /// \brief The most levels of a pyramid, so that tile numbers and
+  /// pixel counts stay well inside 32 bits.
+  const unsigned int MAX_PYRAMID_LEVELS = 24;
+
+  TilePyramidOptions::TilePyramidOptions() : tileSize(256), levelCount(6) {}
+
+  namespace {
+
+    /// \brief The bounding box of the shapes of each layer.
+    typedef std::map<int, Bounds> LayerExtents;
+
+    bool sysIsLittleEndian(void) {
+      uint16_t num = 1;
+      return (*(char *)&num == 1);
+    }
+
+    /// \brief Returns the LayerExtents of every Cell of @layout,
+    /// including the cells it places.
+    std::vector<LayerExtents> findLayerExtents(const FrozenLayout& layout) {
+      std::vector<LayerExtents> extents(layout.getCellCount());
+      Span<const unsigned int> order = layout.getHierarchicalOrder();
+      for (std::size_t i = 0; i < order.size(); i++) {
+        const FrozenCell& cell = layout.getCell(order[i]);
+        LayerExtents& target = extents[order[i]];
+        for (std::size_t j = 0; j < cell.polygons.size(); j++)
+          target[cell.polygons[j].layer].add(cell.polygons[j].bounds);
+        for (std::size_t j = 0; j < cell.paths.size(); j++)
+          target[cell.paths[j].layer].add(cell.paths[j].bounds);
+        for (std::size_t j = 0; j < cell.references.size(); j++) {
+          const FrozenReference& ref = cell.references[j];
+          utils::Transform transform(ref.magnification, ref.rotation, ref.position);
+          const LayerExtents& child = extents[ref.cell];
+          for (LayerExtents::const_iterator it = child.begin(); it != child.end(); ++it)
+            target[it->first].add(transform.apply(it->second));
+        }
+        for (std::size_t j = 0; j < cell.arrays.size(); j++) {
+          const FrozenArray& array = cell.arrays[j];
+          utils::Transform transform(array.magnification, array.rotation, array.startingPos);
+          // the first and the last element span the whole lattice
+          utils::Transform last = transform.shifted((array.numCol - 1)*array.xSpacing,
+                                                    (array.numRow - 1)*array.ySpacing);
+          const LayerExtents& child = extents[array.cell];
+          for (LayerExtents::const_iterator it = child.begin(); it != child.end(); ++it) {
+            target[it->first].add(transform.apply(it->second));
+            target[it->first].add(last.apply(it->second));
+          }
+        }
+      }
+      return extents;
+    }
+
+    /// \brief Orders tiles by level, layer, row and column, the order of
+    /// the index.
+    bool tileBefore(const TileRecord& a, const TileRecord& b) {
+      if (a.level != b.level)
+        return a.level < b.level;
+      if (a.layer != b.layer)
+        return a.layer < b.layer;
+      if (a.row != b.row)
+        return a.row < b.row;
+      return a.column < b.column;
+    }
+
+    /// \brief Returns true if no pixel of @tile is set.
+    bool isBlank(const Raster& tile) {
+      for (unsigned int y = 0; y < tile.getHeight(); y++) {
+        const unsigned char* row = tile.getRow(y);
+        for (std::size_t x = 0; x < tile.getRowSize(); x++)
+          if (row[x] != 0)
+            return false;
+      }
+      return true;
+    }
+
+    /// \brief Returns the hash of the pixels of @tile.
+    ContentHash hashPixels(const Raster& tile) {
+      utils::ElementHasher hasher(tile.getWidth());
+      for (unsigned int y = 0; y < tile.getHeight(); y++) {
+        const unsigned char* row = tile.getRow(y);
+        std::size_t x = 0;
+        for (; x + 8 <= tile.getRowSize(); x += 8) {
+          uint64_t word;
+          std::memcpy(&word, row + x, 8);
+          hasher.add(word);
+        }
+        for (; x < tile.getRowSize(); x++)
+          hasher.add(row[x]);
+      }
+      return hasher.finish();
+    }
+
+    /// \brief Builds the tiles of one pyramid and writes them to a file.
+    class PyramidBuilder {
+    private:
+      const FrozenLayout& layout;
+      std::size_t cell;
+      const TilePyramidOptions& options;
+      TilePyramidHeader& header;
+      std::ofstream& file;
+      const std::string& filename;
+
+      std::mutex mutex; //!< Guards everything below.
+      std::vector<TileRecord> records;
+      std::unordered_map<ContentHash, TileRecord, utils::ContentHashHasher> images;
+      TilePyramidStats stats;
+
+    public:
+      PyramidBuilder(const FrozenLayout& usrLayout, std::size_t usrCell,
+                     const TilePyramidOptions& usrOptions, TilePyramidHeader& usrHeader,
+                     std::ofstream& usrFile, const std::string& usrFilename) :
+        layout(usrLayout), cell(usrCell), options(usrOptions), header(usrHeader),
+        file(usrFile), filename(usrFilename) {
+        std::memset(&this->stats, 0, sizeof(this->stats));
+      }
+
+      /// \brief Returns the area covered by a tile.
+      Bounds getWindow(unsigned int level, unsigned int row, unsigned int column) const {
+        double size = (this->header.maxX - this->header.minX)/(1u << level);
+        return Bounds(this->header.minX + column*size, this->header.maxY - (row + 1)*size,
+                      this->header.minX + (column + 1)*size, this->header.maxY - row*size);
+      }
+
+      /// \brief Adds @tile to the file, unless an identical image was
+      /// already written.
+      void store(unsigned int level, int layer, unsigned int row, unsigned int column,
+                 const Raster& tile) {
+        ContentHash hash = hashPixels(tile);
+        TileRecord record = { level, layer, row, column, 0, 0 };
+        {
+          std::lock_guard<std::mutex> lock(this->mutex);
+          auto it = this->images.find(hash);
+          if (it != this->images.end()) {
+            record.offset = it->second.offset;
+            record.size = it->second.size;
+            this->records.push_back(record);
+            this->stats.tilesShared++;
+            return;
+          }
+        }
+        // encode outside of the lock
+        std::ostringstream image;
+        tile.writePNG(image);
+        std::string bytes = image.str();
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto it = this->images.find(hash);
+        if (it != this->images.end()) {
+          // another thread wrote the same image in the meantime
+          record.offset = it->second.offset;
+          record.size = it->second.size;
+          this->stats.tilesShared++;
+        } else {
+          record.offset = this->file.tellp();
+          record.size = bytes.size();
+          this->file.write(bytes.data(), bytes.size());
+          if (!this->file) {
+            std::stringstream errorMsg;
+            errorMsg << "Could not write the tile pyramid " << this->filename << ".\n";
+            throw std::runtime_error(errorMsg.str());
+          }
+          this->images.insert(std::make_pair(hash, record));
+          this->stats.tilesStored++;
+        }
+        this->records.push_back(record);
+      }
+
+      /// \brief Returns the tile of @layer whose four quarters are
+      /// @children (NULL if blank), or NULL if they are all blank.
+      std::unique_ptr<Raster> merge(std::unique_ptr<Raster> children[4]) {
+        if (!children[0] && !children[1] && !children[2] && !children[3])
+          return std::unique_ptr<Raster>();
+        unsigned int size = this->options.tileSize, half = size/2;
+        std::unique_ptr<Raster> tile(new Raster(size, size, 8));
+        for (int quarter = 0; quarter < 4; quarter++) {
+          const Raster* child = children[quarter].get();
+          if (!child)
+            continue;
+          unsigned int left = (quarter%2)*half, top = (quarter/2)*half;
+          for (unsigned int y = 0; y < half; y++) {
+            const unsigned char* upper = child->getRow(2*y);
+            const unsigned char* lower = child->getRow(2*y + 1);
+            unsigned char* pixels = tile->getRow(top + y) + left;
+            for (unsigned int x = 0; x < half; x++)
+              pixels[x] = (upper[2*x] + upper[2*x + 1] + lower[2*x] + lower[2*x + 1] + 2)/4;
+          }
+        }
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stats.tilesMerged++;
+        return tile;
+      }
+
+      /// \brief Builds and stores the tile of @layer at @level, @row and
+      /// @column and every tile below it, depth first.
+      ///
+      /// Returns the tile, or NULL if it is blank.
+      std::unique_ptr<Raster> build(unsigned int level, int layer, unsigned int row,
+                                    unsigned int column, const Bounds& extent) {
+        Bounds window = this->getWindow(level, row, column);
+        if (!window.intersects(extent))
+          return std::unique_ptr<Raster>();
+        std::unique_ptr<Raster> tile;
+        if (level + 1 == this->options.levelCount) {
+          RasterOptions rasterOptions;
+          rasterOptions.layers.push_back(layer);
+          rasterOptions.antialias = true;
+          tile.reset(new Raster(rasterize(this->layout, this->cell, window,
+                                          this->options.tileSize, this->options.tileSize,
+                                          rasterOptions)));
+          {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stats.tilesRendered++;
+          }
+          if (isBlank(*tile))
+            return std::unique_ptr<Raster>();
+        } else {
+          std::unique_ptr<Raster> children[4];
+          for (unsigned int quarter = 0; quarter < 4; quarter++)
+            children[quarter] = this->build(level + 1, layer, 2*row + quarter/2,
+                                            2*column + quarter%2, extent);
+          tile = this->merge(children);
+          if (!tile)
+            return tile;
+        }
+        this->store(level, layer, row, column, *tile);
+        return tile;
+      }
+
+      std::vector<TileRecord>& getRecords(void) {
+        return this->records;
+      }
+
+      const TilePyramidStats& getStats(void) const {
+        return this->stats;
+      }
+    };
+
+  } // namespace
+
+  TilePyramidStats writeTilePyramid(const FrozenLayout& layout, std::size_t cell,
+                                    std::string filename, TilePyramidOptions options) {
+    if (options.tileSize < 2 || options.tileSize%2 != 0) {
+      std::stringstream errorMsg;
+      errorMsg << "The tile size must be even, not " << options.tileSize << ".";
+      throw std::invalid_argument(errorMsg.str());
+    }
+    if (options.levelCount < 1 || options.levelCount > MAX_PYRAMID_LEVELS) {
+      std::stringstream errorMsg;
+      errorMsg << "A tile pyramid has 1 to " << MAX_PYRAMID_LEVELS << " levels, not "
+               << options.levelCount << ".";
+      throw std::invalid_argument(errorMsg.str());
+    }
+    if (!sysIsLittleEndian())
+      throw std::logic_error("Tile pyramids can only be written on little endian systems.\n");
+    const FrozenCell& top = layout.getCell(cell); // throws if there is no such cell
+
+    std::vector<LayerExtents> extents = findLayerExtents(layout);
+    const LayerExtents& topExtents = extents[cell];
+    std::vector<int> layers = options.layers;
+    if (layers.empty())
+      for (LayerExtents::const_iterator it = topExtents.begin(); it != topExtents.end(); ++it)
+        layers.push_back(it->first);
+    std::sort(layers.begin(), layers.end());
+    layers.erase(std::unique(layers.begin(), layers.end()), layers.end());
+
+    TilePyramidHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, TILE_PYRAMID_MAGIC, sizeof(header.magic));
+    header.version = TILE_PYRAMID_VERSION;
+    header.byteOrder = TILE_PYRAMID_BYTE_ORDER;
+    header.tileSize = options.tileSize;
+    header.levelCount = options.levelCount;
+    if (!top.extent.isEmpty()) {
+      // the smallest square over the Cell, anchored at its top left
+      double side = std::max(top.extent.maxX - top.extent.minX,
+                             top.extent.maxY - top.extent.minY);
+      if (side <= 0)
+        side = 1;
+      header.minX = top.extent.minX;
+      header.maxX = top.extent.minX + side;
+      header.maxY = top.extent.maxY;
+      header.minY = top.extent.maxY - side;
+    }
+    header.layerCount = layers.size();
+    header.layerOffset = sizeof(TilePyramidHeader);
+
+    std::ofstream file(filename.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!file) {
+      std::stringstream errorMsg;
+      errorMsg << "Could not open " << filename << " for writing.\n";
+      throw std::runtime_error(errorMsg.str());
+    }
+    // the header and the layers are written again once they are known
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    std::vector<TilePyramidLayer> layerTable(layers.size());
+    file.write(reinterpret_cast<const char*>(layerTable.data()),
+               layerTable.size()*sizeof(TilePyramidLayer));
+
+    PyramidBuilder builder(layout, cell, options, header, file, filename);
+    if (!top.extent.isEmpty() && !layers.empty()) {
+      // split the pyramid into enough subtrees to keep every thread busy
+      unsigned int splitLevel = 0;
+      while (splitLevel + 1 < options.levelCount &&
+             (std::size_t(1) << (2*splitLevel)) < 4*utils::threadCount())
+        splitLevel++;
+      std::size_t side = std::size_t(1) << splitLevel;
+      std::vector<std::unique_ptr<Raster>> tiles(layers.size()*side*side);
+      utils::parallelFor(tiles.size(), [&](std::size_t i) {
+          std::size_t layer = i/(side*side), tile = i%(side*side);
+          LayerExtents::const_iterator extent = topExtents.find(layers[layer]);
+          if (extent != topExtents.end())
+            tiles[i] = builder.build(splitLevel, layers[layer], tile/side, tile%side,
+                                     extent->second);
+        });
+      // reduce the levels above the subtrees, each in parallel
+      for (unsigned int level = splitLevel; level-- > 0;) {
+        side /= 2;
+        std::vector<std::unique_ptr<Raster>> upper(layers.size()*side*side);
+        utils::parallelFor(upper.size(), [&](std::size_t i) {
+            std::size_t layer = i/(side*side), tile = i%(side*side);
+            unsigned int row = tile/side, column = tile%side;
+            std::unique_ptr<Raster> children[4];
+            for (unsigned int quarter = 0; quarter < 4; quarter++) {
+              std::size_t child = layer*4*side*side +
+                (2*row + quarter/2)*2*side + 2*column + quarter%2;
+              children[quarter] = std::move(tiles[child]);
+            }
+            upper[i] = builder.merge(children);
+            if (upper[i])
+              builder.store(level, layers[layer], row, column, *upper[i]);
+          });
+        tiles.swap(upper);
+      }
+    }
+
+    // the index, aligned after the images
+    std::vector<TileRecord>& records = builder.getRecords();
+    std::sort(records.begin(), records.end(), tileBefore);
+    uint64_t end = file.tellp();
+    static const char padding[8] = {0};
+    file.write(padding, (8 - end%8)%8);
+    header.tileCount = records.size();
+    header.tileOffset = file.tellp();
+    file.write(reinterpret_cast<const char*>(records.data()), records.size()*sizeof(TileRecord));
+    header.fileSize = file.tellp();
+    for (std::size_t i = 0; i < layers.size(); i++)
+      layerTable[i].layer = layers[i];
+    for (std::size_t i = 0; i < records.size(); i++)
+      layerTable[std::lower_bound(layers.begin(), layers.end(), records[i].layer) -
+                 layers.begin()].tileCount++;
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(layerTable.data()),
+               layerTable.size()*sizeof(TilePyramidLayer));
+    if (!file) {
+      std::stringstream errorMsg;
+      errorMsg << "Could not write the tile pyramid " << filename << ".\n";
+      throw std::runtime_error(errorMsg.str());
+    }
+    return builder.getStats();
+  }
+
+  TilePyramidStats writeTilePyramid(const Cell& cell, std::string filename,
+                                    TilePyramidOptions options) {
+    return writeTilePyramid(*FrozenLayout::freeze(cell), 0, filename, options);
+  }
+
+  TilePyramid::TilePyramid(std::string filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 ||
+        (std::size_t) info.st_size < sizeof(TilePyramidHeader)) {
+      if (fd >= 0)
+        close(fd);
+      std::stringstream errorMsg;
+      errorMsg << "Could not read the tile pyramid " << filename << ".\n";
+      throw std::runtime_error(errorMsg.str());
+    }
+    this->size = info.st_size;
+    void* mapping = mmap(NULL, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file open
+    if (mapping == MAP_FAILED) {
+      std::stringstream errorMsg;
+      errorMsg << "Could not map the tile pyramid " << filename << ".\n";
+      throw std::runtime_error(errorMsg.str());
+    }
+    this->data = static_cast<const char*>(mapping);
+    this->header = reinterpret_cast<const TilePyramidHeader*>(this->data);
+    try {
+      this->validate(filename);
+    } catch (...) {
+      munmap(const_cast<char*>(this->data), this->size);
+      throw;
+    }
+  }
+
+  TilePyramid::~TilePyramid() {
+    munmap(const_cast<char*>(this->data), this->size);
+  }
+
+  // Checks that the table of @count records of @recordSize bytes at
+  // @offset lies within a file of @size bytes and is aligned.
+  static bool tableFits(uint64_t offset, uint64_t count, uint64_t recordSize,
+                        uint64_t size) {
+    return offset % 8 == 0 && offset <= size &&
+      count <= (size - offset)/recordSize;
+  }
+
+  void TilePyramid::validate(const std::string& filename) const {
+    const TilePyramidHeader& head = *this->header;
+    std::stringstream errorMsg;
+    errorMsg << filename << " is not a valid tile pyramid: ";
+    if (std::memcmp(head.magic, TILE_PYRAMID_MAGIC, sizeof(head.magic)) != 0)
+      errorMsg << "it does not start with " << TILE_PYRAMID_MAGIC << ".\n";
+    else if (head.byteOrder != TILE_PYRAMID_BYTE_ORDER)
+      errorMsg << "its byte order does not match this system.\n";
+    else if (head.version != TILE_PYRAMID_VERSION)
+      errorMsg << "it has version " << head.version << " but only version "
+               << TILE_PYRAMID_VERSION << " is supported.\n";
+    else if (head.fileSize != this->size)
+      errorMsg << "it should be " << head.fileSize << " bytes but it is "
+               << this->size << ".\n";
+    else if (!tableFits(head.layerOffset, head.layerCount, sizeof(TilePyramidLayer), this->size) ||
+             !tableFits(head.tileOffset, head.tileCount, sizeof(TileRecord), this->size))
+      errorMsg << "one of its tables lies outside of the file.\n";
+    else {
+      bool valid = true;
+      for (std::size_t i = 0; valid && i < head.tileCount; i++) {
+        const TileRecord& tile = this->getTile(i);
+        valid = tile.offset <= this->size && tile.size <= this->size - tile.offset &&
+          tile.level < head.levelCount && (i == 0 || tileBefore(this->getTile(i - 1), tile));
+      }
+      if (valid)
+        return;
+      errorMsg << "one of its tiles lies outside of the file or out of order.\n";
+    }
+    throw std::runtime_error(errorMsg.str());
+  }
+
+  const TilePyramidHeader& TilePyramid::getHeader() const {
+    return *this->header;
+  }
+
+  std::vector<int> TilePyramid::getLayers() const {
+    const TilePyramidLayer* layers =
+      reinterpret_cast<const TilePyramidLayer*>(this->data + this->header->layerOffset);
+    std::vector<int> result;
+    for (std::size_t i = 0; i < this->header->layerCount; i++)
+      if (layers[i].tileCount > 0)
+        result.push_back(layers[i].layer);
+    return result;
+  }
+
+  std::size_t TilePyramid::getTileCount() const {
+    return this->header->tileCount;
+  }
+
+  const TileRecord& TilePyramid::getTile(std::size_t index) const {
+    if (index >= this->header->tileCount) {
+      std::stringstream errorMsg;
+      errorMsg << "The tile pyramid has " << this->header->tileCount
+               << " tiles, there is no tile " << index << ".\n";
+      throw std::out_of_range(errorMsg.str());
+    }
+    return reinterpret_cast<const TileRecord*>(this->data + this->header->tileOffset)[index];
+  }
+
+  const TileRecord* TilePyramid::findTile(unsigned int level, int layer, unsigned int row,
+                                          unsigned int column) const {
+    const TileRecord* first =
+      reinterpret_cast<const TileRecord*>(this->data + this->header->tileOffset);
+    const TileRecord* last = first + this->header->tileCount;
+    TileRecord key = { level, layer, row, column, 0, 0 };
+    const TileRecord* it = std::lower_bound(first, last, key, tileBefore);
+    if (it == last || it->level != level || it->layer != layer || it->row != row ||
+        it->column != column)
+      return NULL;
+    return it;
+  }
+
+  const unsigned char* TilePyramid::getImage(const TileRecord& tile) const {
+    return reinterpret_cast<const unsigned char*>(this->data) + tile.offset;
+  }
+
+}
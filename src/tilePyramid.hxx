@@ -0,0 +1,185 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef TILE_PYRAMID_HXX
+#define TILE_PYRAMID_HXX
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <stdint.h> // cross-compiler integer datatypes
+#include "cell.hxx"
+#include "frozenLayout.hxx"
+
+namespace sil {
+
+  // A tile pyramid holds pre-rendered images of a Cell for viewers that
+  // pan and zoom. Level 0 is a single square tile that covers the whole
+  // Cell and every further level splits each tile of the level above it
+  // into four, so level z has 2^z x 2^z tiles, numbered in rows and
+  // columns from the top left. Every layer has its own tiles, which are
+  // anti-aliased grayscale PNG images. Tiles without any shapes are left
+  // out and identical tiles share one image.
+  //
+  // The file is stored little endian: a TilePyramidHeader, the table of
+  // TilePyramidLayer records, the images and finally the 8 byte aligned
+  // index of TileRecords, sorted by level, layer, row and column. A
+  // server finds a tile with a binary search of the index and sends the
+  // bytes at its offset as they are.
+
+  /// \brief The version of the tile pyramid format written by this build.
+  const uint32_t TILE_PYRAMID_VERSION = 1;
+
+  /// \brief The first record of every tile pyramid.
+  struct TilePyramidHeader {
+    char magic[8]; //!< "SILTILE" and a terminating zero.
+    uint32_t version; //!< The TILE_PYRAMID_VERSION the file was written with.
+    uint32_t byteOrder; //!< 0x01020304, to recognize big endian files.
+    uint64_t fileSize; //!< The size of the whole file in bytes.
+    uint32_t tileSize; //!< The width and height of every tile in pixels.
+    uint32_t levelCount; //!< The number of levels.
+    double minX; //!< The square covered by the tile of level 0.
+    double minY;
+    double maxX;
+    double maxY;
+    uint64_t layerCount; //!< The number of TilePyramidLayer records.
+    uint64_t layerOffset; //!< The byte offset of the first TilePyramidLayer.
+    uint64_t tileCount; //!< The number of TileRecords.
+    uint64_t tileOffset; //!< The byte offset of the first TileRecord.
+  };
+
+  /// \brief A layer that has tiles.
+  struct TilePyramidLayer {
+    int32_t layer; //!< The layer number.
+    uint32_t tileCount; //!< The number of tiles of the layer.
+  };
+
+  /// \brief The location of the PNG image of one tile.
+  struct TileRecord {
+    uint32_t level;
+    int32_t layer;
+    uint32_t row; //!< Counted from the top.
+    uint32_t column; //!< Counted from the left.
+    uint64_t offset; //!< The byte offset of the image.
+    uint64_t size; //!< The size of the image in bytes.
+  };
+
+  /// \brief The settings used by writeTilePyramid().
+  struct TilePyramidOptions {
+    /// \brief The width and height of a tile in pixels, which must be
+    /// even.
+    unsigned int tileSize;
+
+    /// \brief The number of levels, at most 24.
+    unsigned int levelCount;
+
+    /// \brief The layers to render, or every layer of the Cell if empty.
+    std::vector<int> layers;
+
+    /// \brief Sets the defaults: 256 pixel tiles, 6 levels, every layer.
+    TilePyramidOptions(void);
+  };
+
+  /// \brief A summary of the work done by writeTilePyramid().
+  struct TilePyramidStats {
+    std::size_t tilesRendered; //!< Tiles of the finest level rendered from the shapes.
+    std::size_t tilesMerged; //!< Tiles reduced from the four tiles below them.
+    std::size_t tilesStored; //!< Images written to the file.
+    std::size_t tilesShared; //!< Tiles that reuse the image of an identical tile.
+  };
+
+  /// \brief Renders the tile pyramid of @cell into the file @filename.
+  ///
+  /// @layout The layout to render from.
+  /// @cell The index of the Cell in @layout.
+  /// @filename The file to write.
+  /// @options The tile size, the number of levels and the layers.
+  ///
+  /// Only the finest level is rendered from the shapes, with
+  /// rasterize(); every coarser tile is reduced from the four tiles
+  /// below it, so the cost does not grow with the number of levels.
+  /// The pyramid is split into subtrees that are built depth first in
+  /// parallel, holding only a few tiles per level in memory, and the
+  /// coarse levels above them are merged in parallel too. Regions
+  /// outside of the extent of a layer are skipped without rendering.
+  /// Repeated cells that produce the same pixels are stored once, which
+  /// keeps the files of regular designs small. Throws
+  /// std::invalid_argument for bad @options, std::out_of_range if there
+  /// is no Cell @cell and std::runtime_error if the file can not be
+  /// written.
+  TilePyramidStats writeTilePyramid(const FrozenLayout& layout, std::size_t cell,
+                                    std::string filename,
+                                    TilePyramidOptions options = TilePyramidOptions());
+
+  /// \brief Renders the tile pyramid of @cell, see writeTilePyramid().
+  TilePyramidStats writeTilePyramid(const Cell& cell, std::string filename,
+                                    TilePyramidOptions options = TilePyramidOptions());
+
+  /// \brief A read-only view of a tile pyramid file.
+  ///
+  /// The file is mapped into memory like a LayoutSnapshot, so opening
+  /// it only costs checking the index, and the images are handed out in
+  /// place. The records stay valid for as long as the TilePyramid
+  /// exists.
+  class TilePyramid {
+  private:
+    const char* data; //!< The start of the mapped file.
+    std::size_t size; //!< The size of the mapped file.
+    const TilePyramidHeader* header; //!< The header at the start of @data.
+
+    /// \brief Checks that the header and the index are consistent,
+    /// throwing std::runtime_error if not.
+    void validate(const std::string& filename) const;
+
+    // copying would unmap the file twice
+    TilePyramid(const TilePyramid&);
+    TilePyramid& operator=(const TilePyramid&);
+
+  public:
+    /// \brief Maps the tile pyramid file @filename.
+    ///
+    /// Throws std::runtime_error if the file can not be read or is not
+    /// a valid tile pyramid of this version.
+    TilePyramid(std::string filename);
+
+    /// \brief Unmaps the file.
+    ~TilePyramid(void);
+
+    /// \brief Returns the header of the file.
+    const TilePyramidHeader& getHeader(void) const;
+
+    /// \brief Returns the layers that have tiles, ascending.
+    std::vector<int> getLayers(void) const;
+
+    /// \brief Returns the number of tiles in the file.
+    std::size_t getTileCount(void) const;
+
+    /// \brief Returns the tile at @index in the index.
+    const TileRecord& getTile(std::size_t index) const;
+
+    /// \brief Returns the tile of @layer at @level, @row and @column,
+    /// or NULL if it has no shapes.
+    const TileRecord* findTile(unsigned int level, int layer, unsigned int row,
+                               unsigned int column) const;
+
+    /// \brief Returns the first of @tile.size bytes of its PNG image.
+    const unsigned char* getImage(const TileRecord& tile) const;
+  };
+
+}
+
+#endif // TILE_PYRAMID_HXX
@@ -0,0 +1,701 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "triangulation.hxx"
+#include "geometry.hxx"
+#include "layout.hxx"
+#include "parallel.hxx"
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace sil {
+
+  std::size_t TriangleMesh::getVertexCount() const {
+    return this->coordinates.size()/2;
+  }
+
+  std::size_t TriangleMesh::getTriangleCount() const {
+    return this->indices.size()/3;
+  }
+
+  double TriangleMesh::getArea() const {
+    double area = 0;
+    for (std::size_t i = 0; i + 2 < this->indices.size(); i += 3) {
+      const double* a = &this->coordinates[2*this->indices[i]];
+      const double* b = &this->coordinates[2*this->indices[i + 1]];
+      const double* c = &this->coordinates[2*this->indices[i + 2]];
+      area += ((b[0] - a[0])*(c[1] - a[1]) - (b[1] - a[1])*(c[0] - a[0]))/2.;
+    }
+    return area;
+  }
+
+  namespace {
+
+    /// \brief The number of polygons triangulated by one task.
+    const std::size_t JOBS_PER_BLOCK = 256;
+
+    /// \brief Stands for the swept vertex in searches of the status.
+    const unsigned int QUERY = std::numeric_limits<unsigned int>::max();
+
+    struct Point {
+      double x;
+      double y;
+    };
+
+    /// \brief Returns twice the signed area of the triangle @a, @b, @c.
+    double orientation(const Point& a, const Point& b, const Point& c) {
+      return (b.x - a.x)*(c.y - a.y) - (b.y - a.y)*(c.x - a.x);
+    }
+
+    /// \brief Triangulates polygons one after another, reusing its
+    /// buffers.
+    ///
+    /// The sweep goes from the top down. Vertices are ordered by
+    /// descending y, then ascending x, then index, so no two vertices
+    /// are level and the copies of a vertex made by a keyhole are
+    /// still told apart. Edge i runs from vertex i to vertex i + 1.
+    class Triangulator {
+    private:
+      /// \brief Orders the edges in the status from left to right where
+      /// they cross the sweep line.
+      struct EdgeLess {
+        const Triangulator* owner;
+        bool operator()(unsigned int a, unsigned int b) const {
+          return owner->edgeLess(a, b);
+        }
+      };
+
+      std::vector<Point> points; //!< The vertices, counterclockwise.
+      std::vector<unsigned int> order; //!< The vertices from the top down.
+      std::vector<unsigned int> helper; //!< The helper of each edge in the status.
+      std::vector<char> merge; //!< Whether each vertex is a merge vertex.
+      std::vector<char> inStatus; //!< Whether each edge is in the status.
+      std::set<unsigned int, EdgeLess> status;
+      std::vector<std::set<unsigned int, EdgeLess>::iterator> position;
+      std::vector<std::pair<unsigned int, unsigned int>> diagonals;
+      std::vector<unsigned int> start; //!< Where the neighbours of each vertex start.
+      std::vector<unsigned int> neighbours; //!< Counterclockwise around each vertex.
+      std::vector<char> visited; //!< Whether each half edge has been walked.
+      std::vector<unsigned int> face;
+      std::vector<unsigned int> sorted;
+      std::vector<char> onLeft;
+      std::vector<unsigned int> stack;
+      std::vector<unsigned int> triangles;
+      std::vector<uint32_t> meshIndex;
+      double sweepX;
+      double sweepY;
+
+      unsigned int next(unsigned int vertex) const {
+        return vertex + 1 == this->points.size() ? 0 : vertex + 1;
+      }
+
+      unsigned int prev(unsigned int vertex) const {
+        return vertex == 0 ? this->points.size() - 1 : vertex - 1;
+      }
+
+      /// \brief Returns true if the sweep reaches @a before @b.
+      bool above(unsigned int a, unsigned int b) const {
+        const Point& p = this->points[a];
+        const Point& q = this->points[b];
+        if (p.y != q.y)
+          return p.y > q.y;
+        if (p.x != q.x)
+          return p.x < q.x;
+        return a < b;
+      }
+
+      /// \brief Returns where edge @edge crosses the sweep line.
+      ///
+      /// A level edge is taken to fall slightly to the right, so it
+      /// crosses the sweep line at the swept vertex.
+      double crossing(unsigned int edge) const {
+        const Point& upper = this->points[edge];
+        const Point& lower = this->points[this->next(edge)];
+        if (upper.y == lower.y)
+          return std::min(std::max(this->sweepX, upper.x), lower.x);
+        if (this->sweepY >= upper.y)
+          return upper.x;
+        if (this->sweepY <= lower.y)
+          return lower.x;
+        return upper.x + (this->sweepY - upper.y)*(lower.x - upper.x)/(lower.y - upper.y);
+      }
+
+      bool edgeLess(unsigned int a, unsigned int b) const {
+        if (a == b)
+          return false;
+        double xa = a == QUERY ? this->sweepX : this->crossing(a);
+        double xb = b == QUERY ? this->sweepX : this->crossing(b);
+        if (xa != xb)
+          return xa < xb;
+        // the edges through the swept vertex can only belong to another
+        // copy of it, which a keyhole makes: the sweep line is taken to
+        // rise slightly to the right, so the interior left of the swept
+        // vertex lies left of them
+        if (a == QUERY)
+          return true;
+        if (b == QUERY)
+          return false;
+        // edges that meet on the sweep line are ordered below it
+        const Point& upperA = this->points[a];
+        const Point& lowerA = this->points[this->next(a)];
+        const Point& upperB = this->points[b];
+        const Point& lowerB = this->points[this->next(b)];
+        double slopeA = (lowerA.x - upperA.x)*(upperB.y - lowerB.y);
+        double slopeB = (lowerB.x - upperB.x)*(upperA.y - lowerA.y);
+        if (slopeA != slopeB)
+          return slopeA < slopeB;
+        return a < b;
+      }
+
+      void insert(unsigned int edge, unsigned int vertex) {
+        this->position[edge] = this->status.insert(edge).first;
+        this->inStatus[edge] = 1;
+        this->helper[edge] = vertex;
+      }
+
+      /// \brief Removes the edge ending at @vertex, joining @vertex to
+      /// the helper of the edge if that is a merge vertex.
+      void finishEdge(unsigned int vertex) {
+        unsigned int edge = this->prev(vertex);
+        if (!this->inStatus[edge])
+          throw std::invalid_argument("The polygon is not simple.");
+        if (this->merge[this->helper[edge]])
+          this->diagonals.push_back(std::make_pair(vertex, this->helper[edge]));
+        this->status.erase(this->position[edge]);
+        this->inStatus[edge] = 0;
+      }
+
+      /// \brief Returns the edge directly left of the swept vertex.
+      unsigned int leftEdge() const {
+        std::set<unsigned int, EdgeLess>::const_iterator it = this->status.upper_bound(QUERY);
+        if (it == this->status.begin())
+          throw std::invalid_argument("The polygon is not simple.");
+        return *--it;
+      }
+
+      void partition(void);
+      void extractFaces(void);
+      void triangulateMonotone(void);
+      void emit(unsigned int a, unsigned int b, unsigned int c);
+
+    public:
+      Triangulator(void) : status(EdgeLess{this}), sweepX(0), sweepY(0) {}
+      Triangulator(const Triangulator&) = delete;
+      Triangulator& operator=(const Triangulator&) = delete;
+
+      std::size_t triangulate(Span<const CoordPnt> vertices, TriangleMesh& mesh);
+    };
+
+    /// \brief Adds the diagonals that split the polygon into y monotone
+    /// pieces.
+    void Triangulator::partition() {
+      std::size_t n = this->points.size();
+      this->order.resize(n);
+      for (unsigned int i = 0; i < n; i++)
+        this->order[i] = i;
+      std::sort(this->order.begin(), this->order.end(),
+                [this](unsigned int a, unsigned int b) { return this->above(a, b); });
+      this->status.clear();
+      this->helper.assign(n, 0);
+      this->merge.assign(n, 0);
+      this->inStatus.assign(n, 0);
+      this->position.resize(n);
+      this->diagonals.clear();
+      for (std::size_t k = 0; k < n; k++) {
+        unsigned int vertex = this->order[k];
+        unsigned int before = this->prev(vertex);
+        unsigned int after = this->next(vertex);
+        this->sweepX = this->points[vertex].x;
+        this->sweepY = this->points[vertex].y;
+        bool beforeBelow = this->above(vertex, before);
+        bool afterBelow = this->above(vertex, after);
+        bool convex = orientation(this->points[before], this->points[vertex],
+                                  this->points[after]) > 0;
+        if (beforeBelow && afterBelow) {
+          if (!convex) {
+            // a split vertex: join it to the vertex above that sees it
+            unsigned int left = this->leftEdge();
+            this->diagonals.push_back(std::make_pair(vertex, this->helper[left]));
+            this->helper[left] = vertex;
+          }
+          this->insert(vertex, vertex);
+        } else if (!beforeBelow && !afterBelow) {
+          this->finishEdge(vertex);
+          if (!convex) {
+            this->merge[vertex] = 1;
+            unsigned int left = this->leftEdge();
+            if (this->merge[this->helper[left]])
+              this->diagonals.push_back(std::make_pair(vertex, this->helper[left]));
+            this->helper[left] = vertex;
+          }
+        } else if (afterBelow) {
+          // on a left boundary, the interior is to the right
+          this->finishEdge(vertex);
+          this->insert(vertex, vertex);
+        } else {
+          unsigned int left = this->leftEdge();
+          if (this->merge[this->helper[left]])
+            this->diagonals.push_back(std::make_pair(vertex, this->helper[left]));
+          this->helper[left] = vertex;
+        }
+      }
+    }
+
+    /// \brief Walks the pieces the diagonals cut the polygon into and
+    /// triangulates each of them.
+    ///
+    /// The pieces are found from the indices alone: the neighbours of a
+    /// vertex lie counterclockwise around it in the order of their
+    /// indices counted from the vertex, which also holds for the copies
+    /// of a vertex that a keyhole makes.
+    void Triangulator::extractFaces() {
+      unsigned int n = this->points.size();
+      for (std::size_t i = 0; i < this->diagonals.size(); i++)
+        if (this->diagonals[i].first > this->diagonals[i].second)
+          std::swap(this->diagonals[i].first, this->diagonals[i].second);
+      std::sort(this->diagonals.begin(), this->diagonals.end());
+      this->diagonals.erase(std::unique(this->diagonals.begin(), this->diagonals.end()),
+                            this->diagonals.end());
+
+      this->start.assign(n + 1, 0);
+      for (unsigned int i = 0; i < n; i++)
+        this->start[i + 1] = 2;
+      for (std::size_t i = 0; i < this->diagonals.size(); i++) {
+        this->start[this->diagonals[i].first + 1]++;
+        this->start[this->diagonals[i].second + 1]++;
+      }
+      for (unsigned int i = 0; i < n; i++)
+        this->start[i + 1] += this->start[i];
+      this->neighbours.resize(this->start[n]);
+      std::vector<unsigned int>& fill = this->sorted;
+      fill.assign(this->start.begin(), this->start.end() - 1);
+      for (unsigned int i = 0; i < n; i++) {
+        this->neighbours[fill[i]++] = this->next(i);
+        this->neighbours[fill[i]++] = this->prev(i);
+      }
+      for (std::size_t i = 0; i < this->diagonals.size(); i++) {
+        unsigned int a = this->diagonals[i].first, b = this->diagonals[i].second;
+        this->neighbours[fill[a]++] = b;
+        this->neighbours[fill[b]++] = a;
+      }
+      for (unsigned int i = 0; i < n; i++)
+        std::sort(this->neighbours.begin() + this->start[i],
+                  this->neighbours.begin() + this->start[i + 1],
+                  [i, n](unsigned int a, unsigned int b) {
+                    return (a + n - i)%n < (b + n - i)%n;
+                  });
+
+      // every half edge but the reversed polygon edges bounds a piece
+      this->visited.assign(this->neighbours.size(), 0);
+      for (unsigned int vertex = 0; vertex < n; vertex++)
+        for (unsigned int slot = this->start[vertex]; slot + 1 < this->start[vertex + 1]; slot++) {
+          if (this->visited[slot])
+            continue;
+          this->face.clear();
+          unsigned int from = vertex, current = slot;
+          do {
+            this->visited[current] = 1;
+            this->face.push_back(from);
+            unsigned int to = this->neighbours[current];
+            // turn as far right as possible at the end of the half edge
+            std::vector<unsigned int>::const_iterator first =
+              this->neighbours.begin() + this->start[to];
+            std::vector<unsigned int>::const_iterator last =
+              this->neighbours.begin() + this->start[to + 1];
+            std::vector<unsigned int>::const_iterator it =
+              std::lower_bound(first, last, from, [to, n](unsigned int a, unsigned int b) {
+                  return (a + n - to)%n < (b + n - to)%n;
+                });
+            if (it == first || it == last || *it != from)
+              throw std::logic_error("The triangulation lost track of a polygon piece.");
+            current = it - this->neighbours.begin() - 1;
+            from = to;
+          } while (current != slot);
+          this->triangulateMonotone();
+        }
+    }
+
+    void Triangulator::emit(unsigned int a, unsigned int b, unsigned int c) {
+      if (orientation(this->points[a], this->points[b], this->points[c]) < 0)
+        std::swap(b, c);
+      this->triangles.push_back(a);
+      this->triangles.push_back(b);
+      this->triangles.push_back(c);
+    }
+
+    /// \brief Triangulates the y monotone piece in @face.
+    ///
+    /// The two chains from the top to the bottom are merged, and the
+    /// vertices that cannot be cut off yet are kept on a stack, which
+    /// takes linear time.
+    void Triangulator::triangulateMonotone() {
+      std::size_t m = this->face.size();
+      if (m < 3)
+        return;
+      if (m == 3) {
+        this->emit(this->face[0], this->face[1], this->face[2]);
+        return;
+      }
+      std::size_t top = 0, bottom = 0;
+      for (std::size_t i = 1; i < m; i++) {
+        if (this->above(this->face[i], this->face[top]))
+          top = i;
+        if (this->above(this->face[bottom], this->face[i]))
+          bottom = i;
+      }
+      // the piece is counterclockwise, so the left chain follows it
+      this->sorted.clear();
+      this->onLeft.clear();
+      this->sorted.push_back(this->face[top]);
+      this->onLeft.push_back(0);
+      std::size_t left = (top + 1)%m, right = (top + m - 1)%m;
+      while (left != bottom || right != bottom) {
+        if (right == bottom || (left != bottom && this->above(this->face[left], this->face[right]))) {
+          this->sorted.push_back(this->face[left]);
+          this->onLeft.push_back(1);
+          left = (left + 1)%m;
+        } else {
+          this->sorted.push_back(this->face[right]);
+          this->onLeft.push_back(0);
+          right = (right + m - 1)%m;
+        }
+      }
+      this->sorted.push_back(this->face[bottom]);
+      this->onLeft.push_back(0);
+
+      std::vector<unsigned int>& stack = this->stack;
+      stack.clear();
+      stack.push_back(0);
+      stack.push_back(1);
+      for (std::size_t j = 2; j + 1 < m; j++) {
+        unsigned int vertex = this->sorted[j];
+        if (this->onLeft[j] != this->onLeft[stack.back()]) {
+          // fan to the whole other chain
+          while (stack.size() > 1) {
+            unsigned int last = stack.back();
+            stack.pop_back();
+            this->emit(vertex, this->sorted[last], this->sorted[stack.back()]);
+          }
+          stack.clear();
+          stack.push_back(j - 1);
+          stack.push_back(j);
+        } else {
+          // cut off the vertices of this chain that it sees
+          unsigned int last = stack.back();
+          stack.pop_back();
+          while (!stack.empty()) {
+            const Point& p = this->points[this->sorted[stack.back()]];
+            const Point& q = this->points[this->sorted[last]];
+            const Point& r = this->points[vertex];
+            if ((this->onLeft[j] ? orientation(p, q, r) : orientation(r, q, p)) <= 0)
+              break;
+            this->emit(vertex, this->sorted[last], this->sorted[stack.back()]);
+            last = stack.back();
+            stack.pop_back();
+          }
+          stack.push_back(last);
+          stack.push_back(j);
+        }
+      }
+      while (stack.size() > 1) {
+        unsigned int last = stack.back();
+        stack.pop_back();
+        this->emit(this->sorted[m - 1], this->sorted[last], this->sorted[stack.back()]);
+      }
+    }
+
+    std::size_t Triangulator::triangulate(Span<const CoordPnt> vertices, TriangleMesh& mesh) {
+      this->points.clear();
+      for (std::size_t i = 0; i < vertices.size(); i++) {
+        Point pnt = {vertices[i].getX(), vertices[i].getY()};
+        if (this->points.empty() || pnt.x != this->points.back().x ||
+            pnt.y != this->points.back().y)
+          this->points.push_back(pnt);
+      }
+      while (this->points.size() > 1 && this->points.back().x == this->points[0].x &&
+             this->points.back().y == this->points[0].y)
+        this->points.pop_back();
+      std::size_t n = this->points.size();
+      if (n < 3)
+        return 0;
+      double area = 0;
+      for (std::size_t i = 0; i < n; i++)
+        area += orientation(this->points[0], this->points[i], this->points[(i + 1)%n]);
+      if (area == 0)
+        return 0;
+      if (area < 0)
+        std::reverse(this->points.begin(), this->points.end());
+      std::size_t base = mesh.getVertexCount();
+      if (base + n > std::numeric_limits<uint32_t>::max()) {
+        std::stringstream errorMsg;
+        errorMsg << "A mesh can hold at most " << std::numeric_limits<uint32_t>::max()
+                 << " vertices.";
+        throw std::length_error(errorMsg.str());
+      }
+
+      this->triangles.clear();
+      this->partition();
+      this->extractFaces();
+
+      // weld the copies of the vertices that keyholes visit twice
+      std::vector<unsigned int>& byPosition = this->order;
+      std::sort(byPosition.begin(), byPosition.end(), [this](unsigned int a, unsigned int b) {
+          const Point& p = this->points[a];
+          const Point& q = this->points[b];
+          if (p.x != q.x)
+            return p.x < q.x;
+          if (p.y != q.y)
+            return p.y < q.y;
+          return a < b;
+        });
+      std::vector<unsigned int>& canonical = this->sorted;
+      canonical.resize(n);
+      for (std::size_t i = 0; i < n; i++) {
+        unsigned int vertex = byPosition[i];
+        canonical[vertex] = vertex;
+        if (i > 0) {
+          unsigned int previous = byPosition[i - 1];
+          if (this->points[previous].x == this->points[vertex].x &&
+              this->points[previous].y == this->points[vertex].y)
+            canonical[vertex] = canonical[previous];
+        }
+      }
+      this->meshIndex.resize(n);
+      uint32_t count = base;
+      for (std::size_t i = 0; i < n; i++)
+        if (canonical[i] == i) {
+          this->meshIndex[i] = count++;
+          mesh.coordinates.push_back(this->points[i].x);
+          mesh.coordinates.push_back(this->points[i].y);
+        }
+      for (std::size_t i = 0; i < n; i++)
+        this->meshIndex[i] = this->meshIndex[canonical[i]];
+
+      std::size_t added = 0;
+      for (std::size_t i = 0; i < this->triangles.size(); i += 3) {
+        uint32_t a = this->meshIndex[this->triangles[i]];
+        uint32_t b = this->meshIndex[this->triangles[i + 1]];
+        uint32_t c = this->meshIndex[this->triangles[i + 2]];
+        if (a == b || b == c || c == a)
+          continue;
+        mesh.indices.push_back(a);
+        mesh.indices.push_back(b);
+        mesh.indices.push_back(c);
+        added++;
+      }
+      return added;
+    }
+
+    /// \brief A cell placed in the flattened cell.
+    struct Instance {
+      unsigned int cell;
+      utils::Transform transform;
+    };
+
+    /// \brief The triangles of a block of consecutive polygons.
+    struct Block {
+      TriangleMesh mesh;
+      std::vector<std::size_t> vertexCounts; //!< The vertices of each polygon.
+      std::vector<std::size_t> triangleCounts; //!< The triangles of each polygon.
+    };
+
+  } // namespace
+
+  std::size_t triangulatePolygon(Span<const CoordPnt> vertices, TriangleMesh& mesh) {
+    Triangulator triangulator;
+    return triangulator.triangulate(vertices, mesh);
+  }
+
+  std::vector<LayerMesh> triangulate(const FrozenLayout& layout, std::size_t cell,
+                                     TriangulationOptions options) {
+    layout.getCell(cell); // throws if there is no such cell
+    std::size_t numCells = layout.getCellCount();
+
+    // the layers to triangulate
+    std::vector<int> layers;
+    for (std::size_t c = 0; c < numCells; c++) {
+      const FrozenCell& frozen = layout.getCell(c);
+      for (std::size_t j = 0; j < frozen.polygons.size(); j++) {
+        int layer = frozen.polygons[j].layer;
+        if (options.layers.empty() ||
+            std::find(options.layers.begin(), options.layers.end(), layer) != options.layers.end())
+          layers.push_back(layer);
+      }
+    }
+    std::sort(layers.begin(), layers.end());
+    layers.erase(std::unique(layers.begin(), layers.end()), layers.end());
+    std::size_t numSlots = layers.size();
+
+    // the cells that hold polygons on those layers, or place such cells
+    std::vector<char> relevant(numCells, 0);
+    Span<const unsigned int> order = layout.getHierarchicalOrder();
+    for (std::size_t i = 0; i < order.size(); i++) {
+      const FrozenCell& frozen = layout.getCell(order[i]);
+      for (std::size_t j = 0; j < frozen.polygons.size() && !relevant[order[i]]; j++)
+        relevant[order[i]] = std::binary_search(layers.begin(), layers.end(),
+                                                frozen.polygons[j].layer);
+      for (std::size_t j = 0; j < frozen.children.size(); j++)
+        relevant[order[i]] = relevant[order[i]] || relevant[frozen.children[j]];
+    }
+
+    // every placement of such a cell
+    std::vector<Instance> instances;
+    std::vector<Instance> pending(1);
+    pending[0].cell = cell;
+    std::vector<char> placed(numCells, 0);
+    while (!pending.empty()) {
+      Instance instance = pending.back();
+      pending.pop_back();
+      if (!relevant[instance.cell])
+        continue;
+      instances.push_back(instance);
+      placed[instance.cell] = 1;
+      const FrozenCell& frozen = layout.getCell(instance.cell);
+      for (std::size_t j = 0; j < frozen.references.size(); j++) {
+        const FrozenReference& ref = frozen.references[j];
+        Instance child = {ref.cell, instance.transform.after(
+            utils::Transform(ref.magnification, ref.rotation, ref.position))};
+        pending.push_back(child);
+      }
+      for (std::size_t j = 0; j < frozen.arrays.size(); j++) {
+        const FrozenArray& array = frozen.arrays[j];
+        if (!relevant[array.cell])
+          continue;
+        utils::Transform first(array.magnification, array.rotation, array.startingPos);
+        for (int col = 0; col < array.numCol; col++)
+          for (int row = 0; row < array.numRow; row++) {
+            Instance child = {array.cell, instance.transform.after(
+                first.shifted(col*array.xSpacing, row*array.ySpacing))};
+            pending.push_back(child);
+          }
+      }
+    }
+
+    // the polygons of the placed cells, by cell and layer
+    std::vector<std::pair<unsigned int, unsigned int>> jobs; // cell and polygon
+    std::vector<std::size_t> firstJob(numCells*numSlots + 1, 0);
+    for (std::size_t c = 0; c < numCells; c++) {
+      const FrozenCell& frozen = layout.getCell(c);
+      for (std::size_t slot = 0; slot < numSlots; slot++) {
+        firstJob[c*numSlots + slot] = jobs.size();
+        if (!placed[c])
+          continue;
+        for (std::size_t j = 0; j < frozen.polygons.size(); j++)
+          if (frozen.polygons[j].layer == layers[slot])
+            jobs.push_back(std::make_pair(static_cast<unsigned int>(c),
+                                          static_cast<unsigned int>(j)));
+      }
+    }
+    firstJob[numCells*numSlots] = jobs.size();
+
+    // triangulate every polygon once, in blocks
+    std::vector<Block> blocks((jobs.size() + JOBS_PER_BLOCK - 1)/JOBS_PER_BLOCK);
+    utils::parallelFor(blocks.size(), [&](std::size_t b) {
+        Block& block = blocks[b];
+        Triangulator triangulator;
+        std::size_t end = std::min(jobs.size(), (b + 1)*JOBS_PER_BLOCK);
+        for (std::size_t j = b*JOBS_PER_BLOCK; j < end; j++) {
+          const FrozenPolygon& polygon = layout.getCell(jobs[j].first).polygons[jobs[j].second];
+          std::size_t before = block.mesh.getVertexCount();
+          block.triangleCounts.push_back(triangulator.triangulate(polygon.vertices, block.mesh));
+          block.vertexCounts.push_back(block.mesh.getVertexCount() - before);
+        }
+      });
+
+    // where the vertices and triangles of every polygon start in their
+    // block, and how many each cell has on each layer
+    std::vector<std::size_t> vertexFirst(jobs.size()), triangleFirst(jobs.size());
+    for (std::size_t b = 0; b < blocks.size(); b++) {
+      std::size_t vertices = 0, triangles = 0;
+      for (std::size_t i = 0; i < blocks[b].vertexCounts.size(); i++) {
+        vertexFirst[b*JOBS_PER_BLOCK + i] = vertices;
+        triangleFirst[b*JOBS_PER_BLOCK + i] = triangles;
+        vertices += blocks[b].vertexCounts[i];
+        triangles += blocks[b].triangleCounts[i];
+      }
+    }
+    std::vector<std::size_t> ownVertices(numCells*numSlots, 0);
+    std::vector<std::size_t> ownTriangles(numCells*numSlots, 0);
+    for (std::size_t k = 0; k < numCells*numSlots; k++)
+      for (std::size_t j = firstJob[k]; j < firstJob[k + 1]; j++) {
+        ownVertices[k] += blocks[j/JOBS_PER_BLOCK].vertexCounts[j%JOBS_PER_BLOCK];
+        ownTriangles[k] += blocks[j/JOBS_PER_BLOCK].triangleCounts[j%JOBS_PER_BLOCK];
+      }
+
+    // where each instance writes its triangles, layer by layer
+    std::size_t numInstances = instances.size();
+    std::vector<std::size_t> vertexOffset(numSlots*numInstances);
+    std::vector<std::size_t> triangleOffset(numSlots*numInstances);
+    std::vector<LayerMesh> result(numSlots);
+    for (std::size_t slot = 0; slot < numSlots; slot++) {
+      std::size_t numVertices = 0, numTriangles = 0;
+      for (std::size_t i = 0; i < numInstances; i++) {
+        vertexOffset[slot*numInstances + i] = numVertices;
+        triangleOffset[slot*numInstances + i] = numTriangles;
+        numVertices += ownVertices[instances[i].cell*numSlots + slot];
+        numTriangles += ownTriangles[instances[i].cell*numSlots + slot];
+      }
+      if (numVertices > std::numeric_limits<uint32_t>::max()) {
+        std::stringstream errorMsg;
+        errorMsg << "Layer " << layers[slot] << " of the flattened cell has " << numVertices
+                 << " vertices, more than a mesh can hold.";
+        throw std::length_error(errorMsg.str());
+      }
+      result[slot].layer = layers[slot];
+      result[slot].mesh.coordinates.resize(2*numVertices);
+      result[slot].mesh.indices.resize(3*numTriangles);
+    }
+
+    utils::parallelFor(numInstances, [&](std::size_t i) {
+        const Instance& instance = instances[i];
+        for (std::size_t slot = 0; slot < numSlots; slot++) {
+          TriangleMesh& target = result[slot].mesh;
+          std::size_t vertex = vertexOffset[slot*numInstances + i];
+          std::size_t triangle = triangleOffset[slot*numInstances + i];
+          std::size_t key = instance.cell*numSlots + slot;
+          for (std::size_t j = firstJob[key]; j < firstJob[key + 1]; j++) {
+            const Block& block = blocks[j/JOBS_PER_BLOCK];
+            std::size_t vertexCount = block.vertexCounts[j%JOBS_PER_BLOCK];
+            std::size_t triangleCount = block.triangleCounts[j%JOBS_PER_BLOCK];
+            const double* source = &block.mesh.coordinates[2*vertexFirst[j]];
+            for (std::size_t k = 0; k < vertexCount; k++) {
+              CoordPnt mapped = instance.transform.apply(CoordPnt(source[2*k], source[2*k + 1]));
+              target.coordinates[2*(vertex + k)] = mapped.getX();
+              target.coordinates[2*(vertex + k) + 1] = mapped.getY();
+            }
+            // the placements only rotate and scale, which keeps the
+            // triangles counterclockwise
+            const uint32_t* indices = &block.mesh.indices[3*triangleFirst[j]];
+            for (std::size_t k = 0; k < 3*triangleCount; k++)
+              target.indices[3*triangle + k] = indices[k] - vertexFirst[j] + vertex;
+            vertex += vertexCount;
+            triangle += triangleCount;
+          }
+        }
+      });
+    return result;
+  }
+
+  std::vector<LayerMesh> triangulate(const Cell& cell, TriangulationOptions options) {
+    return triangulate(*FrozenLayout::freeze(cell), 0, options);
+  }
+
+}
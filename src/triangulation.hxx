@@ -0,0 +1,96 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef TRIANGULATION_HXX
+#define TRIANGULATION_HXX
+
+#include <cstddef>
+#include <vector>
+#include <stdint.h> // cross-compiler integer datatypes
+#include "cell.hxx"
+#include "coord.hxx"
+#include "frozenLayout.hxx"
+#include "span.hxx"
+
+namespace sil {
+
+  /// \brief Triangles over a shared list of vertices, laid out so that
+  /// both buffers can be handed to a graphics API or a mesher as they
+  /// are.
+  struct TriangleMesh {
+    std::vector<double> coordinates; //!< The x and y of every vertex, interleaved.
+    std::vector<uint32_t> indices; //!< Three vertices per triangle, counterclockwise.
+
+    /// \brief Returns the number of vertices.
+    std::size_t getVertexCount(void) const;
+
+    /// \brief Returns the number of triangles.
+    std::size_t getTriangleCount(void) const;
+
+    /// \brief Returns the total area of the triangles.
+    double getArea(void) const;
+  };
+
+  /// \brief The triangles of one layer, see triangulate().
+  struct LayerMesh {
+    int layer;
+    TriangleMesh mesh;
+  };
+
+  /// \brief The settings used by triangulate().
+  struct TriangulationOptions {
+    /// \brief The layers to triangulate, or every layer if empty.
+    std::vector<int> layers;
+  };
+
+  /// \brief Appends the triangles of the polygon @vertices to @mesh and
+  /// returns how many there are.
+  ///
+  /// The polygon must be simple, except that holes may be joined to
+  /// the outline by keyholes: pairs of coincident edges running in
+  /// opposite directions. Either orientation is accepted. The polygon
+  /// is split into pieces that are monotone in y by a sweep over its
+  /// vertices (adding a diagonal at every vertex where the outline
+  /// turns back), and each piece is triangulated in linear time, which
+  /// takes O(n log n) time in all. No vertices are added. The copies of
+  /// a vertex that the keyholes make are welded into one, so the
+  /// triangles around a hole share their edges. Repeated vertices are
+  /// skipped.
+  std::size_t triangulatePolygon(Span<const CoordPnt> vertices, TriangleMesh& mesh);
+
+  /// \brief Triangulates the polygons of @cell and of every Cell it
+  /// places, flattened into one mesh per layer.
+  ///
+  /// @layout The layout to triangulate.
+  /// @cell The index of the Cell in @layout.
+  /// @options The layers.
+  ///
+  /// Every polygon of a Cell is triangulated once, no matter how often
+  /// the Cell is placed, with the polygons of all cells spread over
+  /// every thread. The placements are then copied into the meshes in
+  /// parallel. The meshes are sorted by layer. Paths are not
+  /// triangulated. Throws std::out_of_range if there is no Cell @cell.
+  std::vector<LayerMesh> triangulate(const FrozenLayout& layout, std::size_t cell,
+                                     TriangulationOptions options = TriangulationOptions());
+
+  /// \brief Triangulates @cell, see triangulate().
+  std::vector<LayerMesh> triangulate(const Cell& cell,
+                                     TriangulationOptions options = TriangulationOptions());
+
+}
+
+#endif // TRIANGULATION_HXX
@@ -0,0 +1,273 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "validation.hxx"
+#include "parallel.hxx"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <utility>
+
+namespace sil {
+
+  // the number of open DeferredValidation scopes on this thread
+  static thread_local unsigned int deferredDepth = 0;
+
+  DeferredValidation::DeferredValidation() {
+    deferredDepth++;
+  }
+
+  DeferredValidation::~DeferredValidation() {
+    deferredDepth--;
+  }
+
+  bool DeferredValidation::isActive() {
+    return deferredDepth > 0;
+  }
+
+  unsigned int DeferredValidation::exchangeDepth(unsigned int depth) {
+    std::swap(depth, deferredDepth);
+    return depth;
+  }
+
+  bool ValidationReport::isValid() const {
+    return this->violations.empty();
+  }
+
+  std::size_t ValidationReport::count(ViolationKind kind) const {
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < this->violations.size(); i++)
+      if (this->violations[i].kind == kind)
+        total++;
+    return total;
+  }
+
+  std::string ValidationReport::toString() const {
+    static const char* const elementNames[] = {"polygon", "path", "reference", "array"};
+    std::ostringstream text;
+    for (std::size_t i = 0; i < this->violations.size(); i++) {
+      const Violation& violation = this->violations[i];
+      text << violation.cell->getCellname() << ": "
+           << elementNames[violation.element] << " " << violation.index << ": "
+           << violation.message << "\n";
+    }
+    return text.str();
+  }
+
+  namespace {
+
+    // the elements of a Cell checked by one parallel task
+    const std::size_t ELEMENTS_PER_TASK = 4096;
+
+    // the GDSII writer stores thousandths of a user unit in 32 bits
+    const double DATABASE_UNITS_PER_USER_UNIT = 1e3;
+
+    class Checker {
+    private:
+      const Cell& cell;
+      std::vector<Violation>& violations;
+
+      void add(ElementKind element, std::size_t index, ViolationKind kind,
+               const std::string& message) {
+        Violation violation = {&this->cell, element, index, kind, message};
+        this->violations.push_back(violation);
+      }
+
+      void checkLayer(ElementKind element, std::size_t index, int layer, int dataType) {
+        if (layer < 0 || layer > GDS_MAX_LAYER) {
+          std::ostringstream message;
+          message << "layer " << layer << " is outside of 0-" << GDS_MAX_LAYER;
+          this->add(element, index, LAYER_RANGE, message.str());
+        }
+        if (dataType < 0 || dataType > GDS_MAX_DATATYPE) {
+          std::ostringstream message;
+          message << "datatype " << dataType << " is outside of 0-" << GDS_MAX_DATATYPE;
+          this->add(element, index, DATATYPE_RANGE, message.str());
+        }
+      }
+
+      static bool fits(double value) {
+        double units = std::round(value*DATABASE_UNITS_PER_USER_UNIT);
+        return units >= std::numeric_limits<int32_t>::min() &&
+          units <= std::numeric_limits<int32_t>::max();
+      }
+
+      void checkPoints(ElementKind element, std::size_t index, Span<const CoordPnt> points) {
+        for (std::size_t i = 0; i < points.size(); i++)
+          if (!fits(points[i].getX()) || !fits(points[i].getY())) {
+            std::ostringstream message;
+            message << "point " << points[i].toString()
+                    << " does not fit 32 bit database units";
+            this->add(element, index, COORDINATE_RANGE, message.str());
+            return;
+          }
+      }
+
+      void checkMagnification(ElementKind element, std::size_t index, double magnification) {
+        if (!(magnification > 0)) {
+          std::ostringstream message;
+          message << "magnification " << magnification << " is not positive";
+          this->add(element, index, MAGNIFICATION, message.str());
+        }
+      }
+
+    public:
+      Checker(const Cell& usrCell, std::vector<Violation>& usrViolations) :
+        cell(usrCell), violations(usrViolations) {}
+
+      void checkPolygon(std::size_t index) {
+        const Polygon& polygon = this->cell.getPolygonList()[index];
+        Span<const CoordPnt> vertices = polygon.getVertexSpan();
+        this->checkLayer(POLYGON_ELEMENT, index, polygon.getLayer(), polygon.getDataType());
+        if (vertices.size() < GDS_MIN_POLYGON_VERTICES ||
+            vertices.size() > GDS_MAX_POLYGON_VERTICES) {
+          std::ostringstream message;
+          message << vertices.size() << " vertices, polygons need "
+                  << GDS_MIN_POLYGON_VERTICES << "-" << GDS_MAX_POLYGON_VERTICES;
+          this->add(POLYGON_ELEMENT, index, VERTEX_COUNT, message.str());
+        }
+        else if (Polygon::containsInternalVoid(vertices))
+          this->add(POLYGON_ELEMENT, index, SELF_INTERSECTION, "edges cross each other");
+        this->checkPoints(POLYGON_ELEMENT, index, vertices);
+      }
+
+      void checkPath(std::size_t index) {
+        const Path& path = this->cell.getPathList()[index];
+        Span<const CoordPnt> points = path.getCoordPathSpan();
+        this->checkLayer(PATH_ELEMENT, index, path.getLayer(), path.getDataType());
+        if (points.size() < GDS_MIN_PATH_POINTS || points.size() > GDS_MAX_PATH_POINTS) {
+          std::ostringstream message;
+          message << points.size() << " points, paths need "
+                  << GDS_MIN_PATH_POINTS << "-" << GDS_MAX_PATH_POINTS;
+          this->add(PATH_ELEMENT, index, VERTEX_COUNT, message.str());
+        }
+        if (path.getPathType() < 0 || path.getPathType() > 2) {
+          std::ostringstream message;
+          message << "path type " << path.getPathType() << " is not 0, 1 or 2";
+          this->add(PATH_ELEMENT, index, PATH_TYPE, message.str());
+        }
+        if (path.getPathWidth() < 0) {
+          std::ostringstream message;
+          message << "width " << path.getPathWidth() << " is negative";
+          this->add(PATH_ELEMENT, index, PATH_WIDTH, message.str());
+        }
+        this->checkPoints(PATH_ELEMENT, index, points);
+      }
+
+      void checkReference(std::size_t index) {
+        const CellReference& ref = this->cell.getCellReferenceList()[index];
+        this->checkMagnification(REFERENCE_ELEMENT, index, ref.getMagnification());
+        CoordPnt center = ref.getCenter();
+        this->checkPoints(REFERENCE_ELEMENT, index, Span<const CoordPnt>(&center, 1));
+      }
+
+      void checkArray(std::size_t index) {
+        const CellArray& array = this->cell.getCellArrayList()[index];
+        this->checkMagnification(ARRAY_ELEMENT, index, array.getMagnification());
+        if (array.getNumCol() < 1 || array.getNumCol() > GDS_MAX_ARRAY_DIMENSION ||
+            array.getNumRow() < 1 || array.getNumRow() > GDS_MAX_ARRAY_DIMENSION) {
+          std::ostringstream message;
+          message << array.getNumCol() << " columns and " << array.getNumRow()
+                  << " rows, arrays need 1-" << GDS_MAX_ARRAY_DIMENSION << " of each";
+          this->add(ARRAY_ELEMENT, index, ARRAY_DIMENSION, message.str());
+        }
+        // the AREF record holds the origin and the far column and row
+        CoordPnt start = array.getStartingPos();
+        CoordPnt corners[3] = {
+          start,
+          CoordPnt(start.getX() + array.getNumCol()*array.getXSpacing(), start.getY()),
+          CoordPnt(start.getX(), start.getY() + array.getNumRow()*array.getYSpacing())
+        };
+        this->checkPoints(ARRAY_ELEMENT, index, Span<const CoordPnt>(corners, 3));
+      }
+
+      // checks the elements [first, last) of the concatenation of the
+      // polygon, path, reference and array lists
+      void checkRange(std::size_t first, std::size_t last) {
+        std::size_t counts[4] = {
+          this->cell.getPolygonList().size(), this->cell.getPathList().size(),
+          this->cell.getCellReferenceList().size(), this->cell.getCellArrayList().size()
+        };
+        std::size_t offset = 0;
+        for (int list = 0; list < 4; list++) {
+          std::size_t begin = std::max(first, offset);
+          std::size_t end = std::min(last, offset + counts[list]);
+          for (std::size_t i = begin; i < end; i++) {
+            switch (list) {
+            case 0: this->checkPolygon(i - offset); break;
+            case 1: this->checkPath(i - offset); break;
+            case 2: this->checkReference(i - offset); break;
+            default: this->checkArray(i - offset); break;
+            }
+          }
+          offset += counts[list];
+        }
+      }
+    };
+
+    std::size_t elementCount(const Cell& cell) {
+      return cell.getPolygonList().size() + cell.getPathList().size() +
+        cell.getCellReferenceList().size() + cell.getCellArrayList().size();
+    }
+
+  } // namespace
+
+  ValidationReport validateCell(const Cell& cell) {
+    std::size_t total = elementCount(cell);
+    std::size_t tasks = (total + ELEMENTS_PER_TASK - 1)/ELEMENTS_PER_TASK;
+    std::vector<std::vector<Violation> > found(tasks);
+    utils::parallelFor(tasks, [&](std::size_t task) {
+        Checker checker(cell, found[task]);
+        checker.checkRange(task*ELEMENTS_PER_TASK,
+                           std::min(total, (task + 1)*ELEMENTS_PER_TASK));
+      });
+    ValidationReport report;
+    for (std::size_t i = 0; i < tasks; i++)
+      report.violations.insert(report.violations.end(), found[i].begin(), found[i].end());
+    return report;
+  }
+
+  ValidationReport validateLayout(const Layout& layout) {
+    // the elements of every cell are split into tasks like in
+    // validateCell(), so one large cell does not run on a single thread
+    struct Task {
+      const Cell* cell;
+      std::size_t first;
+      std::size_t last;
+    };
+    std::vector<Cell*> cells = layout.getCells();
+    std::vector<Task> tasks;
+    for (std::size_t i = 0; i < cells.size(); i++) {
+      std::size_t total = elementCount(*cells[i]);
+      for (std::size_t first = 0; first < total; first += ELEMENTS_PER_TASK) {
+        Task task = {cells[i], first, std::min(total, first + ELEMENTS_PER_TASK)};
+        tasks.push_back(task);
+      }
+    }
+    std::vector<std::vector<Violation> > found(tasks.size());
+    utils::parallelFor(tasks.size(), [&](std::size_t i) {
+        Checker checker(*tasks[i].cell, found[i]);
+        checker.checkRange(tasks[i].first, tasks[i].last);
+      });
+    ValidationReport report;
+    for (std::size_t i = 0; i < tasks.size(); i++)
+      report.violations.insert(report.violations.end(), found[i].begin(), found[i].end());
+    return report;
+  }
+
+} // namespace sil
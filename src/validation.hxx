@@ -0,0 +1,139 @@
+// This file is a part of silhouette (2D Geometry suite)
+//
+// Copyright 2015 Taylor Fryett
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef VALIDATION_HXX
+#define VALIDATION_HXX
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "cell.hxx"
+#include "layout.hxx"
+
+namespace sil {
+
+  const int GDS_MAX_LAYER = 63; //!< The largest layer the shapes accept.
+  const int GDS_MAX_DATATYPE = 63; //!< The largest datatype the shapes accept.
+  const std::size_t GDS_MIN_POLYGON_VERTICES = 3; //!< Fewest vertices of a BOUNDARY.
+  const std::size_t GDS_MAX_POLYGON_VERTICES = 199; //!< Most vertices of a BOUNDARY, without the closing one.
+  const std::size_t GDS_MIN_PATH_POINTS = 2; //!< Fewest points of a PATH.
+  const std::size_t GDS_MAX_PATH_POINTS = 199; //!< Most points of a PATH.
+  const int GDS_MAX_ARRAY_DIMENSION = 32767; //!< Most columns or rows of an AREF.
+
+  /// \brief Turns off the checks made while shapes are built, for as
+  /// long as an object of this class exists on the calling thread.
+  ///
+  /// Trusted generators that make many shapes can skip the vertex count,
+  /// self intersection, layer and datatype checks of every Polygon, Path
+  /// and CellArray they build:
+  ///
+  ///   {
+  ///     sil::DeferredValidation deferred;
+  ///     ... build the cells ...
+  ///   }
+  ///   sil::ValidationReport report = sil::validateLayout(layout);
+  ///
+  /// Invalid values are stored as given, so validateCell() or
+  /// validateLayout() should be run before the Layout is written. Scopes
+  /// may nest.
+  ///
+  /// A scope covers the thread that created it and the tasks that thread
+  /// starts through a TaskGroup, which includes the iterations of
+  /// utils::parallelFor() and so CellShards filled with it. Threads
+  /// started any other way, such as a std::thread, are not covered and
+  /// need a scope of their own.
+  class DeferredValidation {
+  private:
+    friend class TaskGroup;
+
+    /// \brief Sets the number of open scopes of the calling thread to
+    /// @depth and returns the previous number, so that a task runs
+    /// with the scopes of the thread that started it.
+    static unsigned int exchangeDepth(unsigned int depth);
+
+  public:
+    DeferredValidation(void);
+    ~DeferredValidation(void);
+
+    DeferredValidation(const DeferredValidation&) = delete;
+    DeferredValidation& operator=(const DeferredValidation&) = delete;
+
+    /// \brief Returns true if the calling thread is inside a
+    /// DeferredValidation scope.
+    static bool isActive(void);
+  };
+
+  /// \brief The kinds of element a Violation can be found in.
+  enum ElementKind {
+    POLYGON_ELEMENT,
+    PATH_ELEMENT,
+    REFERENCE_ELEMENT,
+    ARRAY_ELEMENT
+  };
+
+  /// \brief The rules validateCell() checks.
+  enum ViolationKind {
+    VERTEX_COUNT, //!< Too few or too many vertices or points.
+    SELF_INTERSECTION, //!< Edges of a polygon cross each other.
+    LAYER_RANGE, //!< The layer is outside of 0 to GDS_MAX_LAYER.
+    DATATYPE_RANGE, //!< The datatype is outside of 0 to GDS_MAX_DATATYPE.
+    PATH_TYPE, //!< The path type is not 0, 1 or 2.
+    PATH_WIDTH, //!< The path width is negative.
+    COORDINATE_RANGE, //!< A coordinate does not fit a 32 bit integer in database units.
+    MAGNIFICATION, //!< The magnification is not positive.
+    ARRAY_DIMENSION //!< The columns or rows are outside of 1 to GDS_MAX_ARRAY_DIMENSION.
+  };
+
+  /// \brief One broken rule.
+  struct Violation {
+    const Cell* cell; //!< The Cell holding the element.
+    ElementKind element; //!< The list of @cell the element is in.
+    std::size_t index; //!< The position of the element in that list.
+    ViolationKind kind; //!< The rule that is broken.
+    std::string message; //!< A description for people.
+  };
+
+  /// \brief The result of validateCell() and validateLayout().
+  struct ValidationReport {
+    /// \brief Every violation found, ordered by Cell, then by element
+    /// list and position.
+    std::vector<Violation> violations;
+
+    /// \brief Returns true if no rule is broken.
+    bool isValid(void) const;
+
+    /// \brief Returns the number of violations of @kind.
+    std::size_t count(ViolationKind kind) const;
+
+    /// \brief Returns the messages, one per line, prefixed with the
+    /// cell name and the element.
+    std::string toString(void) const;
+  };
+
+  /// \brief Checks every element of @cell against the GDSII limits.
+  ///
+  /// The elements are checked in parallel. Referenced cells are not
+  /// checked.
+  ValidationReport validateCell(const Cell& cell);
+
+  /// \brief Checks every Cell of @layout against the GDSII limits, the
+  /// cells in parallel.
+  ValidationReport validateLayout(const Layout& layout);
+
+} // namespace sil
+
+#endif // VALIDATION_HXX
@@ -0,0 +1,126 @@
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "testUtils.hxx"
+
+int main() {
+  int failures = 0;
+  sil::Arena arena(1 << 16);
+  {
+    sil::Layout layout(&arena);
+    failures += check(layout.getMemoryResource() == &arena, "the layout keeps its resource");
+    sil::Cell& leaf = layout.createCell("Leaf");
+    failures += check(leaf.getMemoryResource() == &arena, "created cells use the arena");
+    for (int i = 0; i < 1000; i++)
+      leaf.addPolygon(sil::Square(sil::CoordPnt(3 * i, 0), 1));
+    std::vector<sil::CoordPnt> points;
+    points.push_back(sil::CoordPnt(0, 0));
+    points.push_back(sil::CoordPnt(10, 10));
+    leaf.addPath(sil::Path(points, 1));
+    sil::Cell& top = layout.createCell("Top");
+    top.addCellReference(sil::CellReference(leaf, sil::CoordPnt(0, 0)));
+
+    failures += check(arena.getBytesInUse() > 1000 * 4 * sizeof(sil::CoordPnt),
+		      "the vertices come from the arena");
+    failures += check(arena.getBlockCount() > 1, "the arena grows by blocks");
+    failures += check(arena.getBytesReserved() >= arena.getBytesInUse(),
+		      "the blocks hold the memory in use");
+    sil::PolygonList& polygons = leaf.getPolygonList();
+    failures += check(polygons[0].getVertices().get_allocator().resource() == &arena,
+		      "polygons added to the cell allocate from the arena");
+    failures += check(leaf.getPathList()[0].getCoordPath().size() == 2, "paths keep their points");
+    failures += check(polygons[999].getVertices().size() == 4 &&
+		      polygons[999].getVertices().get_allocator().resource() == &arena,
+		      "vertices survive growing the list");
+
+    // copies outside the cell use the default resource again
+    sil::Polygon copy = polygons[0];
+    failures += check(copy.getVertices().get_allocator().resource() ==
+		      std::pmr::get_default_resource(), "plain copies use the default resource");
+
+    // cells not made by the layout are unaffected
+    sil::Cell plain("Plain");
+    failures += check(plain.getMemoryResource() == std::pmr::get_default_resource(),
+		      "cells use the default resource by default");
+    layout.write("arenaTest.gds");
+  }
+  arena.release();
+  failures += check(arena.getBlockCount() == 0 && arena.getBytesReserved() == 0,
+		    "release returns every block");
+
+  // threads allocate concurrently without overlapping
+  const std::size_t numThreads = 4;
+  const std::size_t numAllocations = 20000;
+  std::vector<std::vector<unsigned int*> > pieces(numThreads);
+  std::vector<std::thread> workers;
+  for (std::size_t t = 0; t < numThreads; t++)
+    workers.push_back(std::thread([&arena, &pieces, t, numAllocations]() {
+	  for (std::size_t i = 0; i < numAllocations; i++) {
+	    unsigned int* piece = static_cast<unsigned int*>(arena.allocate(3 * sizeof(unsigned int),
+									      alignof(unsigned int)));
+	    piece[0] = piece[1] = piece[2] = t * numAllocations + i;
+	    pieces[t].push_back(piece);
+	  }
+	}));
+  for (std::size_t t = 0; t < workers.size(); t++)
+    workers[t].join();
+  bool intact = true;
+  for (std::size_t t = 0; t < numThreads; t++)
+    for (std::size_t i = 0; i < numAllocations; i++)
+      for (int j = 0; j < 3; j++)
+	intact = intact && pieces[t][i][j] == t * numAllocations + i;
+  failures += check(intact, "concurrent allocations do not overlap");
+  failures += check(arena.getBytesAllocated() == numThreads * numAllocations * 3 * sizeof(unsigned int),
+		    "concurrent allocations are counted");
+  arena.release();
+  void* again = arena.allocate(16, 8);
+  failures += check(again != NULL && arena.getBlockCount() == 1,
+		    "threads take new blocks after a release");
+
+  // a thread alternating between many arenas keeps a block in each
+  std::vector<std::unique_ptr<sil::Arena> > arenas;
+  for (int i = 0; i < 10; i++)
+    arenas.push_back(std::unique_ptr<sil::Arena>(new sil::Arena(1 << 16)));
+  bool oneBlockEach = true;
+  for (int round = 0; round < 200; round++)
+    for (std::size_t i = 0; i < arenas.size(); i++)
+      oneBlockEach = arenas[i]->allocate(32, 8) != NULL && oneBlockEach;
+  for (std::size_t i = 0; i < arenas.size(); i++)
+    oneBlockEach = oneBlockEach && arenas[i]->getBlockCount() == 1 &&
+      arenas[i]->getBytesAllocated() == 200 * 32;
+  failures += check(oneBlockEach, "alternating between arenas keeps their blocks");
+
+  // threads beyond THREAD_BLOCKS share a block
+  const std::size_t manyThreads = sil::Arena::THREAD_BLOCKS + 8;
+  sil::Arena crowded(1 << 16);
+  std::atomic<std::size_t> started(0);
+  std::vector<std::vector<std::size_t*> > crowdPieces(manyThreads);
+  std::vector<std::thread> crowd;
+  for (std::size_t t = 0; t < manyThreads; t++)
+    crowd.push_back(std::thread([&, t]() {
+	  // every thread is alive at once, so none reuses another's index
+	  started++;
+	  while (started < manyThreads)
+	    std::this_thread::yield();
+	  for (std::size_t i = 0; i < 100; i++) {
+	    std::size_t* piece = static_cast<std::size_t*>(crowded.allocate(sizeof(std::size_t),
+									   alignof(std::size_t)));
+	    *piece = t * 100 + i;
+	    crowdPieces[t].push_back(piece);
+	  }
+	}));
+  for (std::size_t t = 0; t < crowd.size(); t++)
+    crowd[t].join();
+  intact = true;
+  for (std::size_t t = 0; t < manyThreads; t++)
+    for (std::size_t i = 0; i < 100; i++)
+      intact = intact && *crowdPieces[t][i] == t * 100 + i;
+  failures += check(intact && crowded.getBytesAllocated() == manyThreads * 100 * sizeof(std::size_t),
+		    "threads beyond the thread blocks share one");
+  return failures;
+}
@@ -0,0 +1,100 @@
+#include <math.h>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "testUtils.hxx"
+
+const double PI = acos(-1);
+
+// Collects the first vertex of every polygon in @cell, including those
+// placed through references and arrays (one level deep), on a 1 nm grid.
+std::vector<std::pair<long, long> > flatAnchors(const sil::Cell& cell) {
+  std::vector<std::pair<long, long> > anchors;
+  sil::PolygonList& polygons = cell.getPolygonList();
+  for (unsigned int i = 0; i < polygons.size(); i++)
+    anchors.push_back(std::make_pair(lround(polygons[i].getVertices()[0].getX()*1e3),
+				     lround(polygons[i].getVertices()[0].getY()*1e3)));
+  sil::CellReferenceList& refs = cell.getCellReferenceList();
+  for (unsigned int i = 0; i < refs.size(); i++) {
+    const sil::CoordPnt& origin = refs[i].getReferencedCell().getPolygonList()[0].getVertices()[0];
+    anchors.push_back(std::make_pair(lround((origin.getX() + refs[i].getCenter().getX())*1e3),
+				     lround((origin.getY() + refs[i].getCenter().getY())*1e3)));
+  }
+  sil::CellArrayList& arrays = cell.getCellArrayList();
+  for (unsigned int i = 0; i < arrays.size(); i++) {
+    const sil::CoordPnt& origin = arrays[i].getReferencedCell().getPolygonList()[0].getVertices()[0];
+    for (int row = 0; row < arrays[i].getNumRow(); row++)
+      for (int col = 0; col < arrays[i].getNumCol(); col++) {
+	double x = arrays[i].getStartingPos().getX() + col*arrays[i].getXSpacing();
+	double y = arrays[i].getStartingPos().getY() + row*arrays[i].getYSpacing();
+	anchors.push_back(std::make_pair(lround((origin.getX() + x)*1e3),
+					 lround((origin.getY() + y)*1e3)));
+      }
+  }
+  std::sort(anchors.begin(), anchors.end());
+  return anchors;
+}
+
+int main() {
+  sil::Layout layout;
+  sil::Cell crystal = sil::Cell("Crystal");
+
+  // a triangular lattice of holes with a line defect, the same kind of
+  // structure that tests/test.cxx generates
+  double period = 0.264;
+  for (int row = -10; row <= 10; row++)
+    for (int col = -15; col <= 15; col++) {
+      if (row == 0 && std::abs(col) < 2)
+	continue;
+      double x = col*period + (row % 2 != 0 ? period/2 : 0);
+      double y = row*period*sin(PI/3.);
+      crystal.addPolygon(sil::Circle(sil::CoordPnt(x, y), 0.07));
+    }
+  // a few one-off shapes that must be left alone
+  crystal.addPolygon(sil::Rectangle(sil::CoordPnt(0, 10), 5, 1));
+  crystal.addPolygon(sil::Circle(sil::CoordPnt(3, 3), 0.02));
+
+  // a regular grid of references that should collapse into an array
+  sil::Cell marker = sil::Cell("Marker");
+  marker.addPolygon(sil::Square(sil::CoordPnt(0, 0), 1));
+  for (int i = 0; i < 6; i++)
+    for (int j = 0; j < 3; j++)
+      crystal.addCellReference(sil::CellReference(marker, sil::CoordPnt(20 + 5*i, 10*j)));
+  layout.addCell(marker);
+  layout.addCell(crystal);
+
+  std::vector<std::pair<long, long> > before = flatAnchors(crystal);
+  unsigned int polygonsBefore = crystal.getPolygonList().size();
+  sil::ArrayDetectionStats stats = sil::detectArrays(layout, crystal);
+  std::vector<std::pair<long, long> > after = flatAnchors(crystal);
+
+  int failures = 0;
+  failures += check(before == after, "flattened placements are unchanged");
+  failures += check(stats.polygonsReplaced == polygonsBefore - 2,
+		    "every repeated hole moved into a child cell");
+  failures += check(crystal.getPolygonList().size() == 2,
+		    "one-off shapes stay in the cell");
+  failures += check(stats.cellsCreated == 1, "one child cell per repeated shape");
+  failures += check(crystal.getCellArrayList().size() <= 8,
+		    "the lattice collapses into a handful of arrays");
+  failures += check(stats.referencesReplaced == 18 &&
+		    crystal.getCellReferenceList().size() <= 2,
+		    "the grid of references collapses into an array");
+
+  // a pair of references is left alone like a pair of shapes
+  sil::Cell pair = sil::Cell("Pair");
+  pair.addCellReference(sil::CellReference(marker, sil::CoordPnt(0, 0)));
+  pair.addCellReference(sil::CellReference(marker, sil::CoordPnt(5, 0)));
+  failures += check(sil::detectArrays(layout, pair).referencesReplaced == 0 &&
+		    pair.getCellArrayList().empty(), "rare references are left alone");
+  sil::ArrayDetectionOptions options;
+  options.minInstances = 2;
+  failures += check(sil::detectArrays(layout, pair, options).referencesReplaced == 2,
+		    "a pair becomes an array when that is smaller");
+
+  layout.write("arrayDetectionTest.gds");
+  layout.writeOASIS("arrayDetectionTest.oas");
+  return failures;
+}
@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "../src/gdsfile.hxx"
+#include "testUtils.hxx"
+
+std::string readFile(std::string filename) {
+  std::ifstream file(filename.c_str(), std::ios::binary);
+  return std::string((std::istreambuf_iterator<char>(file)),
+		     std::istreambuf_iterator<char>());
+}
+
+// Returns the STRNAME of every structure in the GDSII file @filename.
+std::vector<std::string> structureNames(std::string filename) {
+  std::string data = readFile(filename);
+  std::vector<std::string> names;
+  for (size_t i = 0; i + 4 <= data.size();) {
+    size_t size = ((unsigned char) data[i] << 8) | (unsigned char) data[i + 1];
+    int16_t record = ((unsigned char) data[i + 2] << 8) | (unsigned char) data[i + 3];
+    if (size < 4)
+      break;
+    if (record == sil::utils::STRNAME) {
+      std::string name = data.substr(i + 4, size - 4);
+      names.push_back(name.substr(0, name.find('\0')));
+    }
+    i += size;
+  }
+  return names;
+}
+
+int main() {
+  sil::Layout layout;
+  sil::Cell& leaf = layout.createCell("Leaf");
+  leaf.addPolygon(sil::Square(sil::CoordPnt(0, 0), 1));
+  sil::Cell& block = layout.createCell("Block");
+  block.addCellArray(sil::CellArray(leaf, sil::CoordPnt(0, 0), 4, 4, 2, 2));
+  block.addCellReference(sil::CellReference(leaf, sil::CoordPnt(20, 0)));
+  sil::Cell& top = layout.createCell("Top");
+  top.addCellReference(sil::CellReference(block, sil::CoordPnt(0, 0)));
+  top.addCellReference(sil::CellReference(leaf, sil::CoordPnt(-5, 0)));
+  sil::Cell& unused = layout.createCell("Unused");
+  unused.addCellReference(sil::CellReference(leaf, sil::CoordPnt(0, 0)));
+  // placed by the top cell without being part of the layout
+  sil::Cell outside = sil::Cell("Outside");
+  outside.addPolygon(sil::Square(sil::CoordPnt(0, 0), 1));
+  top.addCellReference(sil::CellReference(outside, sil::CoordPnt(9, 9)));
+
+  int failures = 0;
+  sil::CellGraph graph(layout);
+  failures += check(graph.size() == 5 && graph.getLayoutCellCount() == 4,
+		    "referenced cells outside the layout are nodes too");
+  failures += check(graph.getChildren(graph.getNode(block)).size() == 1,
+		    "children are distinct");
+  failures += check(graph.getParents(graph.getNode(leaf)).size() == 3,
+		    "parents are distinct");
+  failures += check(!graph.hasCycle(), "the hierarchy has no cycle");
+
+  std::vector<unsigned int> order = graph.topologicalOrder();
+  std::vector<unsigned int> position(graph.size());
+  for (unsigned int i = 0; i < order.size(); i++)
+    position[order[i]] = i;
+  bool childrenFirst = order.size() == graph.size();
+  for (unsigned int node = 0; node < graph.size(); node++)
+    for (unsigned int i = 0; i < graph.getChildren(node).size(); i++)
+      childrenFirst = childrenFirst && position[graph.getChildren(node)[i]] < position[node];
+  failures += check(childrenFirst, "children come before their parents");
+  failures += check(graph.getLevels().size() == 3, "three levels");
+
+  std::vector<unsigned int> tops = graph.topCells();
+  failures += check(tops.size() == 2 && &graph.getCell(tops[0]) == &top &&
+		    &graph.getCell(tops[1]) == &unused, "top cells are found");
+
+  // every node sees all of its children finished
+  std::vector<std::atomic<int> > depth(graph.size());
+  for (unsigned int node = 0; node < graph.size(); node++)
+    depth[node] = -1;
+  bool ordered = true;
+  graph.parallelBottomUp([&](unsigned int node) {
+      int deepest = -1;
+      for (unsigned int i = 0; i < graph.getChildren(node).size(); i++) {
+	int childDepth = depth[graph.getChildren(node)[i]];
+	if (childDepth < 0)
+	  ordered = false;
+	deepest = std::max(deepest, childDepth);
+      }
+      depth[node] = deepest + 1;
+    });
+  failures += check(ordered && depth[graph.getNode(top)] == 2,
+		    "bottom up traversal visits children first");
+
+  std::vector<const sil::Cell*> keep(1, &top);
+  failures += check(sil::pruneUnreachableCells(layout, keep) == 1,
+		    "one cell is unreachable");
+  failures += check(layout.findCell("Unused") == NULL && layout.getCells().size() == 3,
+		    "the unreachable cell is removed");
+
+  // a cycle is reported with the cells that form it
+  leaf.addCellReference(sil::CellReference(top, sil::CoordPnt(0, 0)));
+  sil::CellGraph cyclic(layout);
+  failures += check(cyclic.hasCycle() && cyclic.getCycle().size() == 2,
+		    "the cycle Leaf -> Top -> Leaf is found");
+  bool threw = false;
+  try {
+    layout.write("cellGraphCycle.gds");
+  } catch (std::logic_error& e) {
+    threw = true;
+  }
+  failures += check(threw, "cyclic layouts can not be written");
+
+  // a Cell added twice is written once, along with every other cell
+  sil::Layout twice;
+  sil::Cell alpha("Alpha");
+  alpha.addPolygon(sil::Square(sil::CoordPnt(0, 0), 1));
+  sil::Cell bravo("Bravo");
+  bravo.addPolygon(sil::Square(sil::CoordPnt(5, 0), 1));
+  twice.addCell(alpha);
+  twice.addCell(alpha);
+  twice.addCell(bravo);
+  sil::CellGraph twiceGraph(twice);
+  failures += check(twiceGraph.getLayoutCellCount() == 2 && &twiceGraph.getCell(1) == &bravo,
+		    "cells added twice are one node");
+  twice.write("cellGraphTwice.gds");
+  std::vector<std::string> names = structureNames("cellGraphTwice.gds");
+  failures += check(names.size() == 2 && names[0] != names[1] &&
+		    std::count(names.begin(), names.end(), "Bravo") == 1,
+		    "cells added twice are written once");
+  twice.writeOASIS("cellGraphTwice.oas");
+  failures += check(readFile("cellGraphTwice.oas").find("Bravo") != std::string::npos,
+		    "cells added twice do not hide others in OASIS files");
+
+  return failures;
+}
@@ -0,0 +1,63 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "testUtils.hxx"
+
+int main() {
+  int failures = 0;
+  sil::Arena arena;
+  sil::Layout layout(&arena);
+  sil::Cell& cell = layout.createCell("Shapes");
+
+  std::vector<sil::CoordPnt> triangle;
+  triangle.push_back(sil::CoordPnt(0, 0));
+  triangle.push_back(sil::CoordPnt(4, 0));
+  triangle.push_back(sil::CoordPnt(0, 3));
+  sil::Polygon& emplaced = cell.emplacePolygon(triangle, 5, 2);
+  failures += check(emplaced.getLayer() == 5 && emplaced.getDataType() == 2,
+		    "emplaced polygons take the layer and datatype");
+  failures += check(emplaced.getVertices().get_allocator().resource() == &arena,
+		    "emplaced polygons allocate from the cell's resource");
+
+  // views share the storage of the shape
+  sil::Span<const sil::CoordPnt> span = emplaced.getVertexSpan();
+  failures += check(span.size() == 3 && span.data() == emplaced.getVertices().data(),
+		    "vertex spans do not copy");
+  failures += check(span[1].getX() == 4 && span.back().getY() == 3, "spans index the vertices");
+
+  std::vector<sil::CoordPnt> square;
+  square.push_back(sil::CoordPnt(0, 0));
+  square.push_back(sil::CoordPnt(1, 0));
+  square.push_back(sil::CoordPnt(1, 1));
+  square.push_back(sil::CoordPnt(0, 1));
+  std::vector<sil::Polygon> batch;
+  for (int i = 0; i < 100; i++) {
+    batch.push_back(sil::Polygon(square, 1));
+    batch.back().translate(sil::CoordPnt(2 * i, 0));
+  }
+  cell.addPolygons(batch.begin(), batch.end());
+  failures += check(cell.getPolygonList().size() == 101, "bulk additions add every polygon");
+  failures += check(cell.getPolygonList().back().getVertices().get_allocator().resource() == &arena,
+		    "bulk additions copy into the cell's resource");
+  failures += check(cell.getPolygonList()[100].getVertexSpan()[0].getX() == 198,
+		    "bulk additions keep the order");
+  cell.addPolygons(std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+  failures += check(cell.getPolygonList().size() == 201, "polygons can be moved in");
+
+  sil::Path& path = cell.emplacePath(std::vector<sil::CoordPnt>(triangle.begin(), triangle.end()), 0.5);
+  failures += check(path.getCoordPathSpan().size() == 3 && path.getPathWidth() == 0.5,
+		    "emplaced paths take their points and width");
+  std::vector<sil::CoordPnt> segment = {sil::CoordPnt(0, 0), sil::CoordPnt(7, 0)};
+  path.setCoordPath(segment);
+  failures += check(path.getCoordPathSpan().size() == 2 && path.getCoordPath()[1].getX() == 7,
+		    "points can be set from a vector");
+  std::vector<sil::Path> paths(3, path);
+  cell.addPaths(paths.begin(), paths.end());
+  failures += check(cell.getPathList().size() == 4 &&
+		    cell.getPathList()[3].getCoordPathSpan()[1].getX() == 7,
+		    "paths can be added in bulk");
+
+  layout.write("cellInsertionTest.gds");
+  return failures;
+}
@@ -0,0 +1,81 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "../src/silhouette.hxx"
+#include "testUtils.hxx"
+
+int main() {
+  sil::Layout layout;
+  const int numCells = 20000;
+  for (int i = 0; i < numCells; i++) {
+    std::ostringstream name;
+    name << "Cell_" << i;
+    layout.createCell(name.str());
+  }
+
+  int failures = 0;
+  // constant time lookups keep this loop fast even for many cells
+  int found = 0;
+  for (int i = 0; i < numCells; i++) {
+    std::ostringstream name;
+    name << "Cell_" << i;
+    sil::Cell* cell = layout.findCell(name.str());
+    if (cell != NULL && cell->getCellname() == name.str())
+      found++;
+  }
+  failures += check(found == numCells, "every cell is found by name");
+  failures += check(layout.findCell("Missing") == NULL, "unknown names are not found");
+
+  // renaming is picked up by the next lookup
+  sil::Cell* renamed = layout.findCell("Cell_42");
+  renamed->setCellname("Answer");
+  failures += check(layout.findCell("Answer") == renamed, "renamed cells are found");
+  failures += check(layout.findCell("Cell_42") == NULL, "old names are forgotten");
+
+  // cells added by the user are indexed as well, the first of two cells
+  // with the same name wins until it is removed
+  sil::Cell duplicate = sil::Cell("Answer");
+  layout.addCell(duplicate);
+  failures += check(layout.findCell("Answer") == renamed, "the first cell wins");
+  layout.removeCell(*renamed);
+  failures += check(layout.findCell("Answer") == &duplicate,
+		    "removing a cell uncovers the next one with its name");
+  layout.removeCell(duplicate);
+  failures += check(layout.findCell("Answer") == NULL, "removed cells are not found");
+
+  // a rename only moves its own entry, so renaming and looking up every
+  // cell takes linear time
+  int renamedFound = 0;
+  for (int i = 0; i < numCells; i++) {
+    std::ostringstream name, newName;
+    name << "Cell_" << i;
+    newName << "Renamed_" << i;
+    sil::Cell* cell = layout.findCell(name.str());
+    if (cell == NULL)
+      continue;
+    cell->setCellname(newName.str());
+    if (layout.findCell(newName.str()) == cell && layout.findCell(name.str()) == NULL)
+      renamedFound++;
+  }
+  failures += check(renamedFound == numCells - 1, "every rename is picked up at once");
+
+  // a Cell in two layouts is renamed in both, and leaves them when destroyed
+  {
+    sil::Layout other;
+    sil::Cell* shared = layout.findCell("Renamed_7");
+    other.addCell(*shared);
+    shared->setCellname("Shared");
+    failures += check(layout.findCell("Shared") == shared && other.findCell("Shared") == shared,
+                      "both layouts see the rename");
+    {
+      sil::Cell temporary("Temporary");
+      other.addCell(temporary);
+      failures += check(other.findCell("Temporary") == &temporary, "added cells are found");
+    }
+    failures += check(other.findCell("Temporary") == NULL && other.getCells().size() == 1,
+                      "destroyed cells leave the layout");
+  }
+  failures += check(layout.findCell("Shared") != NULL, "the other layout is gone");
+
+  return failures;
+}
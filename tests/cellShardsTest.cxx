@@ -0,0 +1,114 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "../src/parallel.hxx"
+#include "testUtils.hxx"
+
+// fills one lattice row, the same way serially and from the shards
+template <typename Target>
+void fillRow(Target& target, sil::Cell& hole, int row) {
+  for (int column = 0; column < 200; column++) {
+    std::vector<sil::CoordPnt> vertices;
+    vertices.push_back(sil::CoordPnt(column, row));
+    vertices.push_back(sil::CoordPnt(column + 0.5, row));
+    vertices.push_back(sil::CoordPnt(column, row + 0.5));
+    target.emplacePolygon(vertices, 1, 0);
+  }
+  std::vector<sil::CoordPnt> points;
+  points.push_back(sil::CoordPnt(0, row));
+  points.push_back(sil::CoordPnt(200, row));
+  target.addPath(sil::Path(points, 0.1));
+  target.addCellReference(sil::CellReference(hole, sil::CoordPnt(-1, row)));
+}
+
+bool sameContents(sil::Cell& a, sil::Cell& b) {
+  sil::PolygonList& polygonsA = a.getPolygonList();
+  sil::PolygonList& polygonsB = b.getPolygonList();
+  if (polygonsA.size() != polygonsB.size() ||
+      a.getPathList().size() != b.getPathList().size() ||
+      a.getCellReferenceList().size() != b.getCellReferenceList().size())
+    return false;
+  for (unsigned int i = 0; i < polygonsA.size(); i++) {
+    sil::Span<const sil::CoordPnt> va = polygonsA[i].getVertexSpan();
+    sil::Span<const sil::CoordPnt> vb = polygonsB[i].getVertexSpan();
+    for (unsigned int j = 0; j < va.size(); j++)
+      if (va[j].getX() != vb[j].getX() || va[j].getY() != vb[j].getY())
+	return false;
+  }
+  for (unsigned int i = 0; i < a.getPathList().size(); i++)
+    if (a.getPathList()[i].getCoordPathSpan()[0].getY() !=
+	b.getPathList()[i].getCoordPathSpan()[0].getY())
+      return false;
+  return true;
+}
+
+int main() {
+  int failures = 0;
+  const int numRows = 64;
+  sil::Arena arena;
+  sil::Layout layout(&arena);
+  sil::Cell& hole = layout.createCell("Hole");
+
+  sil::Cell& serial = layout.createCell("Serial");
+  for (int row = 0; row < numRows; row++)
+    fillRow(serial, hole, row);
+
+  sil::Cell& parallel = layout.createCell("Parallel");
+  sil::CellShards shards(parallel, numRows);
+  failures += check(shards.getShardCount() == numRows, "one shard per row");
+  sil::utils::parallelFor(numRows, [&](std::size_t row) {
+      fillRow(shards.getShard(row), hole, row);
+    });
+  failures += check(parallel.getPolygonList().empty(), "nothing is added before the commit");
+  failures += check(shards.getShard(3).size() == 202, "shards buffer their elements");
+  shards.commit();
+  failures += check(sameContents(serial, parallel), "commits follow the shard order");
+  failures += check(shards.getShard(3).size() == 0, "commits empty the shards");
+  failures += check(parallel.getPolygonList().back().getVertices().get_allocator().resource() == &arena,
+		    "committed shapes use the cell's resource");
+
+  // the shards can be filled again and append to what was committed
+  fillRow(shards.getShard(1), hole, numRows + 1);
+  fillRow(shards.getShard(0), hole, numRows);
+  shards.commit();
+  fillRow(serial, hole, numRows);
+  fillRow(serial, hole, numRows + 1);
+  failures += check(sameContents(serial, parallel), "later commits append");
+
+  bool threw = false;
+  try {
+    shards.getShard(numRows);
+  }
+  catch (const std::out_of_range&) {
+    threw = true;
+  }
+  failures += check(threw, "unknown shards throw");
+
+  // threads sharing one arena each bump a block of their own
+  const std::size_t numThreads = 4;
+  sil::Arena sharedArena(1 << 16);
+  sil::Layout sharedLayout(&sharedArena);
+  sil::Cell& threaded = sharedLayout.createCell("Threaded");
+  sil::CellShards threadShards(threaded, numRows);
+  std::vector<std::thread> workers;
+  for (std::size_t t = 0; t < numThreads; t++)
+    workers.push_back(std::thread([&threadShards, &hole, t, numThreads, numRows]() {
+	  for (std::size_t row = t; row < (std::size_t) numRows; row += numThreads)
+	    fillRow(threadShards.getShard(row), hole, row);
+	}));
+  for (std::size_t t = 0; t < workers.size(); t++)
+    workers[t].join();
+  threadShards.commit();
+  sil::Cell& reference = layout.createCell("Reference");
+  for (int row = 0; row < numRows; row++)
+    fillRow(reference, hole, row);
+  failures += check(sameContents(reference, threaded), "threads fill the shards of an arena");
+  failures += check(threaded.getPolygonList()[0].getVertices().get_allocator().resource() ==
+		    &sharedArena && sharedArena.getBytesInUse() > 0,
+		    "threaded shards allocate from the arena");
+  failures += check(sharedArena.getBlockCount() >= numThreads,
+		    "every thread bumps its own block");
+  return failures;
+}
@@ -0,0 +1,85 @@
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "testUtils.hxx"
+
+int main(void) {
+  int failures = 0;
+  // metal 1 on layer 1, metal 2 on layer 3, vias between them on layer 2
+  sil::LayerStack stack;
+  stack.addVia(2, 1, 3);
+  failures += check(stack.getLayers().size() == 3, "stack layers");
+  failures += check(stack.connects(1, 2) && stack.connects(3, 2) && stack.connects(1, 1),
+                    "connected layers");
+  failures += check(!stack.connects(1, 3) && !stack.connects(1, 4), "separate layers");
+
+  sil::Layout layout;
+  sil::Cell& top = layout.createCell("top");
+  sil::Cell& via = layout.createCell("via");
+  via.addPolygon(box(-0.1, -0.1, 0.1, 0.1, 2));
+
+  // net A: a metal 1 wire, a via and a metal 2 wire
+  top.addPolygon(box(0, 0, 2, 1, 1));
+  top.addCellReference(sil::CellReference(via, sil::CoordPnt(1.5, 0.5)));
+  top.addPolygon(box(1, 0, 5, 1, 3));
+  // net B: a bent path on metal 1 that crosses net A's metal 2 without a via
+  std::vector<sil::CoordPnt> bend;
+  bend.push_back(sil::CoordPnt(3, -2));
+  bend.push_back(sil::CoordPnt(3, 3));
+  bend.push_back(sil::CoordPnt(6, 3));
+  top.addPath(sil::Path(bend, 0.2, 0, 1));
+  // the end of the bend is met by a rotated wire of metal 1
+  sil::Cell& wire = layout.createCell("wire");
+  wire.addPolygon(box(0, -0.1, 2, 0.1, 1));
+  sil::CellReference rotated(wire, sil::CoordPnt(6, 3));
+  rotated.setRotation(M_PI/4);
+  top.addCellReference(rotated);
+  // net C and beyond: a row of vias on a metal 2 rail, and separate metal 1 pads
+  sil::Cell& pad = layout.createCell("pad");
+  pad.addPolygon(box(-0.2, -0.2, 0.2, 0.2, 1));
+  pad.addCellReference(sil::CellReference(via));
+  top.addCellArray(sil::CellArray(pad, sil::CoordPnt(0, 10), 4, 1, 1, 1));
+  top.addPolygon(box(-0.5, 9.9, 3.5, 10.1, 3));
+  top.addPolygon(box(10, 10, 11, 11, 4)); // not on the stack
+
+  std::shared_ptr<const sil::FrozenLayout> frozen = layout.freeze();
+  sil::Connectivity connectivity(*frozen, frozen->findCell("top"), stack);
+  // 3 polygons, 2 path segments, the wire, 1 via and 4 pads with their vias
+  failures += check(connectivity.getShapeCount() == 3 + 2 + 1 + 1 + 8, "shape count");
+
+  unsigned int netA = connectivity.findNet(sil::CoordPnt(0.5, 0.5), 1);
+  unsigned int netB = connectivity.findNet(sil::CoordPnt(3, 0), 1);
+  unsigned int netC = connectivity.findNet(sil::CoordPnt(0, 10), 2);
+  failures += check(netA != sil::Connectivity::NO_NET && netB != sil::Connectivity::NO_NET &&
+                    netC != sil::Connectivity::NO_NET, "nets found");
+  failures += check(connectivity.findNet(sil::CoordPnt(4.5, 0.5), 3) == netA,
+                    "net through the via");
+  failures += check(netB != netA && netC != netA && netB != netC, "separate nets");
+  failures += check(connectivity.getNetCount() == 3, "net count");
+  failures += check(connectivity.findNet(sil::CoordPnt(5.5, 3), 1) == netB, "path bend");
+  failures += check(connectivity.findNet(sil::CoordPnt(6 + 1.4/std::sqrt(2.),
+                                                       3 + 1.4/std::sqrt(2.)), 1) == netB,
+                    "rotated wire");
+  failures += check(connectivity.findNet(sil::CoordPnt(3, 10.15), 1) == netC, "last pad");
+
+  sil::Span<const unsigned int> traced = connectivity.traceNet(sil::CoordPnt(0.5, 0.5), 1);
+  failures += check(traced.size() == 3, "traced net A");
+  for (std::size_t i = 0; i < traced.size(); i++)
+    failures += check(connectivity.getNet(traced[i]) == netA, "traced shape on net A");
+  failures += check(connectivity.getNetShapes(netC).size() == 9, "net C shapes");
+  failures += check(connectivity.traceNet(sil::CoordPnt(8, 8), 1).empty(), "empty trace");
+  failures += check(connectivity.findNet(sil::CoordPnt(10.5, 10.5), 4) ==
+                    sil::Connectivity::NO_NET, "layer off the stack");
+
+  bool thrown = false;
+  try {
+    sil::Connectivity missing(*frozen, frozen->getCellCount(), stack);
+  } catch (const std::out_of_range&) {
+    thrown = true;
+  }
+  failures += check(thrown, "missing top cell");
+  return failures;
+}
@@ -0,0 +1,100 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "testUtils.hxx"
+
+// Fills @cell with a ring of holes, in the given order, as a parametric
+// generator would.
+void makeRing(sil::Cell& cell, double radius, bool reversed) {
+  for (int i = 0; i < 12; i++) {
+    int k = reversed ? 11 - i : i;
+    double angle = k*acos(-1)/6.;
+    cell.addPolygon(sil::Circle(sil::CoordPnt(radius*cos(angle), radius*sin(angle)), 0.1));
+  }
+  cell.addPolygon(sil::Rectangle(sil::CoordPnt(0, 0), 0.5, 0.2));
+}
+
+int main() {
+  sil::Layout layout;
+  // RingB only differs from RingA by rounding well below the database
+  // grid and by the order of its polygons
+  sil::Cell& ringA = layout.createCell("RingA");
+  makeRing(ringA, 2.0, false);
+  sil::Cell& ringB = layout.createCell("RingB");
+  makeRing(ringB, 2.0 + 1e-7, true);
+  sil::Cell& ringC = layout.createCell("RingC");
+  makeRing(ringC, 2.5, false);
+
+  // the parents become identical once their children are
+  sil::Cell& parentA = layout.createCell("ParentA");
+  parentA.addCellReference(sil::CellReference(ringA, sil::CoordPnt(10, 0)));
+  parentA.addCellArray(sil::CellArray(ringC, sil::CoordPnt(0, 0), 3, 2, 6, 6));
+  sil::Cell& parentB = layout.createCell("ParentB");
+  parentB.addCellArray(sil::CellArray(ringC, sil::CoordPnt(0, 0), 3, 2, 6, 6));
+  parentB.addCellReference(sil::CellReference(ringB, sil::CoordPnt(10, 0)));
+
+  sil::Cell& top = layout.createCell("Top");
+  top.addCellReference(sil::CellReference(parentA, sil::CoordPnt(0, 0)));
+  top.addCellReference(sil::CellReference(parentB, sil::CoordPnt(50, 0)));
+  top.addCellArray(sil::CellArray(ringB, sil::CoordPnt(0, 50), 4, 4, 6, 6));
+
+  int failures = 0;
+  std::vector<sil::ContentHash> hashes = sil::computeContentHashes(layout);
+  failures += check(hashes.size() == 6, "one hash per cell");
+  failures += check(hashes[0] == hashes[1], "identical rings hash the same");
+  failures += check(hashes[0] != hashes[2], "different rings hash differently");
+  failures += check(hashes[3] == hashes[4], "identical hierarchies hash the same");
+  failures += check(hashes[5] != hashes[3], "different hierarchies hash differently");
+
+  sil::DeduplicationStats stats = sil::deduplicateCells(layout);
+  failures += check(stats.cellsMerged == 2, "RingB and ParentB are merged");
+  failures += check(stats.referencesRetargeted == 3, "references are retargeted");
+  failures += check(layout.getCells().size() == 4, "duplicates leave the layout");
+  failures += check(layout.findCell("RingB") == NULL && layout.findCell("ParentB") == NULL,
+		    "the first cell of each set survives");
+  failures += check(top.getCellReferenceList()[1].getCellname() == "ParentA",
+		    "references point at the survivor");
+  failures += check(top.getCellArrayList()[0].getCellname() == "RingA",
+		    "arrays point at the survivor");
+  failures += check(sil::deduplicateCells(layout).cellsMerged == 0,
+		    "deduplication is idempotent");
+
+  // a Cell added twice has one hash, at its first position
+  sil::Layout twice;
+  twice.addCell(ringA);
+  twice.addCell(ringC);
+  twice.addCell(ringA);
+  hashes = sil::computeContentHashes(twice);
+  failures += check(hashes.size() == 2, "one hash per distinct cell");
+  failures += check(hashes[0] != hashes[1], "hashes follow the first positions");
+
+  // identical top cells keep their names unless asked to merge them
+  sil::Layout tops;
+  sil::Cell& chipA = tops.createCell("ChipA");
+  makeRing(chipA, 1.0, false);
+  sil::Cell& chipB = tops.createCell("ChipB");
+  makeRing(chipB, 1.0, true);
+  failures += check(sil::deduplicateCells(tops).cellsMerged == 0,
+		    "top cells are kept by default");
+  failures += check(tops.findCell("ChipB") != NULL, "both top cells survive");
+  sil::DeduplicationOptions options;
+  options.mergeTopCells = true;
+  failures += check(sil::deduplicateCells(tops, options).cellsMerged == 1,
+		    "top cells merge on request");
+  failures += check(tops.findCell("ChipA") != NULL && tops.findCell("ChipB") == NULL,
+		    "the first top cell survives");
+
+  // cycles in the hierarchy can not be hashed
+  sil::Cell& loop = layout.createCell("Loop");
+  loop.addCellReference(sil::CellReference(loop));
+  bool threw = false;
+  try {
+    sil::computeContentHashes(layout);
+  } catch (std::logic_error& e) {
+    threw = true;
+  }
+  failures += check(threw, "cycles are reported");
+
+  return failures;
+}
@@ -0,0 +1,201 @@
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "testUtils.hxx"
+
+std::size_t countIn(const sil::DesignRuleReport& report, const std::string& cellname) {
+  std::size_t total = 0;
+  for (std::size_t i = 0; i < report.violations.size(); i++)
+    if (report.violations[i].cellname == cellname)
+      total++;
+  return total;
+}
+
+int main(void) {
+  int failures = 0;
+  std::vector<sil::DesignRule> rules;
+  rules.push_back(sil::DesignRule(sil::MIN_WIDTH, 1, 0.1));
+  rules.push_back(sil::DesignRule(sil::MIN_SPACING, 2, 0.1));
+  rules.push_back(sil::DesignRule(sil::MIN_AREA, 1, 0.02));
+  rules.push_back(sil::DesignRule(sil::MIN_SPACING, 3, 0.1));
+  rules.push_back(sil::DesignRule(sil::MIN_ENCLOSURE, 4, 0.15, 5));
+
+  // flat checks
+  {
+    sil::Layout layout;
+    sil::Cell& cell = layout.createCell("flat");
+    cell.addPolygon(box(0, 0, 0.05, 1, 1)); // too narrow
+    cell.addPolygon(box(1, 0, 2, 1, 1)); // fine
+    cell.addPolygon(box(3, 0, 3.1, 0.1, 1)); // too small, not too narrow
+    cell.addPolygon(box(0, 2, 1, 3, 2));
+    cell.addPolygon(box(1.05, 2, 2, 3, 2)); // too close to the one before
+    cell.addPolygon(box(1.5, 2.5, 2.5, 3.5, 2)); // overlaps it, so not too close
+    cell.addPolygon(box(3, 2, 4, 3, 2)); // far enough
+    sil::DesignRuleReport report = sil::checkDesignRules(layout, rules);
+    failures += check(report.count(0) == 1 && report.count(1) == 1 && report.count(2) == 1 &&
+                      report.violations.size() == 3, "flat violations:\n" + report.toString());
+    for (std::size_t i = 0; i < report.violations.size(); i++) {
+      const sil::DesignRuleViolation& violation = report.violations[i];
+      std::vector<sil::CoordPnt> marker(violation.marker.getVertexSpan().begin(),
+                                        violation.marker.getVertexSpan().end());
+      sil::Bounds bounds;
+      for (std::size_t j = 0; j < marker.size(); j++)
+        bounds.add(marker[j]);
+      if (violation.rule == 0)
+        failures += check(near(violation.measured, 0.05) && near(bounds.minX, 0) &&
+                          near(bounds.maxX, 0.05) && near(bounds.minY, 0) && near(bounds.maxY, 1),
+                          "width marker covers the narrow part");
+      if (violation.rule == 1)
+        failures += check(near(violation.measured, 0.05) && near(bounds.minX, 1) &&
+                          near(bounds.maxX, 1.05) && violation.marker.getLayer() == 2,
+                          "spacing marker lies in the gap");
+      if (violation.rule == 2)
+        failures += check(near(violation.measured, 0.01), "area is measured");
+    }
+  }
+
+  // curved outlines only measure between edges that face each other
+  {
+    std::vector<sil::DesignRule> widths;
+    widths.push_back(sil::DesignRule(sil::MIN_WIDTH, 1, 2.0));
+    widths.push_back(sil::DesignRule(sil::MIN_WIDTH, 2, 11.0));
+    sil::Layout layout;
+    sil::Cell& cell = layout.createCell("curved");
+    cell.addPolygon(sil::Circle(sil::CoordPnt(0, 0), 5));
+    cell.addPolygon(sil::Oval(sil::CoordPnt(20, 0), 10, 4));
+    sil::Circle wide(sil::CoordPnt(0, 20), 5);
+    wide.setLayer(2);
+    cell.addPolygon(wide);
+    sil::DesignRuleReport report = sil::checkDesignRules(layout, widths);
+    failures += check(report.count(0) == 0, "circles and ovals are wide enough:\n" +
+                      report.toString());
+    bool across = report.count(1) > 0;
+    for (std::size_t i = 0; i < report.violations.size(); i++)
+      across = across && report.violations[i].measured > 9.9;
+    failures += check(across, "a circle is as wide as its diameter");
+  }
+
+  // touching and overlapping polygons are merged for width and area
+  {
+    sil::Layout layout;
+    sil::Cell& cell = layout.createCell("merged");
+    cell.addPolygon(box(0, 0, 1, 5, 1)); // abuts the next one
+    cell.addPolygon(box(1, 0, 5, 5, 1));
+    cell.addPolygon(box(10, 0, 10.05, 1, 1)); // narrow, overlapped by the next one
+    cell.addPolygon(box(10, 0.5, 11, 1.5, 1));
+    cell.addPolygon(box(20, 0, 20.1, 0.1, 1)); // small, and so is the union with the next one
+    cell.addPolygon(box(20.1, 0, 20.15, 0.1, 1));
+    std::vector<sil::DesignRule> merged;
+    merged.push_back(sil::DesignRule(sil::MIN_WIDTH, 1, 0.5));
+    merged.push_back(sil::DesignRule(sil::MIN_AREA, 1, 0.02));
+    sil::DesignRuleReport report = sil::checkDesignRules(layout, merged);
+    bool narrowStub = false;
+    for (std::size_t i = 0; i < report.violations.size(); i++)
+      narrowStub = narrowStub || (report.violations[i].rule == 0 &&
+                                  near(report.violations[i].measured, 0.05));
+    failures += check(narrowStub, "the stub below the overlap is narrow");
+    // the stub, and across and along the small union
+    failures += check(report.count(0) == 3 && report.count(1) == 1 &&
+                      near(report.violations.back().measured, 0.015),
+                      "merged width and area:\n" + report.toString());
+  }
+
+  // instances are checked once, their interactions once per offset
+  {
+    sil::Layout layout;
+    sil::Cell& top = layout.createCell("top");
+    sil::Cell& leaf = layout.createCell("leaf");
+    leaf.addPolygon(box(0, 0, 1, 1, 3));
+    leaf.addPolygon(box(0, 0, 0.05, 1, 1)); // narrow, in every instance
+    top.addCellArray(sil::CellArray(leaf, sil::CoordPnt(0, 0), 10, 10, 1.05, 1.05));
+    sil::DesignRuleReport report = sil::checkDesignRules(layout, rules);
+    failures += check(countIn(report, "leaf") == 1 && report.count(0) == 1,
+                      "a cell is checked once however often it is placed");
+    // up, right and both diagonals
+    failures += check(countIn(report, "top") == 4 && report.count(3) == 4,
+                      "array elements are checked once per offset:\n" + report.toString());
+
+    sil::Layout spaced;
+    sil::Cell& spacedTop = spaced.createCell("top");
+    spacedTop.addCellArray(sil::CellArray(leaf, sil::CoordPnt(0, 0), 10, 10, 1.2, 1.2));
+    sil::CellReference turned(leaf, sil::CoordPnt(12.85, 0));
+    turned.setRotation(std::acos(-1.)/2); // covers x from 11.85 to 12.85
+    spacedTop.addCellReference(turned);
+    spacedTop.addPolygon(box(0, -1, 1, -0.05, 3));
+    report = sil::checkDesignRules(spaced, rules);
+    // the turned reference against the last column, the own shape against the first row
+    failures += check(countIn(report, "top") == 2 && report.count(3) == 2,
+                      "placements and own shapes interact:\n" + report.toString());
+  }
+
+  // magnification scales the rules
+  {
+    sil::Layout layout;
+    sil::Cell& top = layout.createCell("top");
+    sil::Cell& leaf = layout.createCell("leaf");
+    leaf.addPolygon(box(0, 0, 0.08, 1, 1));
+    sil::CellReference ref(leaf, sil::CoordPnt(0, 0));
+    ref.setMagneification(2);
+    top.addCellReference(ref);
+    sil::DesignRuleReport report = sil::checkDesignRules(layout, rules);
+    failures += check(report.isClean(), "a magnified cell is wide enough");
+    top.addCellReference(sil::CellReference(leaf, sil::CoordPnt(5, 0)));
+    report = sil::checkDesignRules(layout, rules);
+    failures += check(report.violations.size() == 1 &&
+                      near(report.violations[0].magnification, 1) &&
+                      near(report.violations[0].measured, 0.08),
+                      "the unmagnified placement is too narrow");
+  }
+
+  // enclosure across the hierarchy
+  {
+    sil::Layout layout;
+    sil::Cell& top = layout.createCell("top");
+    sil::Cell& via = layout.createCell("via");
+    via.addPolygon(box(-0.1, -0.1, 0.1, 0.1, 4));
+    via.addPolygon(box(-0.2, -0.2, 0.2, 0.2, 5)); // encloses by 0.1 only
+    top.addPolygon(box(-5, -5, 5, 5, 5));
+    top.addCellReference(sil::CellReference(via, sil::CoordPnt(0, 0))); // inside the plate
+    top.addCellReference(sil::CellReference(via, sil::CoordPnt(10, 0))); // outside of it
+    top.addPolygon(box(20, 0, 20.2, 0.2, 4)); // not enclosed at all
+    sil::DesignRuleReport report = sil::checkDesignRules(layout, rules);
+    failures += check(report.count(4) == 2 && countIn(report, "top") == 2,
+                      "enclosure is resolved in the parents:\n" + report.toString());
+    bool sawPartial = false, sawMissing = false;
+    for (std::size_t i = 0; i < report.violations.size(); i++) {
+      sawPartial = sawPartial || near(report.violations[i].measured, 0.1);
+      sawMissing = sawMissing || report.violations[i].measured == -1;
+    }
+    failures += check(sawPartial && sawMissing, "enclosure measurements");
+  }
+
+  // the frozen overload gives the same answer
+  {
+    sil::Layout layout;
+    sil::Cell& cell = layout.createCell("flat");
+    cell.addPolygon(box(0, 0, 0.05, 1, 1));
+    std::shared_ptr<const sil::FrozenLayout> frozen = layout.freeze();
+    failures += check(sil::checkDesignRules(*frozen, rules).violations.size() == 1,
+                      "checking a frozen layout");
+  }
+
+  bool thrown = false;
+  try {
+    sil::DesignRule(sil::MIN_WIDTH, 1, 0);
+  } catch (std::invalid_argument&) {
+    thrown = true;
+  }
+  failures += check(thrown, "rules need a positive value");
+  thrown = false;
+  try {
+    sil::DesignRule(sil::MIN_ENCLOSURE, 1, 0.1);
+  } catch (std::invalid_argument&) {
+    thrown = true;
+  }
+  failures += check(thrown, "enclosure rules need an outer layer");
+
+  return failures;
+}
@@ -0,0 +1,119 @@
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "testUtils.hxx"
+
+double totalArea(const std::vector<sil::Trapezoid>& figures, std::size_t first,
+                 std::size_t count) {
+  double area = 0;
+  for (std::size_t i = first; i < first + count; i++)
+    area += figures[i].getArea();
+  return area;
+}
+
+int main(void) {
+  int failures = 0;
+  sil::FractureOptions options;
+  std::vector<sil::Trapezoid> figures;
+
+  std::vector<sil::CoordPnt> ell;
+  ell.push_back(sil::CoordPnt(0, 0));
+  ell.push_back(sil::CoordPnt(2, 0));
+  ell.push_back(sil::CoordPnt(2, 1));
+  ell.push_back(sil::CoordPnt(1, 1));
+  ell.push_back(sil::CoordPnt(1, 2));
+  ell.push_back(sil::CoordPnt(0, 2));
+  sil::fracturePolygon(ell, options, figures);
+  failures += check(figures.size() == 2 && totalArea(figures, 0, 2) == 3, "L shape");
+
+  // a 64-gon cuts 32 slices, the ones at the top and bottom very thin,
+  // and its mirrored vertices only match up to rounding
+  sil::Circle circle(sil::CoordPnt(0, 0), 10);
+  double circleArea = std::abs(circle.getSignedArea());
+  figures.clear();
+  sil::fracturePolygon(circle.getVertexSpan(), options, figures);
+  failures += check(figures.size() == 32, "circle slices");
+  failures += check(std::abs(totalArea(figures, 0, figures.size()) - circleArea) < 1e-9,
+                    "circle area");
+  options.sliverSize = 1;
+  figures.clear();
+  sil::fracturePolygon(circle.getVertexSpan(), options, figures);
+  bool thick = true;
+  for (std::size_t i = 0; i < figures.size(); i++)
+    thick = thick && figures[i].top - figures[i].bottom >= 1;
+  failures += check(figures.size() < 32 && thick, "sliver control");
+  failures += check(std::abs(totalArea(figures, 0, figures.size()) - circleArea) <
+                    0.02*circleArea, "sliver control area");
+  options.sliverSize = 1e-6;
+
+  // monotone in y, but its two chains cross
+  std::vector<sil::CoordPnt> twisted;
+  twisted.push_back(sil::CoordPnt(0, 0));
+  twisted.push_back(sil::CoordPnt(3, 0.5));
+  twisted.push_back(sil::CoordPnt(-1, 1.5));
+  twisted.push_back(sil::CoordPnt(0, 2));
+  twisted.push_back(sil::CoordPnt(2, 1));
+  figures.clear();
+  sil::fracturePolygon(twisted, options, figures);
+  sil::utils::ScanlineSweep sweep;
+  sweep.addPolygon(twisted, 0);
+  std::vector<sil::Trapezoid> swept;
+  sweep.sweep(sil::utils::SWEEP_UNION, swept);
+  bool ordered = true;
+  for (std::size_t i = 0; i < figures.size(); i++)
+    ordered = ordered && figures[i].bottomLeft <= figures[i].bottomRight + 1e-9 &&
+      figures[i].topLeft <= figures[i].topRight + 1e-9;
+  failures += check(ordered && figures.size() == swept.size() &&
+                    std::abs(totalArea(figures, 0, figures.size()) -
+                             totalArea(swept, 0, swept.size())) < 1e-9, "crossing chains");
+
+  sil::Layout layout;
+  sil::Cell& leaf = layout.createCell("leaf");
+  leaf.addPolygon(box(0, 0, 2, 2, 2));
+  leaf.addPolygon(box(1, 1, 3, 3, 2)); // overlaps the first
+  leaf.addPolygon(box(0, 0, 1, 1, 1));
+  leaf.addPolygon(box(5, 5, 5.01, 5.01, 1)); // a speck
+  std::vector<sil::CoordPnt> points;
+  points.push_back(sil::CoordPnt(0, 10));
+  points.push_back(sil::CoordPnt(10, 10));
+  points.push_back(sil::CoordPnt(10, 20));
+  leaf.addPath(sil::Path(points, 2, 0, 3));
+  sil::Cell& top = layout.createCell("top");
+  top.addCellReference(sil::CellReference(leaf, sil::CoordPnt(0, 0)));
+  for (int i = 0; i < 1000; i++)
+    top.addPolygon(box(4*i, 0, 4*i + 3, 3, 1));
+  std::shared_ptr<const sil::FrozenLayout> frozen = layout.freeze();
+
+  std::vector<sil::FracturedCell> cells = sil::fracture(*frozen, options);
+  failures += check(cells.size() == 2, "one result per cell");
+  sil::FracturedCell fractured = cells[0];
+  failures += check(fractured.groups.size() == 3 && fractured.groups[0].layer == 1 &&
+                    fractured.groups[1].layer == 2 && fractured.groups[2].layer == 3, "groups");
+  failures += check(fractured.groups[0].count == 2 && fractured.groups[1].first == 2 &&
+                    fractured.groups[1].count == 2, "group ranges");
+  failures += check(totalArea(fractured.trapezoids, 2, 2) == 8, "overlaps fractured apart");
+  // the path is the union of its two segments, 10 + 10 long and 2 wide
+  failures += check(std::abs(totalArea(fractured.trapezoids, fractured.groups[2].first,
+                                       fractured.groups[2].count) - 40) < 1e-9, "path");
+  failures += check(cells[1].trapezoids.size() == 1000 && cells[1].groups.size() == 1 &&
+                    cells[1].trapezoids[999].bottomLeft == 3996, "many shapes in order");
+
+  options.mergeOverlaps = true;
+  options.minFigureSize = 0.1;
+  options.layers.push_back(1);
+  options.layers.push_back(2);
+  cells = sil::fracture(*frozen, options);
+  failures += check(cells[0].groups.size() == 2, "layer selection");
+  failures += check(std::abs(totalArea(cells[0].trapezoids, cells[0].groups[1].first,
+                                       cells[0].groups[1].count) - 7) < 1e-9, "merged overlaps");
+  failures += check(cells[0].groups[0].count == 1 && cells[0].figuresDropped == 1 &&
+                    std::abs(cells[0].droppedArea - 1e-4) < 1e-9, "minimum figure size");
+
+  sil::FracturedCell single = sil::fracture(leaf);
+  failures += check(single.trapezoids.size() == fractured.trapezoids.size(),
+                    "single cell");
+  return failures;
+}
@@ -0,0 +1,141 @@
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "testUtils.hxx"
+
+bool sameBounds(const sil::Bounds& bounds, double minX, double minY,
+                double maxX, double maxY) {
+  return near(bounds.minX, minX) && near(bounds.minY, minY) &&
+    near(bounds.maxX, maxX) && near(bounds.maxY, maxY);
+}
+
+// sums everything a reader can see, to compare what several threads saw
+double readAll(const sil::FrozenLayout& frozen) {
+  double sum = 0;
+  for (std::size_t i = 0; i < frozen.getCellCount(); i++) {
+    const sil::FrozenCell& cell = frozen.getCell(i);
+    for (std::size_t j = 0; j < cell.polygons.size(); j++) {
+      sum += cell.polygons[j].signedArea + cell.polygons[j].bounds.maxX;
+      for (std::size_t k = 0; k < cell.polygons[j].vertices.size(); k++)
+        sum += cell.polygons[j].vertices[k].getX();
+    }
+    sum += cell.extent.maxY + cell.children.size() + cell.layers.size();
+  }
+  return sum;
+}
+
+int main(void) {
+  int failures = 0;
+
+  sil::Layout layout;
+  sil::Cell& top = layout.createCell("top");
+  sil::Cell& leaf = layout.createCell("leaf");
+  sil::Rectangle square(sil::CoordPnt(1, 1), 2, 2);
+  square.setLayer(2);
+  leaf.addPolygon(square);
+  std::vector<sil::CoordPnt> points;
+  points.push_back(sil::CoordPnt(0, 0));
+  points.push_back(sil::CoordPnt(4, 0));
+  sil::Path path(points, 1);
+  path.setLayer(5);
+  path.setPathType(0);
+  leaf.addPath(path);
+  sil::CellReference ref(leaf, sil::CoordPnt(10, 0));
+  ref.setRotation(std::acos(-1.)/2);
+  top.addCellReference(ref);
+  top.addCellArray(sil::CellArray(leaf, sil::CoordPnt(20, 0), 3, 2, 10, 10));
+
+  std::shared_ptr<const sil::FrozenLayout> frozen = layout.freeze();
+  failures += check(frozen->getCellCount() == 2 && frozen->getLayoutCellCount() == 2,
+                    "cells are copied");
+  std::size_t topIndex = frozen->findCell("top");
+  std::size_t leafIndex = frozen->findCell("leaf");
+  failures += check(topIndex == 0 && leafIndex == 1, "cells are found by name");
+  failures += check(frozen->findCell("missing") == frozen->getCellCount(), "unknown names");
+
+  const sil::FrozenCell& frozenLeaf = frozen->getCell(leafIndex);
+  const sil::FrozenCell& frozenTop = frozen->getCell(topIndex);
+  failures += check(frozenLeaf.polygons.size() == 1 && frozenLeaf.paths.size() == 1,
+                    "shapes are copied");
+  const sil::FrozenPolygon& polygon = frozenLeaf.polygons[0];
+  failures += check(polygon.layer == 2 && polygon.vertices.size() == 4 &&
+                    (polygon.shapeClass & sil::Polygon::RECTANGLE) &&
+                    near(std::abs(polygon.signedArea), 4) && near(polygon.perimeter, 8),
+                    "polygon properties are precomputed");
+  failures += check(sameBounds(polygon.bounds, 0, 0, 2, 2), "polygon bounds");
+  failures += check(sameBounds(frozenLeaf.paths[0].bounds, -0.5, -0.5, 4.5, 0.5), "path bounds");
+  failures += check(sameBounds(frozenLeaf.bounds, -0.5, -0.5, 4.5, 2), "cell bounds");
+  failures += check(frozenLeaf.layers.size() == 2 && frozenLeaf.layers[0] == 2 &&
+                    frozenLeaf.layers[1] == 5, "layer index");
+  failures += check(frozenTop.bounds.isEmpty(), "a cell without shapes has empty bounds");
+  failures += check(sameBounds(frozenTop.extent, 8, -0.5, 44.5, 12), "hierarchical extent");
+  failures += check(frozenTop.references.size() == 1 && frozenTop.references[0].cell == leafIndex &&
+                    frozenTop.arrays.size() == 1 && frozenTop.arrays[0].numCol == 3,
+                    "placements refer to cell indices");
+  failures += check(frozenTop.children.size() == 1 && frozenTop.children[0] == leafIndex &&
+                    frozenLeaf.parents.size() == 1 && frozenLeaf.parents[0] == topIndex,
+                    "children and parents");
+  failures += check(frozen->getTopCells().size() == 1 && frozen->getTopCells()[0] == topIndex &&
+                    frozen->getHierarchicalOrder().back() == topIndex, "hierarchy order");
+
+  // editing the layout does not change the frozen copy
+  double before = readAll(*frozen);
+  leaf.getPolygonList()[0].getVertices()[0] = sil::CoordPnt(-7, -7);
+  leaf.addPolygon(sil::Rectangle(sil::CoordPnt(100, 100), 1, 1));
+  top.setCellname("renamed");
+  failures += check(readAll(*frozen) == before && frozen->findCell("top") == topIndex &&
+                    frozenLeaf.polygons.size() == 1, "the frozen copy is independent");
+
+  // concurrent readers while the layout is being edited
+  std::atomic<int> mismatches(0);
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; t++)
+    readers.push_back(std::thread([&]() {
+          for (int i = 0; i < 200; i++)
+            if (readAll(*frozen) != before)
+              mismatches++;
+        }));
+  for (int i = 0; i < 1000; i++)
+    leaf.addPolygon(sil::Rectangle(sil::CoordPnt(i, 0), 1, 1));
+  for (std::size_t t = 0; t < readers.size(); t++)
+    readers[t].join();
+  failures += check(mismatches == 0, "concurrent readers agree");
+
+  std::shared_ptr<const sil::FrozenLayout> refrozen = layout.freeze();
+  failures += check(refrozen->getCell(1).polygons.size() == 1002 &&
+                    refrozen->findCell("renamed") == 0, "freezing again sees the edits");
+
+  // a Cell frozen on its own is cell 0, followed by what it places
+  sil::Cell loose("loose");
+  loose.addCellReference(sil::CellReference(leaf, sil::CoordPnt(0, 0)));
+  std::shared_ptr<const sil::FrozenLayout> single = sil::FrozenLayout::freeze(loose);
+  failures += check(single->getCellCount() == 2 && single->getLayoutCellCount() == 1 &&
+                    single->getCell(0).cellname == "loose" &&
+                    single->getCell(1).polygons.size() == 1002, "a single cell can be frozen");
+  failures += check(single->getTopCells().size() == 1 && single->getTopCells()[0] == 0,
+                    "the frozen cell is the top cell");
+
+  bool thrown = false;
+  try {
+    frozen->getCell(2);
+  } catch (std::out_of_range&) {
+    thrown = true;
+  }
+  failures += check(thrown, "getCell checks its index");
+
+  thrown = false;
+  leaf.addCellReference(sil::CellReference(top));
+  try {
+    layout.freeze();
+  } catch (std::logic_error&) {
+    thrown = true;
+  }
+  failures += check(thrown, "cyclic hierarchies can not be frozen");
+
+  return failures;
+}
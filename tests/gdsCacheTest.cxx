@@ -0,0 +1,117 @@
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "../src/gdsfile.hxx"
+#include "testUtils.hxx"
+
+// Reads a GDSII file, blanking the time stamps of the BGNLIB and BGNSTR
+// records so that files written at different times can be compared.
+std::string readWithoutTimes(std::string filename) {
+  std::ifstream file(filename.c_str(), std::ios::binary);
+  std::string data((std::istreambuf_iterator<char>(file)),
+		   std::istreambuf_iterator<char>());
+  for (size_t i = 0; i + 4 <= data.size();) {
+    size_t size = ((unsigned char) data[i] << 8) | (unsigned char) data[i + 1];
+    int16_t record = ((unsigned char) data[i + 2] << 8) | (unsigned char) data[i + 3];
+    if (record == sil::utils::BGNLIB || record == sil::utils::BGNSTR)
+      data.replace(i + 4, size - 4, size - 4, '\0');
+    if (size < 4)
+      break;
+    i += size;
+  }
+  return data;
+}
+
+void fillCell(sil::Cell& cell, int count, double offset) {
+  for (int i = 0; i < count; i++)
+    cell.addPolygon(sil::Circle(sil::CoordPnt(i + offset, 0), 0.3));
+}
+
+int main() {
+  sil::Cell leaf = sil::Cell("Leaf");
+  fillCell(leaf, 50, 0);
+  sil::Cell other = sil::Cell("Other");
+  fillCell(other, 50, 0.5);
+  sil::Cell top = sil::Cell("Top");
+  top.addCellReference(sil::CellReference(leaf, sil::CoordPnt(0, 0)));
+  top.addCellArray(sil::CellArray(other, sil::CoordPnt(0, 10), 3, 3, 60, 5));
+  std::vector<sil::Cell*> cells;
+  cells.push_back(&leaf);
+  cells.push_back(&other);
+  cells.push_back(&top);
+
+  int failures = 0;
+  sil::utils::GDS_WriteCache cache;
+  {
+    sil::utils::GDS_File file("gdsCacheFirst.gds");
+    file.Write(cells, &cache);
+  }
+  failures += check(cache.getMisses() == 3 && cache.getHits() == 0,
+		    "the first write serializes every cell");
+  {
+    sil::utils::GDS_File file("gdsCacheSecond.gds");
+    file.Write(cells, &cache);
+  }
+  failures += check(cache.getMisses() == 0 && cache.getHits() == 3,
+		    "an unchanged layout is copied from the cache");
+  failures += check(readWithoutTimes("gdsCacheFirst.gds") ==
+		    readWithoutTimes("gdsCacheSecond.gds"),
+		    "cached output matches serialized output");
+
+  // editing a cell through the list it exposes must also be noticed
+  other.getPolygonList()[3].translate(sil::CoordPnt(0.002, 0));
+  {
+    sil::utils::GDS_File file("gdsCacheEdited.gds");
+    file.Write(cells, &cache);
+  }
+  {
+    sil::utils::GDS_File file("gdsCacheUncached.gds");
+    file.Write(cells);
+  }
+  failures += check(cache.getMisses() == 1 && cache.getHits() == 2,
+		    "only the edited cell is serialized again");
+  failures += check(readWithoutTimes("gdsCacheEdited.gds") ==
+		    readWithoutTimes("gdsCacheUncached.gds"),
+		    "an edited layout matches a write without the cache");
+
+  // renaming a referenced cell changes the SNAME of its parent
+  leaf.setCellname("Renamed");
+  {
+    sil::utils::GDS_File file("gdsCacheRenamed.gds");
+    file.Write(cells, &cache);
+  }
+  failures += check(cache.getMisses() == 2 && cache.getHits() == 1,
+		    "a renamed cell and its parent are serialized again");
+
+  // cells that are no longer written are dropped from the cache
+  cells.pop_back();
+  {
+    sil::utils::GDS_File file("gdsCacheDropped.gds");
+    file.Write(cells, &cache);
+  }
+  failures += check(cache.getHits() == 2, "remaining cells are reused");
+  cells.push_back(&top);
+  {
+    sil::utils::GDS_File file("gdsCacheDropped.gds");
+    file.Write(cells, &cache);
+  }
+  failures += check(cache.getMisses() == 1, "dropped cells are serialized again");
+
+  // a Layout only caches when it is given a cache
+  sil::Layout layout;
+  fillCell(layout.createCell("Alpha"), 20, 0);
+  fillCell(layout.createCell("Bravo"), 20, 0.5);
+  sil::utils::GDS_WriteCache layoutCache;
+  layout.write("gdsCacheLayout.gds");
+  failures += check(layoutCache.getSize() == 0, "a plain write fills no cache");
+  layout.write("gdsCacheLayout.gds", layoutCache);
+  failures += check(layoutCache.getMisses() == 2 && layoutCache.getSize() > 0,
+		    "a write fills the cache it is given");
+  layout.write("gdsCacheLayout.gds", layoutCache);
+  failures += check(layoutCache.getHits() == 2, "the layout reuses its cache");
+
+  return failures;
+}
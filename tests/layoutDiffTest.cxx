@@ -0,0 +1,97 @@
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "testUtils.hxx"
+
+// A top cell placing a 3 x 2 array of a leaf and a rotated block. The
+// leaf's square is moved right by @shift.
+void build(sil::Layout& layout, double shift) {
+  sil::Cell& leaf = layout.createCell("leaf");
+  leaf.addPolygon(box(shift, 0, 1 + shift, 1, 1));
+  sil::Cell& block = layout.createCell("block");
+  block.addPolygon(box(0, 0, 3, 1, 2));
+  std::vector<sil::CoordPnt> points;
+  points.push_back(sil::CoordPnt(0, 2));
+  points.push_back(sil::CoordPnt(3, 2));
+  points.push_back(sil::CoordPnt(3, 4));
+  block.addPath(sil::Path(points, 0.5, 0, 2));
+  sil::Cell& top = layout.createCell("top");
+  top.addCellArray(sil::CellArray(leaf, sil::CoordPnt(0, 0), 3, 2, 10, 10));
+  sil::CellReference rotated(block, sil::CoordPnt(50, 0));
+  rotated.setRotation(std::acos(-1.)/2);
+  top.addCellReference(rotated);
+}
+
+int main(void) {
+  int failures = 0;
+  {
+    sil::Layout first, second;
+    build(first, 0);
+    build(second, 0);
+    sil::LayoutDiff diff = sil::diffLayouts(first, second);
+    failures += check(diff.isIdentical() && diff.changedCells.empty() &&
+                      diff.addedCells.empty() && diff.removedCells.empty(),
+                      "identical layouts:\n" + diff.toString());
+  }
+  {
+    sil::Layout first, second;
+    build(first, 0);
+    build(second, 0.25);
+    second.createCell("extra").addPolygon(box(100, 100, 101, 102, 3));
+    sil::LayoutDiff diff = sil::diffLayouts(first, second);
+    failures += check(diff.changedCells.size() == 2 && diff.changedCells[0] == "leaf" &&
+                      diff.changedCells[1] == "top", "changed cells:\n" + diff.toString());
+    failures += check(diff.addedCells.size() == 1 && diff.addedCells[0] == "extra" &&
+                      diff.removedCells.empty(), "added cells");
+    failures += check(diff.layers.size() == 2 && diff.layers[0].layer == 1 &&
+                      diff.layers[1].layer == 3, "changed layers:\n" + diff.toString());
+    // each element loses and gains a 0.25 x 1 strip
+    failures += check(near(diff.layers[0].area, 6*0.5, 1e-6), "leaf area");
+    failures += check(near(diff.layers[1].area, 2, 1e-6), "extra area");
+    double polygonArea = 0;
+    for (std::size_t i = 0; i < diff.layers[0].polygons.size(); i++)
+      polygonArea += diff.layers[0].polygons[i].getArea();
+    failures += check(near(polygonArea, diff.layers[0].area, 1e-6), "difference polygons");
+
+    sil::LayoutDiffOptions options;
+    options.tileSize = 0.3;
+    sil::LayoutDiff tiled = sil::diffLayouts(first, second, options);
+    failures += check(tiled.layers.size() == 2 && near(tiled.layers[0].area, 3, 1e-6) &&
+                      near(tiled.layers[1].area, 2, 1e-6), "small tiles:\n" + tiled.toString());
+
+    first.writeSnapshot("layoutDiffTest1.silsnap");
+    second.writeSnapshot("layoutDiffTest2.silsnap");
+    sil::LayoutDiff files = sil::diffSnapshots("layoutDiffTest1.silsnap", "layoutDiffTest2.silsnap");
+    failures += check(files.layers.size() == 2 && near(files.layers[0].area, 3, 1e-6) &&
+                      files.changedCells == diff.changedCells, "snapshot files");
+    std::remove("layoutDiffTest1.silsnap");
+    std::remove("layoutDiffTest2.silsnap");
+  }
+  // an unchanged cell covers a changed shape, so nothing differs
+  {
+    sil::Layout first, second;
+    sil::Cell& coverA = first.createCell("cover");
+    coverA.addPolygon(box(1, 0, 3, 1, 1));
+    first.createCell("top").addPolygon(box(0, 0, 2, 1, 1));
+    first.findCell("top")->addCellReference(sil::CellReference(coverA));
+    sil::Cell& coverB = second.createCell("cover");
+    coverB.addPolygon(box(1, 0, 3, 1, 1));
+    second.createCell("top").addPolygon(box(0, 0, 1, 1, 1));
+    second.findCell("top")->addCellReference(sil::CellReference(coverB));
+    sil::LayoutDiff diff = sil::diffLayouts(first, second);
+    failures += check(diff.changedCells.size() == 1 && diff.isIdentical(),
+                      "covered change:\n" + diff.toString());
+  }
+  bool thrown = false;
+  try {
+    sil::diffSnapshots("missing1.silsnap", "missing2.silsnap");
+  } catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  failures += check(thrown, "missing files");
+  return failures;
+}
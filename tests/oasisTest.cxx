@@ -0,0 +1,529 @@
+#include <math.h>
+#include <stdint.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "../src/oasisfile.hxx"
+#include "testUtils.hxx"
+#include "SilhouetteConfig.h"
+#ifdef SILHOUETTE_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+// Returns the contents of the file as a string.
+std::string readFile(std::string filename) {
+  std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+  return std::string((std::istreambuf_iterator<char>(file)),
+		     std::istreambuf_iterator<char>());
+}
+
+typedef std::pair<int64_t, int64_t> Point;
+
+// A RECTANGLE, POLYGON or PATH record with its repetition expanded.
+struct DecodedShape {
+  int record;
+  uint64_t layer;
+  uint64_t dataType;
+  uint64_t width; // rectangles
+  uint64_t height; // rectangles
+  uint64_t halfwidth; // paths
+  uint64_t extension; // paths
+  std::vector<Point> points; // polygon vertices or path points, relative to the position
+  std::vector<Point> positions; // sorted
+};
+
+// A PLACEMENT record with its repetition expanded.
+struct DecodedPlacement {
+  std::string cell;
+  double magnification;
+  double angle; // degrees
+  std::vector<Point> positions; // sorted
+};
+
+struct DecodedCell {
+  std::string name;
+  std::vector<DecodedShape> shapes;
+  std::vector<DecodedPlacement> placements;
+};
+
+// Decodes the subset of OASIS that OASIS_File writes, tracking the modal
+// variables the way a reader must, so that the tests can compare values.
+class OasisDecoder {
+private:
+  std::string data;
+  std::size_t pos;
+  std::vector<std::string> cellnames;
+  std::vector<DecodedCell> cells;
+  bool relative;
+  Point geometry;
+  Point placement;
+  uint64_t layer, dataType, width, height, halfwidth;
+  std::string placementCell;
+  std::vector<Point> polygonPoints, pathPoints, repetition;
+
+  uint8_t byte() {
+    if (this->pos >= this->data.size())
+      throw std::runtime_error("unexpected end of the OASIS data");
+    return this->data[this->pos++];
+  }
+
+  uint64_t readUnsigned() {
+    uint64_t value = 0;
+    for (int shift = 0;; shift += 7) {
+      uint8_t b = this->byte();
+      value |= static_cast<uint64_t>(b & 0x7F) << shift;
+      if (!(b & 0x80))
+	return value;
+    }
+  }
+
+  int64_t readSigned() {
+    uint64_t value = this->readUnsigned();
+    return (value & 1) ? -static_cast<int64_t>(value >> 1) : static_cast<int64_t>(value >> 1);
+  }
+
+  double readReal() {
+    uint64_t type = this->readUnsigned();
+    if (type == 0 || type == 1) {
+      double value = this->readUnsigned();
+      return type == 0 ? value : -value;
+    }
+    if (type != 7)
+      throw std::runtime_error("unexpected real type");
+    uint64_t bits = 0;
+    for (int i = 0; i < 8; i++)
+      bits |= static_cast<uint64_t>(this->byte()) << (8*i);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  std::string readString() {
+    uint64_t length = this->readUnsigned();
+    std::string value = this->data.substr(this->pos, length);
+    this->pos += length;
+    return value;
+  }
+
+  static Point direction(uint64_t code, int64_t magnitude) {
+    static const int dx[8] = {1, 0, -1, 0, 1, -1, -1, 1};
+    static const int dy[8] = {0, 1, 0, -1, 1, 1, -1, -1};
+    return Point(dx[code]*magnitude, dy[code]*magnitude);
+  }
+
+  Point readGDelta() {
+    uint64_t first = this->readUnsigned();
+    if (!(first & 1))
+      return direction((first >> 1) & 7, first >> 4);
+    int64_t x = static_cast<int64_t>(first >> 2);
+    return Point((first & 2) ? -x : x, this->readSigned());
+  }
+
+  // Returns the vertices of a point-list, starting with (0, 0).
+  std::vector<Point> readPointList() {
+    uint64_t type = this->readUnsigned();
+    uint64_t count = this->readUnsigned();
+    std::vector<Point> points(1, Point(0, 0));
+    for (uint64_t i = 0; i < count; i++) {
+      Point delta;
+      if (type == 2) {
+	uint64_t value = this->readUnsigned();
+	delta = direction(value & 3, value >> 2);
+      } else if (type == 3) {
+	uint64_t value = this->readUnsigned();
+	delta = direction(value & 7, value >> 3);
+      } else if (type == 4) {
+	delta = this->readGDelta();
+      } else {
+	throw std::runtime_error("unexpected point-list type");
+      }
+      points.push_back(Point(points.back().first + delta.first,
+			     points.back().second + delta.second));
+    }
+    return points;
+  }
+
+  // Returns the offsets of a repetition, starting with (0, 0).
+  std::vector<Point> readRepetition() {
+    uint64_t type = this->readUnsigned();
+    if (type == 0)
+      return this->repetition;
+    std::vector<Point> offsets;
+    if (type == 1 || type == 2 || type == 3) {
+      uint64_t columns = type == 3 ? 1 : this->readUnsigned() + 2;
+      uint64_t rows = type == 2 ? 1 : this->readUnsigned() + 2;
+      if (type == 3)
+	rows = this->readUnsigned() + 2;
+      int64_t xSpace = type == 3 ? 0 : this->readUnsigned();
+      int64_t ySpace = type == 2 ? 0 : this->readUnsigned();
+      for (uint64_t r = 0; r < rows; r++)
+	for (uint64_t c = 0; c < columns; c++)
+	  offsets.push_back(Point(c*xSpace, r*ySpace));
+    } else if (type == 8 || type == 9) {
+      uint64_t columns = this->readUnsigned() + 2;
+      uint64_t rows = type == 9 ? 1 : this->readUnsigned() + 2;
+      Point n = this->readGDelta();
+      Point m = type == 9 ? Point(0, 0) : this->readGDelta();
+      for (uint64_t r = 0; r < rows; r++)
+	for (uint64_t c = 0; c < columns; c++)
+	  offsets.push_back(Point(c*n.first + r*m.first, c*n.second + r*m.second));
+    } else if (type == 10) {
+      uint64_t count = this->readUnsigned() + 2;
+      offsets.push_back(Point(0, 0));
+      for (uint64_t i = 1; i < count; i++) {
+	Point delta = this->readGDelta();
+	offsets.push_back(Point(offsets.back().first + delta.first,
+				offsets.back().second + delta.second));
+      }
+    } else {
+      throw std::runtime_error("unexpected repetition type");
+    }
+    this->repetition = offsets;
+    return offsets;
+  }
+
+  // Moves @modal by the x and y of a record and returns the positions
+  // of its repetition.
+  std::vector<Point> readPositions(Point& modal, bool hasX, bool hasY, bool hasRepetition) {
+    if (hasX)
+      modal.first = this->relative ? modal.first + this->readSigned() : this->readSigned();
+    if (hasY)
+      modal.second = this->relative ? modal.second + this->readSigned() : this->readSigned();
+    std::vector<Point> offsets(1, Point(0, 0));
+    if (hasRepetition)
+      offsets = this->readRepetition();
+    std::vector<Point> positions;
+    for (std::size_t i = 0; i < offsets.size(); i++)
+      positions.push_back(Point(modal.first + offsets[i].first, modal.second + offsets[i].second));
+    std::sort(positions.begin(), positions.end());
+    return positions;
+  }
+
+  void startCell(const std::string& name) {
+    DecodedCell cell;
+    cell.name = name;
+    this->cells.push_back(cell);
+    this->relative = false;
+    this->geometry = this->placement = Point(0, 0);
+    this->layer = this->dataType = this->width = this->height = this->halfwidth = 0;
+    this->placementCell.clear();
+    this->polygonPoints.clear();
+    this->pathPoints.clear();
+    this->repetition.clear();
+  }
+
+  void readShape(uint8_t record) {
+    uint8_t info = this->byte();
+    DecodedShape shape;
+    shape.record = record;
+    if (info & 0x01) this->layer = this->readUnsigned();
+    if (info & 0x02) this->dataType = this->readUnsigned();
+    shape.layer = this->layer;
+    shape.dataType = this->dataType;
+    shape.width = shape.height = shape.halfwidth = shape.extension = 0;
+    if (record == sil::utils::OAS_RECTANGLE) {
+      if (info & 0x40) this->width = this->readUnsigned();
+      if (info & 0x20) this->height = this->readUnsigned();
+      if (info & 0x80) this->height = this->width;
+      shape.width = this->width;
+      shape.height = this->height;
+    } else if (record == sil::utils::OAS_POLYGON) {
+      if (info & 0x20) this->polygonPoints = this->readPointList();
+      shape.points = this->polygonPoints;
+    } else {
+      if (info & 0x40) this->halfwidth = this->readUnsigned();
+      shape.halfwidth = this->halfwidth;
+      if (info & 0x80) shape.extension = this->readUnsigned();
+      if (info & 0x20) this->pathPoints = this->readPointList();
+      shape.points = this->pathPoints;
+    }
+    shape.positions = this->readPositions(this->geometry, info & 0x10, info & 0x08, info & 0x04);
+    this->cells.back().shapes.push_back(shape);
+  }
+
+  void readPlacement(uint8_t record) {
+    uint8_t info = this->byte();
+    DecodedPlacement placed;
+    if (info & 0x80)
+      this->placementCell = (info & 0x40) ? this->cellnames.at(this->readUnsigned())
+	: this->readString();
+    placed.cell = this->placementCell;
+    placed.magnification = 1;
+    placed.angle = 0;
+    if (record == sil::utils::OAS_PLACEMENT) {
+      placed.angle = 90*((info >> 1) & 3);
+    } else {
+      if (info & 0x04) placed.magnification = this->readReal();
+      if (info & 0x02) placed.angle = this->readReal();
+    }
+    placed.positions = this->readPositions(this->placement, info & 0x20, info & 0x10, info & 0x08);
+    this->cells.back().placements.push_back(placed);
+  }
+
+public:
+  explicit OasisDecoder(const std::string& usrData) : data(usrData), pos(0), relative(false) {}
+
+  // Decodes the records up to and including END.
+  std::vector<DecodedCell> decode() {
+    if (this->data.compare(0, 13, "%SEMI-OASIS\r\n") != 0)
+      throw std::runtime_error("missing the OASIS magic bytes");
+    this->pos = 13;
+    if (this->byte() != sil::utils::OAS_START)
+      throw std::runtime_error("missing the START record");
+    this->readString(); // version
+    this->readReal(); // unit
+    if (this->readUnsigned() != 1)
+      throw std::runtime_error("expected the table offsets in the END record");
+    while (true) {
+      uint8_t record = this->byte();
+      switch (record) {
+      case sil::utils::OAS_PAD:
+	break;
+      case sil::utils::OAS_END:
+	return this->cells;
+      case sil::utils::OAS_CELLNAME_IMPLICIT:
+	this->cellnames.push_back(this->readString());
+	break;
+      case sil::utils::OAS_CELL_REFNUM:
+	this->startCell(this->cellnames.at(this->readUnsigned()));
+	break;
+      case sil::utils::OAS_XYABSOLUTE:
+	this->relative = false;
+	break;
+      case sil::utils::OAS_XYRELATIVE:
+	this->relative = true;
+	break;
+      case sil::utils::OAS_RECTANGLE:
+      case sil::utils::OAS_POLYGON:
+      case sil::utils::OAS_PATH:
+	this->readShape(record);
+	break;
+      case sil::utils::OAS_PLACEMENT:
+      case sil::utils::OAS_PLACEMENT_TRANSFORM:
+	this->readPlacement(record);
+	break;
+#ifdef SILHOUETTE_HAVE_ZLIB
+      case sil::utils::OAS_CBLOCK: {
+	if (this->readUnsigned() != 0)
+	  throw std::runtime_error("unexpected compression type");
+	std::string inflated(this->readUnsigned(), '\0');
+	uint64_t compressedSize = this->readUnsigned();
+	z_stream stream;
+	std::memset(&stream, 0, sizeof(stream));
+	inflateInit2(&stream, -15);
+	stream.next_in = reinterpret_cast<Bytef*>(&this->data[this->pos]);
+	stream.avail_in = compressedSize;
+	stream.next_out = reinterpret_cast<Bytef*>(&inflated[0]);
+	stream.avail_out = inflated.size();
+	int status = inflate(&stream, Z_FINISH);
+	inflateEnd(&stream);
+	if (status != Z_STREAM_END)
+	  throw std::runtime_error("could not inflate a CBLOCK");
+	// the inflated records are read in place of the CBLOCK
+	this->data.replace(this->pos, compressedSize, inflated);
+	break;
+      }
+#endif
+      default:
+	throw std::runtime_error("unexpected record " + std::to_string(record));
+      }
+    }
+  }
+};
+
+const DecodedCell* findDecoded(const std::vector<DecodedCell>& cells, const std::string& name) {
+  for (std::size_t i = 0; i < cells.size(); i++)
+    if (cells[i].name == name)
+      return &cells[i];
+  return NULL;
+}
+
+// Returns the sorted positions of a @columns by @rows grid starting at @origin.
+std::vector<Point> grid(Point origin, int columns, int rows, int64_t xSpace, int64_t ySpace) {
+  std::vector<Point> positions;
+  for (int r = 0; r < rows; r++)
+    for (int c = 0; c < columns; c++)
+      positions.push_back(Point(origin.first + c*xSpace, origin.second + r*ySpace));
+  std::sort(positions.begin(), positions.end());
+  return positions;
+}
+
+// Compares the decoded records of the small layout written by main().
+int checkDecoded(const std::vector<DecodedCell>& cells, const sil::Circle& dot, std::string what) {
+  int failures = 0;
+  const DecodedCell* shapes = findDecoded(cells, "Shapes");
+  const DecodedCell* top = findDecoded(cells, "Top");
+  failures += check(cells.size() == 3 && findDecoded(cells, "Dot") && shapes && top,
+		    what + ": every cell is decoded");
+  if (!shapes || !top)
+    return failures;
+
+  // the rectangle: lower left corner, width and height in database units
+  const DecodedShape* box = NULL;
+  const DecodedShape* dots = NULL;
+  const DecodedShape* wire = NULL;
+  for (std::size_t i = 0; i < shapes->shapes.size(); i++) {
+    const DecodedShape& shape = shapes->shapes[i];
+    if (shape.record == sil::utils::OAS_RECTANGLE) box = &shape;
+    if (shape.record == sil::utils::OAS_POLYGON) dots = &shape;
+    if (shape.record == sil::utils::OAS_PATH) wire = &shape;
+  }
+  failures += check(shapes->shapes.size() == 3 && box && dots && wire,
+		    what + ": one record per group of shapes");
+  if (!box || !dots || !wire)
+    return failures;
+  failures += check(box->layer == 5 && box->dataType == 2 && box->width == 3000 &&
+		    box->height == 4000 && box->positions == std::vector<Point>(1, Point(-500, 0)),
+		    what + ": rectangle");
+
+  // the circles: one POLYGON repeated on a 3 by 2 grid
+  failures += check(dots->layer == 1 && dots->dataType == 0 &&
+		    dots->positions.size() == 6 &&
+		    dots->positions == grid(dots->positions[0], 3, 2, 250, 500),
+		    what + ": repeated circle positions");
+  sil::Span<const sil::CoordPnt> vertices = dot.getVertexSpan();
+  bool sameOutline = dots->points.size() == vertices.size();
+  for (std::size_t i = 0; sameOutline && i < vertices.size(); i++)
+    sameOutline = dots->positions[0].first + dots->points[i].first ==
+      llround(vertices[i].getX()*1e3) &&
+      dots->positions[0].second + dots->points[i].second == llround(vertices[i].getY()*1e3);
+  failures += check(sameOutline, what + ": repeated circle vertices");
+
+  // the path: half width, extension scheme and points
+  std::vector<Point> route;
+  route.push_back(Point(0, 0));
+  route.push_back(Point(0, 15000));
+  route.push_back(Point(15000, 30000));
+  failures += check(wire->layer == 3 && wire->halfwidth == 250 && wire->extension == 0x0A &&
+		    wire->points == route && wire->positions == std::vector<Point>(1, Point(-5000, -5000)),
+		    what + ": path");
+
+  // the placements: a 10 by 5 CellArray, a turned and a magnified reference
+  const DecodedPlacement* array = NULL;
+  const DecodedPlacement* turned = NULL;
+  const DecodedPlacement* magnified = NULL;
+  for (std::size_t i = 0; i < top->placements.size(); i++) {
+    const DecodedPlacement& placed = top->placements[i];
+    if (placed.positions.size() == 50) array = &placed;
+    else if (placed.angle == 90) turned = &placed;
+    else if (placed.magnification == 2.5) magnified = &placed;
+  }
+  failures += check(top->placements.size() == 3 && array && turned && magnified,
+		    what + ": one record per placement");
+  if (!array || !turned || !magnified)
+    return failures;
+  failures += check(array->cell == "Dot" && array->angle == 0 && array->magnification == 1 &&
+		    array->positions == grid(Point(-20000, 0), 10, 5, 1000, 2000),
+		    what + ": cell array");
+  failures += check(turned->cell == "Shapes" && turned->magnification == 1 &&
+		    turned->positions == std::vector<Point>(1, Point(7000, -3000)),
+		    what + ": rotated reference");
+  failures += check(magnified->cell == "Dot" && fabs(magnified->angle - 30) < 1e-9 &&
+		    magnified->positions == std::vector<Point>(1, Point(0, 12500)),
+		    what + ": magnified reference");
+  return failures;
+}
+
+int main() {
+  sil::Layout layout;
+
+  // a small lattice of holes, repeated placements and a path
+  sil::Cell hole = sil::Cell("Hole");
+  hole.addPolygon(sil::Circle(sil::CoordPnt(0, 0), 0.065));
+  sil::Cell lattice = sil::Cell("Lattice");
+  for (int row = 0; row < 40; row++)
+    for (int col = 0; col < 40; col++)
+      lattice.addPolygon(sil::Circle(sil::CoordPnt(0.25*col, 0.5*row), 0.065));
+  for (int i = 0; i < 10; i++)
+    lattice.addPolygon(sil::Rectangle(sil::CoordPnt(20 + 3*i, -5), 2, 1));
+  std::vector<sil::CoordPnt> route;
+  route.push_back(sil::CoordPnt(-5, -5));
+  route.push_back(sil::CoordPnt(-5, 10));
+  route.push_back(sil::CoordPnt(10, 25));
+  lattice.addPath(sil::Path(route, 0.5, 2, 3));
+  lattice.addCellReference(sil::CellReference(hole, sil::CoordPnt(-10, -10)));
+  lattice.addCellArray(sil::CellArray(hole, sil::CoordPnt(-20, 0), 10, 5, 1, 2));
+  layout.addCell(hole);
+  layout.addCell(lattice);
+
+  layout.write("oasisTest.gds");
+  layout.writeOASIS("oasisTest.oas");
+  std::string gds = readFile("oasisTest.gds");
+  std::string oas = readFile("oasisTest.oas");
+
+  int failures = 0;
+  failures += check(oas.compare(0, 13, "%SEMI-OASIS\r\n") == 0,
+		    "OASIS magic bytes");
+  failures += check(oas.size() > 256 && oas[oas.size() - 256] == 2,
+		    "END record is the last 256 bytes");
+  failures += check(10*oas.size() < gds.size(),
+		    "OASIS output is at least 10x smaller than GDSII");
+
+  // the lattice is folded into one repeated circle
+  std::vector<DecodedCell> decoded = OasisDecoder(oas).decode();
+  const DecodedCell* decodedLattice = findDecoded(decoded, "Lattice");
+  std::size_t circles = 0;
+  std::size_t rectangles = 0;
+  if (decodedLattice)
+    for (std::size_t i = 0; i < decodedLattice->shapes.size(); i++) {
+      const DecodedShape& shape = decodedLattice->shapes[i];
+      if (shape.record == sil::utils::OAS_POLYGON)
+	circles += shape.positions.size();
+      if (shape.record == sil::utils::OAS_RECTANGLE)
+	rectangles += shape.positions.size();
+    }
+  failures += check(circles == 1600 && rectangles == 10, "the lattice decodes to every shape");
+
+  // a small layout whose records are compared value by value
+  sil::Layout small;
+  sil::Cell dotCell("Dot");
+  sil::Circle dot(sil::CoordPnt(0, 0), 0.065);
+  dotCell.addPolygon(dot);
+  sil::Cell shapes("Shapes");
+  sil::Rectangle box(sil::CoordPnt(1, 2), 3, 4);
+  box.setLayer(5);
+  box.setDataType(2);
+  shapes.addPolygon(box);
+  for (int row = 0; row < 2; row++)
+    for (int col = 0; col < 3; col++)
+      shapes.addPolygon(sil::Circle(sil::CoordPnt(0.25*col, 0.5*row), 0.065));
+  shapes.addPath(sil::Path(route, 0.5, 2, 3));
+  sil::Cell top("Top");
+  top.addCellArray(sil::CellArray(dotCell, sil::CoordPnt(-20, 0), 10, 5, 1, 2));
+  sil::CellReference turned(shapes, sil::CoordPnt(7, -3));
+  turned.setRotation(acos(-1)/2);
+  top.addCellReference(turned);
+  sil::CellReference magnified(dotCell, sil::CoordPnt(0, 12.5));
+  magnified.setMagneification(2.5);
+  magnified.setRotation(acos(-1)/6);
+  top.addCellReference(magnified);
+  small.addCell(dotCell);
+  small.addCell(shapes);
+  small.addCell(top);
+  small.writeOASIS("oasisSmall.oas");
+  std::string smallOas = readFile("oasisSmall.oas");
+  failures += checkDecoded(OasisDecoder(smallOas).decode(), dot, "uncompressed");
+
+#ifdef SILHOUETTE_HAVE_ZLIB
+  layout.writeOASIS("oasisTestCompressed.oas", true);
+  std::string compressed = readFile("oasisTestCompressed.oas");
+  failures += check(compressed.size() <= oas.size(),
+		    "compressed OASIS output is not larger");
+  std::vector<DecodedCell> inflated = OasisDecoder(compressed).decode();
+  decodedLattice = findDecoded(inflated, "Lattice");
+  failures += check(decodedLattice && decodedLattice->shapes.size() ==
+		    findDecoded(decoded, "Lattice")->shapes.size(),
+		    "compressed cells decode to the same records");
+  small.writeOASIS("oasisSmallCompressed.oas", true);
+  failures += checkDecoded(OasisDecoder(readFile("oasisSmallCompressed.oas")).decode(),
+			   dot, "compressed");
+#endif
+
+  return failures;
+}
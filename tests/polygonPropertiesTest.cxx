@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "testUtils.hxx"
+
+int main() {
+  int failures = 0;
+
+  sil::Rectangle rectangle(sil::CoordPnt(1, 1), 4, 2);
+  failures += check(rectangle.isRectangle() && rectangle.isManhattan() && rectangle.isConvex(),
+		    "rectangles are classified");
+  failures += check(near(rectangle.getArea(), 8) && near(rectangle.getPerimeter(), 12),
+		    "rectangle area and perimeter");
+  failures += check(rectangle.getSignedArea() < 0, "rectangle corners run clockwise");
+  sil::BoxList box = rectangle.getBoundingBox();
+  failures += check(box[0].getX() == -1 && box[0].getY() == 2 &&
+		    box[2].getX() == 3 && box[2].getY() == 0, "rectangle bounding box");
+  failures += check(rectangle.pointInsidePolygon(sil::CoordPnt(0, 1)), "inside a rectangle");
+  failures += check(!rectangle.pointInsidePolygon(sil::CoordPnt(3, 1)),
+		    "the boundary is not inside");
+
+  // an L shape: manhattan but not convex
+  std::vector<sil::CoordPnt> outline;
+  outline.push_back(sil::CoordPnt(0, 0));
+  outline.push_back(sil::CoordPnt(4, 0));
+  outline.push_back(sil::CoordPnt(4, 1));
+  outline.push_back(sil::CoordPnt(1, 1));
+  outline.push_back(sil::CoordPnt(1, 3));
+  outline.push_back(sil::CoordPnt(0, 3));
+  sil::Polygon ell(outline);
+  failures += check(ell.isManhattan() && !ell.isConvex() && !ell.isRectangle(),
+		    "L shapes are manhattan only");
+  failures += check(near(ell.getSignedArea(), 6) && near(ell.getPerimeter(), 14),
+		    "L shape area and perimeter");
+  failures += check(ell.pointInsidePolygon(sil::CoordPnt(0.5, 2)), "inside the L shape");
+  failures += check(!ell.pointInsidePolygon(sil::CoordPnt(3, 2)),
+		    "inside the bounding box but outside the L shape");
+  failures += check(near(ell.getCenter().getX(), 10.0 / 6) && near(ell.getCenter().getY(), 8.0 / 6),
+		    "the center is the average vertex");
+
+  // moving keeps the cached values in step
+  ell.translate(sil::CoordPnt(10, 20));
+  box = ell.getBoundingBox();
+  failures += check(box[3].getX() == 10 && box[3].getY() == 20 && box[1].getX() == 14 &&
+		    box[1].getY() == 23, "translation moves the bounding box");
+  failures += check(near(ell.getArea(), 6) && near(ell.getCenter().getY(), 20 + 8.0 / 6),
+		    "translation keeps the area and moves the center");
+
+  // a quarter turn keeps the area and the classification
+  const double PI = std::acos(-1);
+  ell.rotate(sil::CoordPnt(10, 20), PI / 2);
+  box = ell.getBoundingBox();
+  failures += check(near(box[3].getX(), 7) && near(box[1].getY(), 24),
+		    "rotation moves the bounding box");
+  failures += check(near(ell.getArea(), 6) && near(ell.getPerimeter(), 14),
+		    "rotation keeps the area and perimeter");
+  sil::Polygon diamond(std::vector<sil::CoordPnt>(rectangle.getVertexSpan().begin(),
+						  rectangle.getVertexSpan().end()));
+  diamond.rotate(sil::CoordPnt(0, 0), PI / 4);
+  failures += check(!diamond.isManhattan() && diamond.isConvex() && near(diamond.getArea(), 8),
+		    "rotated rectangles are convex but not manhattan");
+
+  // editing the vertices forgets the cached values
+  sil::Polygon triangle(std::vector<sil::CoordPnt>(outline.begin(), outline.begin() + 3));
+  failures += check(near(triangle.getArea(), 2) && triangle.isConvex(), "triangle area");
+  triangle.getVertices()[2] = sil::CoordPnt(4, 3);
+  failures += check(near(triangle.getArea(), 6), "edits through getVertices are seen");
+
+  // the first queries of a shared polygon may come from several threads
+  const sil::Circle circle(sil::CoordPnt(3, 4), 5);
+  std::vector<int> agree(8, 0);
+  std::vector<std::thread> readers;
+  for (std::size_t t = 0; t < agree.size(); t++)
+    readers.push_back(std::thread([&circle, &agree, t]() {
+	  sil::BoxList bounds = circle.getBoundingBox();
+	  agree[t] = circle.isConvex() && near(circle.getCenter().getX(), 3) &&
+	    circle.getArea() > 78 && circle.getArea() < 78.54 &&
+	    bounds[1].getX() > 7.9 && bounds[1].getX() < 8 + 1e-9 &&
+	    circle.getVertices().size() == 64;
+	}));
+  for (std::size_t t = 0; t < readers.size(); t++)
+    readers[t].join();
+  failures += check(std::count(agree.begin(), agree.end(), 1) == (int) agree.size(),
+		    "concurrent queries agree");
+  sil::Circle copy(circle);
+  failures += check(near(copy.getArea(), circle.getArea()) && copy.isConvex(),
+		    "copies keep the computed properties");
+
+  return failures;
+}
@@ -0,0 +1,99 @@
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "testUtils.hxx"
+
+std::string readFile(const std::string& filename) {
+  std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+int main(void) {
+  int failures = 0;
+  sil::Layout layout;
+  sil::Cell& dot = layout.createCell("dot");
+  dot.addPolygon(box(0, 0, 1, 1, 1));
+  sil::Cell& top = layout.createCell("top");
+  top.addPolygon(box(0, 0, 4, 2, 1)); // the bottom left
+  top.addPolygon(box(2, 0, 6, 2, 1)); // overlaps it
+  top.addPolygon(box(0, 8, 2.5, 10, 2)); // half a pixel on the right edge
+  // a 4 x 1 row of dots along y 5 to 6, every other pixel
+  top.addCellArray(sil::CellArray(dot, sil::CoordPnt(1, 5), 4, 1, 2, 2));
+  std::vector<sil::CoordPnt> points;
+  points.push_back(sil::CoordPnt(9, 0));
+  points.push_back(sil::CoordPnt(9, 10));
+  top.addPath(sil::Path(points, 2, 0, 3)); // the right two columns
+
+  sil::Bounds window(0, 0, 10, 10);
+  sil::Raster raster = sil::rasterize(top, window, 10, 10);
+  failures += check(raster.getWidth() == 10 && raster.getHeight() == 10 &&
+                    raster.getRowSize() == 10, "size");
+  // rows count from the top: y 0 to 1 is row 9
+  failures += check(raster.getPixel(0, 9) == 255 && raster.getPixel(5, 8) == 255 &&
+                    raster.getPixel(6, 9) == 0, "overlapping boxes");
+  failures += check(raster.getPixel(1, 0) == 255 && raster.getPixel(2, 0) == 0 &&
+                    raster.getPixel(2, 1) == 0, "center sampling");
+  failures += check(raster.getPixel(1, 4) == 255 && raster.getPixel(2, 4) == 0 &&
+                    raster.getPixel(7, 4) == 255 && raster.getPixel(8, 4) == 255 &&
+                    raster.getPixel(1, 3) == 0, "array");
+  failures += check(raster.getPixel(9, 0) == 255 && raster.getPixel(8, 5) == 255 &&
+                    raster.getPixel(7, 5) == 0, "path");
+
+  sil::RasterOptions options;
+  options.antialias = true;
+  options.layers.push_back(2);
+  sil::Raster shaded = sil::rasterize(top, window, 10, 10, options);
+  failures += check(shaded.getPixel(1, 0) == 255 && std::abs(shaded.getPixel(2, 0) - 128) <= 1 &&
+                    shaded.getPixel(3, 0) == 0, "area coverage");
+  failures += check(shaded.getPixel(0, 9) == 0, "layer selection");
+  // at 20 x 20 pixels the overlap at x 2 to 4 still reads as fully covered
+  options.layers.clear();
+  sil::Raster fine = sil::rasterize(top, window, 20, 20, options);
+  failures += check(fine.getPixel(5, 19) == 255 && fine.getPixel(11, 18) == 255 &&
+                    fine.getPixel(12, 19) == 0, "overlaps count once");
+
+  options.bitsPerPixel = 1;
+  options.antialias = false;
+  sil::Raster mask = sil::rasterize(top, window, 10, 10, options);
+  failures += check(mask.getRowSize() == 2, "mask rows");
+  for (unsigned int y = 0; y < 10; y++)
+    for (unsigned int x = 0; x < 10; x++)
+      failures += check(mask.getPixel(x, y) == raster.getPixel(x, y), "mask pixel");
+
+  // a tall image spans several bands
+  sil::Raster tall = sil::rasterize(top, sil::Bounds(0, 0, 10, 10), 5, 100);
+  failures += check(tall.getPixel(0, 99) == 255 && tall.getPixel(0, 60) == 0 &&
+                    tall.getPixel(0, 15) == 255, "bands");
+
+  raster.writePGM("rasterTest.pgm");
+  std::string pgm = readFile("rasterTest.pgm");
+  failures += check(pgm.size() == 13 + 100 && pgm.compare(0, 13, "P5\n10 10\n255\n") == 0,
+                    "PGM file");
+  mask.writePNG("rasterTest.png");
+  std::string png = readFile("rasterTest.png");
+  failures += check(png.size() > 8 + 25 + 12 + 12 && png.compare(1, 3, "PNG") == 0 &&
+                    png.compare(12, 4, "IHDR") == 0 && png[24] == 1, "PNG file");
+  std::remove("rasterTest.pgm");
+  std::remove("rasterTest.png");
+
+  bool thrown = false;
+  try {
+    sil::rasterize(top, sil::Bounds(), 10, 10);
+  } catch (const std::invalid_argument&) {
+    thrown = true;
+  }
+  failures += check(thrown, "empty window");
+  thrown = false;
+  try {
+    sil::Raster odd(4, 4, 4);
+  } catch (const std::invalid_argument&) {
+    thrown = true;
+  }
+  failures += check(thrown, "bits per pixel");
+  return failures;
+}
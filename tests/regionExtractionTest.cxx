@@ -0,0 +1,106 @@
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "testUtils.hxx"
+
+double layerArea(const sil::Cell& cell, int layer) {
+  double total = 0;
+  const sil::PolygonList& polygons = cell.getPolygonList();
+  for (std::size_t i = 0; i < polygons.size(); i++)
+    if (polygons[i].getLayer() == layer)
+      total += polygons[i].getArea();
+  return total;
+}
+
+int main(void) {
+  int failures = 0;
+  sil::Layout layout;
+  sil::Cell& leaf = layout.createCell("leaf");
+  leaf.addPolygon(box(0, 0, 1, 1, 1));
+  sil::Cell& far = layout.createCell("far");
+  far.addPolygon(box(0, 0, 1, 1, 2));
+  sil::Cell& top = layout.createCell("top");
+  top.addPolygon(box(1, 1, 2, 2, 2)); // inside
+  top.addPolygon(box(8, 1, 12, 2, 2)); // straddles the right border
+  top.addPolygon(box(20, 20, 21, 21, 2)); // outside
+  std::vector<sil::CoordPnt> ell; // concave, straddles the top border
+  ell.push_back(sil::CoordPnt(1, 8));
+  ell.push_back(sil::CoordPnt(4, 8));
+  ell.push_back(sil::CoordPnt(4, 9));
+  ell.push_back(sil::CoordPnt(2, 9));
+  ell.push_back(sil::CoordPnt(2, 12));
+  ell.push_back(sil::CoordPnt(1, 12));
+  top.addPolygon(sil::Polygon(ell, 3, 0));
+  std::vector<sil::CoordPnt> points;
+  points.push_back(sil::CoordPnt(5, 5));
+  points.push_back(sil::CoordPnt(15, 5));
+  top.addPath(sil::Path(points, 1, 0, 4)); // straddles the right border
+  top.addCellReference(sil::CellReference(leaf, sil::CoordPnt(3, 3))); // inside
+  top.addCellReference(sil::CellReference(leaf, sil::CoordPnt(-0.5, 3))); // straddles
+  top.addCellReference(sil::CellReference(far, sil::CoordPnt(30, 30))); // outside
+  sil::CellReference tilted(leaf, sil::CoordPnt(10, 7));
+  tilted.setRotation(std::acos(-1.)/4);
+  top.addCellReference(tilted); // straddles, rotated by 45 degrees
+  // a 20 x 20 array with a 2 pitch, of which columns and rows -0.5 to 9.5 fall in
+  top.addCellArray(sil::CellArray(leaf, sil::CoordPnt(-0.5, 20.5), 20, 20, 2, 2));
+
+  sil::Bounds window(0, 0, 10, 10);
+  sil::Layout target;
+  sil::Cell& cut = sil::extractRegion(top, window, target);
+  failures += check(cut.getCellname() == "top", "top name");
+  failures += check(target.findCell("far") == NULL, "dropped cell");
+  failures += check(target.findCell("leaf") != NULL && target.findCell("leaf_clip") != NULL,
+                    "copied and clipped cells");
+  failures += check(near(layerArea(cut, 2), 1 + 2, 1e-6), "layer 2");
+  failures += check(near(layerArea(cut, 3), 3 + 1, 1e-6), "concave polygon");
+  failures += check(near(layerArea(cut, 4), 5, 1e-6), "path");
+  // the window cuts the rotated leaf along its diagonal
+  failures += check(near(layerArea(cut, 1), 0.5, 1e-6), "rotated reference");
+  failures += check(cut.getCellReferenceList().size() == 2 && cut.getCellArrayList().empty(),
+                    "kept references");
+
+  // the array at y 20.5 lies outside, so cut a second window with it
+  sil::RegionExtractor extractor(layout);
+  sil::Bounds arrayWindow(0, 20, 10, 30);
+  sil::Layout arrayTarget;
+  sil::Cell& arrayCut = extractor.extract(extractor.getLayout().findCell("top"), arrayWindow,
+                                          arrayTarget);
+  // columns at x 1.5 to 7.5 and rows at y 20.5 to 28.5 lie inside
+  failures += check(arrayCut.getCellArrayList().size() == 1 &&
+                    arrayCut.getCellArrayList()[0].getNumCol() == 4 &&
+                    arrayCut.getCellArrayList()[0].getNumRow() == 5, "array block");
+  // the columns at -0.5 and 9.5 straddle, each row of them clipped in half
+  failures += check(arrayCut.getCellReferenceList().size() == 10, "straddling elements");
+
+  // flattening covers the same area as the hierarchy
+  sil::RegionExtractionOptions options;
+  options.flatten = true;
+  sil::Layout flatTarget;
+  sil::Cell& flat = extractor.extract(extractor.getLayout().findCell("top"), arrayWindow,
+                                      flatTarget, options);
+  failures += check(flat.getCellReferenceList().empty() && flat.getCellArrayList().empty(),
+                    "flat cell");
+  failures += check(near(layerArea(flat, 1), 4*5 + 10*0.5, 1e-6), "flat area");
+  sil::LayoutDiff diff = sil::diffLayouts(arrayTarget, flatTarget);
+  failures += check(diff.isIdentical(), "flat and hierarchical:\n" + diff.toString());
+
+  sil::Layout flatWindowTarget;
+  sil::Layout hierarchicalWindowTarget;
+  sil::extractRegion(top, window, flatWindowTarget, options);
+  sil::extractRegion(top, window, hierarchicalWindowTarget);
+  diff = sil::diffLayouts(hierarchicalWindowTarget, flatWindowTarget);
+  failures += check(diff.isIdentical(), "flat and hierarchical window:\n" + diff.toString());
+
+  bool thrown = false;
+  try {
+    sil::Layout unused;
+    sil::extractRegion(top, sil::Bounds(), unused);
+  } catch (const std::invalid_argument&) {
+    thrown = true;
+  }
+  failures += check(thrown, "empty window");
+  return failures;
+}
@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "../src/geometry.hxx"
+#include "testUtils.hxx"
+
+double area(const std::vector<sil::Trapezoid>& trapezoids) {
+  double total = 0;
+  for (std::size_t i = 0; i < trapezoids.size(); i++)
+    total += trapezoids[i].getArea();
+  return total;
+}
+
+int main(void) {
+  int failures = 0;
+  // two overlapping squares, one of them clockwise
+  {
+    sil::utils::ScanlineSweep sweep;
+    sweep.addPolygon(sil::Span<const sil::CoordPnt>(boxVertices(0, 0, 2, 2)), 0);
+    std::vector<sil::CoordPnt> clockwise = boxVertices(1, 1, 3, 3);
+    std::reverse(clockwise.begin(), clockwise.end());
+    sweep.addPolygon(sil::Span<const sil::CoordPnt>(clockwise), 1);
+    std::vector<sil::Trapezoid> result;
+    sweep.sweep(sil::utils::SWEEP_UNION, result);
+    failures += check(near(area(result), 7), "union area");
+    result.clear();
+    sweep.sweep(sil::utils::SWEEP_INTERSECTION, result);
+    failures += check(near(area(result), 1) && result.size() == 1, "intersection");
+    result.clear();
+    sweep.sweep(sil::utils::SWEEP_DIFFERENCE, result);
+    failures += check(near(area(result), 3), "difference area");
+    result.clear();
+    sweep.sweep(sil::utils::SWEEP_XOR, result);
+    failures += check(near(area(result), 6), "xor area");
+  }
+  // a rectangle comes out whole, and identical operands cancel
+  {
+    sil::utils::ScanlineSweep sweep;
+    std::vector<sil::CoordPnt> rect = boxVertices(0, 0, 4, 1);
+    rect.insert(rect.begin() + 2, sil::CoordPnt(4, 0.5)); // an extra vertex on the right
+    sweep.addPolygon(sil::Span<const sil::CoordPnt>(rect), 0);
+    std::vector<sil::Trapezoid> result;
+    sweep.sweep(sil::utils::SWEEP_UNION, result);
+    failures += check(result.size() == 2 && near(area(result), 4), "split rectangle");
+    sweep.addPolygon(sil::Span<const sil::CoordPnt>(boxVertices(0, 0, 4, 1)), 1);
+    result.clear();
+    sweep.sweep(sil::utils::SWEEP_XOR, result);
+    failures += check(result.empty(), "identical operands");
+  }
+  // crossing triangles: the sweep stops where their edges cross
+  {
+    sil::utils::ScanlineSweep sweep;
+    std::vector<sil::CoordPnt> up, down;
+    up.push_back(sil::CoordPnt(0, 0));
+    up.push_back(sil::CoordPnt(2, 0));
+    up.push_back(sil::CoordPnt(1, 2));
+    down.push_back(sil::CoordPnt(0, 2));
+    down.push_back(sil::CoordPnt(1, 0));
+    down.push_back(sil::CoordPnt(2, 2));
+    sweep.addPolygon(sil::Span<const sil::CoordPnt>(up), 0);
+    sweep.addPolygon(sil::Span<const sil::CoordPnt>(down), 1);
+    std::vector<sil::Trapezoid> result;
+    sweep.sweep(sil::utils::SWEEP_INTERSECTION, result);
+    // the overlap is the rhombus (1, 0), (1.5, 1), (1, 2), (0.5, 1)
+    failures += check(near(area(result), 1), "crossing triangles");
+    for (std::size_t i = 0; i < result.size(); i++)
+      failures += check(result[i].bottom >= 0 && result[i].top <= 2 &&
+                        result[i].bottomLeft <= result[i].bottomRight &&
+                        result[i].topLeft <= result[i].topRight, "trapezoid shape");
+  }
+  // a self-overlapping union on one operand counts once
+  {
+    sil::utils::ScanlineSweep sweep;
+    sweep.addPolygon(sil::Span<const sil::CoordPnt>(boxVertices(0, 0, 2, 1)), 0);
+    sweep.addPolygon(sil::Span<const sil::CoordPnt>(boxVertices(1, 0, 3, 1)), 0);
+    std::vector<sil::Trapezoid> result;
+    sweep.sweep(sil::utils::SWEEP_XOR, result);
+    failures += check(near(area(result), 3), "overlaps on one operand");
+  }
+  sil::Trapezoid triangle = {0, 1, 0, 2, 1, 1};
+  failures += check(triangle.getVertices().size() == 3 && near(triangle.getArea(), 1), "triangle");
+
+  bool thrown = false;
+  try {
+    sil::utils::ScanlineSweep sweep;
+    sweep.addPolygon(sil::Span<const sil::CoordPnt>(boxVertices(0, 0, 1, 1)), 2);
+  } catch (const std::invalid_argument&) {
+    thrown = true;
+  }
+  failures += check(thrown, "bad operand");
+  // outlines of a union: one piece with a hole, and two squares meeting at a corner
+  {
+    sil::utils::ScanlineSweep sweep;
+    sweep.addPolygon(sil::Span<const sil::CoordPnt>(boxVertices(0, 0, 3, 1)), 0);
+    sweep.addPolygon(sil::Span<const sil::CoordPnt>(boxVertices(0, 2, 3, 3)), 0);
+    sweep.addPolygon(sil::Span<const sil::CoordPnt>(boxVertices(0, 0, 1, 3)), 0);
+    sweep.addPolygon(sil::Span<const sil::CoordPnt>(boxVertices(2, 0, 3, 3)), 0);
+    sweep.addPolygon(sil::Span<const sil::CoordPnt>(boxVertices(3, 3, 4, 4)), 0);
+    std::vector<sil::Trapezoid> result;
+    sweep.sweep(sil::utils::SWEEP_UNION, result);
+    std::vector<std::vector<sil::CoordPnt> > outlines;
+    sil::utils::traceOutlines(result, outlines);
+    double total = 0;
+    std::size_t outer = 0, holes = 0;
+    for (std::size_t i = 0; i < outlines.size(); i++) {
+      double signedArea = sil::utils::signedArea(sil::Span<const sil::CoordPnt>(outlines[i]));
+      total += signedArea;
+      failures += check(outlines[i].size() == 4, "straight corners are dropped");
+      if (signedArea > 0)
+        outer++;
+      else
+        holes++;
+    }
+    failures += check(outlines.size() == 3 && outer == 2 && holes == 1 && near(total, 9),
+                      "outlines of a frame and a square touching it");
+  }
+
+  return failures;
+}
@@ -0,0 +1,125 @@
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "testUtils.hxx"
+
+// the distance from @pnt to the closest edge of @vertices
+double outlineDistance(const sil::CoordPnt& pnt, sil::Span<const sil::CoordPnt> vertices) {
+  double best = INFINITY;
+  for (std::size_t i = 0; i < vertices.size(); i++) {
+    const sil::CoordPnt& a = vertices[i];
+    const sil::CoordPnt& b = vertices[(i + 1)%vertices.size()];
+    double dx = b.getX() - a.getX(), dy = b.getY() - a.getY();
+    double t = ((pnt.getX() - a.getX())*dx + (pnt.getY() - a.getY())*dy)/(dx*dx + dy*dy);
+    t = std::min(1., std::max(0., t));
+    best = std::min(best, std::hypot(pnt.getX() - a.getX() - t*dx, pnt.getY() - a.getY() - t*dy));
+  }
+  return best;
+}
+
+int main(void) {
+  int failures = 0;
+
+  sil::Cell cell("shapes");
+  {
+    // generated shapes, as a generator would build them
+    sil::DeferredValidation deferred;
+    std::vector<sil::CoordPnt> square;
+    square.push_back(sil::CoordPnt(0, 0));
+    square.push_back(sil::CoordPnt(1, 0));
+    square.push_back(sil::CoordPnt(2, 0));
+    square.push_back(sil::CoordPnt(2.0002, 0)); // a repeat once snapped
+    square.push_back(sil::CoordPnt(2, 2));
+    square.push_back(sil::CoordPnt(0, 2));
+    square.push_back(sil::CoordPnt(0, 1));
+    square.push_back(sil::CoordPnt(0, 0));
+    cell.addPolygon(sil::Polygon(square, 1, 0));
+
+    std::vector<sil::CoordPnt> hair;
+    hair.push_back(sil::CoordPnt(0, 0));
+    hair.push_back(sil::CoordPnt(2, 0));
+    hair.push_back(sil::CoordPnt(2, 1));
+    hair.push_back(sil::CoordPnt(3, 1));
+    hair.push_back(sil::CoordPnt(2, 1));
+    hair.push_back(sil::CoordPnt(0, 1));
+    cell.addPolygon(sil::Polygon(hair, 1, 0));
+
+    std::vector<sil::CoordPnt> sliver;
+    sliver.push_back(sil::CoordPnt(0, 0));
+    sliver.push_back(sil::CoordPnt(1, 0));
+    sliver.push_back(sil::CoordPnt(1, 0.0001));
+    sliver.push_back(sil::CoordPnt(0, 0.0001));
+    cell.addPolygon(sil::Polygon(sliver, 1, 0));
+
+    std::vector<sil::CoordPnt> points;
+    points.push_back(sil::CoordPnt(0, 0));
+    points.push_back(sil::CoordPnt(1, 0));
+    points.push_back(sil::CoordPnt(2, 0));
+    points.push_back(sil::CoordPnt(2, 0));
+    points.push_back(sil::CoordPnt(2, 5));
+    cell.addPath(sil::Path(points, 0.5, 0, 1));
+  }
+  std::vector<sil::CoordPnt> onGrid;
+  onGrid.push_back(sil::CoordPnt(0.1, 0.1));
+  onGrid.push_back(sil::CoordPnt(0.3, 0.1));
+  onGrid.push_back(sil::CoordPnt(0.3, 0.7));
+  cell.addPolygon(sil::Polygon(onGrid, 1, 0));
+  sil::Circle circle(sil::CoordPnt(50, 50), 10);
+  circle.setLayer(2);
+  cell.addPolygon(circle);
+  std::size_t circleVertices = circle.getVertexSpan().size();
+
+  sil::SimplificationStats stats = sil::simplifyGeometry(cell);
+  const sil::PolygonList& polygons = cell.getPolygonList();
+  failures += check(stats.polygonsRemoved == 1 && polygons.size() == 4, "collapsed sliver");
+  failures += check(polygons[0].getVertexSpan().size() == 4 && polygons[0].getArea() == 4,
+                    "repeated and straight vertices");
+  failures += check(polygons[1].getVertexSpan().size() == 5, "doubled back vertex kept");
+  failures += check(polygons[2].getVertexSpan()[0].getX() == 0.1 &&
+                    polygons[2].getVertexSpan()[2].getY() == 0.7, "grid values kept");
+  failures += check(polygons[3].getVertexSpan().size() == circleVertices, "curve kept");
+  failures += check(cell.getPathList()[0].getCoordPathSpan().size() == 3, "path");
+  // the vertices of the circle are snapped to the grid
+  failures += check(stats.polygonsSimplified == 3 && stats.pathsSimplified == 1,
+                    "shapes changed");
+  failures += check(stats.verticesBefore == 8 + 6 + 4 + 5 + 3 + circleVertices &&
+                    stats.verticesAfter == 4 + 5 + 3 + 3 + circleVertices, "vertex counts");
+
+  // Douglas-Peucker on the circle only
+  sil::SimplificationOptions options;
+  options.tolerance = 0.1;
+  options.layers.push_back(2);
+  stats = sil::simplifyGeometry(cell, options);
+  sil::Span<const sil::CoordPnt> thinned = polygons[3].getVertexSpan();
+  bool close = true;
+  for (std::size_t i = 0; i < circleVertices; i++)
+    close = close && outlineDistance(circle.getVertexSpan()[i], thinned) <= 0.1 + 1e-9;
+  failures += check(thinned.size() < circleVertices && stats.polygonsSimplified == 1 &&
+                    close, "tolerance");
+  failures += check(polygons[0].getVertexSpan().size() == 4 && stats.verticesBefore ==
+                    circleVertices, "layer selection");
+
+  // thinning each side out on its own would make the outline cross
+  // itself
+  sil::Layout layout;
+  sil::Cell& folded = layout.createCell("folded");
+  double corners[] = {9.479, 7.627, 5.871, 7.779, 0.917, 2.704, 2.099, 1.011,
+                      9.509, 2.651, 2.722, 2.122, 5.426, 5.66};
+  std::vector<sil::CoordPnt> fold;
+  for (int i = 0; i < 14; i += 2)
+    fold.push_back(sil::CoordPnt(corners[i], corners[i + 1]));
+  folded.addPolygon(sil::Polygon(fold, 1, 0));
+  double foldArea = folded.getPolygonList()[0].getSignedArea();
+  sil::Cell& other = layout.createCell("other");
+  other.addPolygon(sil::Polygon(onGrid, 1, 0));
+  options = sil::SimplificationOptions();
+  options.tolerance = 3;
+  stats = sil::simplifyGeometry(layout, options);
+  const sil::Polygon& unfolded = folded.getPolygonList()[0];
+  failures += check(!sil::Polygon::containsInternalVoid(unfolded.getVertexSpan()) &&
+                    (unfolded.getSignedArea() > 0) == (foldArea > 0), "topology");
+  failures += check(stats.verticesBefore == 7 + 3, "layout");
+  return failures;
+}
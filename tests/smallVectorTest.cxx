@@ -0,0 +1,75 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "testUtils.hxx"
+
+int main() {
+  int failures = 0;
+  sil::Arena arena;
+  sil::VertexList::allocator_type allocator(&arena);
+
+  // small shapes keep their vertices inline
+  sil::Polygon::allocator_type polygonAllocator(&arena);
+  std::vector<sil::CoordPnt> square;
+  square.push_back(sil::CoordPnt(0, 0));
+  square.push_back(sil::CoordPnt(1, 0));
+  square.push_back(sil::CoordPnt(1, 1));
+  square.push_back(sil::CoordPnt(0, 1));
+  sil::Polygon small(std::allocator_arg, polygonAllocator, square, 1, 0);
+  failures += check(small.getVertices().isSmall() && arena.getBytesAllocated() == 0,
+		    "small polygons do not allocate");
+  sil::Rectangle rectangle(sil::CoordPnt(0, 0), 2, 1);
+  failures += check(rectangle.getVertices().isSmall(), "rectangles are stored inline");
+
+  // large shapes fall back to the allocator
+  sil::Circle circle(sil::CoordPnt(0, 0), 5, 64);
+  failures += check(!circle.getVertices().isSmall() && circle.getVertices().size() == 64,
+		    "large shapes are stored on the heap");
+  sil::VertexList large(allocator);
+  for (int i = 0; i < 20; i++)
+    large.push_back(sil::CoordPnt(i, 0));
+  failures += check(!large.isSmall() && arena.getBytesAllocated() > 0,
+		    "growing past the inline capacity allocates from the resource");
+  bool ordered = true;
+  for (int i = 0; i < 20; i++)
+    ordered = ordered && large[i].getX() == i;
+  failures += check(ordered, "growing keeps the elements");
+
+  // moving a heap list takes its memory, moving an inline one copies
+  const sil::CoordPnt* heapData = large.data();
+  sil::VertexList moved(std::move(large));
+  failures += check(moved.data() == heapData && large.empty() && large.isSmall(),
+		    "moves take the heap memory");
+  sil::VertexList inlineList;
+  inlineList.push_back(sil::CoordPnt(1, 2));
+  sil::VertexList movedInline(std::move(inlineList));
+  failures += check(movedInline.size() == 1 && movedInline[0].getY() == 2 &&
+		    movedInline.isSmall(), "inline moves copy the elements");
+
+  // a move to another resource copies into that resource
+  sil::VertexList other(std::move(moved), sil::VertexList::allocator_type());
+  failures += check(other.size() == 20 && other.data() != heapData &&
+		    other.get_allocator().resource() == std::pmr::get_default_resource(),
+		    "moves to another resource copy");
+
+  // copies and assignments
+  sil::VertexList copy = other;
+  failures += check(copy.size() == 20 && copy[19].getX() == 19, "copies hold every element");
+  copy = movedInline;
+  failures += check(copy.size() == 1 && copy.back().getX() == 1, "assignment replaces the elements");
+
+  // pushing an element of the list while it grows
+  sil::VertexList self;
+  self.push_back(sil::CoordPnt(3, 4));
+  for (int i = 0; i < 10; i++)
+    self.push_back(self[0]);
+  bool same = self.size() == 11;
+  for (unsigned int i = 0; i < self.size(); i++)
+    same = same && self[i].getX() == 3 && self[i].getY() == 4;
+  failures += check(same, "elements of the list can be pushed while it grows");
+
+  // bounding boxes are always inline
+  failures += check(sil::BoxList().capacity() == 4, "bounding boxes hold four corners");
+  return failures;
+}
@@ -0,0 +1,160 @@
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "../src/gdsfile.hxx"
+#include "testUtils.hxx"
+
+std::string readFile(std::string filename) {
+  std::ifstream file(filename.c_str(), std::ios::binary);
+  return std::string((std::istreambuf_iterator<char>(file)),
+		     std::istreambuf_iterator<char>());
+}
+
+// Reads a GDSII file, blanking the time stamps of the BGNLIB and BGNSTR
+// records so that files written at different times can be compared.
+std::string readWithoutTimes(std::string filename) {
+  std::string data = readFile(filename);
+  for (size_t i = 0; i + 4 <= data.size();) {
+    size_t size = ((unsigned char) data[i] << 8) | (unsigned char) data[i + 1];
+    int16_t record = ((unsigned char) data[i + 2] << 8) | (unsigned char) data[i + 3];
+    if (record == sil::utils::BGNLIB || record == sil::utils::BGNSTR)
+      data.replace(i + 4, size - 4, size - 4, '\0');
+    if (size < 4)
+      break;
+    i += size;
+  }
+  return data;
+}
+
+int main() {
+  sil::Layout layout;
+  sil::Cell hole = sil::Cell("Hole");
+  hole.addPolygon(sil::Circle(sil::CoordPnt(0, 0), 0.1));
+  sil::Cell wire = sil::Cell("Wire"); // referenced but never added
+  std::vector<sil::CoordPnt> route;
+  route.push_back(sil::CoordPnt(0, 0));
+  route.push_back(sil::CoordPnt(5, 0));
+  route.push_back(sil::CoordPnt(5, 3));
+  wire.addPath(sil::Path(route, 0.5, 2, 3));
+  sil::Cell top = sil::Cell("Top");
+  top.addPolygon(sil::Rectangle(sil::CoordPnt(1, 2), 3, 4));
+  top.addCellArray(sil::CellArray(hole, sil::CoordPnt(0, 0), 20, 10, 0.3, 0.3));
+  sil::CellReference ref(wire, sil::CoordPnt(-4, 7));
+  ref.setRotation(acos(-1)/2);
+  ref.setMagneification(2);
+  top.addCellReference(ref);
+  layout.addCell(hole);
+  layout.addCell(top);
+
+  int failures = 0;
+  layout.writeSnapshot("snapshotTest.snap");
+  {
+    sil::LayoutSnapshot snapshot("snapshotTest.snap");
+    failures += check(snapshot.getCellCount() == 3, "referenced cells are included");
+    failures += check(snapshot.getCellname(2) == "Wire", "names come from the pool");
+    std::size_t topIndex = snapshot.findCell("Top");
+    failures += check(topIndex == 1, "cells can be found by name");
+
+    // shapes are used straight from the mapping
+    const sil::SnapshotCell& cell = snapshot.getCell(topIndex);
+    failures += check(cell.polygonCount == 1 && cell.arrayCount == 1 &&
+		      cell.referenceCount == 1, "the top cell's elements");
+    const sil::SnapshotPolygon& rectangle = snapshot.getPolygons(cell)[0];
+    failures += check(rectangle.minX == -0.5 && rectangle.maxY == 4,
+		      "polygons carry their bounding box");
+    const sil::SnapshotVertex* vertices = snapshot.getVertices(rectangle);
+    failures += check(rectangle.vertexCount == 4 && vertices[1].x == 2.5 &&
+		      vertices[1].y == 4, "vertices are stored as they are");
+    failures += check(snapshot.getArrays(cell)[0].cell == 0 &&
+		      snapshot.getArrays(cell)[0].numCol == 20,
+		      "arrays refer to cells by index");
+
+    // a loaded snapshot writes the same GDSII file as the original
+    sil::Layout loaded;
+    snapshot.load(loaded);
+    failures += check(loaded.getCells().size() == 3, "every cell is loaded");
+    layout.addCell(wire);
+    layout.write("snapshotOriginal.gds");
+    loaded.write("snapshotLoaded.gds");
+    failures += check(readWithoutTimes("snapshotOriginal.gds") ==
+		      readWithoutTimes("snapshotLoaded.gds"),
+		      "a loaded snapshot matches the original");
+  }
+
+  // damaged files are rejected rather than read out of bounds
+  std::string data = readFile("snapshotTest.snap");
+  std::ofstream truncated("snapshotTruncated.snap", std::ios::binary);
+  truncated.write(data.data(), data.size() - 8);
+  truncated.close();
+  bool threw = false;
+  try {
+    sil::LayoutSnapshot snapshot("snapshotTruncated.snap");
+  } catch (std::runtime_error& e) {
+    threw = true;
+  }
+  failures += check(threw, "truncated snapshots are rejected");
+
+  // records are checked when they are used, or all at once by verify()
+  sil::SnapshotHeader header;
+  std::memcpy(&header, data.data(), sizeof(header));
+  std::string damaged = data;
+  uint64_t farAway = 1000000;
+  std::memcpy(&damaged[header.cellOffset + sizeof(sil::SnapshotCell) +
+		       offsetof(sil::SnapshotCell, firstPolygon)], &farAway, sizeof(farAway));
+  std::ofstream damagedFile("snapshotDamaged.snap", std::ios::binary);
+  damagedFile.write(damaged.data(), damaged.size());
+  damagedFile.close();
+  {
+    sil::LayoutSnapshot snapshot("snapshotDamaged.snap");
+    failures += check(snapshot.getCellname(0) == "Hole", "undamaged records can be used");
+    threw = false;
+    try {
+      snapshot.getCell(1);
+    } catch (std::runtime_error& e) {
+      threw = true;
+    }
+    failures += check(threw, "damaged records are rejected when they are used");
+    threw = false;
+    try {
+      snapshot.verify();
+    } catch (std::runtime_error& e) {
+      threw = true;
+    }
+    failures += check(threw, "verify finds damaged records");
+  }
+
+  // names are looked up through the sorted name index
+  sil::Layout named;
+  const int numNamed = 500;
+  for (int i = 0; i < numNamed; i++)
+    named.createCell("C" + std::to_string((i * 7919) % numNamed));
+  sil::Cell firstTwin("Twin");
+  sil::Cell secondTwin("Twin");
+  named.addCell(firstTwin);
+  named.addCell(secondTwin);
+  named.writeSnapshot("snapshotNamed.snap");
+  {
+    sil::LayoutSnapshot snapshot("snapshotNamed.snap");
+    snapshot.verify();
+    bool found = true;
+    for (int i = 0; i < numNamed; i++) {
+      std::string cellname = "C" + std::to_string(i);
+      std::size_t index = snapshot.findCell(cellname);
+      found = found && index < snapshot.getCellCount() && snapshot.getCellname(index) == cellname;
+    }
+    failures += check(found, "every cell is found by name");
+    failures += check(snapshot.findCell("C500") == snapshot.getCellCount() &&
+		      snapshot.findCell("") == snapshot.getCellCount() &&
+		      snapshot.findCell("Z") == snapshot.getCellCount(),
+		      "unknown names are not found");
+    failures += check(snapshot.findCell("Twin") == (std::size_t) numNamed,
+		      "the first of several cells with a name is found");
+  }
+
+  return failures;
+}
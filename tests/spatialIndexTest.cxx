@@ -0,0 +1,46 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "testUtils.hxx"
+
+int main(void) {
+  int failures = 0;
+  srand(7);
+  std::vector<sil::Bounds> boxes;
+  for (int i = 0; i < 5000; i++) {
+    double x = rand()%10000/10., y = rand()%10000/10.;
+    boxes.push_back(sil::Bounds(x, y, x + rand()%50/10., y + rand()%50/10.));
+  }
+  boxes.push_back(sil::Bounds()); // empty boxes are never found
+  sil::SpatialIndex index(boxes);
+  failures += check(index.size() == boxes.size(), "every box is kept");
+
+  bool same = true;
+  for (int q = 0; q < 200; q++) {
+    double x = rand()%10000/10., y = rand()%10000/10.;
+    sil::Bounds window(x, y, x + rand()%300/10., y + rand()%300/10.);
+    std::vector<unsigned int> found;
+    index.query(window, found);
+    std::sort(found.begin(), found.end());
+    std::vector<unsigned int> expected;
+    for (unsigned int i = 0; i < boxes.size(); i++)
+      if (boxes[i].intersects(window))
+        expected.push_back(i);
+    same = same && found == expected;
+  }
+  failures += check(same, "queries match a linear search");
+
+  std::vector<unsigned int> found;
+  sil::SpatialIndex().query(sil::Bounds(0, 0, 1, 1), found);
+  failures += check(found.empty(), "an empty index finds nothing");
+
+  sil::Bounds a(0, 0, 2, 2), b(1, 1, 3, 3);
+  sil::Bounds both = a.intersection(b);
+  failures += check(both.minX == 1 && both.maxX == 2 && a.intersects(b) &&
+                    !a.contains(b) && a.grown(1).contains(b), "box operations");
+  failures += check(a.intersection(sil::Bounds(5, 5, 6, 6)).isEmpty(), "disjoint boxes");
+  return failures;
+}
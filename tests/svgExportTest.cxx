@@ -0,0 +1,91 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "testUtils.hxx"
+
+std::size_t countOf(const std::string& text, const std::string& pattern) {
+  std::size_t count = 0;
+  for (std::size_t at = text.find(pattern); at != std::string::npos;
+       at = text.find(pattern, at + 1))
+    count++;
+  return count;
+}
+
+int main(void) {
+  int failures = 0;
+  sil::Layout layout;
+  sil::Cell& leaf = layout.createCell("leaf");
+  leaf.addPolygon(box(0, 0, 10, 10, 1));
+  leaf.addPolygon(box(0, 0, 0.01, 0.01, 2)); // far below a pixel
+  sil::Cell& dot = layout.createCell("dot");
+  dot.addPolygon(box(0, 0, 0.001, 0.001, 1));
+  sil::Cell& top = layout.createCell("top");
+  top.addCellReference(sil::CellReference(leaf, sil::CoordPnt(0, 0)));
+  top.addCellReference(sil::CellReference(dot, sil::CoordPnt(50, 50)));
+  top.addCellArray(sil::CellArray(leaf, sil::CoordPnt(0, 100), 5, 3, 20, 20));
+  std::vector<sil::CoordPnt> points;
+  points.push_back(sil::CoordPnt(0, 50));
+  points.push_back(sil::CoordPnt(90, 50));
+  top.addPath(sil::Path(points, 2, 0, 3));
+  std::shared_ptr<const sil::FrozenLayout> frozen = layout.freeze();
+
+  std::stringstream out;
+  sil::SVGExportStats stats = sil::writeSVG(*frozen, 2, out);
+  std::string svg = out.str();
+  failures += check(svg.compare(0, 5, "<?xml") == 0 && svg.find("</svg>") != std::string::npos,
+                    "document");
+  failures += check(stats.cellsWritten == 2 && countOf(svg, "<symbol") == 2, "one symbol per cell");
+  failures += check(svg.find("<title>leaf</title>") != std::string::npos, "cell names");
+  failures += check(stats.shapesWritten == 2 && stats.shapesDropped == 1 &&
+                    countOf(svg, "<polygon") == 1 && countOf(svg, "<polyline") == 1, "shapes");
+  failures += check(stats.instancesWritten == 2 && stats.instancesDropped == 1, "instances");
+  // 5 columns: groups of 1, 2 and 4 and a row of 1 + 4; 3 rows: groups
+  // of 1 and 2 rows, placed as 1 + 2
+  failures += check(countOf(svg, "<g id=") == 3 + 1 + 1 && countOf(svg, "<use") ==
+                    1 + 2 + 2 + 2 + 2 + 2 + 1 + 1, "array doubling");
+  failures += check(svg.find("scale(1 -1)") != std::string::npos, "flipped");
+  failures += check(svg.find(".l1 {") != std::string::npos && svg.find(".l2 {") != std::string::npos,
+                    "layer styles");
+
+  sil::SVGExportOptions options;
+  options.boxSmallShapes = true;
+  std::stringstream boxedOut;
+  stats = sil::writeSVG(*frozen, 2, boxedOut, options);
+  failures += check(stats.shapesBoxed == 1 && stats.instancesBoxed == 1 &&
+                    boxedOut.str().find("class=\"lod\"") != std::string::npos, "boxes");
+
+  options.boxSmallShapes = false;
+  options.layers.push_back(2);
+  std::stringstream layerOut;
+  stats = sil::writeSVG(*frozen, 2, layerOut, options);
+  failures += check(layerOut.str().find(".l1 {") == std::string::npos &&
+                    stats.shapesWritten == 0 && stats.shapesDropped == 1, "layer selection");
+
+  options.layers.clear();
+  options.minFeature = 0;
+  std::stringstream fullOut;
+  stats = sil::writeSVG(*frozen, 2, fullOut, options);
+  failures += check(stats.cellsWritten == 3 && stats.shapesDropped == 0 &&
+                    stats.instancesDropped == 0, "no culling");
+
+  // the file follows the hierarchy, not the number of elements
+  sil::Cell& wafer = layout.createCell("wafer");
+  wafer.addCellArray(sil::CellArray(leaf, sil::CoordPnt(0, 0), 1000, 1000, 20, 20));
+  std::stringstream waferOut;
+  sil::writeSVG(*layout.freeze(), 3, waferOut);
+  failures += check(waferOut.str().size() < 8192, "large array");
+
+  bool thrown = false;
+  options.width = 0;
+  try {
+    sil::writeSVG(*frozen, 2, fullOut, options);
+  } catch (const std::invalid_argument&) {
+    thrown = true;
+  }
+  failures += check(thrown, "zero width");
+  return failures;
+}
@@ -0,0 +1,42 @@
+#ifndef TEST_UTILS_HXX
+#define TEST_UTILS_HXX
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../src/silhouette.hxx"
+
+// Helpers shared by the test drivers. Every driver returns the number
+// of failed checks from main().
+
+// Reports @message if @condition does not hold and returns the number of
+// failures (0 or 1) so that the results can be summed up.
+inline int check(bool condition, std::string message) {
+  if (!condition)
+    std::cerr << "FAILED: " << message << std::endl;
+  return condition ? 0 : 1;
+}
+
+// Returns true if @a and @b differ by less than @tolerance.
+inline bool near(double a, double b, double tolerance = 1e-9) {
+  return std::abs(a - b) < tolerance;
+}
+
+// Returns the corners of the axis aligned box from (@x0, @y0) to
+// (@x1, @y1), counterclockwise if x0 < x1 and y0 < y1.
+inline std::vector<sil::CoordPnt> boxVertices(double x0, double y0, double x1, double y1) {
+  std::vector<sil::CoordPnt> vertices;
+  vertices.push_back(sil::CoordPnt(x0, y0));
+  vertices.push_back(sil::CoordPnt(x1, y0));
+  vertices.push_back(sil::CoordPnt(x1, y1));
+  vertices.push_back(sil::CoordPnt(x0, y1));
+  return vertices;
+}
+
+// Returns the box from (@x0, @y0) to (@x1, @y1) as a Polygon on @layer.
+inline sil::Polygon box(double x0, double y0, double x1, double y1, int layer) {
+  return sil::Polygon(boxVertices(x0, y0, x1, y1), layer, 0);
+}
+
+#endif // TEST_UTILS_HXX
@@ -0,0 +1,129 @@
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "../src/parallel.hxx"
+#include "testUtils.hxx"
+
+// recursive fork and join, every level waits for its children
+long fibonacci(int n) {
+  if (n < 12)
+    return n < 2 ? n : fibonacci(n - 1) + fibonacci(n - 2);
+  long a = 0, b = 0;
+  sil::TaskGroup group;
+  group.run([&]() { a = fibonacci(n - 1); });
+  group.run([&]() { b = fibonacci(n - 2); });
+  group.wait();
+  return a + b;
+}
+
+// an executor of the application that queues tasks but never runs them
+class StalledExecutor : public sil::Executor {
+public:
+  unsigned int submitted;
+
+  StalledExecutor(void) : submitted(0) {}
+
+  void execute(std::function<void()> task) {
+    this->submitted++;
+    this->tasks.push_back(task);
+  }
+
+  unsigned int getConcurrency(void) const {
+    return 4;
+  }
+
+private:
+  std::vector<std::function<void()> > tasks;
+};
+
+int main(void) {
+  int failures = 0;
+
+  sil::setWorkerCount(3);
+  failures += check(sil::getExecutor().getConcurrency() == 3, "worker count is applied");
+  failures += check(sil::utils::threadCount() == 3, "threadCount follows the executor");
+
+  // plain loop
+  std::vector<int> hits(10000, 0);
+  sil::utils::parallelFor(hits.size(), [&](std::size_t i) { hits[i]++; });
+  bool allOnce = true;
+  for (unsigned int i = 0; i < hits.size(); i++)
+    allOnce = allOnce && hits[i] == 1;
+  failures += check(allOnce, "parallelFor visits every index once");
+
+  // nested loops and groups
+  std::atomic<long> total(0);
+  sil::utils::parallelFor(32, [&](std::size_t i) {
+      sil::utils::parallelFor(100, [&](std::size_t j) { total += i * 100 + j; });
+    });
+  failures += check(total == 3200L * 3199 / 2, "nested parallelFor");
+  failures += check(fibonacci(22) == 17711, "nested TaskGroups");
+
+  // exceptions reach the caller
+  bool thrown = false;
+  try {
+    sil::utils::parallelFor(1000, [](std::size_t i) {
+        if (i == 500)
+          throw std::runtime_error("iteration failed");
+      });
+  } catch (std::runtime_error&) {
+    thrown = true;
+  }
+  failures += check(thrown, "parallelFor rethrows");
+  thrown = false;
+  {
+    sil::TaskGroup group;
+    group.run([]() {});
+    group.run([]() { throw std::logic_error("task failed"); });
+    try {
+      group.wait();
+    } catch (std::logic_error&) {
+      thrown = true;
+    }
+  }
+  failures += check(thrown, "TaskGroup rethrows");
+
+  // a pool of its own
+  {
+    sil::ThreadPool pool(2);
+    std::atomic<int> count(0);
+    sil::TaskGroup group(pool);
+    for (int i = 0; i < 100; i++)
+      group.run([&]() { count++; });
+    group.wait();
+    failures += check(pool.getConcurrency() == 2 && count == 100, "separate pool");
+  }
+
+  // an external executor that never runs anything still finishes
+  std::shared_ptr<StalledExecutor> stalled(new StalledExecutor());
+  sil::setExecutor(stalled);
+  failures += check(&sil::getExecutor() == stalled.get(), "external executor installed");
+  std::fill(hits.begin(), hits.end(), 0);
+  sil::utils::parallelFor(hits.size(), [&](std::size_t i) { hits[i]++; });
+  allOnce = true;
+  for (unsigned int i = 0; i < hits.size(); i++)
+    allOnce = allOnce && hits[i] == 1;
+  failures += check(allOnce, "parallelFor on a stalled executor");
+  failures += check(stalled->submitted == 3, "work offered to the external executor");
+
+  // library passes use it too
+  sil::Layout layout;
+  for (int i = 0; i < 8; i++) {
+    sil::Cell& cell = layout.createCell("cell" + std::to_string(i));
+    cell.addPolygon(sil::Rectangle(sil::CoordPnt(0, 0), 1, 1));
+  }
+  unsigned int before = stalled->submitted;
+  failures += check(sil::validateLayout(layout).isValid(), "validation on the external executor");
+  failures += check(stalled->submitted > before, "validation submits to the executor");
+
+  sil::setExecutor(NULL);
+  failures += check(&sil::getExecutor() != stalled.get(), "own pool restored");
+  failures += check(sil::getExecutor().getConcurrency() == 3, "restored pool keeps the worker count");
+  sil::setWorkerCount(0);
+
+  return failures;
+}
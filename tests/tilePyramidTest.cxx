@@ -0,0 +1,76 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "testUtils.hxx"
+
+int main(void) {
+  int failures = 0;
+  sil::Layout layout;
+  sil::Cell& unit = layout.createCell("unit");
+  unit.addPolygon(box(0, 0, 1, 1, 1));
+  sil::Cell& top = layout.createCell("top");
+  // layer 1 covers all of [0, 8] x [0, 8], layer 2 only its top right corner
+  top.addCellArray(sil::CellArray(unit, sil::CoordPnt(0, 0), 8, 8, 1, 1));
+  top.addPolygon(box(7, 7, 8, 8, 2));
+
+  sil::TilePyramidOptions options;
+  options.tileSize = 16;
+  options.levelCount = 3;
+  sil::TilePyramidStats stats = sil::writeTilePyramid(top, "tilePyramidTest.tiles", options);
+  // 16 tiles of layer 1 and the single corner tile of layer 2
+  failures += check(stats.tilesRendered == 17, "finest level culled by layer extents");
+  failures += check(stats.tilesMerged == 5 + 2, "coarse levels merged");
+  // every tile of layer 1 is fully covered, so they all share one image
+  failures += check(stats.tilesStored == 1 + 3 && stats.tilesShared == 20, "shared images");
+
+  sil::TilePyramid pyramid("tilePyramidTest.tiles");
+  const sil::TilePyramidHeader& header = pyramid.getHeader();
+  failures += check(header.tileSize == 16 && header.levelCount == 3, "header");
+  failures += check(header.minX == 0 && header.minY == 0 && header.maxX == 8 &&
+                    header.maxY == 8, "bounds");
+  std::vector<int> layers = pyramid.getLayers();
+  failures += check(layers.size() == 2 && layers[0] == 1 && layers[1] == 2, "layers");
+  failures += check(pyramid.getTileCount() == 24, "tile count");
+  const sil::TileRecord* corner = pyramid.findTile(2, 2, 0, 3);
+  failures += check(corner != NULL && corner->size > 8 &&
+                    std::memcmp(pyramid.getImage(*corner) + 1, "PNG", 3) == 0, "corner tile");
+  failures += check(pyramid.findTile(2, 2, 3, 0) == NULL && pyramid.findTile(3, 1, 0, 0) == NULL,
+                    "missing tiles");
+  const sil::TileRecord* whole = pyramid.findTile(0, 1, 0, 0);
+  const sil::TileRecord* part = pyramid.findTile(2, 1, 3, 3);
+  failures += check(whole != NULL && part != NULL && whole->offset == part->offset,
+                    "identical tiles share an image");
+
+  options.layers.push_back(2);
+  stats = sil::writeTilePyramid(top, "tilePyramidTest.tiles", options);
+  failures += check(stats.tilesRendered == 1 && stats.tilesStored == 3, "layer selection");
+  failures += check(sil::TilePyramid("tilePyramidTest.tiles").getTileCount() == 3,
+                    "layer selection tiles");
+
+  std::ofstream junk("tilePyramidTest.tiles", std::ios::out | std::ios::trunc);
+  junk << std::string(200, 'x');
+  junk.close();
+  bool thrown = false;
+  try {
+    sil::TilePyramid broken("tilePyramidTest.tiles");
+  } catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  failures += check(thrown, "invalid file");
+  std::remove("tilePyramidTest.tiles");
+
+  thrown = false;
+  options.tileSize = 15;
+  try {
+    sil::writeTilePyramid(top, "tilePyramidTest.tiles", options);
+  } catch (const std::invalid_argument&) {
+    thrown = true;
+  }
+  failures += check(thrown, "odd tile size");
+  return failures;
+}
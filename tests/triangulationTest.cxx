@@ -0,0 +1,152 @@
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "testUtils.hxx"
+
+bool counterclockwise(const sil::TriangleMesh& mesh) {
+  for (std::size_t i = 0; i < mesh.indices.size(); i += 3) {
+    const double* a = &mesh.coordinates[2*mesh.indices[i]];
+    const double* b = &mesh.coordinates[2*mesh.indices[i + 1]];
+    const double* c = &mesh.coordinates[2*mesh.indices[i + 2]];
+    if ((b[0] - a[0])*(c[1] - a[1]) - (b[1] - a[1])*(c[0] - a[0]) <= 0)
+      return false;
+  }
+  return true;
+}
+
+// the number of edges used by a single triangle, or -1 if an edge is
+// used twice in the same direction or by more than two triangles
+int boundaryEdges(const sil::TriangleMesh& mesh) {
+  std::map<std::pair<uint32_t, uint32_t>, int> edges;
+  for (std::size_t i = 0; i < mesh.indices.size(); i += 3)
+    for (int k = 0; k < 3; k++) {
+      uint32_t from = mesh.indices[i + k], to = mesh.indices[i + (k + 1)%3];
+      if (edges.count(std::make_pair(from, to)))
+        return -1;
+      edges[std::make_pair(from, to)] = 1;
+    }
+  int boundary = 0;
+  for (auto it = edges.begin(); it != edges.end(); ++it)
+    if (!edges.count(std::make_pair(it->first.second, it->first.first)))
+      boundary++;
+  return boundary;
+}
+
+int main(void) {
+  int failures = 0;
+
+  sil::TriangleMesh mesh;
+  std::vector<sil::CoordPnt> ell;
+  ell.push_back(sil::CoordPnt(0, 0));
+  ell.push_back(sil::CoordPnt(0, 2));
+  ell.push_back(sil::CoordPnt(1, 2));
+  ell.push_back(sil::CoordPnt(1, 1));
+  ell.push_back(sil::CoordPnt(2, 1));
+  ell.push_back(sil::CoordPnt(2, 0));
+  ell.push_back(sil::CoordPnt(0, 0)); // closed, and clockwise
+  failures += check(sil::triangulatePolygon(ell, mesh) == 4 && mesh.getVertexCount() == 6,
+                    "L shape");
+  failures += check(mesh.getArea() == 3 && counterclockwise(mesh), "L shape area");
+
+  // a square with a square hole, joined by a keyhole
+  std::vector<sil::CoordPnt> keyhole;
+  keyhole.push_back(sil::CoordPnt(0, 0));
+  keyhole.push_back(sil::CoordPnt(10, 0));
+  keyhole.push_back(sil::CoordPnt(10, 10));
+  keyhole.push_back(sil::CoordPnt(0, 10));
+  keyhole.push_back(sil::CoordPnt(0, 0));
+  keyhole.push_back(sil::CoordPnt(4, 4));
+  keyhole.push_back(sil::CoordPnt(4, 6));
+  keyhole.push_back(sil::CoordPnt(6, 6));
+  keyhole.push_back(sil::CoordPnt(6, 4));
+  keyhole.push_back(sil::CoordPnt(4, 4));
+  mesh = sil::TriangleMesh();
+  failures += check(sil::triangulatePolygon(keyhole, mesh) == 8 && mesh.getVertexCount() == 8,
+                    "keyhole welded");
+  failures += check(mesh.getArea() == 96 && counterclockwise(mesh), "keyhole area");
+  failures += check(boundaryEdges(mesh) == 8, "keyhole conforming");
+
+  // teeth pointing up and down make split and merge vertices
+  std::vector<sil::CoordPnt> comb;
+  for (int i = 0; i < 50; i++) {
+    comb.push_back(sil::CoordPnt(2*i, 0));
+    comb.push_back(sil::CoordPnt(2*i + 1, -3 - i%3));
+  }
+  comb.push_back(sil::CoordPnt(100, 0));
+  for (int i = 50; i > 0; i--) {
+    comb.push_back(sil::CoordPnt(2*i, 1));
+    comb.push_back(sil::CoordPnt(2*i - 1, 4 + i%2));
+  }
+  comb.push_back(sil::CoordPnt(0, 1));
+  mesh = sil::TriangleMesh();
+  failures += check(sil::triangulatePolygon(comb, mesh) == comb.size() - 2, "comb");
+  failures += check(std::abs(mesh.getArea() - 474) < 1e-9 &&
+                    counterclockwise(mesh) && boundaryEdges(mesh) == int(comb.size()),
+                    "comb area");
+
+  sil::Circle circle(sil::CoordPnt(0, 0), 10);
+  mesh = sil::TriangleMesh();
+  sil::triangulatePolygon(circle.getVertexSpan(), mesh);
+  failures += check(mesh.getTriangleCount() == circle.getVertexSpan().size() - 2 &&
+                    std::abs(mesh.getArea() - std::abs(circle.getSignedArea())) < 1e-9,
+                    "circle");
+  // appending keeps the earlier triangles
+  std::size_t before = mesh.getTriangleCount();
+  sil::triangulatePolygon(ell, mesh);
+  failures += check(mesh.getTriangleCount() == before + 4 && counterclockwise(mesh),
+                    "append");
+
+  sil::Layout layout;
+  sil::Cell& leaf = layout.createCell("leaf");
+  leaf.addPolygon(box(0, 0, 2, 1, 1));
+  {
+    // keyholes touch themselves, which only files read in are allowed
+    sil::DeferredValidation deferred;
+    leaf.addPolygon(sil::Polygon(keyhole, 2, 0));
+  }
+  sil::Cell& top = layout.createCell("top");
+  sil::CellReference turned(leaf, sil::CoordPnt(100, 0));
+  turned.setRotation(M_PI/2);
+  top.addCellReference(turned);
+  top.addCellArray(sil::CellArray(leaf, sil::CoordPnt(0, 0), 3, 2, 20, 20));
+  top.addPolygon(box(0, -5, 1, -4, 3));
+  std::shared_ptr<const sil::FrozenLayout> frozen = layout.freeze();
+  std::size_t topIndex = frozen->findCell("top");
+
+  std::vector<sil::LayerMesh> meshes = sil::triangulate(*frozen, topIndex);
+  failures += check(meshes.size() == 3 && meshes[0].layer == 1 && meshes[1].layer == 2 &&
+                    meshes[2].layer == 3, "layers");
+  failures += check(meshes[0].mesh.getTriangleCount() == 14 &&
+                    std::abs(meshes[0].mesh.getArea() - 14) < 1e-9, "placements");
+  failures += check(meshes[1].mesh.getVertexCount() == 56 &&
+                    std::abs(meshes[1].mesh.getArea() - 7*96) < 1e-9 &&
+                    counterclockwise(meshes[1].mesh) && boundaryEdges(meshes[1].mesh) == 56,
+                    "placed keyholes");
+  bool turnedFound = false;
+  for (std::size_t i = 0; i < meshes[0].mesh.coordinates.size(); i += 2)
+    turnedFound = turnedFound || (std::abs(meshes[0].mesh.coordinates[i] - 99) < 1e-9 &&
+                                  std::abs(meshes[0].mesh.coordinates[i + 1] - 2) < 1e-9);
+  failures += check(turnedFound, "rotation");
+
+  sil::TriangulationOptions options;
+  options.layers.push_back(2);
+  meshes = sil::triangulate(*frozen, topIndex, options);
+  failures += check(meshes.size() == 1 && meshes[0].layer == 2, "layer selection");
+  meshes = sil::triangulate(leaf);
+  failures += check(meshes.size() == 2 && meshes[1].mesh.getTriangleCount() == 8,
+                    "single cell");
+
+  bool thrown = false;
+  try {
+    sil::triangulate(*frozen, frozen->getCellCount());
+  } catch (std::out_of_range&) {
+    thrown = true;
+  }
+  failures += check(thrown, "missing cell");
+  return failures;
+}
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/silhouette.hxx"
+#include "../src/parallel.hxx"
+#include "testUtils.hxx"
+
+template <typename Function>
+bool throwsInvalidArgument(Function function) {
+  try {
+    function();
+  }
+  catch (const std::invalid_argument&) {
+    return true;
+  }
+  return false;
+}
+
+int main() {
+  int failures = 0;
+  std::vector<sil::CoordPnt> triangle;
+  triangle.push_back(sil::CoordPnt(0, 0));
+  triangle.push_back(sil::CoordPnt(1, 0));
+  triangle.push_back(sil::CoordPnt(0, 1));
+  std::vector<sil::CoordPnt> bowTie;
+  bowTie.push_back(sil::CoordPnt(0, 0));
+  bowTie.push_back(sil::CoordPnt(2, 2));
+  bowTie.push_back(sil::CoordPnt(2, 0));
+  bowTie.push_back(sil::CoordPnt(0, 2));
+  std::vector<sil::CoordPnt> line(triangle.begin(), triangle.begin() + 2);
+
+  // checked construction rejects bad shapes
+  failures += check(throwsInvalidArgument([&]() { sil::Polygon polygon(triangle, 64); }),
+		    "out of range layers throw");
+  failures += check(throwsInvalidArgument([&]() { sil::Polygon polygon(triangle, 1, -1); }),
+		    "out of range datatypes throw");
+  failures += check(throwsInvalidArgument([&]() { sil::Polygon polygon(bowTie); }),
+		    "self intersecting polygons throw");
+  failures += check(throwsInvalidArgument([&]() { sil::Polygon polygon(line); }),
+		    "polygons need three vertices");
+  failures += check(throwsInvalidArgument([&]() {
+	sil::Cell cell("Cell");
+	sil::CellArray array(cell, sil::CoordPnt(0, 0), 0, 1, 1, 1);
+      }), "arrays need columns");
+
+  sil::Layout layout;
+  sil::Cell& good = layout.createCell("Good");
+  good.emplacePolygon(triangle, 1, 0);
+  good.addPath(sil::Path(line, 0.1));
+  sil::Cell& bad = layout.createCell("Bad");
+  {
+    sil::DeferredValidation deferred;
+    failures += check(sil::DeferredValidation::isActive(), "the scope is active");
+    bad.emplacePolygon(triangle, 1, 0);
+    bad.emplacePolygon(bowTie, 70, 0);
+    bad.emplacePolygon(line, 1, 99);
+    bad.addPath(sil::Path(triangle, -1, 7));
+    sil::CellArray array(good, sil::CoordPnt(0, 0), 40000, 1, 1, 1);
+    array.setMagnification(0);
+    bad.addCellArray(array);
+    sil::CellReference far(good, sil::CoordPnt(3e6, 0));
+    bad.addCellReference(far);
+  }
+  failures += check(!sil::DeferredValidation::isActive(), "the scope ends");
+  failures += check(throwsInvalidArgument([&]() { sil::Polygon polygon(bowTie); }),
+		    "checks resume after the scope");
+
+  sil::ValidationReport goodReport = sil::validateCell(good);
+  failures += check(goodReport.isValid(), "valid cells have no violations");
+
+  sil::ValidationReport report = sil::validateLayout(layout);
+  failures += check(!report.isValid(), "invalid cells are reported");
+  failures += check(report.count(sil::SELF_INTERSECTION) == 1, "self intersection");
+  failures += check(report.count(sil::LAYER_RANGE) == 1, "layer range");
+  failures += check(report.count(sil::DATATYPE_RANGE) == 1, "datatype range");
+  failures += check(report.count(sil::VERTEX_COUNT) == 1, "vertex count");
+  failures += check(report.count(sil::PATH_TYPE) == 1 && report.count(sil::PATH_WIDTH) == 1,
+		    "path type and width");
+  failures += check(report.count(sil::ARRAY_DIMENSION) == 1 && report.count(sil::MAGNIFICATION) == 1,
+		    "array dimension and magnification");
+  failures += check(report.count(sil::COORDINATE_RANGE) == 1,
+		    "references beyond 32 bits");
+  failures += check(report.violations.size() == 9, "every violation is reported");
+  bool ordered = true;
+  for (unsigned int i = 0; i < report.violations.size(); i++)
+    ordered = ordered && report.violations[i].cell == &bad;
+  failures += check(ordered && report.violations[0].element == sil::POLYGON_ELEMENT &&
+		    report.violations[0].index == 1, "violations are in element order");
+  failures += check(report.toString().find("Bad: polygon 1:") == 0, "reports can be printed");
+
+  // many elements are checked in parallel and reported in order
+  sil::Cell& large = layout.createCell("Large");
+  {
+    sil::DeferredValidation deferred;
+    for (int i = 0; i < 20000; i++)
+      large.emplacePolygon(triangle, i % 100, 0);
+  }
+  sil::ValidationReport largeReport = sil::validateCell(large);
+  bool sorted = largeReport.violations.size() == 20000 - 200*64;
+  for (unsigned int i = 1; sorted && i < largeReport.violations.size(); i++)
+    sorted = largeReport.violations[i - 1].index < largeReport.violations[i].index;
+  failures += check(sorted, "large cells are checked completely and in order");
+  sil::ValidationReport layoutReport = sil::validateLayout(layout);
+  sorted = layoutReport.violations.size() == 9 + largeReport.violations.size() &&
+    layoutReport.violations[8].cell == &bad && layoutReport.violations[9].cell == &large;
+  for (unsigned int i = 10; sorted && i < layoutReport.violations.size(); i++)
+    sorted = layoutReport.violations[i - 1].index < layoutReport.violations[i].index;
+  failures += check(sorted, "large cells of a layout are checked completely and in order");
+
+  // the tasks of parallel passes inherit the scope of the thread that
+  // starts them, whichever thread runs them
+  sil::setWorkerCount(4);
+  std::vector<char> active(256, 0);
+  std::vector<int> built(active.size(), 0);
+  bool threw = false;
+  try {
+    sil::DeferredValidation deferred;
+    sil::utils::parallelFor(active.size(), [&](std::size_t i) {
+	// slow enough that the workers take some of the iterations
+	std::this_thread::sleep_for(std::chrono::microseconds(200));
+	active[i] = sil::DeferredValidation::isActive();
+	built[i] = sil::Polygon(triangle, 70, 0).getLayer();
+      });
+  }
+  catch (const std::invalid_argument&) {
+    threw = true;
+  }
+  failures += check(!threw && std::count(active.begin(), active.end(), 1) == (int) active.size() &&
+		    built.back() == 70,
+		    "parallel iterations inherit the scope");
+  sil::utils::parallelFor(active.size(), [&](std::size_t i) {
+      active[i] = sil::DeferredValidation::isActive();
+    });
+  failures += check(std::count(active.begin(), active.end(), 0) == (int) active.size(),
+		    "parallel iterations outside of a scope validate");
+  sil::setWorkerCount(0);
+  return failures;
+}